@@ -34,6 +34,8 @@ CPPUTEST_CFLAGS += -DSYSTEM_UNIT_TEST=1
 CPPUTEST_CFLAGS += -g3
 CPPUTEST_CFLAGS += -O0 
 CPPUTEST_CPPFLAGS += -DSYSTEM_UNIT_TEST=1
+CPPUTEST_CXXFLAGS += -pthread
+CPPUTEST_LDFLAGS += -pthread
 
 SRC_DIRS = \
 	src \
@@ -1,22 +1,13 @@
 #include "chrono_uart.h"
 
-#define UART_BUFFER_SIZE  100
+#define RX_BUFFER_SIZE  256   // HardwareSerial default receive buffer
 
 //#define DEBUG
 
-static uint8_t uart_buffer[UART_BUFFER_SIZE];
-static uint8_t buffer_index = 0;
-static uint8_t read_success = 0;
-
 typedef enum
 {
   Waiting,
   Idle,
-  Ready,
-  ReadBitmap,
-  ReadColour,
-  ReadBrightness,
-  ReadDisplayStatus,
 }StateCode;
 
 typedef struct
@@ -35,28 +26,23 @@ typedef struct
 }StateMachine;
 
 static void Default_In(void);
-static void Default_Process(void);
 static void Default_Out(void);
 static void Waiting_Process(void);
 static void Waiting_Out(void);
-static void Idle_In(void);
 static void Idle_Process(void);
-static void Ready_Process(void);
-static void Read_Process(void);
-static void ReadBitmap_Out(void);
-static void ReadColour_Out(void);
-static void ReadBrightness_Out(void);
-static void ReadDisplayStatus_Out(void);
 
 static void transition(State *next_state);
-static void clearBuffer(void);
+static void transmit(uint8_t *buf, uint16_t len);
+static void deliver(uint8_t code, uint8_t *payload, uint8_t len);
+static uint8_t getCredit(void);
 
 static StateMachine g_chrono;
+static ChronoLink g_link;
 
 State s_waiting = 
 {
   .state_code = Waiting,
-  .in = Idle_In,
+  .in = Default_In,
   .process = Waiting_Process,
   .out = Waiting_Out
 };
@@ -64,79 +50,54 @@ State s_waiting =
 State s_idle = 
 {
   .state_code = Idle,
-  .in = Idle_In,
-  .process = Idle_Process,
-  .out = Default_Out
-};
-
-State s_ready = 
-{
-  .state_code = Ready,
   .in = Default_In,
-  .process = Ready_Process,
+  .process = Idle_Process,
   .out = Default_Out
 };
 
-State s_read_bitmap =
-{
-  .state_code = ReadBitmap,
-  .in = Default_In,
-  .process = Read_Process,
-  .out = ReadBitmap_Out
-};
-
-State s_read_colour =
-{
-  .state_code = ReadColour,
-  .in = Default_In,
-  .process = Read_Process,
-  .out = ReadColour_Out
-};
-
-State s_read_brightness =
-{
-  .state_code = ReadBrightness,
-  .in = Default_In,
-  .process = Read_Process,
-  .out = ReadBrightness_Out
-};
-
-State s_read_display_status = 
-{
-  .state_code = ReadDisplayStatus,
-  .in = Default_In,
-  .process = Read_Process,
-  .out = ReadDisplayStatus_Out
-};
-
 void Chrono_Init(Chrono *ctx, uint32_t br)
 {
   Serial.begin(br);
   g_chrono.ctx = ctx;
+  g_link.rto_ms = CHRONO_DEFAULT_RTO_MS;
+  g_link.transmit = transmit;
+  g_link.deliver = deliver;
+  g_link.getCredit = getCredit;
+  ChronoLink_Init(&g_link);
   g_chrono.curr_state = &s_waiting;
   g_chrono.curr_state->in();
 }
 
 void Chrono_Update()
 {
+  ChronoLinkStats stats;
   if(g_chrono.curr_state->state_code == Waiting)
   {
     Serial.write(END_CODE);
   }
-  else if(g_chrono.curr_state->state_code == Idle)
+  else
+  {
+    // Keep announcing ready until the first frame arrives
+    ChronoLink_GetStats(&stats);
+    if(stats.received == 0)
+    {
+      Serial.write(START_CODE);
+    }
+  }
+  while(Serial.available()>0)
   {
-    Serial.write(START_CODE);
+    g_chrono.curr_state->process();
   }
-  if(!(Serial.available()>0)){return;} 
-  g_chrono.curr_state->process();
+}
+
+void Chrono_GetStats(ChronoLinkStats *stats)
+{
+  ChronoLink_GetStats(stats);
 }
 
 void Waiting_Process(void)
 {
   uint8_t c = Serial.read();
-#ifdef DEBUG
-  Serial.write(c);
-#endif
   if(c == START_CODE)
   {
     transition(&s_idle);
@@ -148,123 +109,79 @@ void Waiting_Out(void)
   Serial.write(START_CODE);
   Serial.write(START_CODE);
   Serial.write(START_CODE);
-}
 
-void Idle_In(void)
-{
-  clearBuffer();
+  // Back from a reset the panel is blank, have the clock resend everything
+  ChronoLink_Reset();
 }
 
 void Idle_Process(void)
 {
-  uint8_t c = Serial.read();
-#ifdef DEBUG
-  Serial.write(c);
-#endif
-  if(c == START_CODE)
-  {
-  transition(&s_ready);
-  }
+  ChronoLink_ReceiveByte(Serial.read());
 }
 
-void Ready_Process(void)
+void deliver(uint8_t code, uint8_t *payload, uint8_t len)
 {
-  uint8_t c = Serial.read();
 #ifdef DEBUG
-  Serial.write(c);
+  Serial.printf("\nFrame: %02X, %d bytes\n", code, len);
 #endif
-  switch(c)
+  switch(code)
   {
   case BITMAP_CODE:
-    transition(&s_read_bitmap);
+    if(len > 1)
+    {
+      g_chrono.ctx->setBitmap(payload[0], payload+1);
+    }
     break;
   case COLOUR_CODE:
-    transition(&s_read_colour);
+    if(len == 2)
+    {
+      g_chrono.ctx->setColour(payload[0], payload[1]);
+    }
     break;
   case BRIGHTNESS_CODE:
-    transition(&s_read_brightness);
+    if(len == 1)
+    {
+      g_chrono.ctx->setMatrixBrightness(payload[0]);
+    }
     break;
   case STATUS_CODE:
-    transition(&s_read_display_status);
+    if(len == 2)
+    {
+      g_chrono.ctx->setRegionStatus(payload[0], payload[1]);
+    }
+    break;
+  case STATE_CODE:
+    if(g_chrono.ctx->setState != NULL)
+    {
+      g_chrono.ctx->setState(payload, len);
+    }
     break;
   case ON_CODE:
     g_chrono.ctx->display_on();
-    transition(&s_idle);
     break;
   case OFF_CODE:
     g_chrono.ctx->display_off();
-    transition(&s_idle);
-    break;
-  case START_CODE:
-  case END_CODE:
-    transition(&s_idle);
     break;
   default:
     break;
   }
 }
 
-void Read_Process(void)
+void transmit(uint8_t *buf, uint16_t len)
 {
-  uint8_t c = Serial.read();
-#ifdef DEBUG
-  Serial.write(c);
-#endif
-  if(c == END_CODE)
-  {
-    read_success = 1;
-    transition(&s_idle);
-  }
-  else if(c == START_CODE)
-  {
-    read_success = 0;
-  }
-  else
-  {
-    uart_buffer[buffer_index] = c;
-    buffer_index++;
-    if(buffer_index >= UART_BUFFER_SIZE)
-    {
-      transition(&s_idle);
-    }
-  }
+  Serial.write(buf, len);
 }
 
-void ReadBitmap_Out(void)
-{
-  if(read_success)
-  {
-    g_chrono.ctx->setBitmap(uart_buffer[0], uart_buffer+1);
-  }
-}
-void ReadColour_Out(void)
-{
-  if(read_success)
-  {
-    g_chrono.ctx->setColour(uart_buffer[0], uart_buffer[1]);
-  } 
-}
-void ReadBrightness_Out(void)
+// Largest frames the receive buffer still has room for
+uint8_t getCredit(void)
 {
-  if(read_success)
-  {
-    g_chrono.ctx->setMatrixBrightness(uart_buffer[0]);
-  }
-}
-void ReadDisplayStatus_Out(void)
-{
-  if(read_success)
-  {
-    g_chrono.ctx->setRegionStatus(uart_buffer[0], uart_buffer[1]);
-  }
+  int space = RX_BUFFER_SIZE - Serial.available();
+  return (space > 0) ? space / CHRONO_MAX_RAW_FRAME : 0;
 }
 
 void Default_In(void)
 {
 }
-void Default_Process(void)
-{
-}
 void Default_Out(void)
 {
 }
@@ -281,9 +198,3 @@ void transition(State *next_state)
   Serial.printf("\nEnter state: %d\n", g_chrono.curr_state->state_code);
 #endif
 }
-
-void clearBuffer(void)
-{
-  memset(uart_buffer, 0, UART_BUFFER_SIZE);
-  buffer_index = 0;
-}
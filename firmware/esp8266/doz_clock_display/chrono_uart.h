@@ -2,7 +2,10 @@
 #define CHRONO_UART_H
 
 #include <Arduino.h>
-#include "chrono_protocol.h"
+extern "C"
+{
+#include "src/clock/chrono_link.h"
+}
 
 typedef struct
 {
@@ -12,10 +15,12 @@ typedef struct
   void (*setMatrixBrightness)(uint8_t val);
   void (*setBitmap)(uint8_t id, uint8_t *vals);
   void (*setRegionStatus)(uint8_t id, uint8_t val);
+  void (*setState)(uint8_t *vals, uint8_t len);
 }Chrono;
 
 
 void Chrono_Init(Chrono *ctx, uint32_t br);
 void Chrono_Update();
+void Chrono_GetStats(ChronoLinkStats *stats);
 
 #endif /*CHRONO_UART_H*/
@@ -2,9 +2,25 @@
 #include "test_bitmap.h"
 #include "chrono_uart.h"
 
+// Shared clock sources, copied in with `make esp-shared`
+extern "C"
+{
+#include "src/clock/display.h"
+}
+
+#define RENDER_PERIOD_MS  50
+#define BLINK_PERIOD_MS   500
 
 Chrono chrono_ctx;
 
+// Local renderer used when the clock sends its state instead of bitmaps
+Display clock_display;
+SnapshotPub clock_snapshot;
+DisplayStateMsg rx_state;       // Last state received
+DisplayStateMsg render_state;   // Received state advanced to now
+uint32_t rx_state_ms = 0, render_ms = 0, blink_ms = 0;
+bool state_mode = false;
+
 void displayOn(void)
 {
   RgbMatrix_RegionWritePixels(&top_region);
@@ -133,6 +149,110 @@ void setRegionStatus(uint8_t id, uint8_t val)
   }
 }
 
+PixelRegion *rowToRegion(uint8_t row)
+{
+  switch(row)
+  {
+    case ROW_1:
+      return &top_region;
+    case ROW_3:
+      return &bot_region;
+    case ROW_2:
+    default:
+      return &mid_region;
+  }
+}
+
+void renderBrightness(uint8_t brightness)
+{
+  // Brightness still arrives as its own message
+}
+
+void renderBitmap(uint8_t row, uint8_t *bitmap)
+{
+  PixelRegion *region = rowToRegion(row);
+  memcpy(region->pixel_buffer, bitmap, region->pixel_buffer_size);
+  RgbMatrix_RegionWritePixels(region);
+}
+
+void renderColour(uint8_t row, Colour colour_id)
+{
+  PixelColour colour;
+  switch(colour_id)
+  {
+    case GREEN:
+      colour = Green;
+      break;
+    case BLUE:
+      colour = Blue;
+      break;
+    case YELLOW:
+      colour = Yellow;
+      break;
+    case MAGENTA:
+      colour = Magenta;
+      break;
+    case CYAN:
+      colour = Cyan;
+      break;
+    case WHITE:
+      colour = White;
+      break;
+    case RED:
+    default:
+      colour = Red;
+      break;
+  }
+  RgbMatrix_RegionSetColour(rowToRegion(row), colour);
+}
+
+void renderShow(uint8_t row)
+{
+  RgbMatrix_RegionOn(rowToRegion(row));
+}
+
+void renderHide(uint8_t row)
+{
+  RgbMatrix_RegionOff(rowToRegion(row));
+}
+
+void setState(uint8_t *vals, uint8_t len)
+{
+  if(Display_UnpackState(&rx_state, vals, len) != CLOCK_OK)
+  {
+    return;
+  }
+  rx_state_ms = millis();
+  render_state = rx_state;
+  if(!state_mode)
+  {
+    Snapshot_Init(&clock_snapshot);
+    Display_Init(&clock_display, &clock_snapshot);
+    state_mode = true;
+  }
+  Display_PublishState(&clock_snapshot, &render_state);
+  Display_ApplyState(&render_state);
+}
+
+void renderState(void)
+{
+  uint32_t now = millis();
+  if(now - render_ms >= RENDER_PERIOD_MS)
+  {
+    render_ms = now;
+    // Run the clock forward from the last message with the local clock
+    render_state = rx_state;
+    Display_AdvanceState(&render_state, now - rx_state_ms);
+    Display_PublishState(&clock_snapshot, &render_state);
+    Display_Update();
+  }
+  if(now - blink_ms >= BLINK_PERIOD_MS)
+  {
+    blink_ms = now;
+    Display_PeriodicCallback();
+  }
+}
+
 void setup() {
   chrono_ctx.display_off = displayOff;
   chrono_ctx.display_on = displayOn;
@@ -140,7 +260,17 @@ void setup() {
   chrono_ctx.setMatrixBrightness = setMatrixBrightness;
   chrono_ctx.setBitmap = setBitmap;
   chrono_ctx.setRegionStatus = setRegionStatus;
+  chrono_ctx.setState = setState;
   Chrono_Init(&chrono_ctx, 9600);
+
+  clock_display.displayOff = displayOff;
+  clock_display.displayOn = displayOn;
+  clock_display.setBrightness = renderBrightness;
+  clock_display.setBitmap = renderBitmap;
+  clock_display.setColour = renderColour;
+  clock_display.show = renderShow;
+  clock_display.hide = renderHide;
+  clock_display.setState = NULL;
   
   RgbMatrix_Init();
   memcpy(top_region.pixel_buffer, bars_map, top_region.pixel_buffer_size);
@@ -153,4 +283,8 @@ void setup() {
 void loop() {
   // put your main code here, to run repeatedly:
   Chrono_Update();
+  if(state_mode)
+  {
+    renderState();
+  }
 }
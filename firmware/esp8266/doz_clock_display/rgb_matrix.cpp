@@ -19,6 +19,7 @@
 uint8_t display_draw_time=10; //30-70 is usually fine
 PxMATRIX display(PIXEL_COLS,PIXEL_ROWS,P_LAT, P_OE,P_A,P_B,P_C,P_D);
 Ticker display_ticker;
+uint8_t clear_count = 0;  // Incremented whenever the whole panel is blanked
 
 // Some standard colors
 uint16_t my_red = display.color565(255, 0, 0);
@@ -53,39 +54,43 @@ void RgbMatrix_SetBrightness(uint8_t level)
 void RgbMatrix_Clear()
 {
   display.clearDisplay();
+  clear_count++;
 }
 
 void RgbMatrix_RegionWritePixels(PixelRegion *region)
 {
-  uint8_t x = 0, y = 0;
-  uint8_t pixel_byte = 0;
-  uint16_t colour_val = 0;
-  
-  if(region->is_active)
-  {
-    colour_val = get_colour_val(region->colour);
-  }
-  else
+  uint8_t x = region->topleft_x, y = region->topleft_y;
+  uint8_t lit = 0, changed = 0, bit = 0;
+  uint16_t colour_val = get_colour_val(region->colour);
+  bool recolour = (region->colour != region->drawn_colour);
+
+  if(region->drawn_clear_count != clear_count)
   {
-    colour_val = my_black;
+    // Panel was cleared since the last write, nothing in the region is lit
+    memset(region->drawn_buffer, 0, region->pixel_buffer_size);
+    region->drawn_clear_count = clear_count;
   }
   for(int x_byte = 0; x_byte < region->pixel_buffer_size; x_byte++)
   {
-    pixel_byte = region->pixel_buffer[x_byte];
-    x = x_byte * 8 % region->width + region->topleft_x;
-    y = x_byte * 8 / region->width + region->topleft_y;
-    for(int i = 7; i >= 0; i--)
+    lit = region->is_active ? region->pixel_buffer[x_byte] : 0;
+    // Only touch pixels that differ from the panel, or every lit pixel on a colour change
+    changed = recolour ? (lit | region->drawn_buffer[x_byte]) : (lit ^ region->drawn_buffer[x_byte]);
+    while(changed)
+    {
+      bit = __builtin_clz((uint32_t)changed) - 24;  // Leftmost changed pixel
+      display.drawPixelRGB565(x + bit, y, (lit & (0x80 >> bit)) ? colour_val : my_black);
+      changed &= ~(0x80 >> bit);
+    }
+    region->drawn_buffer[x_byte] = lit;
+
+    x += 8;
+    if(x >= region->topleft_x + region->width)
     {
-      if((pixel_byte >> i) & 1)
-      {
-        display.drawPixel(x + (7 - i), y, colour_val);
-      }
-      else
-      {
-        display.drawPixel(x + (7 - i), y, my_black);
-      }
+      x = region->topleft_x;
+      y++;
     }
   }
+  region->drawn_colour = region->colour;
 }
 
 void RgbMatrix_RegionOff(PixelRegion *region)
@@ -33,9 +33,13 @@ typedef struct {
   uint8_t is_active;
   uint8_t *pixel_buffer;
   uint8_t pixel_buffer_size;
+  uint8_t *drawn_buffer;      // Pixels currently lit on the panel
+  PixelColour drawn_colour;   // Colour the lit pixels were drawn in
+  uint8_t drawn_clear_count;  // Panel clear count when drawn_buffer was valid
 }PixelRegion;
 
 static uint8_t top_region_buffer[SMALL_REGION_SIZE];
+static uint8_t top_region_drawn[SMALL_REGION_SIZE];
 static PixelRegion top_region = {
   .height = SMALL_REGION_HEIGHT,
   .width = PIXEL_COLS,
@@ -45,9 +49,13 @@ static PixelRegion top_region = {
   .is_active = 1,
   .pixel_buffer = top_region_buffer,
   .pixel_buffer_size = SMALL_REGION_SIZE,
+  .drawn_buffer = top_region_drawn,
+  .drawn_colour = Black,
+  .drawn_clear_count = 0,
 };
 
 static uint8_t mid_region_buffer[LARGE_REGION_SIZE];
+static uint8_t mid_region_drawn[LARGE_REGION_SIZE];
 static PixelRegion mid_region = {
   .height = LARGE_REGION_HEIGHT,
   .width = PIXEL_COLS,
@@ -57,9 +65,13 @@ static PixelRegion mid_region = {
   .is_active = 1,
   .pixel_buffer = mid_region_buffer,
   .pixel_buffer_size = LARGE_REGION_SIZE,
+  .drawn_buffer = mid_region_drawn,
+  .drawn_colour = Black,
+  .drawn_clear_count = 0,
 };
 
 static uint8_t bot_region_buffer[SMALL_REGION_SIZE];
+static uint8_t bot_region_drawn[SMALL_REGION_SIZE];
 static PixelRegion bot_region = {
   .height = SMALL_REGION_HEIGHT,
   .width = PIXEL_COLS,
@@ -69,6 +81,9 @@ static PixelRegion bot_region = {
   .is_active = 1,
   .pixel_buffer = bot_region_buffer,
   .pixel_buffer_size = SMALL_REGION_SIZE,
+  .drawn_buffer = bot_region_drawn,
+  .drawn_colour = Black,
+  .drawn_clear_count = 0,
 };
 
 void RgbMatrix_Init();
@@ -0,0 +1,60 @@
+/*
+ * chrono_link.h
+ * Reliable framing for the chrono display link
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: Matt L.
+ */
+
+#ifndef FIRMWARE_INC_CHRONO_LINK_H_
+#define FIRMWARE_INC_CHRONO_LINK_H_
+
+#include "clock_types.h"
+#include "chrono_protocol.h"
+
+#define CHRONO_SEQ_MOD          64      // Sequence numbers never collide with START_CODE or END_CODE
+#define CHRONO_RX_WINDOW        32      // Out of order frames the receiver can track
+#define CHRONO_WINDOW           4       // Frames in flight before an ACK is needed
+#define CHRONO_NUM_CHANNELS     16
+#define CHRONO_MAX_PAYLOAD      (LARGE_BITMAP_SIZE + 1)
+#define CHRONO_HEADER_SIZE      3       // Code, sequence number and window base
+#define CHRONO_MAX_RAW_FRAME    (CHRONO_HEADER_SIZE + CHRONO_MAX_PAYLOAD + 1)
+#define CHRONO_MAX_FRAME        (2 * CHRONO_MAX_RAW_FRAME + 2)  // Every byte escaped plus start and end
+#define CHRONO_DEFAULT_RTO_MS   500
+#define CHRONO_DUP_ACKS         2       // Repeated ACKs before the missing frame is resent
+
+typedef struct chrono_link_stats_t
+{
+    // Sender
+    uint32_t sent;
+    uint32_t acked;
+    uint32_t retransmitted;
+    uint32_t dropped;       // Replaced by newer state before being acknowledged
+    uint32_t resets;        // Receiver restarted, everything held was queued again
+    // Receiver
+    uint32_t received;
+    uint32_t duplicates;
+    uint32_t rejected;      // Bad checksum, bad length, overflow or an ACK for nothing sent
+    uint32_t resyncs;       // Frame outside the receive window, restarted from the sender's base
+} ChronoLinkStats;
+
+typedef struct chrono_link_t
+{
+    uint32_t rto_ms;        // Retransmit timeout, 0 for CHRONO_DEFAULT_RTO_MS
+
+    void (*transmit)(uint8_t *buf, uint16_t len);
+    void (*deliver)(uint8_t code, uint8_t *payload, uint8_t len);  // Optional, receiving side only
+    uint8_t (*getCredit)(void);                                     // Optional, frames the receiver can buffer
+    void (*peerWaiting)(void);                                      // Optional, an END_CODE between frames, the other end restarted
+} ChronoLink;
+
+ClockStatus ChronoLink_Init(ChronoLink *self);
+ClockStatus ChronoLink_Submit(uint8_t channel, uint8_t code, uint8_t *payload, uint8_t len, uint32_t now_ms);
+void ChronoLink_Supersede(uint8_t channel);
+void ChronoLink_Poll(uint32_t now_ms);
+void ChronoLink_ReceiveByte(uint8_t c);
+void ChronoLink_Reset(void);
+void ChronoLink_GetStats(ChronoLinkStats *stats);
+uint8_t ChronoLink_InFlight(void);
+
+#endif  // FIRMWARE_INC_CHRONO_LINK_H_
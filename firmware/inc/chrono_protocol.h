@@ -1,5 +1,5 @@
-#ifndef CHRONO_PROTOCOL_H
-#define CHRONO_PROTOCOL_H
+#ifndef FIRMWARE_INC_CHRONO_PROTOCOL_H_
+#define FIRMWARE_INC_CHRONO_PROTOCOL_H_
 
 #define START_CODE  0xAA
 #define END_CODE    0x55
@@ -10,6 +10,11 @@
 #define STATUS_CODE     0xC4
 #define ON_CODE         0xC5
 #define OFF_CODE        0xC6
+#define STATE_CODE      0xC7    // Payload is a packed DisplayStateMsg
+#define ACK_CODE        0xC8    // Display to clock, acknowledges frames and grants credit
+#define RESET_CODE      0xC9    // Display to clock, its receiver restarted and shows nothing
+#define ESCAPE_CODE     0x7D    // Next byte is XOR ESCAPE_MASK, lets payloads hold any value
+#define ESCAPE_MASK     0x20
 
 #define TOP_REGION_ID   0xE1
 #define MID_REGION_ID   0xE2
@@ -36,6 +41,9 @@
 //#define STATUS_CODE     '4'
 //#define ON_CODE         '5'
 //#define OFF_CODE        '6'
+//#define STATE_CODE      '7'
+//#define ACK_CODE        '8'
+//#define RESET_CODE      '9'
 //
 //#define TOP_REGION_ID   't'
 //#define MID_REGION_ID   'm'
@@ -58,4 +66,4 @@
 #define LARGE_BITMAP_SIZE 96
 #define SMALL_BITMAP_SIZE 56
 
-#endif /*CHRONO_PROTOCOL_H*/
+#endif  // FIRMWARE_INC_CHRONO_PROTOCOL_H_
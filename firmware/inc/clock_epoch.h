@@ -0,0 +1,35 @@
+/*
+ * clock_epoch.h
+ * Milliseconds since 2000-01-01 00:00, with time of day and calendar views
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: Matt L.
+ */
+
+#ifndef FIRMWARE_INC_CLOCK_EPOCH_H_
+#define FIRMWARE_INC_CLOCK_EPOCH_H_
+
+#include "clock_types.h"
+
+#define EPOCH_DAY_MS        86400000ULL
+#define EPOCH_BASE_YEAR     2000    // The RTCs keep two digits of year, both count from here
+#define EPOCH_LAST_YEAR     2099
+
+typedef uint64_t EpochMs;
+
+typedef struct clock_date_t
+{
+    uint16_t    year;       // EPOCH_BASE_YEAR to EPOCH_LAST_YEAR
+    uint8_t     month;      // 1 to 12
+    uint8_t     day;        // 1 to 31
+} ClockDate;
+
+EpochMs Epoch_FromDate(const ClockDate *date, uint32_t time_ms);
+void Epoch_ToDate(EpochMs epoch_ms, ClockDate *date);
+uint32_t Epoch_TimeOfDay(EpochMs epoch_ms);
+EpochMs Epoch_Nearest(EpochMs near_ms, uint32_t time_ms);
+ClockStatus Epoch_CheckDate(const ClockDate *date);
+uint32_t Epoch_HmsToMs(uint8_t hr, uint8_t min, uint8_t sec);
+void Epoch_MsToHms(uint32_t time_ms, uint8_t *hr, uint8_t *min, uint8_t *sec);
+
+#endif  // FIRMWARE_INC_CLOCK_EPOCH_H_
@@ -0,0 +1,49 @@
+/*
+ * clock_snapshot.h
+ * Clock values published whole for the display to render from
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: Matt L.
+ */
+
+#ifndef FIRMWARE_INC_CLOCK_SNAPSHOT_H_
+#define FIRMWARE_INC_CLOCK_SNAPSHOT_H_
+
+#include "clock_types.h"
+
+#define SNAPSHOT_DIGITS     7       // Digit values carried for set-mode blinking
+
+// Plain values, a reader works on its own copy. Publishing compares whole structs,
+// so zero one before filling it in and the padding never reads as a change.
+typedef struct clock_snapshot_t
+{
+    uint32_t    time_ms;
+    uint32_t    user_time_ms;
+    uint32_t    user_alarm_ms;
+    uint32_t    user_timer_ms;
+    int32_t     rtc_calib;
+    ClockStatus error_code;
+    uint8_t     digit_sel;
+    uint8_t     digit_vals[SNAPSHOT_DIGITS];
+    uint8_t     diurn_radix_pos;
+    uint8_t     semi_diurn_radix_pos;
+    bool        alarm_set;
+    bool        timer_set;
+    bool        alarm_triggered;
+    bool        timer_triggered;
+    bool        show_error;
+    bool        timer_alarm_displayed;
+} ClockSnapshot;
+
+// One writer, any number of readers. seq is odd while a write is in progress.
+typedef struct snapshot_pub_t
+{
+    volatile uint32_t   seq;
+    ClockSnapshot       data;
+} SnapshotPub;
+
+void Snapshot_Init(SnapshotPub *pub);
+uint32_t Snapshot_Publish(SnapshotPub *pub, const ClockSnapshot *snap);
+uint32_t Snapshot_Read(SnapshotPub *pub, ClockSnapshot *output);
+
+#endif  // FIRMWARE_INC_CLOCK_SNAPSHOT_H_
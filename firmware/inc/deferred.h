@@ -0,0 +1,44 @@
+/*
+ * deferred.h
+ * Work posted from interrupts and run later from the main loop
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: Matt L.
+ */
+
+#ifndef FIRMWARE_INC_DEFERRED_H_
+#define FIRMWARE_INC_DEFERRED_H_
+
+#include "clock_types.h"
+
+#define DEFER_MAX_WORK      16      // Registered work items, one pending bit each
+
+#ifndef DEFER_BATCH
+#define DEFER_BATCH         4       // Items run per Defer_Run, bounds how long one pass can hold the main loop
+#endif
+
+// Owned by the caller, set name and run then register it once
+typedef struct defer_work_t
+{
+    const char  *name;
+    void        (*run)(uint32_t arg);
+
+    // Set on post
+    uint8_t             id;
+    volatile uint32_t   arg;            // Latest posted, a repost before the run replaces it
+    volatile uint32_t   posted_us;      // First post since the last run
+
+    // Accounting, microseconds
+    uint32_t    runs;
+    volatile uint32_t merged;           // Posted again before it ran
+    uint32_t    max_latency_us;         // Post to start of run
+    uint64_t    total_latency_us;
+} DeferWork;
+
+ClockStatus Defer_Init(uint32_t (*getUs)(void));
+ClockStatus Defer_Register(DeferWork *work);
+ClockStatus Defer_Post(DeferWork *work, uint32_t arg);
+bool Defer_Pending(void);
+void Defer_Run(void);
+
+#endif  // FIRMWARE_INC_DEFERRED_H_
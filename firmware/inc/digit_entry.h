@@ -0,0 +1,42 @@
+/*
+ * digit_entry.h
+ * Digit by digit entry of a time in any display format
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: Matt L.
+ */
+
+#ifndef FIRMWARE_INC_DIGIT_ENTRY_H_
+#define FIRMWARE_INC_DIGIT_ENTRY_H_
+
+#include "clock_types.h"
+#include "display.h"
+
+#define ENTRY_MAX_DIGITS    7
+#define ENTRY_NO_COUPLING   0xFF
+
+// One per TimeFormats plus the timer's, see digit_entry.c
+typedef struct digit_entry_format_t
+{
+    uint8_t     num_digits;                     // Positions digit_sel moves over
+    uint8_t     radix[ENTRY_MAX_DIGITS];        // Each position wraps back to 0 here
+
+    // Coupling, the hours units wrap early when the hours tens is at its top value
+    uint8_t     tens_top;                       // ENTRY_NO_COUPLING when the positions are independent
+    uint8_t     units_radix;
+
+    // Digit 6 is AM/PM, 12 reads as PM and 00 as AM
+    bool        meridiem;
+
+    // Composed value, sum(vals[i] * weight[i]) * unit_num / unit_den ms rounded to nearest
+    uint32_t    weight[ENTRY_MAX_DIGITS];
+    uint32_t    unit_num;
+    uint32_t    unit_den;
+} DigitEntryFormat;
+
+const DigitEntryFormat *DigitEntry_Format(TimeFormats format);
+const DigitEntryFormat *DigitEntry_TimerFormat(TimeFormats format);
+void DigitEntry_Step(const DigitEntryFormat *fmt, uint8_t *vals, uint8_t sel, bool up);
+uint32_t DigitEntry_ToMs(const DigitEntryFormat *fmt, const uint8_t *vals);
+
+#endif  // FIRMWARE_INC_DIGIT_ENTRY_H_
@@ -9,6 +9,7 @@
 #ifndef FIRMWARE_INC_DISPLAY_H_
 #define FIRMWARE_INC_DISPLAY_H_
 
+#include "clock_snapshot.h"
 #include "clock_types.h"
 
 // Row 1 Display Indeces
@@ -73,6 +74,8 @@
 #define RADIX_POS4_ROW3_5DIGIT_DISPLAY_INDEX    40
 #define RADIX_POS5_ROW3_5DIGIT_DISPLAY_INDEX    46
 
+#define DISPLAY_BLINK_PERIOD_MS     500     // Half a blink, see Display_PeriodicCallback
+
 #define RADIX_POS0_ROW3_4DIGIT_DISPLAY_INDEX    19
 #define RADIX_POS1_ROW3_4DIGIT_DISPLAY_INDEX    25
 #define RADIX_POS2_ROW3_4DIGIT_DISPLAY_INDEX    31
@@ -111,6 +114,11 @@
 #define ROW2_RADIX_OFFSET   4
 #define ROW3_RADIX_OFFSET   2
 
+#define DISPLAY_STATE_DIGITS        SNAPSHOT_DIGITS
+#define DISPLAY_STATE_MSG_SIZE      34      // Packed size of a DisplayStateMsg
+#define DISPLAY_STATE_RESYNC_MS     10000   // Resend time to a state backend at least this often
+#define DISPLAY_STATE_TOLERANCE_MS  500     // Allowed timer error before resending state
+
 typedef enum brightness_levels_t
 {
     LOW_BRIGHTNESS = 30,
@@ -152,29 +160,47 @@ typedef enum timer_alarm_displayed_t
     DISPLAY_ALARM
 } TimerAlarmDisplayed;
 
-typedef struct extern_vars_t
+typedef enum display_state_code_t
+{
+    STATE_OFF,
+    STATE_SHOWTIME123,
+    STATE_SHOWTIME23,
+    STATE_SHOWTIME12,
+    STATE_SHOWTIME2,
+    STATE_SETTIME,
+    STATE_SETTIMER,
+    STATE_SETALARM,
+    STATE_SETCALIB,
+
+    NUM_DISPLAY_STATES
+} DisplayStateCode;
+
+// Everything needed to render a frame, sent instead of bitmaps to backends that render locally
+typedef struct display_state_msg_t
 {
-    uint32_t    *time_ms;
-    uint32_t    *user_time_ms;
-    uint32_t    *user_alarm_ms;
-    uint32_t    *user_timer_ms;
-    int32_t     *rtc_calib;
-    uint8_t     *digit_sel;
-    uint8_t     *digit_vals;
-    uint8_t     *diurn_radix_pos;
-    uint8_t     *semi_diurn_radix_pos;
-    ClockStatus *error_code;
-    bool        *alarm_set;
-    bool        *timer_set;
-    bool        *alarm_triggered;
-    bool        *timer_triggered;
-    bool        *show_error;
-    bool        *timer_alarm_displayed;
-} ExternVars;
+    DisplayStateCode    state_code;
+    TimeFormats         time_format;
+    uint32_t            time_ms;
+    uint32_t            user_time_ms;
+    uint32_t            user_alarm_ms;
+    uint32_t            user_timer_ms;
+    int32_t             rtc_calib;
+    uint8_t             digit_sel;
+    uint8_t             digit_vals[DISPLAY_STATE_DIGITS];
+    uint8_t             diurn_radix_pos;
+    uint8_t             semi_diurn_radix_pos;
+    ClockStatus         error_code;
+    bool                alarm_set;
+    bool                timer_set;
+    bool                alarm_triggered;
+    bool                timer_triggered;
+    bool                show_error;
+    bool                timer_alarm_displayed;
+} DisplayStateMsg;
 
 typedef struct display_t
 {
-    ExternVars  *clock_vars;
+    SnapshotPub *clock_src;     // Read once per frame
     TimeFormats time_format;
     uint8_t     brightness;
 
@@ -185,6 +211,9 @@ typedef struct display_t
     void (*setColour)(uint8_t region_id, Colour colour_id);
     void (*show)(uint8_t region_id);
     void (*hide)(uint8_t region_id);
+
+    // Optional, when set the display state is sent instead of rendered bitmaps
+    void (*setState)(DisplayStateMsg *state);
 } Display;
 
 typedef struct bitmap{
@@ -192,19 +221,6 @@ typedef struct bitmap{
     uint8_t     *p_bitmap;
     uint8_t     bitmap_size;
 } Bitmap;
-typedef enum display_state_code_t
-{
-    STATE_OFF,
-    STATE_SHOWTIME123,
-    STATE_SHOWTIME23,
-    STATE_SHOWTIME12,
-    STATE_SHOWTIME2,
-    STATE_SETTIME,
-    STATE_SETTIMER,
-    STATE_SETALARM,
-    STATE_SETCALIB,
-} DisplayStateCode;
-
 typedef struct display_state_t
 {
     DisplayStateCode state_code;
@@ -215,13 +231,13 @@ typedef struct display_state_t
 } DisplayState;
 
 typedef struct display_state_machine_t {
-    DisplayState *curr_state;
+    const DisplayState *curr_state;
     Display *ctx;
 } DisplayFSM;
 
-ClockStatus Display_Init(Display *self, ExternVars *vars);
+ClockStatus Display_Init(Display *self, SnapshotPub *src);
 void Display_Update(void);
-void Display_PeriodicCallback(void);
+void Display_PeriodicCallback(void);    // Run every DISPLAY_BLINK_PERIOD_MS
 void Display_Off(void);
 void Display_On(void);
 void Display_ToggleMode(void);
@@ -232,4 +248,11 @@ void Display_ShowTime(void);
 void Display_SetFormat(TimeFormats format);
 void Display_SetBrightness(BrightnessLevels brightness);
 void Display_SetCalib(void);
+
+// Display state messages
+ClockStatus Display_ApplyState(DisplayStateMsg *state);
+void Display_PublishState(SnapshotPub *pub, DisplayStateMsg *state);
+void Display_AdvanceState(DisplayStateMsg *state, uint32_t elapsed_ms);
+uint8_t Display_PackState(DisplayStateMsg *state, uint8_t *buf);
+ClockStatus Display_UnpackState(DisplayStateMsg *state, uint8_t *buf, uint8_t size);
 #endif  // FIRMWARE_INC_DISPLAY_H_
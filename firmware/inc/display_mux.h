@@ -0,0 +1,38 @@
+/*
+ * display_mux.h
+ * Fans the clock display out to several backends
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: Matt L.
+ */
+
+#ifndef FIRMWARE_INC_DISPLAY_MUX_H_
+#define FIRMWARE_INC_DISPLAY_MUX_H_
+
+#include "clock_types.h"
+#include "display.h"
+
+#define DISPLAY_MUX_MAX_SINKS   4
+#define DISPLAY_MUX_REGIONS     3
+
+typedef struct display_sink_stats_t
+{
+    uint32_t delivered;     // Updates passed on to the sink
+    uint32_t coalesced;     // Pending updates replaced by newer ones before the sink was due
+    uint32_t dropped;       // Updates the sink already had, never sent
+} DisplaySinkStats;
+
+typedef struct display_mux_t
+{
+    Display display;        // Give this to the clock, it forwards to every sink
+
+    uint32_t (*getTick)(void);
+} DisplayMux;
+
+ClockStatus DisplayMux_Init(DisplayMux *self);
+ClockStatus DisplayMux_AddSink(Display *sink, uint32_t min_period_ms, uint8_t *sink_id);
+void DisplayMux_Update(void);
+bool DisplayMux_Pending(void);
+ClockStatus DisplayMux_GetStats(uint8_t sink_id, DisplaySinkStats *stats);
+
+#endif  // FIRMWARE_INC_DISPLAY_MUX_H_
@@ -1,20 +1,23 @@
 #ifndef FIRMWARE_INC_DOZ_CLOCK_H_
 #define FIRMWARE_INC_DOZ_CLOCK_H_
 
-#include <rtc_module.h>
 #include "bitmaps.h"
 #include "buzzer.h"
 #include "clock_types.h"
+#include "digit_entry.h"
 #include "display.h"
 #include "event_queue.h"
+#include "flight_recorder.h"
 #include "gps.h"
 #include "rtc_module.h"
+#include "scheduler.h"
+#include "time_format.h"
 #include "time_track.h"
-#include <math.h>
 
 #define TIMER_PERIOD_MS  167
+#define UPDATE_PERIOD_MS 50     // Redraw deadline, queued events are handled as soon as they arrive
 #define MAX_DIGITS       7
-#define PM_12H_MS       (43200000 - 1)
+#define TIMER_EARLY_MS   2000   // A timer alarm this close to the timer's end counts as the end
 
 typedef struct doz_clock_t
 {
@@ -23,7 +26,7 @@ typedef struct doz_clock_t
     Gps *gps;
     Rtc *rtc;
 
-    EventId curr_event;
+    ClockEvent curr_event;
 
     bool alarm_set;
     bool alarm_triggered;
@@ -67,16 +70,14 @@ typedef struct doz_clock_state_t {
 } DozClockState;
 
 typedef struct doz_clock_state_machine_t {
-    DozClockState *curr_state;
+    const DozClockState *curr_state;
     DozClock *ctx;
 } DozClockFSM;
 
 // FSM Event Functions
 void DozClock_Init(DozClock *ctx);
 void DozClock_Update();
-void DozClock_TimerCallback();  // Called from 6 Hz timer
-void msToTrad(uint32_t time_ms, uint8_t *hr_24, uint8_t *min, uint8_t *sec);
-void msToDiurn(uint32_t time_ms, uint8_t *digit1, uint8_t *digit2, uint8_t *digit3, uint8_t *digit4, uint8_t *digit5);
-void msToSemiDiurn(uint32_t time_ms, uint8_t *digit1, uint8_t *digit2, uint8_t *digit3, uint8_t *digit4, uint8_t *digit5);
+void DozClock_TimerCallback();  // Run every TIMER_PERIOD_MS
+void DozClock_StartTasks(void); // Schedules the update, timer and display blink
 
 #endif  // FIRMWARE_INC_DOZ_CLOCK_H_
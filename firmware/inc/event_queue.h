@@ -3,7 +3,26 @@
 
 #include "clock_types.h"
 
-#define BUFFER_SIZE     5
+// Slots reserved for each class, all powers of two
+#ifndef EVENTQ_ALARM_DEPTH
+#define EVENTQ_ALARM_DEPTH      4
+#endif
+#ifndef EVENTQ_INPUT_DEPTH
+#define EVENTQ_INPUT_DEPTH      8
+#endif
+#ifndef EVENTQ_AMBIENT_DEPTH
+#define EVENTQ_AMBIENT_DEPTH    4
+#endif
+
+// Higher class events served while a lower class waits before the lower class gets one turn
+#ifndef EVENTQ_STARVE_LIMIT
+#define EVENTQ_STARVE_LIMIT     4
+#endif
+
+#define EVENTQ_IS_POW2(n)   ((n) >= 2 && ((n) & ((n) - 1)) == 0)
+#if !EVENTQ_IS_POW2(EVENTQ_ALARM_DEPTH) || !EVENTQ_IS_POW2(EVENTQ_INPUT_DEPTH) || !EVENTQ_IS_POW2(EVENTQ_AMBIENT_DEPTH)
+#error "Event queue depths must be powers of two"
+#endif
 
 typedef enum btnId
 {
@@ -39,6 +58,23 @@ typedef enum alarmEventType
     TIMER_TRIG
 } AlarmEventType;
 
+// Priority classes, highest first. An alarm waits behind at most one event of each lower class.
+typedef enum eventClass
+{
+    EVENT_CLASS_ALARM,      // Alarm and timer
+    EVENT_CLASS_INPUT,      // Buttons
+    EVENT_CLASS_AMBIENT,    // Light sensor
+
+    NUM_EVENT_CLASSES
+} EventClass;
+
+typedef struct eventQStats
+{
+    uint32_t overflow[NUM_EVENT_CLASSES];       // Events lost to a full lane
+    uint32_t high_water[NUM_EVENT_CLASSES];     // Deepest each lane has been
+    uint32_t coalesced;                         // Events merged into the one before them
+} EventQStats;
+
 typedef enum eventIdType
 {
     E_NONE,
@@ -79,15 +115,28 @@ typedef enum eventIdType
     E_VOLDOWN_SHORT,
     E_CANCEL_SHORT,
 
+    // Held btn events, only the set states use them
+    E_UP_REPEAT,
+    E_DOWN_REPEAT,
+
     NUM_EVENTS
 } EventId;
 
+typedef struct clock_event_t
+{
+    EventId     id;
+    uint32_t    timestamp_ms;   // Tick when the source raised it, 0 without a tick source
+    uint16_t    payload;        // Steps for E_UP_REPEAT and E_DOWN_REPEAT, 1 otherwise
+} ClockEvent;
+
 ClockStatus EventQ_Init();
-ClockStatus EventQ_GetEvent(EventId *event);
+void EventQ_SetTickSource(uint32_t (*getTick)(void));
+ClockStatus EventQ_GetEvent(ClockEvent *event);
+bool EventQ_Pending(void);
 ClockStatus EventQ_TriggerButtonEvent(BtnId button, BtnPressType type);
+ClockStatus EventQ_TriggerButtonRepeat(BtnId button, uint16_t steps);
 ClockStatus EventQ_TriggerLightEvent(LightEventType type);
 ClockStatus EventQ_TriggerAlarmEvent(AlarmEventType type);
-
-
+void EventQ_GetStats(EventQStats *stats);
 
 #endif  // FIRMWARE_INC_EVENT_QUEUE_H_
@@ -0,0 +1,51 @@
+/*
+ * flight_recorder.h
+ * Ring buffer of recent events, state changes and time syncs
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: Matt L.
+ */
+
+#ifndef FIRMWARE_INC_FLIGHT_RECORDER_H_
+#define FIRMWARE_INC_FLIGHT_RECORDER_H_
+
+#include "clock_types.h"
+
+#ifndef FLIGHTREC_DEPTH
+#define FLIGHTREC_DEPTH     128     // Records kept, the oldest is overwritten first
+#endif
+
+#define FLIGHTREC_VERSION   1
+#define FLIGHTREC_LINE_SIZE 26      // One dumped record, hex digits plus "\r\n"
+
+typedef enum flight_rec_type_t
+{
+    REC_BOOT,           // Recorder started, nothing before this is in the dump
+    REC_EVENT,          // code: EventId, arg: payload, value: capture timestamp
+    REC_CLOCK_STATE,    // code: DozClockStateCode entered, arg: state left
+    REC_DISPLAY_STATE,  // code: DisplayStateCode entered, arg: state left
+    REC_RTC_SYNC,       // value: time of day the internal time was set to from the RTC
+    REC_GPS_SYNC,       // value: time of day the internal time and RTC were set to from GPS
+    REC_RTC_TRIM,       // value: estimated RTC rate error in ppb, arg: calibration it dithers around
+    REC_TIME_SOURCE,    // code: TimeSource now followed, arg: the one before, value: uncertainty in us
+
+    NUM_REC_TYPES
+} FlightRecType;
+
+typedef struct flight_record_t
+{
+    uint32_t    tick_ms;
+    uint32_t    value;
+    uint16_t    arg;
+    uint8_t     code;
+    uint8_t     type;
+} FlightRecord;
+
+void FlightRec_Init(uint32_t (*getTick)(void));
+void FlightRec_Log(FlightRecType type, uint8_t code, uint16_t arg, uint32_t value);
+uint16_t FlightRec_Count(void);
+ClockStatus FlightRec_Get(uint16_t index, FlightRecord *record);
+void FlightRec_Dump(void (*write)(uint8_t *buf, uint16_t len));
+ClockStatus FlightRec_ParseLine(const char *line, FlightRecord *record);
+
+#endif  // FIRMWARE_INC_FLIGHT_RECORDER_H_
@@ -0,0 +1,36 @@
+/*
+ * fsm_table.h
+ * Declarative state/event tables kept in flash
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: Matt L.
+ *
+ * A state machine lists its actions once as A(action) and its transitions
+ * once as T(state, event, action) rows, then expands both lists with the
+ * macros below:
+ *
+ *  - FSM_ACTION_ID and FSM_ACTION_FN give a one byte id per action and a
+ *    const table of the functions, id 0 meaning no action.
+ *  - FSM_TABLE_ROW gives a const [state][event] table of action ids, so a
+ *    dispatch is one byte load and one call and the table costs no RAM.
+ *    An event a state does not list is ignored, which is the guard.
+ *  - FSM_PAIR gives an enumerator per row, so listing the same state and
+ *    event twice fails to compile.
+ *  - FSM_REQUIRE(state, event) fails to compile when that row is missing.
+ */
+
+#ifndef FIRMWARE_INC_FSM_TABLE_H_
+#define FIRMWARE_INC_FSM_TABLE_H_
+
+#include "clock_types.h"
+
+#define FSM_NO_ACTION   0
+
+#define FSM_ACTION_ID(action)               FSM_ACT_##action,
+#define FSM_ACTION_FN(action)               action,
+#define FSM_TABLE_ROW(state, event, action) [state][event] = FSM_ACT_##action,
+#define FSM_PAIR(state, event, action)      FSM_PAIR_##state##__##event,
+#define FSM_REQUIRE(state, event) \
+    _Static_assert(FSM_PAIR_##state##__##event >= 0, #state " must handle " #event);
+
+#endif  // FIRMWARE_INC_FSM_TABLE_H_
@@ -2,21 +2,44 @@
 #ifndef FIRMWARE_INC_GPS_H_
 #define FIRMWARE_INC_GPS_H_
 
+#include "clock_epoch.h"
 #include "clock_types.h"
 
+#define GPS_FIX_UNKNOWN     0xff    // The GPS has no getFix
+
 typedef struct gps_time_t {
     uint8_t hr;
     uint8_t min;
     uint8_t sec;
+    uint16_t ms;        // Fraction the sentence gave, 10 ms steps
+    bool stamped;       // at_us is set, the GPS has a microsecond stamp
+    uint32_t at_us;     // Microsecond source when the GPS's clock showed this time
+    uint8_t fix;        // GGA fix quality, 0 is no fix and the time may be the receiver's own guess
+    ClockDate date;     // From the last RMC, year 0 until there is one
 } GpsTime;
 
+typedef struct gps_pps_t {
+    bool labelled;      // ms is known for the pulse at at_us
+    uint32_t at_us;     // Microsecond source at the last pulse
+    uint32_t ms;        // Time of day the pulse marks
+    uint32_t edges;     // Pulses taken
+    uint32_t labels;    // Pulses labelled by their own sentence, the rest carry the last label on
+    uint32_t rejected;  // Pulses not a whole number of seconds after the last
+} GpsPps;
+
 typedef struct gps_t {
     float (*getUtcTime)(void);
     unsigned (*gpsConnected)(void);
+    uint32_t (*getUtcTimeUs)(void);     // Optional, microsecond source as the '$' of the first sentence with that time arrived
+    uint32_t latency_us;                // From the time a sentence gives to its '$', set per module
+    uint8_t (*getFix)(void);            // Optional, fix quality from the last GGA
+    uint32_t (*getDate)(void);          // Optional, ddmmyy from the last RMC, 0 without one
 } Gps;
 
 ClockStatus Gps_Init(Gps *self);
 ClockStatus Gps_Connected();
 GpsTime Gps_GetTime();
+void Gps_PpsEdge(uint32_t at_us);
+ClockStatus Gps_GetPps(GpsPps *output);
 
 #endif  // FIRMWARE_INC_GPS_H_
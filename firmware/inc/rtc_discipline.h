@@ -0,0 +1,46 @@
+/*
+ * rtc_discipline.h
+ * Trims the RTC calibration from the offsets measured at each GPS sync
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: Matt L.
+ */
+
+#ifndef FIRMWARE_INC_RTC_DISCIPLINE_H_
+#define FIRMWARE_INC_RTC_DISCIPLINE_H_
+
+#include "clock_types.h"
+
+#ifndef DISC_BIN_S
+#define DISC_BIN_S          86400   // Sync offsets are averaged over a day, the daily swing cancels out
+#endif
+
+#define DISC_BINS           16      // Bins the rate is fitted through, about two weeks
+#define DISC_DITHER_S       256     // Seconds between steps of the dither between the two nearest calibrations
+#define DISC_STEP_PPM       1000    // An offset bigger than 1 ms per second since the last sync means the time was changed
+
+// Tuning fork crystal, used when the RTC reports a temperature
+#define DISC_TURNOVER_C100  2500        // Temperature the crystal runs fastest at, 1/100 C
+#define DISC_CURVE_PPT      34000       // Datasheet slow-down per C^2 away from it, parts per trillion
+#define DISC_CURVE_WEIGHT   100000000   // How hard the fitted curve is held to the datasheet one
+
+typedef struct disc_stats_t
+{
+    bool        active;         // The RTC can be calibrated
+    bool        locked;         // Enough bins for a rate, the calibration is being trimmed
+    int32_t     freq_ppb;       // Free-running RTC rate error at temp_c100, positive runs fast
+    int32_t     base_ppb;       // Rate error at the turnover temperature
+    int32_t     curve_ppt;      // Fitted slow-down per C^2 away from the turnover
+    int16_t     temp_c100;      // Last crystal temperature, 1/100 C
+    int32_t     target_q8;      // Calibration being dithered, in 1/256 steps
+    int32_t     calib;          // Calibration programmed now
+    uint32_t    syncs;
+    uint32_t    restarts;       // Offsets too big to be drift, the estimate started again
+} DiscStats;
+
+ClockStatus Discipline_Init(void);
+void Discipline_Tick(void);
+ClockStatus Discipline_Measure(int32_t offset_ms);
+void Discipline_GetStats(DiscStats *output);
+
+#endif  // FIRMWARE_INC_RTC_DISCIPLINE_H_
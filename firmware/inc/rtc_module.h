@@ -1,10 +1,9 @@
 #ifndef FIRMWARE_INC_RTC_H_
 #define FIRMWARE_INC_RTC_H_
 
+#include "clock_epoch.h"
 #include "clock_types.h"
 
-#define MAX_NO_DAYS_RESET   5
-
 typedef enum AlarmStatus{
     ALARM_DISABLE   = 0,
     ALARM_ENABLE    = 1,
@@ -32,10 +31,23 @@ typedef struct rtc_t
         uint8_t *hour_24mode,
         uint8_t *minute,
         uint8_t *second);
+    void (*getTimeMs)(          // Optional, for RTCs that count inside the second
+        uint8_t *hour_24mode,
+        uint8_t *minute,
+        uint8_t *second,
+        uint16_t *millis);
+    void (*setTimeDate)(        // Optional, time, day and month in one write so nothing is left half set
+        uint8_t hour_24mode,
+        uint8_t minute,
+        uint8_t second,
+        uint8_t day,
+        uint8_t month);
     void (*setDay)(uint8_t day);
     void (*setMonth)(uint8_t month);
     uint8_t (*getDay)(void);
     uint8_t (*getMonth)(void);
+    void (*setYear)(uint16_t year);     // Optional, without it the year is EPOCH_BASE_YEAR
+    uint16_t (*getYear)(void);
     void (*setAlarm)(
         uint8_t id,
         uint8_t hour_24mode,
@@ -50,19 +62,26 @@ typedef struct rtc_t
     bool (*getAlarmStatus)(uint8_t id);
     bool (*setCalibration)(int32_t calib);
     int32_t (*getCalibration)(void);
-    int32_t max_calib;
+    int32_t max_calib;          // Largest calibration either way
+    int32_t calib_ppb;          // Rate change per calibration step, a positive calibration slows the RTC
+    bool (*getTemperature)(     // Optional, crystal temperature for RTCs that do not compensate for it
+        int16_t *centi_c);      // themselves, false until there is a reading
 
 }Rtc;
 
 ClockStatus Rtc_Init(Rtc *self);
-ClockStatus Rtc_IsValid();
 ClockStatus Rtc_SetTime(RtcTime *time);
+ClockStatus Rtc_SetTimeDate(RtcTime *time, ClockDate *date);
+ClockStatus Rtc_GetDate(ClockDate *date);
 ClockStatus Rtc_GetTime(RtcTime *time);
+ClockStatus Rtc_GetTimeMs(RtcTime *time, uint16_t *ms);
 ClockStatus Rtc_SetAlarm(RtcTime *time, AlarmId id);
 ClockStatus Rtc_GetAlarm(RtcTime *time, AlarmId id);
 ClockStatus Rtc_EnableAlarm(AlarmId id, AlarmStatus enable);
 ClockStatus Rtc_GetAlarmStatus(AlarmId id, bool *status);
 ClockStatus Rtc_SetCalibration(int32_t val);
 ClockStatus Rtc_GetCalibration(int32_t *val);
+ClockStatus Rtc_GetCalibrationStep(int32_t *step_ppb, int32_t *max);
+ClockStatus Rtc_GetTemperature(int16_t *centi_c);
 
 #endif /* FIRMWARE_INC_RTC_H_ */
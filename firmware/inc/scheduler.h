@@ -0,0 +1,73 @@
+/*
+ * scheduler.h
+ * Cooperative run-to-completion scheduler driven by a hierarchical timer wheel
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: Matt L.
+ */
+
+#ifndef FIRMWARE_INC_SCHEDULER_H_
+#define FIRMWARE_INC_SCHEDULER_H_
+
+#include "clock_types.h"
+
+#define SCHED_WHEEL_BITS        6       // 64 slots per level
+#define SCHED_WHEEL_LEVELS      3       // 1 ms, 64 ms and 4096 ms slots, about 4.4 min before re-cascading
+#define SCHED_WHEEL_SLOTS       (1UL << SCHED_WHEEL_BITS)
+#define SCHED_WHEEL_SPAN        (1UL << (SCHED_WHEEL_BITS * SCHED_WHEEL_LEVELS))
+
+#ifndef SCHED_LOAD_WINDOW_MS
+#define SCHED_LOAD_WINDOW_MS    1000    // CPU load is reported over this window
+#endif
+
+#ifndef SCHED_MAX_SLEEP_MS
+#define SCHED_MAX_SLEEP_MS      100     // Longest single sleep, bounds how late a missed wake-up can be
+#endif
+
+#define SCHED_MAX_WATCHED       4       // Tasks with a ready check
+
+// Owned by the caller, usually a static next to the code it runs. Only name, run, period_ms and ready are set by hand.
+typedef struct sched_task_t
+{
+    const char  *name;
+    void        (*run)(void);
+    uint32_t    period_ms;          // 0 runs once per Sched_Start
+    bool        (*ready)(void);     // Optional, runs early whenever this is true, e.g. events are queued
+
+    // Scheduler state
+    uint32_t    due_ms;
+    bool        armed;
+    struct sched_task_t *next;
+    struct sched_task_t **pprev;    // The pointer to this task in its slot list, NULL when not queued
+
+    // Runtime accounting, microseconds when the scheduler has a microsecond source
+    uint32_t    runs;
+    uint32_t    late;               // Started after the next period was already due
+    uint64_t    busy_us;
+    uint32_t    max_us;
+} SchedTask;
+
+typedef struct sched_stats_t
+{
+    uint16_t    load_permille;      // Time spent in tasks over the last full window
+    uint16_t    peak_permille;      // Highest load_permille seen
+    uint32_t    runs;
+    uint32_t    late;
+
+    // Idle, sleep_permille is over the same window as load_permille and the rest is awake
+    uint16_t    sleep_permille;
+    uint32_t    sleeps;
+    uint64_t    sleep_us;
+} SchedStats;
+
+void Sched_Init(uint32_t (*getTick)(void), uint32_t (*getUs)(void));
+ClockStatus Sched_Start(SchedTask *task, uint32_t delay_ms);
+void Sched_Cancel(SchedTask *task);
+void Sched_Run(void);
+void Sched_SetSleep(void (*sleep)(uint32_t max_ms));
+uint32_t Sched_IdleMs(uint32_t max_ms);
+bool Sched_Ready(void);
+void Sched_Idle(void);
+void Sched_GetStats(SchedStats *output);
+
+#endif  // FIRMWARE_INC_SCHEDULER_H_
@@ -0,0 +1,20 @@
+/*
+ * time_format.h
+ * Conversions from milliseconds into displayed time digits
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: Matt L.
+ */
+
+#ifndef FIRMWARE_INC_TIME_FORMAT_H_
+#define FIRMWARE_INC_TIME_FORMAT_H_
+
+#include "clock_types.h"
+
+#define PM_12H_MS       (43200000 - 1)
+
+void msToTrad(uint32_t time_ms, uint8_t *hr_24, uint8_t *min, uint8_t *sec);
+void msToDiurn(uint32_t time_ms, uint8_t *digit1, uint8_t *digit2, uint8_t *digit3, uint8_t *digit4, uint8_t *digit5);
+void msToSemiDiurn(uint32_t time_ms, uint8_t *digit1, uint8_t *digit2, uint8_t *digit3, uint8_t *digit4, uint8_t *digit5);
+
+#endif  // FIRMWARE_INC_TIME_FORMAT_H_
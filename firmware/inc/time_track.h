@@ -8,18 +8,52 @@
 #ifndef FIRMWARE_INC_TIME_TRACK_H_
 #define FIRMWARE_INC_TIME_TRACK_H_
 
+#include "clock_epoch.h"
 #include "clock_types.h"
 #include "gps.h"
 #include "rtc_module.h"
 
 #define TIME_24H_MS      86400000
+#define TIME_UNCERT_UNKNOWN     UINT32_MAX  // Never synced, or synced too long ago to bound
 
+typedef struct time_slew_t
+{
+    int32_t     residual_us;    // Still to take out, positive while the shown time is ahead of the RTC
+    uint32_t    slews;          // Corrections taken out gradually
+    uint32_t    steps;          // Corrections too big to slew
+} TimeSlew;
+
+typedef enum time_source_t
+{
+    TIME_SRC_RTC,       // The RTC as it was set, nothing to check it against yet
+    TIME_SRC_GPS,       // The RTC, synced from GPS on schedule
+    TIME_SRC_PPS,       // The GPS's pulses
+    TIME_SRC_HOLDOVER,  // The RTC, the GPS it was synced from has since been lost or rejected
+} TimeSource;
+
+typedef struct time_quality_t
+{
+    TimeSource  source;
+    uint32_t    uncertainty_us;     // Bound on the error of the time kept, grows from the last sync at the RTC's rate
+    uint32_t    since_sync_s;       // RTC seconds since the last pulse or accepted sync
+    uint32_t    syncs;              // GPS readings accepted
+    uint32_t    no_fix;             // Readings rejected, the receiver had no fix
+    uint32_t    stale;              // Readings rejected, the sentence was too old
+    uint32_t    outliers;           // Readings too far from the time kept, a run that agree is accepted anyway
+} TimeQuality;
+
+void TimeTrack_SetUsSource(uint32_t (*getUs)(void));
 ClockStatus TimeTrack_Init();
 ClockStatus TimeTrack_SyncToRtc();
 ClockStatus TimeTrack_Update();
+ClockStatus TimeTrack_Probe();
+void TimeTrack_SecondEdge(uint32_t at_us);
+ClockStatus TimeTrack_NextEdgeMs(uint32_t *delay_ms);
 ClockStatus TimeTrack_PeriodicCallback(uint32_t period_ms);
 ClockStatus TimeTrack_GetTimeMs(uint32_t *output_ms);
-
-void msToRtcTime(uint32_t time_ms, RtcTime *time);
+ClockStatus TimeTrack_GetEpochMs(EpochMs *output_ms);
+void TimeTrack_GetDate(ClockDate *output);
+void TimeTrack_GetSlew(TimeSlew *output);
+void TimeTrack_GetQuality(TimeQuality *output);
 
 #endif /* FIRMWARE_INC_TIME_TRACK_H_ */
@@ -0,0 +1,465 @@
+/*
+ * chrono_link.c
+ * Reliable framing for the chrono display link
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: Matt L.
+ *
+ * Each channel holds the latest state for one kind of message (e.g. the
+ * bitmap of one region). Frames carry a sequence number and the oldest
+ * sequence number the sender still needs, so state replaced before it was
+ * acknowledged is never resent and the receiver skips its gap.
+ *
+ * A receiver that restarts sends RESET_CODE and the sender queues every
+ * state it holds again from sequence number 0.
+ */
+
+#include "chrono_link.h"
+
+/*
+    Private types
+*/
+typedef struct tx_channel_t
+{
+    uint8_t     code;
+    uint8_t     payload[CHRONO_MAX_PAYLOAD];
+    uint8_t     len;
+    uint8_t     seq;
+    bool        queued;     // Waiting for window space or credit
+    bool        in_flight;  // Sent, not acknowledged yet
+    uint32_t    sent_ms;
+} TxChannel;
+
+/*
+    Private function definitions
+*/
+static void sendFrame(TxChannel *channel);
+static void sendAck(void);
+static void sendControl(uint8_t code);
+static void writeFrame(uint8_t *raw, uint8_t len);
+static void processFrame(uint8_t *raw, uint8_t len);
+static void handleAck(uint8_t ack_seq, uint8_t credit_adv);
+static void handleReset(void);
+static void handleData(uint8_t code, uint8_t seq, uint8_t base, uint8_t *payload, uint8_t len);
+static uint8_t windowBase(void);
+static uint8_t seqDist(uint8_t from, uint8_t to);
+static uint8_t crc8(uint8_t *buf, uint8_t len);
+
+/*
+    Private variables
+*/
+static ChronoLink *g_link = NULL;
+static ChronoLinkStats stats;
+
+// Sender
+static TxChannel tx_channels[CHRONO_NUM_CHANNELS];
+static uint8_t next_seq, credit, in_flight, last_ack, dup_acks;
+static uint32_t last_tx_ms;
+
+// Receiver
+static uint8_t rx_expected;
+static uint32_t rx_mask;    // Bit n set when rx_expected + n was received
+static uint8_t rx_raw[CHRONO_MAX_RAW_FRAME];
+static uint8_t rx_len;
+static bool rx_in_frame, rx_escape;
+
+/*
+    Public functions
+*/
+ClockStatus ChronoLink_Init(ChronoLink *self)
+{
+    if (self->transmit == NULL)
+    {
+        return CLOCK_FAIL;
+    }
+    g_link = self;
+    if (g_link->rto_ms == 0)
+    {
+        g_link->rto_ms = CHRONO_DEFAULT_RTO_MS;
+    }
+    memset(&stats, 0, sizeof(stats));
+    memset(tx_channels, 0, sizeof(tx_channels));
+    next_seq = 0;
+    credit = CHRONO_WINDOW;
+    in_flight = 0;
+    last_ack = 0;
+    dup_acks = 0;
+    last_tx_ms = 0;
+    rx_expected = 0;
+    rx_mask = 0;
+    rx_len = 0;
+    rx_in_frame = false;
+    rx_escape = false;
+    return CLOCK_OK;
+}
+
+// Replace the state held for a channel, any unacknowledged older state is dropped
+ClockStatus ChronoLink_Submit(uint8_t channel, uint8_t code, uint8_t *payload, uint8_t len, uint32_t now_ms)
+{
+    if (g_link == NULL || channel >= CHRONO_NUM_CHANNELS || len > CHRONO_MAX_PAYLOAD)
+    {
+        return CLOCK_FAIL;
+    }
+    // payload may be NULL when len is 0, it is not touched then
+    if (tx_channels[channel].code == code && tx_channels[channel].len == len &&
+        (len == 0 || memcmp(tx_channels[channel].payload, payload, len) == 0))
+    {
+        // Same state is already sent or waiting to be, resending it would only restart delivery
+        return CLOCK_OK;
+    }
+    ChronoLink_Supersede(channel);
+    tx_channels[channel].code = code;
+    if (len > 0)
+    {
+        memcpy(tx_channels[channel].payload, payload, len);
+    }
+    tx_channels[channel].len = len;
+    tx_channels[channel].queued = true;
+    ChronoLink_Poll(now_ms);
+    return CLOCK_OK;
+}
+
+// Forget the state held for a channel, e.g. when a message for all regions replaces it
+void ChronoLink_Supersede(uint8_t channel)
+{
+    if (channel >= CHRONO_NUM_CHANNELS)
+    {
+        return;
+    }
+    if (tx_channels[channel].in_flight)
+    {
+        tx_channels[channel].in_flight = false;
+        in_flight--;
+        stats.dropped++;
+    }
+    tx_channels[channel].queued = false;
+    tx_channels[channel].code = 0;  // The display no longer shows it, next submit must be sent
+}
+
+void ChronoLink_Poll(uint32_t now_ms)
+{
+    if (g_link == NULL)
+    {
+        return;
+    }
+
+    // Resend the latest state of anything not acknowledged in time
+    for (int i = 0; i < CHRONO_NUM_CHANNELS; i++)
+    {
+        if (tx_channels[i].in_flight && now_ms - tx_channels[i].sent_ms >= g_link->rto_ms)
+        {
+            tx_channels[i].sent_ms = now_ms;
+            sendFrame(&tx_channels[i]);
+            stats.retransmitted++;
+            last_tx_ms = now_ms;
+        }
+    }
+
+    // Probe for credit if an ACK carrying it was lost
+    if (credit == 0 && in_flight == 0 && now_ms - last_tx_ms >= g_link->rto_ms)
+    {
+        credit = 1;
+    }
+
+    // Nothing more than a receive window past the oldest frame in flight, or the receiver could not tell it from a resend
+    for (int i = 0; i < CHRONO_NUM_CHANNELS && credit > 0 && in_flight < CHRONO_WINDOW; i++)
+    {
+        if (tx_channels[i].queued && seqDist(windowBase(), next_seq) < CHRONO_RX_WINDOW)
+        {
+            tx_channels[i].queued = false;
+            tx_channels[i].in_flight = true;
+            tx_channels[i].seq = next_seq;
+            tx_channels[i].sent_ms = now_ms;
+            next_seq = (next_seq + 1) % CHRONO_SEQ_MOD;
+            in_flight++;
+            credit--;
+            sendFrame(&tx_channels[i]);
+            stats.sent++;
+            last_tx_ms = now_ms;
+        }
+    }
+}
+
+void ChronoLink_ReceiveByte(uint8_t c)
+{
+    if (c == START_CODE)
+    {
+        rx_in_frame = true;
+        rx_escape = false;
+        rx_len = 0;
+    }
+    else if (!rx_in_frame)
+    {
+        if (c == END_CODE && g_link != NULL && g_link->peerWaiting != NULL)
+        {
+            g_link->peerWaiting();
+        }
+    }
+    else if (c == END_CODE)
+    {
+        rx_in_frame = false;
+        if (rx_len > 0)
+        {
+            processFrame(rx_raw, rx_len);
+        }
+    }
+    else if (c == ESCAPE_CODE)
+    {
+        rx_escape = true;
+    }
+    else if (rx_len >= CHRONO_MAX_RAW_FRAME)
+    {
+        rx_in_frame = false;
+        stats.rejected++;
+    }
+    else
+    {
+        rx_raw[rx_len++] = rx_escape ? (c ^ ESCAPE_MASK) : c;
+        rx_escape = false;
+    }
+}
+
+// Receiving end, call when it starts so the sender resends everything the display lost
+void ChronoLink_Reset(void)
+{
+    if (g_link == NULL)
+    {
+        return;
+    }
+    rx_expected = 0;
+    rx_mask = 0;
+    rx_in_frame = false;
+    sendControl(RESET_CODE);
+}
+
+void ChronoLink_GetStats(ChronoLinkStats *output)
+{
+    *output = stats;
+}
+
+uint8_t ChronoLink_InFlight(void)
+{
+    return in_flight;
+}
+
+/*
+    Private functions
+*/
+static void sendFrame(TxChannel *channel)
+{
+    uint8_t raw[CHRONO_MAX_RAW_FRAME];
+
+    raw[0] = channel->code;
+    raw[1] = channel->seq;
+    raw[2] = windowBase();
+    memcpy(&raw[CHRONO_HEADER_SIZE], channel->payload, channel->len);
+    raw[CHRONO_HEADER_SIZE + channel->len] = crc8(raw, CHRONO_HEADER_SIZE + channel->len);
+    writeFrame(raw, CHRONO_HEADER_SIZE + channel->len + 1);
+}
+
+static void sendAck(void)
+{
+    sendControl(ACK_CODE);
+}
+
+// ACK and RESET carry the next sequence number expected and the credit
+static void sendControl(uint8_t code)
+{
+    uint8_t raw[4];
+
+    raw[0] = code;
+    raw[1] = rx_expected;
+    raw[2] = (g_link->getCredit != NULL) ? g_link->getCredit() : CHRONO_WINDOW;
+    raw[3] = crc8(raw, 3);
+    writeFrame(raw, sizeof(raw));
+}
+
+static void writeFrame(uint8_t *raw, uint8_t len)
+{
+    uint8_t frame[CHRONO_MAX_FRAME];
+    uint16_t size = 0;
+
+    frame[size++] = START_CODE;
+    for (int i = 0; i < len; i++)
+    {
+        if (raw[i] == START_CODE || raw[i] == END_CODE || raw[i] == ESCAPE_CODE)
+        {
+            frame[size++] = ESCAPE_CODE;
+            frame[size++] = raw[i] ^ ESCAPE_MASK;
+        }
+        else
+        {
+            frame[size++] = raw[i];
+        }
+    }
+    frame[size++] = END_CODE;
+    g_link->transmit(frame, size);
+}
+
+static void processFrame(uint8_t *raw, uint8_t len)
+{
+    if (len < 4 || crc8(raw, len - 1) != raw[len - 1])
+    {
+        stats.rejected++;
+        return;
+    }
+    if (raw[0] == ACK_CODE && len == 4)
+    {
+        handleAck(raw[1], raw[2]);
+    }
+    else if (raw[0] == RESET_CODE && len == 4)
+    {
+        handleReset();
+    }
+    else if (raw[1] < CHRONO_SEQ_MOD && raw[2] < CHRONO_SEQ_MOD)
+    {
+        handleData(raw[0], raw[1], raw[2], &raw[CHRONO_HEADER_SIZE], len - CHRONO_HEADER_SIZE - 1);
+    }
+    else
+    {
+        stats.rejected++;
+    }
+}
+
+static void handleAck(uint8_t ack_seq, uint8_t credit_adv)
+{
+    uint8_t base = windowBase();
+    bool progress = false;
+
+    // Only from the oldest frame in flight up to the next one to send, anything else
+    // comes from a receiver that lost its place and would acknowledge frames it never had
+    if (seqDist(base, ack_seq) > seqDist(base, next_seq))
+    {
+        stats.rejected++;
+        return;
+    }
+
+    for (int i = 0; i < CHRONO_NUM_CHANNELS; i++)
+    {
+        // Everything before ack_seq has been received
+        if (tx_channels[i].in_flight && seqDist(base, tx_channels[i].seq) < seqDist(base, ack_seq))
+        {
+            tx_channels[i].in_flight = false;
+            in_flight--;
+            stats.acked++;
+            progress = true;
+        }
+    }
+
+    if (!progress && ack_seq == last_ack && in_flight > 0)
+    {
+        dup_acks++;
+        if (dup_acks >= CHRONO_DUP_ACKS)
+        {
+            // Receiver keeps asking for ack_seq, resend it straight away
+            dup_acks = 0;
+            for (int i = 0; i < CHRONO_NUM_CHANNELS; i++)
+            {
+                if (tx_channels[i].in_flight && tx_channels[i].seq == ack_seq)
+                {
+                    sendFrame(&tx_channels[i]);
+                    stats.retransmitted++;
+                }
+            }
+        }
+    }
+    else
+    {
+        dup_acks = 0;
+    }
+    last_ack = ack_seq;
+    credit = (credit_adv > in_flight) ? credit_adv - in_flight : 0;
+}
+
+static void handleData(uint8_t code, uint8_t seq, uint8_t base, uint8_t *payload, uint8_t len)
+{
+    uint8_t skip = seqDist(rx_expected, base);
+    uint8_t ahead = seqDist(rx_expected, seq);
+
+    if (ahead >= CHRONO_RX_WINDOW)
+    {
+        // Outside the window, one end restarted or ACKs were lost. Start again from the sender's
+        // base, what it resends is the latest state of its channel so applying it twice is harmless.
+        rx_expected = base;
+        rx_mask = 0;
+        stats.resyncs++;
+    }
+    else if (skip > 0 && skip < CHRONO_RX_WINDOW)
+    {
+        // Sender no longer needs anything before base, stop waiting for it
+        rx_mask >>= skip;
+        rx_expected = base;
+    }
+
+    ahead = seqDist(rx_expected, seq);
+    if (ahead >= CHRONO_RX_WINDOW || (rx_mask & (1UL << ahead)))
+    {
+        // Already delivered, applying it again could undo newer state
+        stats.duplicates++;
+    }
+    else
+    {
+        rx_mask |= 1UL << ahead;
+        stats.received++;
+        if (g_link->deliver != NULL)
+        {
+            g_link->deliver(code, payload, len);
+        }
+    }
+
+    while (rx_mask & 1)
+    {
+        rx_mask >>= 1;
+        rx_expected = (rx_expected + 1) % CHRONO_SEQ_MOD;
+    }
+    sendAck();
+}
+
+// The receiver restarted and shows nothing, start the sequence again with every state held
+static void handleReset(void)
+{
+    for (int i = 0; i < CHRONO_NUM_CHANNELS; i++)
+    {
+        tx_channels[i].in_flight = false;
+        tx_channels[i].queued = (tx_channels[i].code != 0);
+    }
+    next_seq = 0;
+    in_flight = 0;
+    credit = CHRONO_WINDOW;
+    last_ack = 0;
+    dup_acks = 0;
+    stats.resets++;
+}
+
+// Oldest sequence number still in flight, or the next one if nothing is
+static uint8_t windowBase(void)
+{
+    uint8_t base = next_seq;
+    for (int i = 0; i < CHRONO_NUM_CHANNELS; i++)
+    {
+        if (tx_channels[i].in_flight && seqDist(tx_channels[i].seq, next_seq) > seqDist(base, next_seq))
+        {
+            base = tx_channels[i].seq;
+        }
+    }
+    return base;
+}
+
+static uint8_t seqDist(uint8_t from, uint8_t to)
+{
+    return (to + CHRONO_SEQ_MOD - from) % CHRONO_SEQ_MOD;
+}
+
+static uint8_t crc8(uint8_t *buf, uint8_t len)
+{
+    uint8_t crc = 0;
+    for (int i = 0; i < len; i++)
+    {
+        crc ^= buf[i];
+        for (int bit = 0; bit < 8; bit++)
+        {
+            crc = (crc & 0x80) ? (crc << 1) ^ 0x07 : crc << 1;
+        }
+    }
+    return crc;
+}
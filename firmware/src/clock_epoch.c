@@ -0,0 +1,117 @@
+/*
+ * clock_epoch.c
+ * Milliseconds since 2000-01-01 00:00, with time of day and calendar views
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: Matt L.
+ *
+ * The time is kept as one count that never wraps, so anything due a day or
+ * more away is just a bigger number. Time of day and the calendar date are
+ * worked out from it when they are shown or written to the hardware. Dates
+ * go to and from a day count with years that start in March, which puts the
+ * leap day at the end of the year and makes every month but February a
+ * fixed pattern.
+ */
+
+#include "clock_epoch.h"
+
+#define DAYS_TO_EPOCH   730425      // From 0000-03-01 to 2000-01-01
+#define DAYS_PER_ERA    146097      // 400 years
+
+/*
+    Private function definitions
+*/
+static uint32_t daysFromDate(uint16_t year, uint8_t month, uint8_t day);
+static uint8_t daysInMonth(uint16_t year, uint8_t month);
+
+/*
+    Public functions
+*/
+// The date must pass Epoch_CheckDate
+EpochMs Epoch_FromDate(const ClockDate *date, uint32_t time_ms)
+{
+    return (EpochMs)daysFromDate(date->year, date->month, date->day) * EPOCH_DAY_MS + time_ms;
+}
+
+void Epoch_ToDate(EpochMs epoch_ms, ClockDate *date)
+{
+    uint32_t days = (uint32_t)(epoch_ms / EPOCH_DAY_MS) + DAYS_TO_EPOCH;
+    uint32_t era = days / DAYS_PER_ERA;
+    uint32_t day_of_era = days - era * DAYS_PER_ERA;
+    uint32_t year_of_era = (day_of_era - day_of_era / 1460 + day_of_era / 36524 - day_of_era / 146096) / 365;
+    uint32_t day_of_year = day_of_era - (365 * year_of_era + year_of_era / 4 - year_of_era / 100);
+    uint32_t month_from_march = (5 * day_of_year + 2) / 153;
+
+    date->day = day_of_year - (153 * month_from_march + 2) / 5 + 1;
+    date->month = (month_from_march < 10) ? month_from_march + 3 : month_from_march - 9;
+    date->year = era * 400 + year_of_era + (date->month <= 2);
+}
+
+uint32_t Epoch_TimeOfDay(EpochMs epoch_ms)
+{
+    return (uint32_t)(epoch_ms % EPOCH_DAY_MS);
+}
+
+// The time time_ms of day closest to near_ms, the day before or after when that is nearer
+EpochMs Epoch_Nearest(EpochMs near_ms, uint32_t time_ms)
+{
+    EpochMs at_ms = near_ms - near_ms % EPOCH_DAY_MS + time_ms;
+
+    if (at_ms > near_ms + EPOCH_DAY_MS / 2 && at_ms >= EPOCH_DAY_MS)
+    {
+        at_ms -= EPOCH_DAY_MS;
+    }
+    else if (at_ms + EPOCH_DAY_MS / 2 < near_ms)
+    {
+        at_ms += EPOCH_DAY_MS;
+    }
+    return at_ms;
+}
+
+// Fails for dates the RTCs cannot hold and days past the end of the month
+ClockStatus Epoch_CheckDate(const ClockDate *date)
+{
+    if (date->year < EPOCH_BASE_YEAR || date->year > EPOCH_LAST_YEAR || date->month < 1 || date->month > 12
+        || date->day < 1 || date->day > daysInMonth(date->year, date->month))
+    {
+        return CLOCK_FAIL;
+    }
+    return CLOCK_OK;
+}
+
+// The RTC and GPS give the time of day as hours, minutes and seconds, converted here and nowhere else
+uint32_t Epoch_HmsToMs(uint8_t hr, uint8_t min, uint8_t sec)
+{
+    return (uint32_t)hr * 3600000 + (uint32_t)min * 60000 + (uint32_t)sec * 1000;
+}
+
+void Epoch_MsToHms(uint32_t time_ms, uint8_t *hr, uint8_t *min, uint8_t *sec)
+{
+    time_ms = time_ms % EPOCH_DAY_MS / 1000;
+    *sec = time_ms % 60;
+    time_ms /= 60;
+    *min = time_ms % 60;
+    *hr = time_ms / 60;
+}
+
+/*
+    Private functions
+*/
+uint32_t daysFromDate(uint16_t year, uint8_t month, uint8_t day)
+{
+    uint32_t era, year_of_era, day_of_year;
+
+    year -= (month <= 2);
+    era = year / 400;
+    year_of_era = year - era * 400;
+    day_of_year = (153 * ((month > 2) ? month - 3 : month + 9) + 2) / 5 + day - 1;
+    return era * DAYS_PER_ERA + year_of_era * 365 + year_of_era / 4 - year_of_era / 100 + day_of_year - DAYS_TO_EPOCH;
+}
+
+uint8_t daysInMonth(uint16_t year, uint8_t month)
+{
+    static const uint8_t days[12] = { 31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31 };
+    bool leap = (year % 4 == 0 && year % 100 != 0) || year % 400 == 0;
+
+    return days[month - 1] + (month == 2 && leap);
+}
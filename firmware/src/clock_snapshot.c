@@ -0,0 +1,60 @@
+/*
+ * clock_snapshot.c
+ * Clock values published whole for the display to render from
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: Matt L.
+ *
+ * A sequence lock. The writer makes seq odd, copies the values in and makes
+ * it even again. A reader copies the values out between two reads of seq
+ * and tries again if they differ or were odd, so it never sees half an
+ * update and never blocks the writer. Publishing values that have not
+ * changed leaves seq alone, so seq also works as a key for "nothing new".
+ *
+ * A reader must not run at a higher priority than the writer, it would spin
+ * on an odd seq that can never finish.
+ */
+
+#include "clock_snapshot.h"
+
+/*
+    Public functions
+*/
+void Snapshot_Init(SnapshotPub *pub)
+{
+    memset(&pub->data, 0, sizeof(pub->data));
+    __atomic_store_n(&pub->seq, 0, __ATOMIC_RELEASE);
+}
+
+// Writer only, returns the sequence number the values are readable under
+uint32_t Snapshot_Publish(SnapshotPub *pub, const ClockSnapshot *snap)
+{
+    uint32_t seq = pub->seq;
+
+    // Only the writer changes data, no lock needed to compare against it
+    if (memcmp(&pub->data, snap, sizeof(*snap)) == 0)
+    {
+        return seq;
+    }
+    __atomic_store_n(&pub->seq, seq + 1, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+    memcpy(&pub->data, snap, sizeof(*snap));
+    __atomic_store_n(&pub->seq, seq + 2, __ATOMIC_RELEASE);
+    return seq + 2;
+}
+
+// Returns the sequence number of the copy taken, equal numbers mean equal values
+uint32_t Snapshot_Read(SnapshotPub *pub, ClockSnapshot *output)
+{
+    uint32_t before, after;
+
+    do
+    {
+        before = __atomic_load_n(&pub->seq, __ATOMIC_ACQUIRE);
+        memcpy(output, &pub->data, sizeof(*output));
+        __atomic_thread_fence(__ATOMIC_ACQUIRE);
+        after = __atomic_load_n(&pub->seq, __ATOMIC_RELAXED);
+    } while ((before & 1) || before != after);
+
+    return before;
+}
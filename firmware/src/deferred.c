@@ -0,0 +1,155 @@
+/*
+ * deferred.c
+ * Work posted from interrupts and run later from the main loop
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: Matt L.
+ *
+ * An interrupt handler keeps only what it must capture straight away and
+ * posts the rest here, e.g. the I2C reads behind an RTC alarm pin or the
+ * parse of a finished NMEA sentence. Posting sets the item's bit in one
+ * pending word, so it takes a few cycles and never blocks. The main loop
+ * takes a snapshot of the word and runs up to DEFER_BATCH items, lowest id
+ * first, measuring how long each waited.
+ */
+
+#include "deferred.h"
+
+/*
+    Private function definitions
+*/
+static uint32_t atomicOr(volatile uint32_t *addr, uint32_t bits);
+static uint32_t atomicAnd(volatile uint32_t *addr, uint32_t bits);
+
+/*
+    Private variables
+*/
+static DeferWork *items[DEFER_MAX_WORK];
+static uint8_t num_items;
+static volatile uint32_t pending;
+static uint32_t (*get_us)(void) = NULL;
+
+/*
+    Public functions
+*/
+// getUs is optional, without it nothing is timed
+ClockStatus Defer_Init(uint32_t (*getUs)(void))
+{
+    get_us = getUs;
+    num_items = 0;
+    pending = 0;
+    return CLOCK_OK;
+}
+
+// Call before the interrupt that posts it is enabled
+ClockStatus Defer_Register(DeferWork *work)
+{
+    if (work == NULL || work->run == NULL || num_items >= DEFER_MAX_WORK)
+    {
+        return CLOCK_FAIL;
+    }
+    work->id = num_items;
+    work->runs = 0;
+    work->merged = 0;
+    work->max_latency_us = 0;
+    work->total_latency_us = 0;
+    items[num_items++] = work;
+    return CLOCK_OK;
+}
+
+// Safe from any interrupt. Posting again before it runs gives one run with the newest arg.
+ClockStatus Defer_Post(DeferWork *work, uint32_t arg)
+{
+    uint32_t bit;
+
+    if (work->id >= num_items || items[work->id] != work)
+    {
+        return CLOCK_FAIL;
+    }
+    bit = 1UL << work->id;
+    work->arg = arg;
+    if (atomicOr(&pending, bit) & bit)
+    {
+        work->merged++;
+    }
+    else
+    {
+        work->posted_us = (get_us != NULL) ? get_us() : 0;
+    }
+    return CLOCK_OK;
+}
+
+bool Defer_Pending(void)
+{
+    return __atomic_load_n(&pending, __ATOMIC_ACQUIRE) != 0;
+}
+
+// Main loop only. Anything left after DEFER_BATCH items stays pending for the next pass.
+void Defer_Run(void)
+{
+    uint32_t snapshot = __atomic_load_n(&pending, __ATOMIC_ACQUIRE);
+    uint32_t latency_us;
+    DeferWork *work;
+
+    for (int i = 0, done = 0; i < num_items && done < DEFER_BATCH && snapshot != 0; i++)
+    {
+        if (!(snapshot & (1UL << i)))
+        {
+            continue;
+        }
+        snapshot &= ~(1UL << i);
+        work = items[i];
+
+        // Clear first, a post that lands while it runs runs it again
+        atomicAnd(&pending, ~(1UL << i));
+        if (get_us != NULL)
+        {
+            latency_us = get_us() - work->posted_us;
+            work->total_latency_us += latency_us;
+            if (latency_us > work->max_latency_us)
+            {
+                work->max_latency_us = latency_us;
+            }
+        }
+        work->runs++;
+        work->run(work->arg);
+        done++;
+    }
+}
+
+/*
+    Private functions
+*/
+#if defined(__ARM_ARCH_6M__)
+// Cortex-M0 has no exclusive access instructions, mask interrupts for the read and write instead
+uint32_t atomicOr(volatile uint32_t *addr, uint32_t bits)
+{
+    uint32_t primask, old;
+    __asm volatile ("mrs %0, primask\n\tcpsid i" : "=r" (primask) :: "memory");
+    old = *addr;
+    *addr = old | bits;
+    __asm volatile ("msr primask, %0" :: "r" (primask) : "memory");
+    return old;
+}
+
+uint32_t atomicAnd(volatile uint32_t *addr, uint32_t bits)
+{
+    uint32_t primask, old;
+    __asm volatile ("mrs %0, primask\n\tcpsid i" : "=r" (primask) :: "memory");
+    old = *addr;
+    *addr = old & bits;
+    __asm volatile ("msr primask, %0" :: "r" (primask) : "memory");
+    return old;
+}
+#else
+// Cortex-M3/M4 builds these from LDREX/STREX, host builds and tests use the compiler's own
+uint32_t atomicOr(volatile uint32_t *addr, uint32_t bits)
+{
+    return __atomic_fetch_or(addr, bits, __ATOMIC_ACQ_REL);
+}
+
+uint32_t atomicAnd(volatile uint32_t *addr, uint32_t bits)
+{
+    return __atomic_fetch_and(addr, bits, __ATOMIC_ACQ_REL);
+}
+#endif
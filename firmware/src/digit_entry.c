@@ -0,0 +1,157 @@
+/*
+ * digit_entry.c
+ * Digit by digit entry of a time in any display format
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: Matt L.
+ *
+ * Each format is one row of the table below: how far each position counts
+ * before it wraps, the one coupling rule between the hours digits and how
+ * the digits add up to milliseconds. Stepping a digit wraps it in its own
+ * radix, then the coupling pulls the hours units back into range and keeps
+ * 12 o'clock on PM. Nothing carries into the neighbouring digit, each one
+ * is set on its own like the display shows it. Timers are not a time of
+ * day, their traditional row counts hours up to 99 so they can run for days.
+ *
+ * The dozenal units are exact fractions, 1/12^5 of a day is 3125/9 ms and
+ * 1/(2*12^4) is 6250/3 ms, so composing stays in integers.
+ */
+
+#include "digit_entry.h"
+
+#define HOUR_MS     3600000
+
+/*
+    Private variables
+*/
+static const DigitEntryFormat formats[] = {
+    [TRAD_24H] = {
+        .num_digits     = 6,
+        .radix          = {3, 10, 6, 10, 6, 10},
+        .tens_top       = 2,
+        .units_radix    = 4,
+        .meridiem       = false,
+        .weight         = {10 * HOUR_MS, HOUR_MS, 600000, 60000, 10000, 1000},
+        .unit_num       = 1,
+        .unit_den       = 1,
+    },
+    [TRAD_12H] = {
+        .num_digits     = 7,
+        .radix          = {2, 10, 6, 10, 6, 10, 2},
+        .tens_top       = 1,
+        .units_radix    = 3,
+        .meridiem       = true,
+        .weight         = {10 * HOUR_MS, HOUR_MS, 600000, 60000, 10000, 1000},
+        .unit_num       = 1,
+        .unit_den       = 1,
+    },
+    [DOZ_DRN4] = {
+        .num_digits     = 4,
+        .radix          = {12, 12, 12, 12},
+        .tens_top       = ENTRY_NO_COUPLING,
+        .weight         = {20736, 1728, 144, 12},
+        .unit_num       = 3125,
+        .unit_den       = 9,
+    },
+    [DOZ_DRN5] = {
+        .num_digits     = 5,
+        .radix          = {12, 12, 12, 12, 12},
+        .tens_top       = ENTRY_NO_COUPLING,
+        .weight         = {20736, 1728, 144, 12, 1},
+        .unit_num       = 3125,
+        .unit_den       = 9,
+    },
+    [DOZ_SEMI] = {
+        .num_digits     = 5,
+        .radix          = {2, 12, 12, 12, 12},
+        .tens_top       = ENTRY_NO_COUPLING,
+        .weight         = {20736, 1728, 144, 12, 1},
+        .unit_num       = 6250,
+        .unit_den       = 3,
+    },
+};
+
+static const DigitEntryFormat trad_timer = {
+    .num_digits     = 6,
+    .radix          = {10, 10, 6, 10, 6, 10},
+    .tens_top       = ENTRY_NO_COUPLING,
+    .meridiem       = false,
+    .weight         = {10 * HOUR_MS, HOUR_MS, 600000, 60000, 10000, 1000},
+    .unit_num       = 1,
+    .unit_den       = 1,
+};
+
+/*
+    Public functions
+*/
+const DigitEntryFormat *DigitEntry_Format(TimeFormats format)
+{
+    if ((unsigned)format >= sizeof(formats) / sizeof(formats[0]))
+    {
+        return NULL;
+    }
+    return &formats[format];
+}
+
+// The dozenal timer stays within a day, its digits are the day's
+const DigitEntryFormat *DigitEntry_TimerFormat(TimeFormats format)
+{
+    if (format == TRAD_24H)
+    {
+        return &trad_timer;
+    }
+    return DigitEntry_Format(format);
+}
+
+// One press of up or down on the selected digit
+void DigitEntry_Step(const DigitEntryFormat *fmt, uint8_t *vals, uint8_t sel, bool up)
+{
+    uint8_t radix;
+
+    if (fmt == NULL || sel >= fmt->num_digits)
+    {
+        return;
+    }
+    radix = fmt->radix[sel];
+    if (sel == 1 && vals[0] == fmt->tens_top)
+    {
+        radix = fmt->units_radix;
+    }
+    vals[sel] = up ? (vals[sel] + 1) % radix : (vals[sel] + radix - 1) % radix;
+
+    if (fmt->tens_top != ENTRY_NO_COUPLING && vals[0] == fmt->tens_top && vals[1] >= fmt->units_radix)
+    {
+        vals[1] = 0;
+    }
+    if (fmt->meridiem)
+    {
+        if (vals[0] == 1 && vals[1] == 2)
+        {
+            vals[6] = 1;
+        }
+        else if (vals[0] == 0 && vals[1] == 0)
+        {
+            vals[6] = 0;
+        }
+    }
+}
+
+// Only needs calling when a digit has changed
+uint32_t DigitEntry_ToMs(const DigitEntryFormat *fmt, const uint8_t *vals)
+{
+    uint32_t sum = 0;
+
+    if (fmt == NULL)
+    {
+        return 0;
+    }
+    for (uint8_t i = 0; i < fmt->num_digits; i++)
+    {
+        sum += vals[i] * fmt->weight[i];
+    }
+    if (fmt->meridiem && vals[6] == 1 && (10 * vals[0] + vals[1]) != 12)
+    {
+        sum += 12 * HOUR_MS;
+    }
+    return (sum * fmt->unit_num + fmt->unit_den / 2) / fmt->unit_den;
+}
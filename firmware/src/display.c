@@ -9,6 +9,7 @@
 #include "display.h"
 #include "bitmaps.h"
 #include "doz_clock.h"
+#include "fsm_table.h"
 
 #define DEFAULT_FORMAT      DOZ_DRN4
 #define DEFAULT_BRIGHTNESS  HIGH_BRIGHTNESS
@@ -37,7 +38,23 @@ static void SetAlarm_Update(Display *ctx);
 static void SetCalib_Entry(Display *ctx);
 static void SetCalib_Update(Display *ctx);
 
-static void transition(DisplayState *next);
+static void transition(const DisplayState *next);
+static void dispatch(uint8_t event);
+
+// Mode change actions
+static void goOff(void);
+static void goShowTime(void);
+static void nextShowTime(void);
+static void goSetTime(void);
+static void goSetTimer(void);
+static void goSetAlarm(void);
+static void goSetCalib(void);
+
+// State message functions
+static void publishState(Display *ctx);
+static bool stateChanged(DisplayStateMsg *state, DisplayStateMsg *sent);
+static void packU32(uint8_t *buf, uint32_t val);
+static uint32_t unpackU32(uint8_t *buf);
 
 // Bitmap creation functions
 static void displayChar(Bitmap *row_bitmap, uint8_t char_index, uint8_t digit[], uint8_t digitSize);
@@ -50,7 +67,7 @@ static void displayCalib(Bitmap *row_bitmap, int32_t calib);
 /*
     State definitions
 */
-static DisplayState s_off =
+static const DisplayState s_off =
 {
     .state_code = STATE_OFF,
     .entry = Off_Entry,
@@ -58,7 +75,7 @@ static DisplayState s_off =
     .exit = Off_Exit,
 };
 
-static DisplayState s_show_time123 =
+static const DisplayState s_show_time123 =
 {
     .state_code = STATE_SHOWTIME123,
     .entry = ShowTime123_Entry,
@@ -66,7 +83,7 @@ static DisplayState s_show_time123 =
     .exit = Default_Exit,
 };
 
-static DisplayState s_show_time23 =
+static const DisplayState s_show_time23 =
 {
     .state_code = STATE_SHOWTIME23,
     .entry = ShowTime23_Entry,
@@ -74,7 +91,7 @@ static DisplayState s_show_time23 =
     .exit = Default_Exit,
 };
 
-static DisplayState s_show_time12 =
+static const DisplayState s_show_time12 =
 {
     .state_code = STATE_SHOWTIME12,
     .entry = ShowTime12_Entry,
@@ -82,7 +99,7 @@ static DisplayState s_show_time12 =
     .exit = Default_Exit,
 };
 
-static DisplayState s_show_time2 =
+static const DisplayState s_show_time2 =
 {
     .state_code = STATE_SHOWTIME2,
     .entry = ShowTime2_Entry,
@@ -90,7 +107,7 @@ static DisplayState s_show_time2 =
     .exit = Default_Exit,
 };
 
-static DisplayState s_set_time =
+static const DisplayState s_set_time =
 {
     .state_code = STATE_SETTIME,
     .entry = SetTime_Entry,
@@ -98,7 +115,7 @@ static DisplayState s_set_time =
     .exit = Default_Exit,
 };
 
-static DisplayState s_set_timer =
+static const DisplayState s_set_timer =
 {
     .state_code = STATE_SETTIMER,
     .entry = SetTimer_Entry,
@@ -106,7 +123,7 @@ static DisplayState s_set_timer =
     .exit = Default_Exit,
 };
 
-static DisplayState s_set_alarm =
+static const DisplayState s_set_alarm =
 {
     .state_code = STATE_SETALARM,
     .entry = SetAlarm_Entry,
@@ -114,7 +131,7 @@ static DisplayState s_set_alarm =
     .exit = Default_Exit,
 };
 
-static DisplayState s_set_calib = 
+static const DisplayState s_set_calib = 
 {
     .state_code = STATE_SETCALIB,
     .entry = SetCalib_Entry,
@@ -150,16 +167,100 @@ Bitmap row3_bitmap = {
     Private variables
 */
 static DisplayFSM g_fsm = {0};
-static DisplayState *show_time_states[NUM_SHOWTIME_STATES] =
+static const DisplayState *const show_time_states[NUM_SHOWTIME_STATES] =
 {
     &s_show_time123,
     &s_show_time23,
     &s_show_time12,
     &s_show_time2
 };
+static const DisplayState *const all_states[NUM_DISPLAY_STATES] =
+{
+    &s_off,
+    &s_show_time123,
+    &s_show_time23,
+    &s_show_time12,
+    &s_show_time2,
+    &s_set_time,
+    &s_set_timer,
+    &s_set_alarm,
+    &s_set_calib
+};
 static uint8_t show_time_index = 0;
+
+// Requests from the clock, each is ignored by a state that does not list it
+enum display_event_t
+{
+    DISPLAY_EV_OFF,
+    DISPLAY_EV_ON,
+    DISPLAY_EV_TOGGLE_MODE,
+    DISPLAY_EV_SET_TIME,
+    DISPLAY_EV_SET_TIMER,
+    DISPLAY_EV_SET_ALARM,
+    DISPLAY_EV_SET_CALIB,
+    DISPLAY_EV_SHOW_TIME,
+
+    NUM_DISPLAY_EVENTS
+};
+
+// State/event spec, see fsm_table.h
+#define DISPLAY_FSM_ACTIONS(A) \
+    A(goOff) \
+    A(goShowTime) \
+    A(nextShowTime) \
+    A(goSetTime) \
+    A(goSetTimer) \
+    A(goSetAlarm) \
+    A(goSetCalib)
+
+#define DISPLAY_FSM_SHOWTIME(T, state) \
+    T(state, DISPLAY_EV_OFF,            goOff) \
+    T(state, DISPLAY_EV_TOGGLE_MODE,    nextShowTime) \
+    T(state, DISPLAY_EV_SET_TIME,       goSetTime) \
+    T(state, DISPLAY_EV_SET_TIMER,      goSetTimer) \
+    T(state, DISPLAY_EV_SET_ALARM,      goSetAlarm) \
+    T(state, DISPLAY_EV_SET_CALIB,      goSetCalib)
+
+#define DISPLAY_FSM_SPEC(T) \
+    T(STATE_OFF,            DISPLAY_EV_ON,          goShowTime) \
+    DISPLAY_FSM_SHOWTIME(T, STATE_SHOWTIME123) \
+    DISPLAY_FSM_SHOWTIME(T, STATE_SHOWTIME23) \
+    DISPLAY_FSM_SHOWTIME(T, STATE_SHOWTIME12) \
+    DISPLAY_FSM_SHOWTIME(T, STATE_SHOWTIME2) \
+    T(STATE_SETTIME,        DISPLAY_EV_SHOW_TIME,   goShowTime) \
+    T(STATE_SETTIMER,       DISPLAY_EV_SHOW_TIME,   goShowTime) \
+    T(STATE_SETALARM,       DISPLAY_EV_SHOW_TIME,   goShowTime) \
+    T(STATE_SETCALIB,       DISPLAY_EV_SHOW_TIME,   goShowTime)
+
+// Every state has a way back to showing the time
+#define DISPLAY_FSM_REQUIRED(R) \
+    R(STATE_OFF, DISPLAY_EV_ON) \
+    R(STATE_SHOWTIME123, DISPLAY_EV_OFF) \
+    R(STATE_SHOWTIME23, DISPLAY_EV_OFF) \
+    R(STATE_SHOWTIME12, DISPLAY_EV_OFF) \
+    R(STATE_SHOWTIME2, DISPLAY_EV_OFF) \
+    R(STATE_SETTIME, DISPLAY_EV_SHOW_TIME) \
+    R(STATE_SETTIMER, DISPLAY_EV_SHOW_TIME) \
+    R(STATE_SETALARM, DISPLAY_EV_SHOW_TIME) \
+    R(STATE_SETCALIB, DISPLAY_EV_SHOW_TIME)
+
+enum display_fsm_action_id { FSM_ACT_NONE = FSM_NO_ACTION, DISPLAY_FSM_ACTIONS(FSM_ACTION_ID) NUM_DISPLAY_FSM_ACTIONS };
+enum display_fsm_pair { DISPLAY_FSM_SPEC(FSM_PAIR) NUM_DISPLAY_FSM_PAIRS };
+DISPLAY_FSM_REQUIRED(FSM_REQUIRE)
+
+static void (* const display_fsm_actions[NUM_DISPLAY_FSM_ACTIONS])(void) = { NULL, DISPLAY_FSM_ACTIONS(FSM_ACTION_FN) };
+static const uint8_t display_event_map[NUM_DISPLAY_STATES][NUM_DISPLAY_EVENTS] = { DISPLAY_FSM_SPEC(FSM_TABLE_ROW) };
 volatile uint8_t blink_state = 0;
 
+static DisplayStateMsg sent_state;
+static bool state_sent = false;
+
+// One consistent copy of the clock per frame, redrawn only when something in it changed
+static ClockSnapshot frame;
+static uint32_t drawn_seq;
+static uint8_t drawn_blink;
+static bool redraw = true;
+
 static const uint8_t row2_trad_digit_indices[7] = {
     TRAD_DIGIT_1_ROW2_DISPLAY_INDEX,
     TRAD_DIGIT_2_ROW2_DISPLAY_INDEX,
@@ -266,7 +367,7 @@ static Colour row3_colour_old;
 /*
     Public functions
 */
-ClockStatus Display_Init(Display *self, ExternVars *vars)
+ClockStatus Display_Init(Display *self, SnapshotPub *src)
 {
     // Check for NULL pointers
     if (self->displayOff == NULL ||
@@ -279,12 +380,14 @@ ClockStatus Display_Init(Display *self, ExternVars *vars)
     {
         return CLOCK_FAIL;
     }
-    self->clock_vars = vars;
+    self->clock_src = src;
     self->time_format = DEFAULT_FORMAT;
     self->brightness = DEFAULT_BRIGHTNESS;
     g_fsm.ctx = self;
     g_fsm.curr_state = &s_off;
     show_time_index = 0;
+    state_sent = false;
+    redraw = true;
 
     // Set brightness
     g_fsm.ctx->setBrightness(g_fsm.ctx->brightness);
@@ -309,7 +412,22 @@ ClockStatus Display_Init(Display *self, ExternVars *vars)
 
 void Display_Update(void)
 {
+    uint32_t seq = Snapshot_Read(g_fsm.ctx->clock_src, &frame);
+
+    if (g_fsm.ctx->setState != NULL)
+    {
+        // Backend renders locally, only send what changed
+        publishState(g_fsm.ctx);
+        return;
+    }
+    if (!redraw && seq == drawn_seq && blink_state == drawn_blink)
+    {
+        return;     // Same clock values, state, format and blink as the frame on screen
+    }
     g_fsm.curr_state->update(g_fsm.ctx);
+    drawn_seq = seq;
+    drawn_blink = blink_state;
+    redraw = false;
 }
 
 void Display_PeriodicCallback(void)
@@ -320,80 +438,43 @@ void Display_PeriodicCallback(void)
 
 void Display_Off(void)
 {
-    // Check if currently in a ShowTime state
-    if (g_fsm.curr_state->state_code ==
-        show_time_states[show_time_index]->state_code)
-    {
-        transition(&s_off);
-    }
+    dispatch(DISPLAY_EV_OFF);
 }
 
 void Display_On(void)
 {
-    // Check if currently in Off state
-    if (g_fsm.curr_state->state_code == STATE_OFF)
-    {
-        transition(show_time_states[show_time_index]);
-    }
+    dispatch(DISPLAY_EV_ON);
 }
 
 void Display_ToggleMode(void)
 {
-    // Check if currently in a ShowTime state
-    if (g_fsm.curr_state->state_code ==
-        show_time_states[show_time_index]->state_code)
-    {
-        // Transition to the next ShowTime state
-        show_time_index = (show_time_index + 1) % NUM_SHOWTIME_STATES;
-        transition(show_time_states[show_time_index]);
-    }
+    dispatch(DISPLAY_EV_TOGGLE_MODE);
 }
 
 void Display_SetTime(void)
 {
-    // Check if currently in a ShowTime state
-    if (g_fsm.curr_state->state_code ==
-        show_time_states[show_time_index]->state_code)
-    {
-        transition(&s_set_time);
-    }
+    dispatch(DISPLAY_EV_SET_TIME);
 }
 
 void Display_SetTimer(void)
 {
-    // Check if currently in a ShowTime state
-    if (g_fsm.curr_state->state_code ==
-        show_time_states[show_time_index]->state_code)
-    {
-        transition(&s_set_timer);
-    }
+    dispatch(DISPLAY_EV_SET_TIMER);
 }
 
 void Display_SetAlarm(void)
 {
-    // Check if currently in a ShowTime state
-    if (g_fsm.curr_state->state_code ==
-        show_time_states[show_time_index]->state_code)
-    {
-        transition(&s_set_alarm);
-    }
+    dispatch(DISPLAY_EV_SET_ALARM);
 }
 
 void Display_ShowTime(void)
 {
-    // Check if currently in a valid Set state
-    if (g_fsm.curr_state->state_code == STATE_SETALARM
-        || g_fsm.curr_state->state_code == STATE_SETTIMER
-        || g_fsm.curr_state->state_code == STATE_SETTIME
-        || g_fsm.curr_state->state_code == STATE_SETCALIB)
-    {
-        transition(show_time_states[show_time_index]);
-    }
+    dispatch(DISPLAY_EV_SHOW_TIME);
 }
 
 void Display_SetFormat(TimeFormats format)
 {
     g_fsm.ctx->time_format = format;
+    redraw = true;
     memset(row1_bitmap.p_bitmap, 0, row1_bitmap.bitmap_size);
     memset(row2_bitmap.p_bitmap, 0, row2_bitmap.bitmap_size);
     memset(row3_bitmap.p_bitmap, 0, row3_bitmap.bitmap_size);
@@ -407,14 +488,121 @@ void Display_SetBrightness(BrightnessLevels brightness)
 
 void Display_SetCalib(void)
 {
-    // Check if currently in a ShowTime state
-    if (g_fsm.curr_state->state_code ==
-        show_time_states[show_time_index]->state_code)
+    dispatch(DISPLAY_EV_SET_CALIB);
+}
+
+ClockStatus Display_ApplyState(DisplayStateMsg *state)
+{
+    if (state->state_code >= NUM_DISPLAY_STATES || state->time_format > DOZ_SEMI)
+    {
+        return CLOCK_FAIL;
+    }
+    if (g_fsm.ctx->time_format != state->time_format)
+    {
+        Display_SetFormat(state->time_format);
+    }
+    if (g_fsm.curr_state->state_code != state->state_code)
+    {
+        if (state->state_code >= STATE_SHOWTIME123 && state->state_code <= STATE_SHOWTIME2)
+        {
+            show_time_index = state->state_code - STATE_SHOWTIME123;
+        }
+        transition(all_states[state->state_code]);
+    }
+    return CLOCK_OK;
+}
+
+// Publish the clock values of a received state, for a backend that renders it locally
+void Display_PublishState(SnapshotPub *pub, DisplayStateMsg *state)
+{
+    ClockSnapshot snap;
+
+    memset(&snap, 0, sizeof(snap));
+    snap.time_ms                = state->time_ms;
+    snap.user_time_ms           = state->user_time_ms;
+    snap.user_alarm_ms          = state->user_alarm_ms;
+    snap.user_timer_ms          = state->user_timer_ms;
+    snap.rtc_calib              = state->rtc_calib;
+    snap.digit_sel              = state->digit_sel;
+    memcpy(snap.digit_vals, state->digit_vals, DISPLAY_STATE_DIGITS);
+    snap.diurn_radix_pos        = state->diurn_radix_pos;
+    snap.semi_diurn_radix_pos   = state->semi_diurn_radix_pos;
+    snap.error_code             = state->error_code;
+    snap.alarm_set              = state->alarm_set;
+    snap.timer_set              = state->timer_set;
+    snap.alarm_triggered        = state->alarm_triggered;
+    snap.timer_triggered        = state->timer_triggered;
+    snap.show_error             = state->show_error;
+    snap.timer_alarm_displayed  = state->timer_alarm_displayed;
+    Snapshot_Publish(pub, &snap);
+}
+
+// Predict the state elapsed_ms after it was sent, used by both ends of the link
+void Display_AdvanceState(DisplayStateMsg *state, uint32_t elapsed_ms)
+{
+    state->time_ms = (state->time_ms + elapsed_ms) % TIME_24H_MS;
+    if (state->timer_set)
     {
-        transition(&s_set_calib);
+        state->user_timer_ms = (state->user_timer_ms > elapsed_ms) ? state->user_timer_ms - elapsed_ms : 0;
     }
 }
 
+uint8_t Display_PackState(DisplayStateMsg *state, uint8_t *buf)
+{
+    buf[0] = state->state_code;
+    buf[1] = state->time_format;
+    buf[2] = state->alarm_set
+           | state->timer_set << 1
+           | state->alarm_triggered << 2
+           | state->timer_triggered << 3
+           | state->show_error << 4
+           | state->timer_alarm_displayed << 5;
+    buf[3] = state->digit_sel;
+    buf[4] = state->diurn_radix_pos;
+    buf[5] = state->semi_diurn_radix_pos;
+    buf[6] = state->error_code;
+    memcpy(&buf[7], state->digit_vals, DISPLAY_STATE_DIGITS);
+    packU32(&buf[14], state->time_ms);
+    packU32(&buf[18], state->user_time_ms);
+    packU32(&buf[22], state->user_alarm_ms);
+    packU32(&buf[26], state->user_timer_ms);
+    packU32(&buf[30], (uint32_t) state->rtc_calib);
+    return DISPLAY_STATE_MSG_SIZE;
+}
+
+ClockStatus Display_UnpackState(DisplayStateMsg *state, uint8_t *buf, uint8_t size)
+{
+    if (size != DISPLAY_STATE_MSG_SIZE)
+    {
+        return CLOCK_FAIL;
+    }
+    state->state_code               = (DisplayStateCode) buf[0];
+    state->time_format              = (TimeFormats) buf[1];
+    state->alarm_set                = buf[2] & 0x01;
+    state->timer_set                = (buf[2] >> 1) & 0x01;
+    state->alarm_triggered          = (buf[2] >> 2) & 0x01;
+    state->timer_triggered          = (buf[2] >> 3) & 0x01;
+    state->show_error               = (buf[2] >> 4) & 0x01;
+    state->timer_alarm_displayed    = (buf[2] >> 5) & 0x01;
+    state->digit_sel                = buf[3];
+    state->diurn_radix_pos          = buf[4];
+    state->semi_diurn_radix_pos     = buf[5];
+    state->error_code               = (ClockStatus) buf[6];
+    memcpy(state->digit_vals, &buf[7], DISPLAY_STATE_DIGITS);
+    state->time_ms                  = unpackU32(&buf[14]);
+    state->user_time_ms             = unpackU32(&buf[18]);
+    state->user_alarm_ms            = unpackU32(&buf[22]);
+    state->user_timer_ms            = unpackU32(&buf[26]);
+    state->rtc_calib                = (int32_t) unpackU32(&buf[30]);
+
+    if (state->state_code >= NUM_DISPLAY_STATES || state->time_format > DOZ_SEMI
+        || state->digit_sel >= DISPLAY_STATE_DIGITS || state->time_ms >= TIME_24H_MS)
+    {
+        return CLOCK_FAIL;
+    }
+    return CLOCK_OK;
+}
+
 /*
     Private functions
 */
@@ -469,38 +657,38 @@ static void ShowTime2_Entry(Display *ctx)
 static void ShowTime_Update(Display *ctx)
 {
     memset(row1_bitmap.p_bitmap, 0, row1_bitmap.bitmap_size);
-    if (*ctx->clock_vars->alarm_set)
+    if (frame.alarm_set)
     {
         displayChar(&row1_bitmap, A_ROW1_DISPLAY_INDEX, small_symbols[A_INDEX], SMALL_DIGIT_ROWS);
     }
-    if (*ctx->clock_vars->timer_set)
+    if (frame.timer_set)
     {
         displayChar(&row1_bitmap, T_ROW1_DISPLAY_INDEX, small_symbols[T_INDEX], SMALL_DIGIT_ROWS);
     }
-    if (*ctx->clock_vars->show_error && *ctx->clock_vars->error_code)
+    if (frame.show_error && frame.error_code)
     {
         displayChar(&row1_bitmap, EXCLAMATION_ROW1_DISPLAY_INDEX, small_symbols[EXCLAMATION_INDEX], SMALL_DIGIT_ROWS);
     }
-    displayFormat(ctx->time_format, *ctx->clock_vars->time_ms);
+    displayFormat(ctx->time_format, frame.time_ms);
 
     memset(row2_bitmap.p_bitmap, 0, row2_bitmap.bitmap_size);
-    displayTime(&row2_bitmap, *ctx->clock_vars->time_ms);
+    displayTime(&row2_bitmap, frame.time_ms);
 
     memset(row3_bitmap.p_bitmap, 0, row3_bitmap.bitmap_size);
-    if (*ctx->clock_vars->timer_set && *ctx->clock_vars->alarm_set) {
-        if (*ctx->clock_vars->timer_alarm_displayed == DISPLAY_ALARM) {
+    if (frame.timer_set && frame.alarm_set) {
+        if (frame.timer_alarm_displayed == DISPLAY_ALARM) {
             row3_colour = BLUE;
-            displayTime(&row3_bitmap, *ctx->clock_vars->user_alarm_ms);
-        } else if (*ctx->clock_vars->timer_alarm_displayed == DISPLAY_TIMER) {
+            displayTime(&row3_bitmap, frame.user_alarm_ms);
+        } else if (frame.timer_alarm_displayed == DISPLAY_TIMER) {
             row3_colour = GREEN;
-            displayTime(&row3_bitmap, *ctx->clock_vars->user_timer_ms);
+            displayTime(&row3_bitmap, frame.user_timer_ms);
         }
-    } else if (*ctx->clock_vars->timer_set) {
+    } else if (frame.timer_set) {
         row3_colour = GREEN;
-        displayTime(&row3_bitmap, *ctx->clock_vars->user_timer_ms);
-    } else if (*ctx->clock_vars->alarm_set) {
+        displayTime(&row3_bitmap, frame.user_timer_ms);
+    } else if (frame.alarm_set) {
         row3_colour = BLUE;
-        displayTime(&row3_bitmap, *ctx->clock_vars->user_alarm_ms);
+        displayTime(&row3_bitmap, frame.user_alarm_ms);
     }
 
     if (row3_colour != row3_colour_old) {
@@ -521,35 +709,35 @@ static void SetTime_Entry(Display *ctx)
 static void SetTime_Update(Display *ctx)
 {
     memset(row1_bitmap.p_bitmap, 0, row1_bitmap.bitmap_size);
-    if (*ctx->clock_vars->alarm_set)
+    if (frame.alarm_set)
     {
         displayChar(&row1_bitmap, A_ROW1_DISPLAY_INDEX, small_symbols[A_INDEX], SMALL_DIGIT_ROWS);
     }
-    if (*ctx->clock_vars->timer_set)
+    if (frame.timer_set)
     {
         displayChar(&row1_bitmap, T_ROW1_DISPLAY_INDEX, small_symbols[T_INDEX], SMALL_DIGIT_ROWS);
     }
-    if (*ctx->clock_vars->show_error && *ctx->clock_vars->error_code)
+    if (frame.show_error && frame.error_code)
     {
         displayChar(&row1_bitmap, EXCLAMATION_ROW1_DISPLAY_INDEX, small_symbols[EXCLAMATION_INDEX], SMALL_DIGIT_ROWS);
     }
-    displayFormat(ctx->time_format, *ctx->clock_vars->user_time_ms);
+    displayFormat(ctx->time_format, frame.user_time_ms);
 
     memset(row3_bitmap.p_bitmap, 0, row3_bitmap.bitmap_size);
-    if (*ctx->clock_vars->timer_set && *ctx->clock_vars->alarm_set) {
-        if (*ctx->clock_vars->timer_alarm_displayed == DISPLAY_ALARM) {
+    if (frame.timer_set && frame.alarm_set) {
+        if (frame.timer_alarm_displayed == DISPLAY_ALARM) {
             row3_colour = BLUE;
-            displayTime(&row3_bitmap, *ctx->clock_vars->user_alarm_ms);
-        } else if (*ctx->clock_vars->timer_alarm_displayed == DISPLAY_TIMER) {
+            displayTime(&row3_bitmap, frame.user_alarm_ms);
+        } else if (frame.timer_alarm_displayed == DISPLAY_TIMER) {
             row3_colour = GREEN;
-            displayTime(&row3_bitmap, *ctx->clock_vars->user_timer_ms);
+            displayTime(&row3_bitmap, frame.user_timer_ms);
         }
-    } else if (*ctx->clock_vars->timer_set) {
+    } else if (frame.timer_set) {
         row3_colour = GREEN;
-        displayTime(&row3_bitmap, *ctx->clock_vars->user_timer_ms);
-    } else if (*ctx->clock_vars->alarm_set) {
+        displayTime(&row3_bitmap, frame.user_timer_ms);
+    } else if (frame.alarm_set) {
         row3_colour = BLUE;
-        displayTime(&row3_bitmap, *ctx->clock_vars->user_alarm_ms);
+        displayTime(&row3_bitmap, frame.user_alarm_ms);
     }
 
     if (row3_colour != row3_colour_old) {
@@ -558,29 +746,29 @@ static void SetTime_Update(Display *ctx)
     }
 
     memset(row2_bitmap.p_bitmap, 0, row2_bitmap.bitmap_size);
-    displayTime(&row2_bitmap, *ctx->clock_vars->user_time_ms);
+    displayTime(&row2_bitmap, frame.user_time_ms);
 
-    if (*ctx->clock_vars->digit_sel == 6) // AM/PM
+    if (frame.digit_sel == 6) // AM/PM
     {
-        blinkDigit(&row1_bitmap, row2_trad_digit_indices[*ctx->clock_vars->digit_sel], true);
+        blinkDigit(&row1_bitmap, row2_trad_digit_indices[frame.digit_sel], true);
     }
     else 
     {
         if (ctx->time_format == TRAD_24H || ctx->time_format == TRAD_12H)
         {
-            blinkDigit(&row2_bitmap, row2_trad_digit_indices[*ctx->clock_vars->digit_sel], false);
+            blinkDigit(&row2_bitmap, row2_trad_digit_indices[frame.digit_sel], false);
         } 
         else if (ctx->time_format == DOZ_DRN5) 
         {
-            blinkDigit(&row2_bitmap, row2_drn5_digit_indices[*ctx->clock_vars->digit_sel] + (((*ctx->clock_vars->digit_sel >= *ctx->clock_vars->diurn_radix_pos) ? ROW2_RADIX_OFFSET : 0)), false);
+            blinkDigit(&row2_bitmap, row2_drn5_digit_indices[frame.digit_sel] + (((frame.digit_sel >= frame.diurn_radix_pos) ? ROW2_RADIX_OFFSET : 0)), false);
         }
         else if (ctx->time_format == DOZ_SEMI) 
         {
-            blinkDigit(&row2_bitmap, row2_semi_digit_indices[*ctx->clock_vars->digit_sel] + (((*ctx->clock_vars->digit_sel >= *ctx->clock_vars->semi_diurn_radix_pos) ? ROW2_RADIX_OFFSET : 0)), false);
+            blinkDigit(&row2_bitmap, row2_semi_digit_indices[frame.digit_sel] + (((frame.digit_sel >= frame.semi_diurn_radix_pos) ? ROW2_RADIX_OFFSET : 0)), false);
         }
         else if (ctx->time_format == DOZ_DRN4) 
         {
-            blinkDigit(&row2_bitmap, row2_drn4_digit_indices[*ctx->clock_vars->digit_sel] + (((*ctx->clock_vars->digit_sel >= *ctx->clock_vars->diurn_radix_pos) ? ROW2_RADIX_OFFSET : 0)), false);
+            blinkDigit(&row2_bitmap, row2_drn4_digit_indices[frame.digit_sel] + (((frame.digit_sel >= frame.diurn_radix_pos) ? ROW2_RADIX_OFFSET : 0)), false);
         }
     }
 
@@ -601,33 +789,33 @@ static void SetTimer_Entry(Display *ctx)
 static void SetTimer_Update(Display *ctx)
 {
     memset(row1_bitmap.p_bitmap, 0, row1_bitmap.bitmap_size);
-    if (*ctx->clock_vars->alarm_set)
+    if (frame.alarm_set)
     {
         displayChar(&row1_bitmap, A_ROW1_DISPLAY_INDEX, small_symbols[A_INDEX], SMALL_DIGIT_ROWS);
     }
-    if (*ctx->clock_vars->timer_set)
+    if (frame.timer_set)
     {
         displayChar(&row1_bitmap, T_ROW1_DISPLAY_INDEX, small_symbols[T_INDEX], SMALL_DIGIT_ROWS);
     }
-    if (*ctx->clock_vars->show_error && *ctx->clock_vars->error_code)
+    if (frame.show_error && frame.error_code)
     {
         displayChar(&row1_bitmap, EXCLAMATION_ROW1_DISPLAY_INDEX, small_symbols[EXCLAMATION_INDEX], SMALL_DIGIT_ROWS);
     }
-    displayFormat(ctx->time_format, *ctx->clock_vars->time_ms);
+    displayFormat(ctx->time_format, frame.time_ms);
 
     memset(row2_bitmap.p_bitmap, 0, row2_bitmap.bitmap_size);
-    displayTime(&row2_bitmap, *ctx->clock_vars->time_ms);
+    displayTime(&row2_bitmap, frame.time_ms);
 
     memset(row3_bitmap.p_bitmap, 0, row3_bitmap.bitmap_size);
-    displayTime(&row3_bitmap, *ctx->clock_vars->user_timer_ms);
+    displayTime(&row3_bitmap, frame.user_timer_ms);
 
     if (ctx->time_format == TRAD_24H)
     {
-        blinkDigit(&row3_bitmap, row3_trad_digit_indices[*ctx->clock_vars->digit_sel], false);
+        blinkDigit(&row3_bitmap, row3_trad_digit_indices[frame.digit_sel], false);
     } 
     else if (ctx->time_format == DOZ_DRN5) 
     {
-        blinkDigit(&row3_bitmap, row3_drn5_digit_indices[*ctx->clock_vars->digit_sel] + (((*ctx->clock_vars->digit_sel >= *ctx->clock_vars->diurn_radix_pos) ? ROW3_RADIX_OFFSET : 0)), false);
+        blinkDigit(&row3_bitmap, row3_drn5_digit_indices[frame.digit_sel] + (((frame.digit_sel >= frame.diurn_radix_pos) ? ROW3_RADIX_OFFSET : 0)), false);
     }
 
     ctx->setBitmap(row1_bitmap.num, row1_bitmap.p_bitmap);
@@ -647,41 +835,41 @@ static void SetAlarm_Entry(Display *ctx)
 static void SetAlarm_Update(Display *ctx)
 {
     memset(row1_bitmap.p_bitmap, 0, row1_bitmap.bitmap_size);
-    if (*ctx->clock_vars->alarm_set)
+    if (frame.alarm_set)
     {
         displayChar(&row1_bitmap, A_ROW1_DISPLAY_INDEX, small_symbols[A_INDEX], SMALL_DIGIT_ROWS);
     }
-    if (*ctx->clock_vars->timer_set)
+    if (frame.timer_set)
     {
         displayChar(&row1_bitmap, T_ROW1_DISPLAY_INDEX, small_symbols[T_INDEX], SMALL_DIGIT_ROWS);
     }
-    if (*ctx->clock_vars->show_error && *ctx->clock_vars->error_code)
+    if (frame.show_error && frame.error_code)
     {
         displayChar(&row1_bitmap, EXCLAMATION_ROW1_DISPLAY_INDEX, small_symbols[EXCLAMATION_INDEX], SMALL_DIGIT_ROWS);
     }
-    displayFormat(ctx->time_format, *ctx->clock_vars->time_ms);
+    displayFormat(ctx->time_format, frame.time_ms);
 
     memset(row2_bitmap.p_bitmap, 0, row2_bitmap.bitmap_size);
-    displayTime(&row2_bitmap, *ctx->clock_vars->time_ms);
+    displayTime(&row2_bitmap, frame.time_ms);
 
     memset(row3_bitmap.p_bitmap, 0, row3_bitmap.bitmap_size);
-    displayTime(&row3_bitmap, *ctx->clock_vars->user_alarm_ms);
+    displayTime(&row3_bitmap, frame.user_alarm_ms);
 
     if (ctx->time_format == TRAD_24H || ctx->time_format == TRAD_12H)
     {
-        blinkDigit(&row3_bitmap, row3_trad_digit_indices[*ctx->clock_vars->digit_sel], (*ctx->clock_vars->digit_sel == 6));
+        blinkDigit(&row3_bitmap, row3_trad_digit_indices[frame.digit_sel], (frame.digit_sel == 6));
     } 
     else if (ctx->time_format == DOZ_DRN5) 
     {
-        blinkDigit(&row3_bitmap, row3_drn5_digit_indices[*ctx->clock_vars->digit_sel] + (((*ctx->clock_vars->digit_sel >= *ctx->clock_vars->diurn_radix_pos) ? ROW3_RADIX_OFFSET : 0)), false);
+        blinkDigit(&row3_bitmap, row3_drn5_digit_indices[frame.digit_sel] + (((frame.digit_sel >= frame.diurn_radix_pos) ? ROW3_RADIX_OFFSET : 0)), false);
     }
     else if (ctx->time_format == DOZ_SEMI) 
     {
-        blinkDigit(&row3_bitmap, row3_semi_digit_indices[*ctx->clock_vars->digit_sel] + (((*ctx->clock_vars->digit_sel >= *ctx->clock_vars->semi_diurn_radix_pos) ? ROW3_RADIX_OFFSET : 0)), false);
+        blinkDigit(&row3_bitmap, row3_semi_digit_indices[frame.digit_sel] + (((frame.digit_sel >= frame.semi_diurn_radix_pos) ? ROW3_RADIX_OFFSET : 0)), false);
     }
     else if (ctx->time_format == DOZ_DRN4) 
     {
-        blinkDigit(&row3_bitmap, row3_drn4_digit_indices[*ctx->clock_vars->digit_sel] + (((*ctx->clock_vars->digit_sel >= *ctx->clock_vars->diurn_radix_pos) ? ROW3_RADIX_OFFSET : 0)), false);
+        blinkDigit(&row3_bitmap, row3_drn4_digit_indices[frame.digit_sel] + (((frame.digit_sel >= frame.diurn_radix_pos) ? ROW3_RADIX_OFFSET : 0)), false);
     }
 
     ctx->setBitmap(row1_bitmap.num, row1_bitmap.p_bitmap);
@@ -703,15 +891,146 @@ static void SetCalib_Update(Display *ctx)
     memset(row3_bitmap.p_bitmap, 0, row3_bitmap.bitmap_size);
 
     memset(row2_bitmap.p_bitmap, 0, row2_bitmap.bitmap_size);
-    displayCalib(&row2_bitmap, *g_fsm.ctx->clock_vars->rtc_calib);
+    displayCalib(&row2_bitmap, frame.rtc_calib);
 
     ctx->setBitmap(row1_bitmap.num, row1_bitmap.p_bitmap);
     ctx->setBitmap(row2_bitmap.num, row2_bitmap.p_bitmap);
     ctx->setBitmap(row3_bitmap.num, row3_bitmap.p_bitmap);
 }
 
-void transition(DisplayState *next)
+static void publishState(Display *ctx)
+{
+    DisplayStateMsg state;
+
+    state.state_code            = g_fsm.curr_state->state_code;
+    state.time_format           = ctx->time_format;
+    state.time_ms               = frame.time_ms;
+    state.user_time_ms          = frame.user_time_ms;
+    state.user_alarm_ms         = frame.user_alarm_ms;
+    state.user_timer_ms         = frame.user_timer_ms;
+    state.rtc_calib             = frame.rtc_calib;
+    state.digit_sel             = frame.digit_sel;
+    memcpy(state.digit_vals, frame.digit_vals, DISPLAY_STATE_DIGITS);
+    state.diurn_radix_pos       = frame.diurn_radix_pos;
+    state.semi_diurn_radix_pos  = frame.semi_diurn_radix_pos;
+    state.error_code            = frame.error_code;
+    state.alarm_set             = frame.alarm_set;
+    state.timer_set             = frame.timer_set;
+    state.alarm_triggered       = frame.alarm_triggered;
+    state.timer_triggered       = frame.timer_triggered;
+    state.show_error            = frame.show_error;
+    state.timer_alarm_displayed = frame.timer_alarm_displayed;
+
+    if (!state_sent || stateChanged(&state, &sent_state))
+    {
+        ctx->setState(&state);
+        sent_state = state;
+        state_sent = true;
+    }
+}
+
+// Checks whether the receiver's prediction from the last sent state no longer matches
+static bool stateChanged(DisplayStateMsg *state, DisplayStateMsg *sent)
+{
+    DisplayStateMsg predicted = *sent;
+    uint32_t elapsed_ms = (state->time_ms + TIME_24H_MS - sent->time_ms) % TIME_24H_MS;
+    uint32_t timer_error_ms;
+
+    if (elapsed_ms >= DISPLAY_STATE_RESYNC_MS)
+    {
+        return true;
+    }
+    Display_AdvanceState(&predicted, elapsed_ms);
+    timer_error_ms = (state->user_timer_ms > predicted.user_timer_ms) ? state->user_timer_ms - predicted.user_timer_ms
+                                                                       : predicted.user_timer_ms - state->user_timer_ms;
+    if (timer_error_ms > DISPLAY_STATE_TOLERANCE_MS)
+    {
+        return true;
+    }
+    return state->state_code != sent->state_code
+        || state->time_format != sent->time_format
+        || state->user_time_ms != sent->user_time_ms
+        || state->user_alarm_ms != sent->user_alarm_ms
+        || state->rtc_calib != sent->rtc_calib
+        || state->digit_sel != sent->digit_sel
+        || memcmp(state->digit_vals, sent->digit_vals, DISPLAY_STATE_DIGITS) != 0
+        || state->diurn_radix_pos != sent->diurn_radix_pos
+        || state->semi_diurn_radix_pos != sent->semi_diurn_radix_pos
+        || state->error_code != sent->error_code
+        || state->alarm_set != sent->alarm_set
+        || state->timer_set != sent->timer_set
+        || state->alarm_triggered != sent->alarm_triggered
+        || state->timer_triggered != sent->timer_triggered
+        || state->show_error != sent->show_error
+        || state->timer_alarm_displayed != sent->timer_alarm_displayed;
+}
+
+static void packU32(uint8_t *buf, uint32_t val)
+{
+    buf[0] = val & 0xFF;
+    buf[1] = (val >> 8) & 0xFF;
+    buf[2] = (val >> 16) & 0xFF;
+    buf[3] = (val >> 24) & 0xFF;
+}
+
+static uint32_t unpackU32(uint8_t *buf)
+{
+    return (uint32_t) buf[0]
+         | (uint32_t) buf[1] << 8
+         | (uint32_t) buf[2] << 16
+         | (uint32_t) buf[3] << 24;
+}
+
+static void dispatch(uint8_t event)
+{
+    uint8_t action = display_event_map[g_fsm.curr_state->state_code][event];
+
+    if (action != FSM_NO_ACTION)
+    {
+        display_fsm_actions[action]();
+    }
+}
+
+static void goOff(void)
+{
+    transition(&s_off);
+}
+
+static void goShowTime(void)
+{
+    transition(show_time_states[show_time_index]);
+}
+
+static void nextShowTime(void)
+{
+    show_time_index = (show_time_index + 1) % NUM_SHOWTIME_STATES;
+    transition(show_time_states[show_time_index]);
+}
+
+static void goSetTime(void)
 {
+    transition(&s_set_time);
+}
+
+static void goSetTimer(void)
+{
+    transition(&s_set_timer);
+}
+
+static void goSetAlarm(void)
+{
+    transition(&s_set_alarm);
+}
+
+static void goSetCalib(void)
+{
+    transition(&s_set_calib);
+}
+
+void transition(const DisplayState *next)
+{
+    FlightRec_Log(REC_DISPLAY_STATE, next->state_code, g_fsm.curr_state->state_code, 0);
+    redraw = true;
     g_fsm.curr_state->exit(g_fsm.ctx);
     g_fsm.curr_state = next;
     g_fsm.curr_state->entry(g_fsm.ctx);
@@ -776,41 +1095,41 @@ static void displayTime(Bitmap *row_bitmap, uint32_t time_ms)
         }
         else if (g_fsm.ctx->time_format == DOZ_DRN5)
         {
-            displayChar(row_bitmap, row2_5digit_radix_pos[*g_fsm.ctx->clock_vars->diurn_radix_pos], large_numbers[RADIX_INDEX], LARGE_DIGIT_ROWS);
+            displayChar(row_bitmap, row2_5digit_radix_pos[frame.diurn_radix_pos], large_numbers[RADIX_INDEX], LARGE_DIGIT_ROWS);
 
             uint8_t digit1, digit2, digit3, digit4, digit5;
             msToDiurn(time_ms, &digit1, &digit2, &digit3, &digit4, &digit5);
 
-            displayChar(row_bitmap, DRN5_DIGIT_1_ROW2_DISPLAY_INDEX + ((*g_fsm.ctx->clock_vars->diurn_radix_pos < RADIX_POS1) ? ROW2_RADIX_OFFSET : 0), large_numbers[digit1], LARGE_DIGIT_ROWS);
-            displayChar(row_bitmap, DRN5_DIGIT_2_ROW2_DISPLAY_INDEX + ((*g_fsm.ctx->clock_vars->diurn_radix_pos < RADIX_POS2) ? ROW2_RADIX_OFFSET : 0), large_numbers[digit2], LARGE_DIGIT_ROWS);
-            displayChar(row_bitmap, DRN5_DIGIT_3_ROW2_DISPLAY_INDEX + ((*g_fsm.ctx->clock_vars->diurn_radix_pos < RADIX_POS3) ? ROW2_RADIX_OFFSET : 0), large_numbers[digit3], LARGE_DIGIT_ROWS);
-            displayChar(row_bitmap, DRN5_DIGIT_4_ROW2_DISPLAY_INDEX + ((*g_fsm.ctx->clock_vars->diurn_radix_pos < RADIX_POS4) ? ROW2_RADIX_OFFSET : 0), large_numbers[digit4], LARGE_DIGIT_ROWS);
-            displayChar(row_bitmap, DRN5_DIGIT_5_ROW2_DISPLAY_INDEX + ((*g_fsm.ctx->clock_vars->diurn_radix_pos < RADIX_POS5) ? ROW2_RADIX_OFFSET : 0), large_numbers[digit5], LARGE_DIGIT_ROWS);
+            displayChar(row_bitmap, DRN5_DIGIT_1_ROW2_DISPLAY_INDEX + ((frame.diurn_radix_pos < RADIX_POS1) ? ROW2_RADIX_OFFSET : 0), large_numbers[digit1], LARGE_DIGIT_ROWS);
+            displayChar(row_bitmap, DRN5_DIGIT_2_ROW2_DISPLAY_INDEX + ((frame.diurn_radix_pos < RADIX_POS2) ? ROW2_RADIX_OFFSET : 0), large_numbers[digit2], LARGE_DIGIT_ROWS);
+            displayChar(row_bitmap, DRN5_DIGIT_3_ROW2_DISPLAY_INDEX + ((frame.diurn_radix_pos < RADIX_POS3) ? ROW2_RADIX_OFFSET : 0), large_numbers[digit3], LARGE_DIGIT_ROWS);
+            displayChar(row_bitmap, DRN5_DIGIT_4_ROW2_DISPLAY_INDEX + ((frame.diurn_radix_pos < RADIX_POS4) ? ROW2_RADIX_OFFSET : 0), large_numbers[digit4], LARGE_DIGIT_ROWS);
+            displayChar(row_bitmap, DRN5_DIGIT_5_ROW2_DISPLAY_INDEX + ((frame.diurn_radix_pos < RADIX_POS5) ? ROW2_RADIX_OFFSET : 0), large_numbers[digit5], LARGE_DIGIT_ROWS);
         }
         else if (g_fsm.ctx->time_format == DOZ_SEMI)
         {
-            displayChar(row_bitmap, row2_5digit_radix_pos[*g_fsm.ctx->clock_vars->semi_diurn_radix_pos], large_numbers[RADIX_INDEX], LARGE_DIGIT_ROWS);
+            displayChar(row_bitmap, row2_5digit_radix_pos[frame.semi_diurn_radix_pos], large_numbers[RADIX_INDEX], LARGE_DIGIT_ROWS);
 
             uint8_t digit1, digit2, digit3, digit4, digit5;
             msToSemiDiurn(time_ms, &digit1, &digit2, &digit3, &digit4, &digit5);
 
             displayChar(row_bitmap, SEMI_DIGIT_1_ROW2_DISPLAY_INDEX, large_numbers[digit1], LARGE_DIGIT_ROWS);
-            displayChar(row_bitmap, SEMI_DIGIT_2_ROW2_DISPLAY_INDEX + ((*g_fsm.ctx->clock_vars->semi_diurn_radix_pos < RADIX_POS2) ? ROW2_RADIX_OFFSET : 0), large_numbers[digit2], LARGE_DIGIT_ROWS);
-            displayChar(row_bitmap, SEMI_DIGIT_3_ROW2_DISPLAY_INDEX + ((*g_fsm.ctx->clock_vars->semi_diurn_radix_pos < RADIX_POS3) ? ROW2_RADIX_OFFSET : 0), large_numbers[digit3], LARGE_DIGIT_ROWS);
-            displayChar(row_bitmap, SEMI_DIGIT_4_ROW2_DISPLAY_INDEX + ((*g_fsm.ctx->clock_vars->semi_diurn_radix_pos < RADIX_POS4) ? ROW2_RADIX_OFFSET : 0), large_numbers[digit4], LARGE_DIGIT_ROWS);
-            displayChar(row_bitmap, SEMI_DIGIT_5_ROW2_DISPLAY_INDEX + ((*g_fsm.ctx->clock_vars->semi_diurn_radix_pos < RADIX_POS5) ? ROW2_RADIX_OFFSET : 0), large_numbers[digit5], LARGE_DIGIT_ROWS);
+            displayChar(row_bitmap, SEMI_DIGIT_2_ROW2_DISPLAY_INDEX + ((frame.semi_diurn_radix_pos < RADIX_POS2) ? ROW2_RADIX_OFFSET : 0), large_numbers[digit2], LARGE_DIGIT_ROWS);
+            displayChar(row_bitmap, SEMI_DIGIT_3_ROW2_DISPLAY_INDEX + ((frame.semi_diurn_radix_pos < RADIX_POS3) ? ROW2_RADIX_OFFSET : 0), large_numbers[digit3], LARGE_DIGIT_ROWS);
+            displayChar(row_bitmap, SEMI_DIGIT_4_ROW2_DISPLAY_INDEX + ((frame.semi_diurn_radix_pos < RADIX_POS4) ? ROW2_RADIX_OFFSET : 0), large_numbers[digit4], LARGE_DIGIT_ROWS);
+            displayChar(row_bitmap, SEMI_DIGIT_5_ROW2_DISPLAY_INDEX + ((frame.semi_diurn_radix_pos < RADIX_POS5) ? ROW2_RADIX_OFFSET : 0), large_numbers[digit5], LARGE_DIGIT_ROWS);
         }
         else if (g_fsm.ctx->time_format == DOZ_DRN4)
         {
-            displayChar(row_bitmap, row2_4digit_radix_pos[*g_fsm.ctx->clock_vars->diurn_radix_pos], large_numbers[RADIX_INDEX], LARGE_DIGIT_ROWS);
+            displayChar(row_bitmap, row2_4digit_radix_pos[frame.diurn_radix_pos], large_numbers[RADIX_INDEX], LARGE_DIGIT_ROWS);
 
             uint8_t digit1, digit2, digit3, digit4, digit5;
             msToDiurn(time_ms, &digit1, &digit2, &digit3, &digit4, &digit5);
 
-            displayChar(row_bitmap, DRN4_DIGIT_1_ROW2_DISPLAY_INDEX + ((*g_fsm.ctx->clock_vars->diurn_radix_pos < RADIX_POS1) ? ROW2_RADIX_OFFSET : 0), large_numbers[digit1], LARGE_DIGIT_ROWS);
-            displayChar(row_bitmap, DRN4_DIGIT_2_ROW2_DISPLAY_INDEX + ((*g_fsm.ctx->clock_vars->diurn_radix_pos < RADIX_POS2) ? ROW2_RADIX_OFFSET : 0), large_numbers[digit2], LARGE_DIGIT_ROWS);
-            displayChar(row_bitmap, DRN4_DIGIT_3_ROW2_DISPLAY_INDEX + ((*g_fsm.ctx->clock_vars->diurn_radix_pos < RADIX_POS3) ? ROW2_RADIX_OFFSET : 0), large_numbers[digit3], LARGE_DIGIT_ROWS);
-            displayChar(row_bitmap, DRN4_DIGIT_4_ROW2_DISPLAY_INDEX + ((*g_fsm.ctx->clock_vars->diurn_radix_pos < RADIX_POS4) ? ROW2_RADIX_OFFSET : 0), large_numbers[digit4], LARGE_DIGIT_ROWS);
+            displayChar(row_bitmap, DRN4_DIGIT_1_ROW2_DISPLAY_INDEX + ((frame.diurn_radix_pos < RADIX_POS1) ? ROW2_RADIX_OFFSET : 0), large_numbers[digit1], LARGE_DIGIT_ROWS);
+            displayChar(row_bitmap, DRN4_DIGIT_2_ROW2_DISPLAY_INDEX + ((frame.diurn_radix_pos < RADIX_POS2) ? ROW2_RADIX_OFFSET : 0), large_numbers[digit2], LARGE_DIGIT_ROWS);
+            displayChar(row_bitmap, DRN4_DIGIT_3_ROW2_DISPLAY_INDEX + ((frame.diurn_radix_pos < RADIX_POS3) ? ROW2_RADIX_OFFSET : 0), large_numbers[digit3], LARGE_DIGIT_ROWS);
+            displayChar(row_bitmap, DRN4_DIGIT_4_ROW2_DISPLAY_INDEX + ((frame.diurn_radix_pos < RADIX_POS4) ? ROW2_RADIX_OFFSET : 0), large_numbers[digit4], LARGE_DIGIT_ROWS);
         }
 
     } 
@@ -824,7 +1143,11 @@ static void displayTime(Bitmap *row_bitmap, uint32_t time_ms)
 
             uint8_t hr, min, sec;
             msToTrad(time_ms, &hr, &min, &sec);
-            if (!(*g_fsm.ctx->clock_vars->timer_set && *g_fsm.ctx->clock_vars->timer_alarm_displayed == DISPLAY_TIMER && g_fsm.curr_state->state_code != STATE_SETALARM) && g_fsm.ctx->time_format == TRAD_12H)
+            if (time_ms >= TIME_24H_MS)
+            {
+                hr = time_ms / 3600000;     // A timer of more than a day
+            }
+            if (!(frame.timer_set && frame.timer_alarm_displayed == DISPLAY_TIMER && g_fsm.curr_state->state_code != STATE_SETALARM) && g_fsm.ctx->time_format == TRAD_12H)
             {
                 if (hr >= 12) {
                     if (hr > 12)
@@ -845,43 +1168,43 @@ static void displayTime(Bitmap *row_bitmap, uint32_t time_ms)
         else if (g_fsm.ctx->time_format == DOZ_DRN5)
         {
 
-            displayChar(row_bitmap, row3_5digit_radix_pos[*g_fsm.ctx->clock_vars->diurn_radix_pos], small_numbers[RADIX_INDEX], SMALL_DIGIT_ROWS);
+            displayChar(row_bitmap, row3_5digit_radix_pos[frame.diurn_radix_pos], small_numbers[RADIX_INDEX], SMALL_DIGIT_ROWS);
 
             uint8_t digit1, digit2, digit3, digit4, digit5;
             msToDiurn(time_ms, &digit1, &digit2, &digit3, &digit4, &digit5);
 
-            displayChar(row_bitmap, DRN5_DIGIT_1_ROW3_DISPLAY_INDEX + ((*g_fsm.ctx->clock_vars->diurn_radix_pos < RADIX_POS1) ? ROW3_RADIX_OFFSET : 0), small_numbers[digit1], SMALL_DIGIT_ROWS);
-            displayChar(row_bitmap, DRN5_DIGIT_2_ROW3_DISPLAY_INDEX + ((*g_fsm.ctx->clock_vars->diurn_radix_pos < RADIX_POS2) ? ROW3_RADIX_OFFSET : 0), small_numbers[digit2], SMALL_DIGIT_ROWS);
-            displayChar(row_bitmap, DRN5_DIGIT_3_ROW3_DISPLAY_INDEX + ((*g_fsm.ctx->clock_vars->diurn_radix_pos < RADIX_POS3) ? ROW3_RADIX_OFFSET : 0), small_numbers[digit3], SMALL_DIGIT_ROWS);
-            displayChar(row_bitmap, DRN5_DIGIT_4_ROW3_DISPLAY_INDEX + ((*g_fsm.ctx->clock_vars->diurn_radix_pos < RADIX_POS4) ? ROW3_RADIX_OFFSET : 0), small_numbers[digit4], SMALL_DIGIT_ROWS);
-            displayChar(row_bitmap, DRN5_DIGIT_5_ROW3_DISPLAY_INDEX + ((*g_fsm.ctx->clock_vars->diurn_radix_pos < RADIX_POS5) ? ROW3_RADIX_OFFSET : 0), small_numbers[digit5], SMALL_DIGIT_ROWS);
+            displayChar(row_bitmap, DRN5_DIGIT_1_ROW3_DISPLAY_INDEX + ((frame.diurn_radix_pos < RADIX_POS1) ? ROW3_RADIX_OFFSET : 0), small_numbers[digit1], SMALL_DIGIT_ROWS);
+            displayChar(row_bitmap, DRN5_DIGIT_2_ROW3_DISPLAY_INDEX + ((frame.diurn_radix_pos < RADIX_POS2) ? ROW3_RADIX_OFFSET : 0), small_numbers[digit2], SMALL_DIGIT_ROWS);
+            displayChar(row_bitmap, DRN5_DIGIT_3_ROW3_DISPLAY_INDEX + ((frame.diurn_radix_pos < RADIX_POS3) ? ROW3_RADIX_OFFSET : 0), small_numbers[digit3], SMALL_DIGIT_ROWS);
+            displayChar(row_bitmap, DRN5_DIGIT_4_ROW3_DISPLAY_INDEX + ((frame.diurn_radix_pos < RADIX_POS4) ? ROW3_RADIX_OFFSET : 0), small_numbers[digit4], SMALL_DIGIT_ROWS);
+            displayChar(row_bitmap, DRN5_DIGIT_5_ROW3_DISPLAY_INDEX + ((frame.diurn_radix_pos < RADIX_POS5) ? ROW3_RADIX_OFFSET : 0), small_numbers[digit5], SMALL_DIGIT_ROWS);
 
         }
         else if (g_fsm.ctx->time_format == DOZ_SEMI)
         {
-            displayChar(row_bitmap, row3_5digit_radix_pos[*g_fsm.ctx->clock_vars->semi_diurn_radix_pos], small_numbers[RADIX_INDEX], SMALL_DIGIT_ROWS);
+            displayChar(row_bitmap, row3_5digit_radix_pos[frame.semi_diurn_radix_pos], small_numbers[RADIX_INDEX], SMALL_DIGIT_ROWS);
 
             uint8_t digit1, digit2, digit3, digit4, digit5;
             msToSemiDiurn(time_ms, &digit1, &digit2, &digit3, &digit4, &digit5);
 
             displayChar(row_bitmap, SEMI_DIGIT_1_ROW3_DISPLAY_INDEX, small_numbers[digit1], SMALL_DIGIT_ROWS);
-            displayChar(row_bitmap, SEMI_DIGIT_2_ROW3_DISPLAY_INDEX + ((*g_fsm.ctx->clock_vars->semi_diurn_radix_pos < RADIX_POS2) ? ROW3_RADIX_OFFSET : 0), small_numbers[digit2], SMALL_DIGIT_ROWS);
-            displayChar(row_bitmap, SEMI_DIGIT_3_ROW3_DISPLAY_INDEX + ((*g_fsm.ctx->clock_vars->semi_diurn_radix_pos < RADIX_POS3) ? ROW3_RADIX_OFFSET : 0), small_numbers[digit3], SMALL_DIGIT_ROWS);
-            displayChar(row_bitmap, SEMI_DIGIT_4_ROW3_DISPLAY_INDEX + ((*g_fsm.ctx->clock_vars->semi_diurn_radix_pos < RADIX_POS4) ? ROW3_RADIX_OFFSET : 0), small_numbers[digit4], SMALL_DIGIT_ROWS);
-            displayChar(row_bitmap, SEMI_DIGIT_5_ROW3_DISPLAY_INDEX + ((*g_fsm.ctx->clock_vars->semi_diurn_radix_pos < RADIX_POS5) ? ROW3_RADIX_OFFSET : 0), small_numbers[digit5], SMALL_DIGIT_ROWS);
+            displayChar(row_bitmap, SEMI_DIGIT_2_ROW3_DISPLAY_INDEX + ((frame.semi_diurn_radix_pos < RADIX_POS2) ? ROW3_RADIX_OFFSET : 0), small_numbers[digit2], SMALL_DIGIT_ROWS);
+            displayChar(row_bitmap, SEMI_DIGIT_3_ROW3_DISPLAY_INDEX + ((frame.semi_diurn_radix_pos < RADIX_POS3) ? ROW3_RADIX_OFFSET : 0), small_numbers[digit3], SMALL_DIGIT_ROWS);
+            displayChar(row_bitmap, SEMI_DIGIT_4_ROW3_DISPLAY_INDEX + ((frame.semi_diurn_radix_pos < RADIX_POS4) ? ROW3_RADIX_OFFSET : 0), small_numbers[digit4], SMALL_DIGIT_ROWS);
+            displayChar(row_bitmap, SEMI_DIGIT_5_ROW3_DISPLAY_INDEX + ((frame.semi_diurn_radix_pos < RADIX_POS5) ? ROW3_RADIX_OFFSET : 0), small_numbers[digit5], SMALL_DIGIT_ROWS);
         }
         else if (g_fsm.ctx->time_format == DOZ_DRN4)
         {
 
-            displayChar(row_bitmap, row3_4digit_radix_pos[*g_fsm.ctx->clock_vars->diurn_radix_pos], small_numbers[RADIX_INDEX], SMALL_DIGIT_ROWS);
+            displayChar(row_bitmap, row3_4digit_radix_pos[frame.diurn_radix_pos], small_numbers[RADIX_INDEX], SMALL_DIGIT_ROWS);
 
             uint8_t digit1, digit2, digit3, digit4, digit5;
             msToDiurn(time_ms, &digit1, &digit2, &digit3, &digit4, &digit5);
 
-            displayChar(row_bitmap, DRN4_DIGIT_1_ROW3_DISPLAY_INDEX + ((*g_fsm.ctx->clock_vars->diurn_radix_pos < RADIX_POS1) ? ROW3_RADIX_OFFSET : 0), small_numbers[digit1], SMALL_DIGIT_ROWS);
-            displayChar(row_bitmap, DRN4_DIGIT_2_ROW3_DISPLAY_INDEX + ((*g_fsm.ctx->clock_vars->diurn_radix_pos < RADIX_POS2) ? ROW3_RADIX_OFFSET : 0), small_numbers[digit2], SMALL_DIGIT_ROWS);
-            displayChar(row_bitmap, DRN4_DIGIT_3_ROW3_DISPLAY_INDEX + ((*g_fsm.ctx->clock_vars->diurn_radix_pos < RADIX_POS3) ? ROW3_RADIX_OFFSET : 0), small_numbers[digit3], SMALL_DIGIT_ROWS);
-            displayChar(row_bitmap, DRN4_DIGIT_4_ROW3_DISPLAY_INDEX + ((*g_fsm.ctx->clock_vars->diurn_radix_pos < RADIX_POS4) ? ROW3_RADIX_OFFSET : 0), small_numbers[digit4], SMALL_DIGIT_ROWS);
+            displayChar(row_bitmap, DRN4_DIGIT_1_ROW3_DISPLAY_INDEX + ((frame.diurn_radix_pos < RADIX_POS1) ? ROW3_RADIX_OFFSET : 0), small_numbers[digit1], SMALL_DIGIT_ROWS);
+            displayChar(row_bitmap, DRN4_DIGIT_2_ROW3_DISPLAY_INDEX + ((frame.diurn_radix_pos < RADIX_POS2) ? ROW3_RADIX_OFFSET : 0), small_numbers[digit2], SMALL_DIGIT_ROWS);
+            displayChar(row_bitmap, DRN4_DIGIT_3_ROW3_DISPLAY_INDEX + ((frame.diurn_radix_pos < RADIX_POS3) ? ROW3_RADIX_OFFSET : 0), small_numbers[digit3], SMALL_DIGIT_ROWS);
+            displayChar(row_bitmap, DRN4_DIGIT_4_ROW3_DISPLAY_INDEX + ((frame.diurn_radix_pos < RADIX_POS4) ? ROW3_RADIX_OFFSET : 0), small_numbers[digit4], SMALL_DIGIT_ROWS);
 
         }
     }
@@ -897,7 +1220,7 @@ static void blinkDigit(Bitmap *row_bitmap, uint8_t char_index, bool symbol)
         }
         else
         {
-            uint8_t am_pm_index = (g_fsm.ctx->clock_vars->digit_vals[6]) ? PM_INDEX : AM_INDEX;
+            uint8_t am_pm_index = (frame.digit_vals[6]) ? PM_INDEX : AM_INDEX;
             updateBitmap(row_bitmap, char_index, small_symbols[am_pm_index], SMALL_DIGIT_ROWS, false);
         }
 
@@ -912,7 +1235,7 @@ static void blinkDigit(Bitmap *row_bitmap, uint8_t char_index, bool symbol)
         }
         else
         {
-            updateBitmap(row_bitmap, char_index, large_numbers[g_fsm.ctx->clock_vars->digit_vals[*(g_fsm.ctx->clock_vars->digit_sel)]], LARGE_DIGIT_ROWS, false);
+            updateBitmap(row_bitmap, char_index, large_numbers[frame.digit_vals[frame.digit_sel]], LARGE_DIGIT_ROWS, false);
         }
     }
     else if (row_bitmap->num == ROW_3)
@@ -923,7 +1246,7 @@ static void blinkDigit(Bitmap *row_bitmap, uint8_t char_index, bool symbol)
         }
         else
         {
-            updateBitmap(row_bitmap, char_index, small_numbers[g_fsm.ctx->clock_vars->digit_vals[*(g_fsm.ctx->clock_vars->digit_sel)]], SMALL_DIGIT_ROWS, false);
+            updateBitmap(row_bitmap, char_index, small_numbers[frame.digit_vals[frame.digit_sel]], SMALL_DIGIT_ROWS, false);
         }
     }
 }
@@ -0,0 +1,322 @@
+/*
+ * display_mux.c
+ * Fans the clock display out to several backends
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: Matt L.
+ *
+ * The mux keeps the latest value of every display item. Each sink has a
+ * dirty mask of the items it has not been sent yet. Sinks without a rate
+ * cap are written straight through. Capped sinks are written from
+ * DisplayMux_Update, after the clock has finished drawing a whole frame,
+ * and get only the newest value of each item.
+ */
+
+#include "display_mux.h"
+
+/*
+    Private types
+*/
+typedef enum display_item_t
+{
+    ITEM_POWER,
+    ITEM_BRIGHTNESS,
+    ITEM_COLOUR,                                    // One per region
+    ITEM_BITMAP = ITEM_COLOUR + DISPLAY_MUX_REGIONS,
+    ITEM_SHOWN  = ITEM_BITMAP + DISPLAY_MUX_REGIONS,
+    ITEM_STATE  = ITEM_SHOWN + DISPLAY_MUX_REGIONS,
+
+    NUM_ITEMS
+} DisplayItem;
+
+typedef struct display_sink_t
+{
+    Display             *backend;
+    uint32_t            min_period_ms;  // 0 to write straight through
+    uint32_t            last_flush_ms;
+    uint32_t            dirty;          // Bit per DisplayItem
+    DisplaySinkStats    stats;
+} DisplaySink;
+
+/*
+    Private function definitions
+*/
+static void muxDisplayOff(void);
+static void muxDisplayOn(void);
+static void muxSetBrightness(uint8_t brightness);
+static void muxSetBitmap(uint8_t region_id, uint8_t *bitmap);
+static void muxSetColour(uint8_t region_id, Colour colour_id);
+static void muxShow(uint8_t region_id);
+static void muxHide(uint8_t region_id);
+static void muxSetState(DisplayStateMsg *state);
+
+static void itemUpdated(DisplayItem item, bool changed);
+static void flushSink(DisplaySink *sink);
+static uint8_t bitmapSize(uint8_t region_id);
+
+/*
+    Private variables
+*/
+static DisplayMux *g_mux = NULL;
+static DisplaySink sinks[DISPLAY_MUX_MAX_SINKS];
+static uint8_t num_sinks;
+
+// Latest value of each item
+static uint32_t valid;          // Bit per DisplayItem that has been set
+static bool power_on;
+static uint8_t brightness;
+static Colour colours[DISPLAY_MUX_REGIONS];
+static uint8_t bitmaps[DISPLAY_MUX_REGIONS][LARGE_BITMAP_SIZE];
+static bool shown[DISPLAY_MUX_REGIONS];
+static DisplayStateMsg state;
+
+/*
+    Public functions
+*/
+ClockStatus DisplayMux_Init(DisplayMux *self)
+{
+    if (self->getTick == NULL)
+    {
+        return CLOCK_FAIL;
+    }
+    g_mux = self;
+    g_mux->display.displayOff = muxDisplayOff;
+    g_mux->display.displayOn = muxDisplayOn;
+    g_mux->display.setBrightness = muxSetBrightness;
+    g_mux->display.setBitmap = muxSetBitmap;
+    g_mux->display.setColour = muxSetColour;
+    g_mux->display.show = muxShow;
+    g_mux->display.hide = muxHide;
+    g_mux->display.setState = NULL;
+    num_sinks = 0;
+    valid = 0;
+    return CLOCK_OK;
+}
+
+ClockStatus DisplayMux_AddSink(Display *sink, uint32_t min_period_ms, uint8_t *sink_id)
+{
+    bool all_state = true;
+
+    if (g_mux == NULL || num_sinks >= DISPLAY_MUX_MAX_SINKS ||
+            sink->displayOff == NULL ||
+            sink->displayOn == NULL ||
+            sink->setBrightness == NULL ||
+            sink->setBitmap == NULL ||
+            sink->setColour == NULL ||
+            sink->show == NULL ||
+            sink->hide == NULL)
+    {
+        return CLOCK_FAIL;
+    }
+    memset(&sinks[num_sinks], 0, sizeof(DisplaySink));
+    sinks[num_sinks].backend = sink;
+    sinks[num_sinks].min_period_ms = min_period_ms;
+    sinks[num_sinks].dirty = valid;     // Catch up on anything already drawn
+    if (sink_id != NULL)
+    {
+        *sink_id = num_sinks;
+    }
+    num_sinks++;
+
+    // State is only sent when every sink renders locally, otherwise all sinks get bitmaps
+    for (int i = 0; i < num_sinks; i++)
+    {
+        all_state = all_state && (sinks[i].backend->setState != NULL);
+    }
+    g_mux->display.setState = all_state ? muxSetState : NULL;
+    return CLOCK_OK;
+}
+
+// Call after Display_Update, writes rate capped sinks that are due
+void DisplayMux_Update(void)
+{
+    uint32_t now = g_mux->getTick();
+
+    for (int i = 0; i < num_sinks; i++)
+    {
+        if (sinks[i].dirty && now - sinks[i].last_flush_ms >= sinks[i].min_period_ms)
+        {
+            sinks[i].last_flush_ms = now;
+            flushSink(&sinks[i]);
+        }
+    }
+}
+
+// A sink has changes it is allowed to take now
+bool DisplayMux_Pending(void)
+{
+    uint32_t now = g_mux->getTick();
+
+    for (int i = 0; i < num_sinks; i++)
+    {
+        if (sinks[i].dirty && now - sinks[i].last_flush_ms >= sinks[i].min_period_ms)
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+ClockStatus DisplayMux_GetStats(uint8_t sink_id, DisplaySinkStats *stats)
+{
+    if (sink_id >= num_sinks)
+    {
+        return CLOCK_FAIL;
+    }
+    *stats = sinks[sink_id].stats;
+    return CLOCK_OK;
+}
+
+/*
+    Private functions
+*/
+static void muxDisplayOff(void)
+{
+    bool changed = power_on || !(valid & (1UL << ITEM_POWER));
+    power_on = false;
+    itemUpdated(ITEM_POWER, changed);
+}
+
+static void muxDisplayOn(void)
+{
+    bool changed = !power_on || !(valid & (1UL << ITEM_POWER));
+    power_on = true;
+    itemUpdated(ITEM_POWER, changed);
+}
+
+static void muxSetBrightness(uint8_t level)
+{
+    bool changed = brightness != level || !(valid & (1UL << ITEM_BRIGHTNESS));
+    brightness = level;
+    itemUpdated(ITEM_BRIGHTNESS, changed);
+}
+
+static void muxSetBitmap(uint8_t region_id, uint8_t *bitmap)
+{
+    if (region_id >= DISPLAY_MUX_REGIONS)
+    {
+        return;
+    }
+    bool changed = memcmp(bitmaps[region_id], bitmap, bitmapSize(region_id)) != 0 ||
+            !(valid & (1UL << (ITEM_BITMAP + region_id)));
+    memcpy(bitmaps[region_id], bitmap, bitmapSize(region_id));
+    itemUpdated(ITEM_BITMAP + region_id, changed);
+}
+
+static void muxSetColour(uint8_t region_id, Colour colour_id)
+{
+    if (region_id >= DISPLAY_MUX_REGIONS)
+    {
+        return;
+    }
+    bool changed = colours[region_id] != colour_id || !(valid & (1UL << (ITEM_COLOUR + region_id)));
+    colours[region_id] = colour_id;
+    itemUpdated(ITEM_COLOUR + region_id, changed);
+}
+
+static void muxShow(uint8_t region_id)
+{
+    if (region_id >= DISPLAY_MUX_REGIONS)
+    {
+        return;
+    }
+    bool changed = !shown[region_id] || !(valid & (1UL << (ITEM_SHOWN + region_id)));
+    shown[region_id] = true;
+    itemUpdated(ITEM_SHOWN + region_id, changed);
+}
+
+static void muxHide(uint8_t region_id)
+{
+    if (region_id >= DISPLAY_MUX_REGIONS)
+    {
+        return;
+    }
+    bool changed = shown[region_id] || !(valid & (1UL << (ITEM_SHOWN + region_id)));
+    shown[region_id] = false;
+    itemUpdated(ITEM_SHOWN + region_id, changed);
+}
+
+static void muxSetState(DisplayStateMsg *new_state)
+{
+    // Display only publishes state when it has changed
+    state = *new_state;
+    itemUpdated(ITEM_STATE, true);
+}
+
+static void itemUpdated(DisplayItem item, bool changed)
+{
+    uint32_t bit = 1UL << item;
+
+    valid |= bit;
+    for (int i = 0; i < num_sinks; i++)
+    {
+        if (!changed)
+        {
+            sinks[i].stats.dropped++;
+            continue;
+        }
+        if (sinks[i].dirty & bit)
+        {
+            sinks[i].stats.coalesced++;
+        }
+        sinks[i].dirty |= bit;
+        if (sinks[i].min_period_ms == 0)
+        {
+            flushSink(&sinks[i]);
+        }
+    }
+}
+
+// Power and appearance first so new bitmaps never flash in the old colour
+static void flushSink(DisplaySink *sink)
+{
+    Display *backend = sink->backend;
+    uint32_t dirty = sink->dirty;
+
+    sink->dirty = 0;
+    for (int item = 0; item < NUM_ITEMS; item++)
+    {
+        if (!(dirty & (1UL << item)))
+        {
+            continue;
+        }
+        if (item == ITEM_POWER && power_on)
+        {
+            backend->displayOn();
+        }
+        else if (item == ITEM_POWER)
+        {
+            backend->displayOff();
+        }
+        else if (item == ITEM_BRIGHTNESS)
+        {
+            backend->setBrightness(brightness);
+        }
+        else if (item < ITEM_BITMAP)
+        {
+            backend->setColour(item - ITEM_COLOUR, colours[item - ITEM_COLOUR]);
+        }
+        else if (item < ITEM_SHOWN)
+        {
+            backend->setBitmap(item - ITEM_BITMAP, bitmaps[item - ITEM_BITMAP]);
+        }
+        else if (item < ITEM_STATE && shown[item - ITEM_SHOWN])
+        {
+            backend->show(item - ITEM_SHOWN);
+        }
+        else if (item < ITEM_STATE)
+        {
+            backend->hide(item - ITEM_SHOWN);
+        }
+        else if (backend->setState != NULL)
+        {
+            backend->setState(&state);
+        }
+        sink->stats.delivered++;
+    }
+}
+
+static uint8_t bitmapSize(uint8_t region_id)
+{
+    return (region_id == ROW_2) ? LARGE_BITMAP_SIZE : SMALL_BITMAP_SIZE;
+}
@@ -1,4 +1,5 @@
 #include "doz_clock.h"
+#include "fsm_table.h"
 
 static void Default_Entry(DozClock *ctx);
 static void Default_Update(DozClock *ctx);
@@ -30,18 +31,21 @@ static void SetCalib_Entry(DozClock *ctx);
 static void SetCalib_Update(DozClock *ctx);
 static void SetCalib_Exit(DozClock *ctx);
 
-static void transition(DozClockState *next);
+static void transition(const DozClockState *next);
 static void process_event();
-static void state_event_map_init();
 static void update_user_timer(DozClock *ctx, uint32_t time_elapsed);
 static void transition_digits(TimeFormats timeFormat, uint32_t ms, uint8_t *vals);
 static void update_timer_in_rtc(DozClock *ctx);
-
-static void (*state_event_map[NUM_STATES][NUM_EVENTS]) (void);
-
-static ExternVars clock_vars = { 0 };
+static EpochMs timer_end(DozClock *ctx);
+static void set_timer_alarm(void);
+static bool timer_due(void);
+static const DigitEntryFormat *entry_format(void);
+static void publish_snapshot(DozClock *ctx);
+static void probe_rtc_edge(void);
+
+static SnapshotPub clock_snapshot;
+static ClockSnapshot snapshot;     // Static so its padding stays zero for the compare in Snapshot_Publish
 static DozClockFSM g_clock_fsm = { 0 };
-static uint8_t timer_delay = 0;
 
 static TimeFormats trad_format_list[] = {TRAD_24H, TRAD_12H};
 static TimeFormats doz_format_list[] = {DOZ_SEMI, DOZ_DRN4, DOZ_DRN5};
@@ -51,11 +55,10 @@ static uint8_t trad_index = 0, doz_index = 1;
 static uint8_t cancel_pressed = 0;
 static uint32_t user_alarm_ms_old, user_timer_ms_old, time_ms_old;
 static uint8_t alarm_set_old, timer_set_old;
-static uint32_t timer_end_ms, curr_set_timer_ms = TIME_24H_MS;
+static EpochMs timer_end_ms;
+static uint32_t curr_set_timer_ms = TIME_24H_MS;
 static uint32_t buzzer_countdown_ms;
 
-static uint32_t increments;
-
 static RtcTime demo_reset = {
         .hr = 17,
         .min = 22,
@@ -67,64 +70,71 @@ static RtcTime alarm_time;
 static uint32_t curr_timer_ms, curr_time_ms, curr_alarm_ms;
 static bool digits_changed = false;
 
+static SchedTask clock_tasks[] = {
+    {.name = "update",  .run = DozClock_Update,             .period_ms = UPDATE_PERIOD_MS,  .ready = EventQ_Pending},
+    {.name = "timer",   .run = DozClock_TimerCallback,      .period_ms = TIMER_PERIOD_MS},
+    {.name = "blink",   .run = Display_PeriodicCallback,    .period_ms = DISPLAY_BLINK_PERIOD_MS},
+};
+static SchedTask edge_task = {.name = "edge", .run = probe_rtc_edge};
+
 // State definitions
-static DozClockState s_init =
+static const DozClockState s_init =
 {
     .state_code = STATE_INIT,
     .entry      = Init_Entry,
     .update     = Init_Update,
     .exit       = Init_Exit,
 };
-static DozClockState s_idle_disp_on =
+static const DozClockState s_idle_disp_on =
 {
     .state_code = STATE_IDLE_DISP_ON,
     .entry      = IdleDispOn_Entry,
     .update     = IdleDispOn_Update,
     .exit       = Default_Exit,
 };
-static DozClockState s_idle_disp_off =
+static const DozClockState s_idle_disp_off =
 {
     .state_code = STATE_IDLE_DISP_OFF,
     .entry      = IdleDispOff_Entry,
     .update     = IdleDispOff_Update,
     .exit       = IdleDispOff_Exit,
 };
-static DozClockState s_set_alarm =
+static const DozClockState s_set_alarm =
 {
     .state_code = STATE_SET_ALARM,
     .entry      = SetAlarm_Entry,
     .update     = SetAlarm_Update,
     .exit       = SetAlarm_Exit,
 };
-static DozClockState s_set_timer =
+static const DozClockState s_set_timer =
 {
     .state_code = STATE_SET_TIMER,
     .entry      = SetTimer_Entry,
     .update     = SetTimer_Update,
     .exit       = SetTimer_Exit,
 };
-static DozClockState s_set_time =
+static const DozClockState s_set_time =
 {
     .state_code = STATE_SET_TIME,
     .entry      = SetTime_Entry,
     .update     = SetTime_Update,
     .exit       = SetTime_Exit,
 };
-static DozClockState s_alarm_timer_disp_on =
+static const DozClockState s_alarm_timer_disp_on =
 {
     .state_code = STATE_ALARM_TIMER_DISP_ON,
     .entry      = AlarmTimerDispOn_Entry,
     .update     = AlarmTimerDispOn_Update,
     .exit       = AlarmTimerDispOn_Exit,
 };
-static DozClockState s_alarm_timer_disp_off =
+static const DozClockState s_alarm_timer_disp_off =
 {
     .state_code = STATE_ALARM_TIMER_DISP_OFF,
     .entry      = AlarmTimerDispOff_Entry,
     .update     = AlarmTimerDispOff_Update,
     .exit       = AlarmTimerDispOff_Exit,
 };
-static DozClockState s_set_calib =
+static const DozClockState s_set_calib =
 {
     .state_code = STATE_SET_CALIB,
     .entry      = SetCalib_Entry,
@@ -135,48 +145,26 @@ static DozClockState s_set_calib =
 // FSM Event Functions
 void DozClock_Init(DozClock *ctx)
 {
-    clock_vars.alarm_set                = &ctx->alarm_set;
-    clock_vars.alarm_triggered          = &ctx->alarm_triggered;
-    clock_vars.timer_set                = &ctx->timer_set;
-    clock_vars.timer_triggered          = &ctx->timer_triggered;
-    clock_vars.show_error               = &ctx->show_error;
-    clock_vars.digit_sel                = &ctx->digit_sel;
-    clock_vars.digit_vals               = ctx->digit_vals;
-    clock_vars.error_code               = &ctx->error_code;
-    clock_vars.time_ms                  = &ctx->time_ms;
-    clock_vars.user_alarm_ms            = &ctx->user_alarm_ms;
-    clock_vars.user_time_ms             = &ctx->user_time_ms;
-    clock_vars.user_timer_ms            = &ctx->user_timer_ms;
-    clock_vars.timer_alarm_displayed    = &ctx->timer_alarm_displayed;
-    clock_vars.diurn_radix_pos          = &ctx->diurn_radix_pos;
-    clock_vars.semi_diurn_radix_pos     = &ctx->semi_diurn_radix_pos;
-    clock_vars.rtc_calib                = &ctx->rtc_calib;
-
-    *clock_vars.alarm_set               = 0;
-    *clock_vars.alarm_triggered         = 0;
-    *clock_vars.timer_set               = 0;
-    *clock_vars.timer_triggered         = 0;
-    *clock_vars.show_error              = 0;
-    *clock_vars.digit_sel               = 0;
-    clock_vars.digit_vals[0]            = 0;
-    clock_vars.digit_vals[1]            = 0;
-    clock_vars.digit_vals[2]            = 0;
-    clock_vars.digit_vals[3]            = 0;
-    clock_vars.digit_vals[4]            = 0;
-    clock_vars.digit_vals[5]            = 0;
-    clock_vars.digit_vals[6]            = 0;
-    *clock_vars.error_code              = 0;
-    *clock_vars.time_ms                 = 0;
-    *clock_vars.user_alarm_ms           = 0;
-    *clock_vars.user_time_ms            = 0;
-    *clock_vars.user_timer_ms           = TIME_24H_MS;
-    *clock_vars.timer_alarm_displayed   = DISPLAY_TIMER;
-    *clock_vars.diurn_radix_pos         = RADIX_POS3;
-    *clock_vars.semi_diurn_radix_pos    = RADIX_POS2;
-
-    state_event_map_init();
-
-    ctx->curr_event = E_NONE;
+    ctx->alarm_set              = 0;
+    ctx->alarm_triggered        = 0;
+    ctx->timer_set              = 0;
+    ctx->timer_triggered        = 0;
+    ctx->show_error             = 0;
+    ctx->digit_sel              = 0;
+    memset(ctx->digit_vals, 0, sizeof(ctx->digit_vals));
+    ctx->error_code             = 0;
+    ctx->time_ms                = 0;
+    ctx->user_alarm_ms          = 0;
+    ctx->user_time_ms           = 0;
+    ctx->user_timer_ms          = TIME_24H_MS;
+    ctx->timer_alarm_displayed  = DISPLAY_TIMER;
+    ctx->diurn_radix_pos        = RADIX_POS3;
+    ctx->semi_diurn_radix_pos   = RADIX_POS2;
+
+    Snapshot_Init(&clock_snapshot);
+    publish_snapshot(ctx);
+
+    ctx->curr_event.id = E_NONE;
 
     g_clock_fsm.ctx = ctx;
     g_clock_fsm.curr_state = &s_init;
@@ -187,17 +175,35 @@ void DozClock_Update()
 {
     TimeTrack_Update();
     g_clock_fsm.curr_state->update(g_clock_fsm.ctx);
+    publish_snapshot(g_clock_fsm.ctx);
     Display_Update();
-    if (EventQ_GetEvent(&g_clock_fsm.ctx->curr_event) == CLOCK_OK)
+
+    // Handle everything queued since the last pass, not one event per loop
+    while (EventQ_GetEvent(&g_clock_fsm.ctx->curr_event) == CLOCK_OK)
     {
         process_event();
     }
 }
 
-// Called from 6 Hz timer
+// Call once the scheduler is running, after DozClock_Init
+void DozClock_StartTasks(void)
+{
+    for (uint8_t i = 0; i < sizeof(clock_tasks) / sizeof(clock_tasks[0]); i++)
+    {
+        Sched_Start(&clock_tasks[i], 0);
+    }
+}
+
+// Run every TIMER_PERIOD_MS
 void DozClock_TimerCallback()
 {
+    uint32_t edge_ms;
+
     TimeTrack_PeriodicCallback(TIMER_PERIOD_MS);
+    if (TimeTrack_NextEdgeMs(&edge_ms) == CLOCK_OK && edge_ms < TIMER_PERIOD_MS)
+    {
+        Sched_Start(&edge_task, edge_ms);
+    }
     if (g_clock_fsm.ctx->timer_set) 
     {
         if (g_clock_fsm.ctx->user_timer_ms <= TIMER_PERIOD_MS) {
@@ -206,12 +212,6 @@ void DozClock_TimerCallback()
             update_user_timer(g_clock_fsm.ctx, TIMER_PERIOD_MS);
         }
     }
-    if (timer_delay == 0)
-    {
-        // Called as 2 Hz timer
-        Display_PeriodicCallback();
-    }
-    timer_delay = (timer_delay + 1) % 3;
 }
 
 // Generic State Functions
@@ -248,7 +248,7 @@ void Init_Entry(DozClock *ctx)
         ctx->error_code = SFWR_INIT;
         ctx->error_handler();
     }
-    if (Display_Init(ctx->display, &clock_vars) != CLOCK_OK)
+    if (Display_Init(ctx->display, &clock_snapshot) != CLOCK_OK)
     {
         ctx->error_code = DISP_INIT;
         ctx->error_handler();
@@ -339,47 +339,11 @@ void SetAlarm_Update(DozClock *ctx)
 {
     TimeTrack_GetTimeMs(&ctx->time_ms);
 
-    if (!digits_changed) {
-        ctx->user_alarm_ms = curr_alarm_ms;
-    } else {
-        if (curr_format == TRAD_24H || curr_format == TRAD_12H) {
-
-            ctx->user_alarm_ms = (uint32_t) (10*ctx->digit_vals[4] + ctx->digit_vals[5]) * 1000 +   // sec
-                                (uint32_t) (10*ctx->digit_vals[2] + ctx->digit_vals[3]) * 60000;   // min
-
-            if (curr_format == TRAD_24H) {
-                ctx->user_alarm_ms += (uint32_t) (10*ctx->digit_vals[0] + ctx->digit_vals[1]) * 3600000;
-            } else { // TRAD_12H
-                if (ctx->digit_vals[6] == 1 && (10*ctx->digit_vals[0] + ctx->digit_vals[1]) != 12) // PM && hour != 12
-                    ctx->user_alarm_ms += (uint32_t) (10*ctx->digit_vals[0] + ctx->digit_vals[1] + 12) * 3600000;
-                else
-                    ctx->user_alarm_ms += (uint32_t) (10*ctx->digit_vals[0] + ctx->digit_vals[1]) * 3600000;
-            }
-
-        } else if (curr_format == DOZ_SEMI) {
-
-            increments = ctx->digit_vals[0]*pow(12,4) 
-                            + ctx->digit_vals[1]*pow(12,3)
-                            + ctx->digit_vals[2]*pow(12,2)
-                            + ctx->digit_vals[3]*pow(12,1)
-                            + ctx->digit_vals[4];
-
-            ctx->user_alarm_ms = round(increments*2083.33333333);
-
-        } else { // DOZ_DRN4 || DOZ_DRN5
-
-            increments = ctx->digit_vals[0]*pow(12,4) 
-                            + ctx->digit_vals[1]*pow(12,3)
-                            + ctx->digit_vals[2]*pow(12,2)
-                            + ctx->digit_vals[3]*pow(12,1)
-                            + ((curr_format == DOZ_DRN5) ? ctx->digit_vals[4] : 0);
-
-            ctx->user_alarm_ms = round(increments*347.22222222);
-
-        }
-
-        curr_alarm_ms = ctx->user_alarm_ms;
+    if (digits_changed) {
+        curr_alarm_ms = DigitEntry_ToMs(entry_format(), ctx->digit_vals);
+        digits_changed = false;
     }
+    ctx->user_alarm_ms = curr_alarm_ms;
 }
 void SetAlarm_Exit(DozClock *ctx)
 {
@@ -396,7 +360,7 @@ void SetAlarm_Exit(DozClock *ctx)
     RtcTime alarmTime;
     ctx->alarm_set = true;
 
-    msToRtcTime(ctx->user_alarm_ms, &alarmTime);
+    Epoch_MsToHms(ctx->user_alarm_ms, &alarmTime.hr, &alarmTime.min, &alarmTime.sec);
     Rtc_SetAlarm(&alarmTime, ALARM);
     Rtc_EnableAlarm(ALARM, ctx->alarm_set);
 
@@ -434,52 +398,17 @@ void SetTimer_Update(DozClock *ctx)
 {
     TimeTrack_GetTimeMs(&ctx->time_ms);
 
-    if (!digits_changed) {
-        ctx->user_timer_ms = curr_timer_ms;
-    } else {
-        if (curr_format == TRAD_24H || curr_format == TRAD_12H) {
-            ctx->user_timer_ms = (uint32_t) (10*ctx->digit_vals[4] + ctx->digit_vals[5]) * 1000 +
-                                (uint32_t) (10*ctx->digit_vals[2] + ctx->digit_vals[3]) * 60000;
-            if (curr_format == TRAD_24H) {
-                ctx->user_timer_ms += (uint32_t) (10*ctx->digit_vals[0] + ctx->digit_vals[1]) * 3600000;
-            } else { // TRAD_12H
-                if (ctx->digit_vals[6] == 1 && (10*ctx->digit_vals[0] + ctx->digit_vals[1]) != 12) // PM && hour != 12
-                    ctx->user_timer_ms += (uint32_t) (10*ctx->digit_vals[0] + ctx->digit_vals[1] + 12) * 3600000;
-                else
-                    ctx->user_timer_ms += (uint32_t) (10*ctx->digit_vals[0] + ctx->digit_vals[1]) * 3600000;
-            }
-        } else if (curr_format == DOZ_SEMI) {
-
-            increments = ctx->digit_vals[0]*pow(12,4) 
-                            + ctx->digit_vals[1]*pow(12,3)
-                            + ctx->digit_vals[2]*pow(12,2)
-                            + ctx->digit_vals[3]*pow(12,1)
-                            + ctx->digit_vals[4];
-
-            ctx->user_timer_ms = round(increments*2083.33333333);
-
-        } else { // DOZ_DRN4 || DOZ_DRN5
-
-            increments = ctx->digit_vals[0]*pow(12,4) 
-                            + ctx->digit_vals[1]*pow(12,3)
-                            + ctx->digit_vals[2]*pow(12,2)
-                            + ctx->digit_vals[3]*pow(12,1)
-                            + ((curr_format == DOZ_DRN5) ? ctx->digit_vals[4] : 0);
-
-            ctx->user_timer_ms = round(increments*347.22222222);
-
-        }
-        
-        curr_timer_ms = ctx->user_timer_ms;
+    if (digits_changed) {
+        curr_timer_ms = DigitEntry_ToMs(entry_format(), ctx->digit_vals);
+        digits_changed = false;
     }
+    ctx->user_timer_ms = curr_timer_ms;
 }
 void SetTimer_Exit(DozClock *ctx)
 {
     ctx->alarm_set = alarm_set_old;
     Rtc_EnableAlarm(ALARM, ctx->alarm_set);
 
-    RtcTime timerTime;
-
     if (cancel_pressed) {
         ctx->user_timer_ms = user_timer_ms_old;
         ctx->timer_set = timer_set_old;
@@ -489,10 +418,9 @@ void SetTimer_Exit(DozClock *ctx)
     }
 
     curr_set_timer_ms = ctx->user_timer_ms;
-    timer_end_ms = (curr_set_timer_ms + ctx->time_ms) % TIME_24H_MS;
+    timer_end_ms = timer_end(ctx);
 
-    msToRtcTime(timer_end_ms, &timerTime);
-    Rtc_SetAlarm(&timerTime, TIMER);
+    set_timer_alarm();
     Rtc_EnableAlarm(TIMER, ctx->timer_set);
 
     Display_SetFormat(timer_prev_format);
@@ -519,44 +447,11 @@ void SetTime_Update(DozClock *ctx)
 {
     TimeTrack_GetTimeMs(&ctx->time_ms);
 
-    if (!digits_changed) {
-        ctx->user_time_ms = curr_time_ms;
-    } else {
-        if (curr_format == TRAD_24H || curr_format == TRAD_12H) {
-            ctx->user_time_ms = (uint32_t) (10*ctx->digit_vals[4] + ctx->digit_vals[5]) * 1000 +
-                                (uint32_t) (10*ctx->digit_vals[2] + ctx->digit_vals[3]) * 60000;
-            if (curr_format == TRAD_24H) {
-                ctx->user_time_ms += (uint32_t) (10*ctx->digit_vals[0] + ctx->digit_vals[1]) * 3600000;
-            } else { // TRAD_12H
-                if (ctx->digit_vals[6] == 1 && (10*ctx->digit_vals[0] + ctx->digit_vals[1]) != 12) // PM && hour != 12
-                    ctx->user_time_ms += (uint32_t) (10*ctx->digit_vals[0] + ctx->digit_vals[1] + 12) * 3600000;
-                else
-                    ctx->user_time_ms += (uint32_t) (10*ctx->digit_vals[0] + ctx->digit_vals[1]) * 3600000;
-            }
-        } else if (curr_format == DOZ_SEMI) {
-
-            increments = ctx->digit_vals[0]*pow(12,4) 
-                            + ctx->digit_vals[1]*pow(12,3)
-                            + ctx->digit_vals[2]*pow(12,2)
-                            + ctx->digit_vals[3]*pow(12,1)
-                            + ctx->digit_vals[4];
-
-            ctx->user_time_ms = round(increments*2083.33333333);
-
-        } else { // DOZ_DRN4 || DOZ_DRN5
-
-            increments = ctx->digit_vals[0]*pow(12,4) 
-                            + ctx->digit_vals[1]*pow(12,3)
-                            + ctx->digit_vals[2]*pow(12,2)
-                            + ctx->digit_vals[3]*pow(12,1)
-                            + ((curr_format == DOZ_DRN5) ? ctx->digit_vals[4] : 0);
-
-            ctx->user_time_ms = round(increments*347.22222222);
-
-        }
-
-        curr_time_ms = ctx->user_time_ms;
+    if (digits_changed) {
+        curr_time_ms = DigitEntry_ToMs(entry_format(), ctx->digit_vals);
+        digits_changed = false;
     }
+    ctx->user_time_ms = curr_time_ms;
 }
 void SetTime_Exit(DozClock *ctx)
 {
@@ -570,7 +465,7 @@ void SetTime_Exit(DozClock *ctx)
     }
 
     RtcTime time;
-    msToRtcTime(ctx->user_time_ms, &time);
+    Epoch_MsToHms(ctx->user_time_ms, &time.hr, &time.min, &time.sec);
     Rtc_SetTime(&time);
     if (TimeTrack_SyncToRtc() != CLOCK_OK)
     {
@@ -690,22 +585,14 @@ static void SetCalib_Exit(DozClock *ctx)
 }
 
 // Helper functions
-static void transition(DozClockState *next)
+static void transition(const DozClockState *next)
 {
+    FlightRec_Log(REC_CLOCK_STATE, next->state_code, g_clock_fsm.curr_state->state_code, 0);
     g_clock_fsm.curr_state->exit(g_clock_fsm.ctx);
     g_clock_fsm.curr_state = next;
     g_clock_fsm.curr_state->entry(g_clock_fsm.ctx);
 }
 
-static void process_event()
-{
-    if (state_event_map[g_clock_fsm.curr_state->state_code][g_clock_fsm.ctx->curr_event] != NULL) 
-    {
-        (*state_event_map[g_clock_fsm.curr_state->state_code][g_clock_fsm.ctx->curr_event]) ();
-    }
-    g_clock_fsm.ctx->curr_event = E_NONE;
-}
-
 static void update_user_timer(DozClock *ctx, uint32_t time_elapsed)
 {
     ctx->user_timer_ms -= time_elapsed;
@@ -718,6 +605,8 @@ static void transition_digits(TimeFormats timeFormat, uint32_t ms, uint8_t *vals
         uint8_t hr, min, sec;
         
         msToTrad(ms, &hr, &min, &sec);
+        if (ms >= TIME_24H_MS)
+            hr = ms / 3600000;  // Only a timer runs past a day
 
         if (timeFormat == TRAD_12H && hr > 12) {
             hr -= 12;
@@ -752,53 +641,64 @@ static void transition_digits(TimeFormats timeFormat, uint32_t ms, uint8_t *vals
     }
 }
 
-void msToTrad(uint32_t time_ms, uint8_t *hr_24, uint8_t *min, uint8_t *sec)
+void update_timer_in_rtc(DozClock *ctx)
 {
-    time_ms = time_ms / 1000;
-    *sec = time_ms % 60;
-    time_ms = time_ms / 60;
-    *min = time_ms % 60;
-    time_ms = time_ms / 60;
-    *hr_24 = time_ms % 24;
+    timer_end_ms = timer_end(ctx);
+    set_timer_alarm();
+    Rtc_EnableAlarm(TIMER, true);
 }
 
-void msToDiurn(uint32_t time_ms, uint8_t *digit1, uint8_t *digit2, uint8_t *digit3, uint8_t *digit4, uint8_t *digit5)
+// The timer runs out a whole count after the time shown, on whatever day that lands
+static EpochMs timer_end(DozClock *ctx)
 {
-    increments = (uint32_t) round(time_ms / 347.22222222);
+    EpochMs now_ms;
 
-    *digit5 = increments % 12;
-    increments /= 12;
-    *digit4 = increments % 12;
-    increments /= 12;
-    *digit3 = increments % 12;
-    increments /= 12;
-    *digit2 = increments % 12;
-    increments /= 12;
-    *digit1 = increments % 12;
+    TimeTrack_GetEpochMs(&now_ms);
+    return Epoch_Nearest(now_ms, ctx->time_ms) + ctx->user_timer_ms;
 }
 
-void msToSemiDiurn(uint32_t time_ms, uint8_t *digit1, uint8_t *digit2, uint8_t *digit3, uint8_t *digit4, uint8_t *digit5)
+// The RTC alarm matches the time of day only, it goes off once a day until the end is this close
+static void set_timer_alarm(void)
 {
-    increments = (uint32_t) round(time_ms / 2083.33333333);
+    RtcTime timerTime;
 
-    *digit5 = increments % 12;
-    increments /= 12;
-    *digit4 = increments % 12;
-    increments /= 12;
-    *digit3 = increments % 12;
-    increments /= 12;
-    *digit2 = increments % 12;
-    increments /= 12;
-    *digit1 = increments % 2;
+    Epoch_MsToHms(Epoch_TimeOfDay(timer_end_ms), &timerTime.hr, &timerTime.min, &timerTime.sec);
+    Rtc_SetAlarm(&timerTime, TIMER);
 }
 
-void update_timer_in_rtc(DozClock *ctx)
+static bool timer_due(void)
 {
-    RtcTime timerTime;
-    timer_end_ms = (ctx->user_timer_ms + ctx->time_ms) % TIME_24H_MS;
-    msToRtcTime(timer_end_ms, &timerTime);
-    Rtc_SetAlarm(&timerTime, TIMER);
-    Rtc_EnableAlarm(TIMER, true);
+    EpochMs now_ms;
+
+    TimeTrack_GetEpochMs(&now_ms);
+    return now_ms + TIMER_EARLY_MS >= timer_end_ms;
+}
+
+static void probe_rtc_edge(void)
+{
+    TimeTrack_Probe();
+}
+
+// Unchanged values keep the same sequence number, so the display can skip the frame
+void publish_snapshot(DozClock *ctx)
+{
+    snapshot.time_ms                = ctx->time_ms;
+    snapshot.user_time_ms           = ctx->user_time_ms;
+    snapshot.user_alarm_ms          = ctx->user_alarm_ms;
+    snapshot.user_timer_ms          = ctx->user_timer_ms;
+    snapshot.rtc_calib              = ctx->rtc_calib;
+    snapshot.error_code             = ctx->error_code;
+    snapshot.digit_sel              = ctx->digit_sel;
+    memcpy(snapshot.digit_vals, ctx->digit_vals, sizeof(snapshot.digit_vals));
+    snapshot.diurn_radix_pos        = ctx->diurn_radix_pos;
+    snapshot.semi_diurn_radix_pos   = ctx->semi_diurn_radix_pos;
+    snapshot.alarm_set              = ctx->alarm_set;
+    snapshot.timer_set              = ctx->timer_set;
+    snapshot.alarm_triggered        = ctx->alarm_triggered;
+    snapshot.timer_triggered        = ctx->timer_triggered;
+    snapshot.show_error             = ctx->show_error;
+    snapshot.timer_alarm_displayed  = ctx->timer_alarm_displayed;
+    Snapshot_Publish(&clock_snapshot, &snapshot);
 }
 
 
@@ -842,170 +742,254 @@ static void radix_pos_right(void);
 static void start_calibration(void);
 static void save_calibration(void);
 static void calib_increase(void);
-static void calib_large_increase(void);
 static void calib_decrease(void);
-static void calib_large_decrease(void);
+static void calib_step(int32_t steps);
+
+// State/event spec, see fsm_table.h. An event a state does not list is ignored.
+#define CLOCK_FSM_ACTIONS(A) \
+    A(toggle_mode) \
+    A(toggle_doz_mode) \
+    A(toggle_trad_mode) \
+    A(toggle_alarm_set) \
+    A(toggle_timer_set) \
+    A(toggle_doz_timer) \
+    A(toggle_trad_timer) \
+    A(toggle_timer_alarm_displayed) \
+    A(transition_idle_disp_off) \
+    A(transition_idle_disp_on) \
+    A(transition_set_alarm) \
+    A(transition_set_timer) \
+    A(transition_set_time_doz) \
+    A(transition_set_time_trad) \
+    A(transition_alarm_disp_on) \
+    A(transition_timer_disp_on) \
+    A(transition_alarm_disp_off) \
+    A(transition_timer_disp_off) \
+    A(set_low_brightness) \
+    A(set_high_brightness) \
+    A(set_state_right_short) \
+    A(set_state_left_short) \
+    A(set_state_up_short) \
+    A(set_state_down_short) \
+    A(set_time_doz_done) \
+    A(set_time_trad_done) \
+    A(cancel_set_state) \
+    A(vol_up_short) \
+    A(vol_up_long) \
+    A(vol_down_short) \
+    A(vol_down_long) \
+    A(radix_pos_left) \
+    A(radix_pos_right) \
+    A(start_calibration) \
+    A(save_calibration) \
+    A(calib_increase) \
+    A(calib_decrease)
+
+#define CLOCK_FSM_SPEC(T) \
+    /* Idle On */ \
+    T(STATE_IDLE_DISP_ON,         E_DISPLAY_SHORT,   toggle_mode) \
+    T(STATE_IDLE_DISP_ON,         E_DISPLAY_LONG,    transition_idle_disp_off) \
+    T(STATE_IDLE_DISP_ON,         E_DOZ_SHORT,       toggle_doz_mode) \
+    T(STATE_IDLE_DISP_ON,         E_DOZ_LONG,        transition_set_time_doz) \
+    T(STATE_IDLE_DISP_ON,         E_TRAD_SHORT,      toggle_trad_mode) \
+    T(STATE_IDLE_DISP_ON,         E_TRAD_LONG,       transition_set_time_trad) \
+    T(STATE_IDLE_DISP_ON,         E_ALARM_SHORT,     toggle_alarm_set) \
+    T(STATE_IDLE_DISP_ON,         E_ALARM_LONG,      transition_set_alarm) \
+    T(STATE_IDLE_DISP_ON,         E_TIMER_SHORT,     toggle_timer_set) \
+    T(STATE_IDLE_DISP_ON,         E_TIMER_LONG,      transition_set_timer) \
+    T(STATE_IDLE_DISP_ON,         E_ROOM_DARK,       set_low_brightness) \
+    T(STATE_IDLE_DISP_ON,         E_ROOM_LIGHT,      set_high_brightness) \
+    T(STATE_IDLE_DISP_ON,         E_CANCEL_LONG,     start_calibration) \
+    T(STATE_IDLE_DISP_ON,         E_VOLUP_SHORT,     vol_up_short) \
+    T(STATE_IDLE_DISP_ON,         E_VOLUP_LONG,      vol_up_long) \
+    T(STATE_IDLE_DISP_ON,         E_VOLDOWN_SHORT,   vol_down_short) \
+    T(STATE_IDLE_DISP_ON,         E_VOLDOWN_LONG,    vol_down_long) \
+    T(STATE_IDLE_DISP_ON,         E_ALARM_TRIG,      transition_alarm_disp_on) \
+    T(STATE_IDLE_DISP_ON,         E_TIMER_TRIG,      transition_timer_disp_on) \
+    T(STATE_IDLE_DISP_ON,         E_LEFT_SHORT,      radix_pos_left) \
+    T(STATE_IDLE_DISP_ON,         E_RIGHT_SHORT,     radix_pos_right) \
+    T(STATE_IDLE_DISP_ON,         E_UP_SHORT,        toggle_timer_alarm_displayed) \
+    T(STATE_IDLE_DISP_ON,         E_DOWN_SHORT,      toggle_timer_alarm_displayed) \
+    /* Idle Off */ \
+    T(STATE_IDLE_DISP_OFF,        E_DISPLAY_LONG,    transition_idle_disp_on) \
+    T(STATE_IDLE_DISP_OFF,        E_ROOM_DARK,       set_low_brightness) \
+    T(STATE_IDLE_DISP_OFF,        E_ROOM_LIGHT,      set_high_brightness) \
+    T(STATE_IDLE_DISP_OFF,        E_VOLUP_SHORT,     vol_up_short) \
+    T(STATE_IDLE_DISP_OFF,        E_VOLUP_LONG,      vol_up_long) \
+    T(STATE_IDLE_DISP_OFF,        E_VOLDOWN_SHORT,   vol_down_short) \
+    T(STATE_IDLE_DISP_OFF,        E_VOLDOWN_LONG,    vol_down_long) \
+    T(STATE_IDLE_DISP_OFF,        E_ALARM_TRIG,      transition_alarm_disp_off) \
+    T(STATE_IDLE_DISP_OFF,        E_TIMER_TRIG,      transition_timer_disp_off) \
+    /* Set Alarm */ \
+    T(STATE_SET_ALARM,            E_DOZ_SHORT,       toggle_doz_mode) \
+    T(STATE_SET_ALARM,            E_TRAD_SHORT,      toggle_trad_mode) \
+    T(STATE_SET_ALARM,            E_LEFT_SHORT,      set_state_left_short) \
+    T(STATE_SET_ALARM,            E_RIGHT_SHORT,     set_state_right_short) \
+    T(STATE_SET_ALARM,            E_UP_SHORT,        set_state_up_short) \
+    T(STATE_SET_ALARM,            E_DOWN_SHORT,      set_state_down_short) \
+    T(STATE_SET_ALARM,            E_UP_REPEAT,       set_state_up_short) \
+    T(STATE_SET_ALARM,            E_DOWN_REPEAT,     set_state_down_short) \
+    T(STATE_SET_ALARM,            E_CANCEL_SHORT,    cancel_set_state) \
+    T(STATE_SET_ALARM,            E_VOLUP_SHORT,     vol_up_short) \
+    T(STATE_SET_ALARM,            E_VOLUP_LONG,      vol_up_long) \
+    T(STATE_SET_ALARM,            E_VOLDOWN_SHORT,   vol_down_short) \
+    T(STATE_SET_ALARM,            E_VOLDOWN_LONG,    vol_down_long) \
+    T(STATE_SET_ALARM,            E_ALARM_LONG,      transition_idle_disp_on) \
+    T(STATE_SET_ALARM,            E_ROOM_DARK,       set_low_brightness) \
+    T(STATE_SET_ALARM,            E_ROOM_LIGHT,      set_high_brightness) \
+    /* Set Timer */ \
+    T(STATE_SET_TIMER,            E_DOZ_SHORT,       toggle_doz_timer) \
+    T(STATE_SET_TIMER,            E_TRAD_SHORT,      toggle_trad_timer) \
+    T(STATE_SET_TIMER,            E_LEFT_SHORT,      set_state_left_short) \
+    T(STATE_SET_TIMER,            E_RIGHT_SHORT,     set_state_right_short) \
+    T(STATE_SET_TIMER,            E_UP_SHORT,        set_state_up_short) \
+    T(STATE_SET_TIMER,            E_DOWN_SHORT,      set_state_down_short) \
+    T(STATE_SET_TIMER,            E_UP_REPEAT,       set_state_up_short) \
+    T(STATE_SET_TIMER,            E_DOWN_REPEAT,     set_state_down_short) \
+    T(STATE_SET_TIMER,            E_CANCEL_SHORT,    cancel_set_state) \
+    T(STATE_SET_TIMER,            E_VOLUP_SHORT,     vol_up_short) \
+    T(STATE_SET_TIMER,            E_VOLUP_LONG,      vol_up_long) \
+    T(STATE_SET_TIMER,            E_VOLDOWN_SHORT,   vol_down_short) \
+    T(STATE_SET_TIMER,            E_VOLDOWN_LONG,    vol_down_long) \
+    T(STATE_SET_TIMER,            E_TIMER_LONG,      transition_idle_disp_on) \
+    T(STATE_SET_TIMER,            E_ROOM_DARK,       set_low_brightness) \
+    T(STATE_SET_TIMER,            E_ROOM_LIGHT,      set_high_brightness) \
+    /* Set Time */ \
+    T(STATE_SET_TIME,             E_DOZ_SHORT,       toggle_doz_mode) \
+    T(STATE_SET_TIME,             E_DOZ_LONG,        set_time_doz_done) \
+    T(STATE_SET_TIME,             E_TRAD_SHORT,      toggle_trad_mode) \
+    T(STATE_SET_TIME,             E_TRAD_LONG,       set_time_trad_done) \
+    T(STATE_SET_TIME,             E_LEFT_SHORT,      set_state_left_short) \
+    T(STATE_SET_TIME,             E_RIGHT_SHORT,     set_state_right_short) \
+    T(STATE_SET_TIME,             E_UP_SHORT,        set_state_up_short) \
+    T(STATE_SET_TIME,             E_DOWN_SHORT,      set_state_down_short) \
+    T(STATE_SET_TIME,             E_UP_REPEAT,       set_state_up_short) \
+    T(STATE_SET_TIME,             E_DOWN_REPEAT,     set_state_down_short) \
+    T(STATE_SET_TIME,             E_CANCEL_SHORT,    cancel_set_state) \
+    T(STATE_SET_TIME,             E_VOLUP_SHORT,     vol_up_short) \
+    T(STATE_SET_TIME,             E_VOLUP_LONG,      vol_up_long) \
+    T(STATE_SET_TIME,             E_VOLDOWN_SHORT,   vol_down_short) \
+    T(STATE_SET_TIME,             E_VOLDOWN_LONG,    vol_down_long) \
+    T(STATE_SET_TIME,             E_ROOM_DARK,       set_low_brightness) \
+    T(STATE_SET_TIME,             E_ROOM_LIGHT,      set_high_brightness) \
+    /* Alarm Timer Triggered Disp On */ \
+    T(STATE_ALARM_TIMER_DISP_ON,  E_CANCEL_SHORT,    transition_idle_disp_on) \
+    T(STATE_ALARM_TIMER_DISP_ON,  E_ROOM_DARK,       set_low_brightness) \
+    T(STATE_ALARM_TIMER_DISP_ON,  E_ROOM_LIGHT,      set_high_brightness) \
+    T(STATE_ALARM_TIMER_DISP_ON,  E_VOLUP_SHORT,     vol_up_short) \
+    T(STATE_ALARM_TIMER_DISP_ON,  E_VOLUP_LONG,      vol_up_long) \
+    T(STATE_ALARM_TIMER_DISP_ON,  E_VOLDOWN_SHORT,   vol_down_short) \
+    T(STATE_ALARM_TIMER_DISP_ON,  E_VOLDOWN_LONG,    vol_down_long) \
+    /* Alarm Timer Triggered Disp Off */ \
+    T(STATE_ALARM_TIMER_DISP_OFF, E_CANCEL_SHORT,    transition_idle_disp_off) \
+    T(STATE_ALARM_TIMER_DISP_OFF, E_ROOM_DARK,       set_low_brightness) \
+    T(STATE_ALARM_TIMER_DISP_OFF, E_ROOM_LIGHT,      set_high_brightness) \
+    T(STATE_ALARM_TIMER_DISP_OFF, E_VOLUP_SHORT,     vol_up_short) \
+    T(STATE_ALARM_TIMER_DISP_OFF, E_VOLUP_LONG,      vol_up_long) \
+    T(STATE_ALARM_TIMER_DISP_OFF, E_VOLDOWN_SHORT,   vol_down_short) \
+    T(STATE_ALARM_TIMER_DISP_OFF, E_VOLDOWN_LONG,    vol_down_long) \
+    /* Set Calib */ \
+    T(STATE_SET_CALIB,            E_CANCEL_SHORT,    save_calibration) \
+    T(STATE_SET_CALIB,            E_CANCEL_LONG,     save_calibration) \
+    T(STATE_SET_CALIB,            E_ALARM_LONG,      save_calibration) \
+    T(STATE_SET_CALIB,            E_TIMER_LONG,      save_calibration) \
+    T(STATE_SET_CALIB,            E_TRAD_LONG,       save_calibration) \
+    T(STATE_SET_CALIB,            E_DOZ_LONG,        save_calibration) \
+    T(STATE_SET_CALIB,            E_UP_SHORT,        calib_increase) \
+    T(STATE_SET_CALIB,            E_DOWN_SHORT,      calib_decrease) \
+    T(STATE_SET_CALIB,            E_UP_REPEAT,       calib_increase) \
+    T(STATE_SET_CALIB,            E_DOWN_REPEAT,     calib_decrease) \
+    T(STATE_SET_CALIB,            E_VOLUP_SHORT,     vol_up_short) \
+    T(STATE_SET_CALIB,            E_VOLUP_LONG,      vol_up_long) \
+    T(STATE_SET_CALIB,            E_VOLDOWN_SHORT,   vol_down_short) \
+    T(STATE_SET_CALIB,            E_VOLDOWN_LONG,    vol_down_long) \
+    T(STATE_SET_CALIB,            E_ROOM_DARK,       set_low_brightness) \
+    T(STATE_SET_CALIB,            E_ROOM_LIGHT,      set_high_brightness)
+
+// Brightness and volume keep working in every state once the clock is running
+#define CLOCK_FSM_GLOBAL(R, state) \
+    R(state, E_ROOM_DARK) R(state, E_ROOM_LIGHT) \
+    R(state, E_VOLUP_SHORT) R(state, E_VOLUP_LONG) R(state, E_VOLDOWN_SHORT) R(state, E_VOLDOWN_LONG)
+
+// Checked at compile time, along with the way out of every state
+#define CLOCK_FSM_REQUIRED(R) \
+    CLOCK_FSM_GLOBAL(R, STATE_IDLE_DISP_ON) \
+    CLOCK_FSM_GLOBAL(R, STATE_IDLE_DISP_OFF) \
+    CLOCK_FSM_GLOBAL(R, STATE_SET_ALARM) \
+    CLOCK_FSM_GLOBAL(R, STATE_SET_TIMER) \
+    CLOCK_FSM_GLOBAL(R, STATE_SET_TIME) \
+    CLOCK_FSM_GLOBAL(R, STATE_ALARM_TIMER_DISP_ON) \
+    CLOCK_FSM_GLOBAL(R, STATE_ALARM_TIMER_DISP_OFF) \
+    CLOCK_FSM_GLOBAL(R, STATE_SET_CALIB) \
+    R(STATE_IDLE_DISP_ON, E_DISPLAY_LONG) \
+    R(STATE_IDLE_DISP_OFF, E_DISPLAY_LONG) \
+    R(STATE_SET_ALARM, E_CANCEL_SHORT) \
+    R(STATE_SET_TIMER, E_CANCEL_SHORT) \
+    R(STATE_SET_TIME, E_CANCEL_SHORT) \
+    R(STATE_ALARM_TIMER_DISP_ON, E_CANCEL_SHORT) \
+    R(STATE_ALARM_TIMER_DISP_OFF, E_CANCEL_SHORT) \
+    R(STATE_SET_CALIB, E_CANCEL_SHORT)
+
+enum clock_fsm_action_id { FSM_ACT_NONE = FSM_NO_ACTION, CLOCK_FSM_ACTIONS(FSM_ACTION_ID) NUM_CLOCK_FSM_ACTIONS };
+enum clock_fsm_pair { CLOCK_FSM_SPEC(FSM_PAIR) NUM_CLOCK_FSM_PAIRS };
+_Static_assert(NUM_CLOCK_FSM_ACTIONS <= UINT8_MAX + 1, "action ids are one byte");
+CLOCK_FSM_REQUIRED(FSM_REQUIRE)
+
+// Both in flash, one byte per state and event
+static void (* const clock_fsm_actions[NUM_CLOCK_FSM_ACTIONS])(void) = { NULL, CLOCK_FSM_ACTIONS(FSM_ACTION_FN) };
+static const uint8_t state_event_map[NUM_STATES][NUM_EVENTS] = { CLOCK_FSM_SPEC(FSM_TABLE_ROW) };
 
-// Helper functions
-static void digit_value_increase(TimeFormats timeFormat, uint8_t *val, uint8_t sel);
-static void digit_value_decrease(TimeFormats timeFormat, uint8_t *val, uint8_t sel);
-
-static void state_event_map_init() 
-{
-    // IDLE ON
-    state_event_map[STATE_IDLE_DISP_ON][E_DISPLAY_SHORT]            = toggle_mode;
-    state_event_map[STATE_IDLE_DISP_ON][E_DISPLAY_LONG]             = transition_idle_disp_off;
-    state_event_map[STATE_IDLE_DISP_ON][E_DOZ_SHORT]                = toggle_doz_mode;
-    state_event_map[STATE_IDLE_DISP_ON][E_DOZ_LONG]                 = transition_set_time_doz;
-    state_event_map[STATE_IDLE_DISP_ON][E_TRAD_SHORT]               = toggle_trad_mode;
-    state_event_map[STATE_IDLE_DISP_ON][E_TRAD_LONG]                = transition_set_time_trad;
-    state_event_map[STATE_IDLE_DISP_ON][E_ALARM_SHORT]              = toggle_alarm_set;
-    state_event_map[STATE_IDLE_DISP_ON][E_ALARM_LONG]               = transition_set_alarm;
-    state_event_map[STATE_IDLE_DISP_ON][E_TIMER_SHORT]              = toggle_timer_set;
-    state_event_map[STATE_IDLE_DISP_ON][E_TIMER_LONG]               = transition_set_timer;
-    state_event_map[STATE_IDLE_DISP_ON][E_ROOM_DARK]                = set_low_brightness;
-    state_event_map[STATE_IDLE_DISP_ON][E_ROOM_LIGHT]               = set_high_brightness;
-    state_event_map[STATE_IDLE_DISP_ON][E_CANCEL_LONG]              = start_calibration;
-    state_event_map[STATE_IDLE_DISP_ON][E_VOLUP_SHORT]              = vol_up_short;
-    state_event_map[STATE_IDLE_DISP_ON][E_VOLUP_LONG]               = vol_up_long;
-    state_event_map[STATE_IDLE_DISP_ON][E_VOLDOWN_SHORT]            = vol_down_short;
-    state_event_map[STATE_IDLE_DISP_ON][E_VOLDOWN_LONG]             = vol_down_long;
-    state_event_map[STATE_IDLE_DISP_ON][E_ALARM_TRIG]               = transition_alarm_disp_on;
-    state_event_map[STATE_IDLE_DISP_ON][E_TIMER_TRIG]               = transition_timer_disp_on;
-    state_event_map[STATE_IDLE_DISP_ON][E_LEFT_SHORT]               = radix_pos_left;
-    state_event_map[STATE_IDLE_DISP_ON][E_RIGHT_SHORT]              = radix_pos_right;
-    state_event_map[STATE_IDLE_DISP_ON][E_UP_SHORT]                 = toggle_timer_alarm_displayed;
-    state_event_map[STATE_IDLE_DISP_ON][E_DOWN_SHORT]               = toggle_timer_alarm_displayed;
-
-    // IDLE OFF
-    state_event_map[STATE_IDLE_DISP_OFF][E_DISPLAY_LONG]            = transition_idle_disp_on;
-    state_event_map[STATE_IDLE_DISP_OFF][E_ROOM_DARK]               = set_low_brightness;
-    state_event_map[STATE_IDLE_DISP_OFF][E_ROOM_LIGHT]              = set_high_brightness;
-    state_event_map[STATE_IDLE_DISP_OFF][E_VOLUP_SHORT]             = vol_up_short;
-    state_event_map[STATE_IDLE_DISP_OFF][E_VOLUP_LONG]              = vol_up_long;
-    state_event_map[STATE_IDLE_DISP_OFF][E_VOLDOWN_SHORT]           = vol_down_short;
-    state_event_map[STATE_IDLE_DISP_OFF][E_VOLDOWN_LONG]            = vol_down_long;
-    state_event_map[STATE_IDLE_DISP_OFF][E_ALARM_TRIG]              = transition_alarm_disp_off;
-    state_event_map[STATE_IDLE_DISP_OFF][E_TIMER_TRIG]              = transition_timer_disp_off;
-
-    // SET ALARM
-    state_event_map[STATE_SET_ALARM][E_DOZ_SHORT]                   = toggle_doz_mode;
-    state_event_map[STATE_SET_ALARM][E_TRAD_SHORT]                  = toggle_trad_mode;
-    state_event_map[STATE_SET_ALARM][E_LEFT_SHORT]                  = set_state_left_short;
-    state_event_map[STATE_SET_ALARM][E_RIGHT_SHORT]                 = set_state_right_short;
-    state_event_map[STATE_SET_ALARM][E_UP_SHORT]                    = set_state_up_short;
-    state_event_map[STATE_SET_ALARM][E_DOWN_SHORT]                  = set_state_down_short;
-    state_event_map[STATE_SET_ALARM][E_CANCEL_SHORT]                = cancel_set_state;
-    state_event_map[STATE_SET_ALARM][E_VOLUP_SHORT]                 = vol_up_short;
-    state_event_map[STATE_SET_ALARM][E_VOLUP_LONG]                  = vol_up_long;
-    state_event_map[STATE_SET_ALARM][E_VOLDOWN_SHORT]               = vol_down_short;
-    state_event_map[STATE_SET_ALARM][E_VOLDOWN_LONG]                = vol_down_long;
-    state_event_map[STATE_SET_ALARM][E_ALARM_LONG]                  = transition_idle_disp_on;
-    state_event_map[STATE_SET_ALARM][E_ROOM_DARK]                   = set_low_brightness;
-    state_event_map[STATE_SET_ALARM][E_ROOM_LIGHT]                  = set_high_brightness;
-
-    // SET TIMER
-    state_event_map[STATE_SET_TIMER][E_DOZ_SHORT]                   = toggle_doz_timer;
-    state_event_map[STATE_SET_TIMER][E_TRAD_SHORT]                  = toggle_trad_timer;
-    state_event_map[STATE_SET_TIMER][E_LEFT_SHORT]                  = set_state_left_short;
-    state_event_map[STATE_SET_TIMER][E_RIGHT_SHORT]                 = set_state_right_short;
-    state_event_map[STATE_SET_TIMER][E_UP_SHORT]                    = set_state_up_short;
-    state_event_map[STATE_SET_TIMER][E_DOWN_SHORT]                  = set_state_down_short;
-    state_event_map[STATE_SET_TIMER][E_CANCEL_SHORT]                = cancel_set_state;
-    state_event_map[STATE_SET_TIMER][E_VOLUP_SHORT]                 = vol_up_short;
-    state_event_map[STATE_SET_TIMER][E_VOLUP_LONG]                  = vol_up_long;
-    state_event_map[STATE_SET_TIMER][E_VOLDOWN_SHORT]               = vol_down_short;
-    state_event_map[STATE_SET_TIMER][E_VOLDOWN_LONG]                = vol_down_long;
-    state_event_map[STATE_SET_TIMER][E_TIMER_LONG]                  = transition_idle_disp_on;
-    state_event_map[STATE_SET_TIMER][E_ROOM_DARK]                   = set_low_brightness;
-    state_event_map[STATE_SET_TIMER][E_ROOM_LIGHT]                  = set_high_brightness;
-
-    // SET TIME
-    state_event_map[STATE_SET_TIME][E_DOZ_SHORT]                    = toggle_doz_mode;
-    state_event_map[STATE_SET_TIME][E_DOZ_LONG]                     = set_time_doz_done;
-    state_event_map[STATE_SET_TIME][E_TRAD_SHORT]                   = toggle_trad_mode;
-    state_event_map[STATE_SET_TIME][E_TRAD_LONG]                    = set_time_trad_done;
-    state_event_map[STATE_SET_TIME][E_LEFT_SHORT]                   = set_state_left_short;
-    state_event_map[STATE_SET_TIME][E_RIGHT_SHORT]                  = set_state_right_short;
-    state_event_map[STATE_SET_TIME][E_UP_SHORT]                     = set_state_up_short;
-    state_event_map[STATE_SET_TIME][E_DOWN_SHORT]                   = set_state_down_short;
-    state_event_map[STATE_SET_TIME][E_CANCEL_SHORT]                 = cancel_set_state;
-    state_event_map[STATE_SET_TIME][E_VOLUP_SHORT]                  = vol_up_short;
-    state_event_map[STATE_SET_TIME][E_VOLUP_LONG]                   = vol_up_long;
-    state_event_map[STATE_SET_TIME][E_VOLDOWN_SHORT]                = vol_down_short;
-    state_event_map[STATE_SET_TIME][E_VOLDOWN_LONG]                 = vol_down_long;
-    state_event_map[STATE_SET_TIME][E_ROOM_DARK]                    = set_low_brightness;
-    state_event_map[STATE_SET_TIME][E_ROOM_LIGHT]                   = set_high_brightness;
-
-    // ALARM TIMER TRIGGERED DISP ON
-    state_event_map[STATE_ALARM_TIMER_DISP_ON][E_CANCEL_SHORT]      = transition_idle_disp_on;
-    state_event_map[STATE_ALARM_TIMER_DISP_ON][E_ROOM_DARK]         = set_low_brightness;
-    state_event_map[STATE_ALARM_TIMER_DISP_ON][E_ROOM_LIGHT]        = set_high_brightness;
-    state_event_map[STATE_ALARM_TIMER_DISP_ON][E_VOLUP_SHORT]       = vol_up_short;
-    state_event_map[STATE_ALARM_TIMER_DISP_ON][E_VOLUP_LONG]        = vol_up_long;
-    state_event_map[STATE_ALARM_TIMER_DISP_ON][E_VOLDOWN_SHORT]     = vol_down_short;
-    state_event_map[STATE_ALARM_TIMER_DISP_ON][E_VOLDOWN_LONG]      = vol_down_long;
-
-    // ALARM TIMER TRIGGERED DISP OFF
-    state_event_map[STATE_ALARM_TIMER_DISP_OFF][E_CANCEL_SHORT]     = transition_idle_disp_off;
-    state_event_map[STATE_ALARM_TIMER_DISP_OFF][E_ROOM_DARK]        = set_low_brightness;
-    state_event_map[STATE_ALARM_TIMER_DISP_OFF][E_ROOM_LIGHT]       = set_high_brightness;
-    state_event_map[STATE_ALARM_TIMER_DISP_OFF][E_VOLUP_SHORT]      = vol_up_short;
-    state_event_map[STATE_ALARM_TIMER_DISP_OFF][E_VOLUP_LONG]       = vol_up_long;
-    state_event_map[STATE_ALARM_TIMER_DISP_OFF][E_VOLDOWN_SHORT]    = vol_down_short;
-    state_event_map[STATE_ALARM_TIMER_DISP_OFF][E_VOLDOWN_LONG]     = vol_down_long;
-
-    // SET CALIB
-    state_event_map[STATE_SET_CALIB][E_CANCEL_SHORT]                = save_calibration;
-    state_event_map[STATE_SET_CALIB][E_CANCEL_LONG]                 = save_calibration;
-    state_event_map[STATE_SET_CALIB][E_ALARM_LONG]                  = save_calibration;
-    state_event_map[STATE_SET_CALIB][E_TIMER_LONG]                  = save_calibration;
-    state_event_map[STATE_SET_CALIB][E_TRAD_LONG]                   = save_calibration;
-    state_event_map[STATE_SET_CALIB][E_DOZ_LONG]                    = save_calibration;
-    state_event_map[STATE_SET_CALIB][E_UP_SHORT]                    = calib_increase;
-    state_event_map[STATE_SET_CALIB][E_DOWN_SHORT]                  = calib_decrease;
-    state_event_map[STATE_SET_CALIB][E_UP_LONG]                     = calib_large_increase;
-    state_event_map[STATE_SET_CALIB][E_DOWN_LONG]                   = calib_large_decrease;
-    state_event_map[STATE_SET_CALIB][E_VOLUP_SHORT]                 = vol_up_short;
-    state_event_map[STATE_SET_CALIB][E_VOLUP_LONG]                  = vol_up_long;
-    state_event_map[STATE_SET_CALIB][E_VOLDOWN_SHORT]               = vol_down_short;
-    state_event_map[STATE_SET_CALIB][E_VOLDOWN_LONG]                = vol_down_long;
-    state_event_map[STATE_SET_CALIB][E_ROOM_DARK]                   = set_low_brightness;
-    state_event_map[STATE_SET_CALIB][E_ROOM_LIGHT]                  = set_high_brightness;
-    
+static void process_event()
+{
+    uint8_t action = FSM_NO_ACTION;
+
+    FlightRec_Log(REC_EVENT, g_clock_fsm.ctx->curr_event.id, g_clock_fsm.ctx->curr_event.payload,
+                  g_clock_fsm.ctx->curr_event.timestamp_ms);
+    if (g_clock_fsm.ctx->curr_event.id < NUM_EVENTS)
+    {
+        action = state_event_map[g_clock_fsm.curr_state->state_code][g_clock_fsm.ctx->curr_event.id];
+    }
+    if (action != FSM_NO_ACTION)
+    {
+        clock_fsm_actions[action]();
+    }
+    g_clock_fsm.ctx->curr_event.id = E_NONE;
+}
+
+// The timer has its own traditional row, its hours run past a day
+static const DigitEntryFormat *entry_format(void)
+{
+    if (g_clock_fsm.curr_state->state_code == STATE_SET_TIMER)
+        return DigitEntry_TimerFormat(curr_format);
+    return DigitEntry_Format(curr_format);
 }
 
 static void set_state_right_short(void)
 {
-    if (curr_format == TRAD_24H)
-        g_clock_fsm.ctx->digit_sel = (g_clock_fsm.ctx->digit_sel + 1) % 6;
-    else if (curr_format == TRAD_12H)
-        g_clock_fsm.ctx->digit_sel = (g_clock_fsm.ctx->digit_sel + 1) % 7;
-    else if (curr_format == DOZ_DRN5 || curr_format == DOZ_SEMI)
-        g_clock_fsm.ctx->digit_sel = (g_clock_fsm.ctx->digit_sel + 1) % 5;
-    else
-        g_clock_fsm.ctx->digit_sel = (g_clock_fsm.ctx->digit_sel + 1) % 4;
+    uint8_t num_digits = entry_format()->num_digits;
+    g_clock_fsm.ctx->digit_sel = (g_clock_fsm.ctx->digit_sel + 1) % num_digits;
 }
 static void set_state_left_short(void)
 {
-    if (curr_format == TRAD_24H)
-        g_clock_fsm.ctx->digit_sel = (g_clock_fsm.ctx->digit_sel + 6 - 1) % 6;
-    else if (curr_format == TRAD_12H)
-        g_clock_fsm.ctx->digit_sel = (g_clock_fsm.ctx->digit_sel + 7 - 1) % 7;
-    else if (curr_format == DOZ_DRN5 || curr_format == DOZ_SEMI)
-        g_clock_fsm.ctx->digit_sel = (g_clock_fsm.ctx->digit_sel + 5 - 1) % 5;
-    else
-        g_clock_fsm.ctx->digit_sel = (g_clock_fsm.ctx->digit_sel + 4 - 1) % 4;
+    uint8_t num_digits = entry_format()->num_digits;
+    g_clock_fsm.ctx->digit_sel = (g_clock_fsm.ctx->digit_sel + num_digits - 1) % num_digits;
 }
 static void set_state_up_short(void)
 {
     digits_changed = true;
-    digit_value_increase(curr_format, &g_clock_fsm.ctx->digit_vals[g_clock_fsm.ctx->digit_sel], g_clock_fsm.ctx->digit_sel);
+    // A held key arrives as one event carrying every step
+    for (uint16_t i = 0; i < g_clock_fsm.ctx->curr_event.payload; i++)
+    {
+        DigitEntry_Step(entry_format(), g_clock_fsm.ctx->digit_vals, g_clock_fsm.ctx->digit_sel, true);
+    }
 }
 static void set_state_down_short(void)
 {
     digits_changed = true;
-    digit_value_decrease(curr_format, &g_clock_fsm.ctx->digit_vals[g_clock_fsm.ctx->digit_sel], g_clock_fsm.ctx->digit_sel);
+    for (uint16_t i = 0; i < g_clock_fsm.ctx->curr_event.payload; i++)
+    {
+        DigitEntry_Step(entry_format(), g_clock_fsm.ctx->digit_vals, g_clock_fsm.ctx->digit_sel, false);
+    }
 }
 static void set_low_brightness(void)
 {
@@ -1065,6 +1049,11 @@ static void transition_alarm_disp_on(void)
 }
 static void transition_timer_disp_on(void)
 {
+    if (!timer_due()) {
+        set_timer_alarm();
+        Rtc_EnableAlarm(TIMER, true);
+        return;
+    }
     g_clock_fsm.ctx->timer_triggered = true;
     transition(&s_alarm_timer_disp_on);
 }
@@ -1075,6 +1064,11 @@ static void transition_alarm_disp_off(void)
 }
 static void transition_timer_disp_off(void)
 {
+    if (!timer_due()) {
+        set_timer_alarm();
+        Rtc_EnableAlarm(TIMER, true);
+        return;
+    }
     g_clock_fsm.ctx->timer_triggered = true;
     transition(&s_alarm_timer_disp_off);
 }
@@ -1092,10 +1086,8 @@ static void toggle_timer_set(void)
 {
     g_clock_fsm.ctx->timer_set = !g_clock_fsm.ctx->timer_set;
     if (g_clock_fsm.ctx->timer_set) {
-        RtcTime timerTime;
-        timer_end_ms = (g_clock_fsm.ctx->user_timer_ms + g_clock_fsm.ctx->time_ms) % TIME_24H_MS;
-        msToRtcTime(timer_end_ms, &timerTime);
-        Rtc_SetAlarm(&timerTime, TIMER);
+        timer_end_ms = timer_end(g_clock_fsm.ctx);
+        set_timer_alarm();
 
         if (g_clock_fsm.ctx->timer_alarm_displayed == DISPLAY_ALARM)
             g_clock_fsm.ctx->timer_alarm_displayed = DISPLAY_TIMER;
@@ -1144,7 +1136,8 @@ static void toggle_doz_mode(void)
 }
 static void toggle_doz_timer(void)
 {
-    if (curr_format == TRAD_24H) {
+    // The dozenal digits cover one day, a longer timer stays traditional
+    if (curr_format == TRAD_24H && g_clock_fsm.ctx->user_timer_ms < TIME_24H_MS) {
         curr_format = DOZ_DRN5;
         g_clock_fsm.ctx->digit_sel = 0;
         transition_digits(curr_format, g_clock_fsm.ctx->user_timer_ms, g_clock_fsm.ctx->digit_vals);
@@ -1244,168 +1237,29 @@ static void save_calibration(void)
 
 static void calib_increase(void)
 {
-    if (Rtc_SetCalibration(g_clock_fsm.ctx->rtc_calib + 1) == CLOCK_OK)
-    {
-        g_clock_fsm.ctx->rtc_calib += 1;
-    }
+    calib_step(g_clock_fsm.ctx->curr_event.payload);
 }
 
 static void calib_decrease(void)
 {
-    if (Rtc_SetCalibration(g_clock_fsm.ctx->rtc_calib - 1) == CLOCK_OK)
-    {
-        g_clock_fsm.ctx->rtc_calib -= 1;
-    }
+    calib_step(-(int32_t)g_clock_fsm.ctx->curr_event.payload);
 }
 
-static void calib_large_increase(void)
+// A held key can carry more steps than are left, stop at the limit rather than short of it
+static void calib_step(int32_t steps)
 {
-    if (Rtc_SetCalibration(g_clock_fsm.ctx->rtc_calib + 10) == CLOCK_OK)
-    {
-        g_clock_fsm.ctx->rtc_calib += 10;
-    }
-}
-
-static void calib_large_decrease(void)
-{
-    if (Rtc_SetCalibration(g_clock_fsm.ctx->rtc_calib - 10) == CLOCK_OK)
-    {
-        g_clock_fsm.ctx->rtc_calib -= 10;
-    }
-}
-
-static void digit_value_increase(TimeFormats timeFormat, uint8_t *val, uint8_t sel)
-{
-    if (timeFormat == TRAD_12H)
-    {
-        if (sel == 0)
-            *val = (*val + 1) % 2;
-        else if (sel == 1) 
-        {
-            if (g_clock_fsm.ctx->digit_vals[0] == 1)
-                *val = (*val + 1) % 3;
-            else
-                *val = (*val + 1) % 10;
-        }
-        else if (sel == 2 || sel == 4)
-            *val = (*val + 1) % 6;
-        else if (sel == 3 || sel == 5)
-            *val = (*val + 1) % 10;
-        else if (sel == 6) 
-            *val = (*val + 1) % 2;
-
-
-        if (g_clock_fsm.ctx->digit_vals[0] == 1 && g_clock_fsm.ctx->digit_vals[1] > 2)
-                g_clock_fsm.ctx->digit_vals[1] = 0;
+    int32_t step_ppb, max_calib, calib = g_clock_fsm.ctx->rtc_calib + steps;
 
-        if (g_clock_fsm.ctx->digit_vals[0] == 1 && g_clock_fsm.ctx->digit_vals[1] == 2 && g_clock_fsm.ctx->digit_vals[6] == 0) {
-            g_clock_fsm.ctx->digit_vals[6] = 1;
-        } else if (g_clock_fsm.ctx->digit_vals[0] == 0 && g_clock_fsm.ctx->digit_vals[1] == 0 && g_clock_fsm.ctx->digit_vals[6] == 1) {
-            g_clock_fsm.ctx->digit_vals[6] = 0;
-        }
-    }
-    else if (timeFormat == TRAD_24H)
-    {
-        if (sel == 0) 
-            *val = (*val + 1) % 3;
-        else if (sel == 1) 
-        {
-            if (g_clock_fsm.ctx->digit_vals[0] == 2)
-                *val = (*val + 1) % 4;
-            else
-                *val = (*val + 1) % 10;
-        }
-        else if (sel == 2 || sel == 4)
-            *val = (*val + 1) % 6;
-        else if (sel == 3 || sel == 5)
-            *val = (*val + 1) % 10;
-
-
-        if (g_clock_fsm.ctx->digit_vals[0] == 2 && g_clock_fsm.ctx->digit_vals[1] > 3)
-                g_clock_fsm.ctx->digit_vals[1] = 0;
-    }
-    else if (timeFormat == DOZ_DRN4)
-    {
-        *val = (*val + 1) % 12;
-    }
-    else if (timeFormat == DOZ_DRN5)
-    {
-        *val = (*val + 1) % 12;
-    }
-    else if (timeFormat == DOZ_SEMI)
-    {
-        if (sel == 0)
-            *val = (*val + 1) % 2;
-        else
-            *val = (*val + 1) % 12;
-    }
-}
-static void digit_value_decrease(TimeFormats timeFormat, uint8_t *val, uint8_t sel)
-{
-    if (timeFormat == TRAD_12H)
-    {
-        if (sel == 0)
-            *val = (*val + 2 - 1) % 2;
-        else if (sel == 1) 
-        {
-            if (g_clock_fsm.ctx->digit_vals[0] == 1)
-                *val = (*val + 3 - 1) % 3;
-            else
-                *val = (*val + 10 - 1) % 10;
-        }
-        else if (sel == 2 || sel == 4)
-            *val = (*val + 6 - 1) % 6;
-        else if (sel == 3 || sel == 5)
-            *val = (*val + 10 - 1) % 10;
-        else if (sel == 6) 
-        {
-            *val = (*val + 1) % 2;
-        }
-
-
-        if (g_clock_fsm.ctx->digit_vals[0] == 1 && g_clock_fsm.ctx->digit_vals[1] > 2)
-                g_clock_fsm.ctx->digit_vals[1] = 0;
-
-        if (g_clock_fsm.ctx->digit_vals[0] == 1 && g_clock_fsm.ctx->digit_vals[1] == 2 && g_clock_fsm.ctx->digit_vals[6] == 0) {
-            g_clock_fsm.ctx->digit_vals[6] = 1;
-        } else if (g_clock_fsm.ctx->digit_vals[0] == 0 && g_clock_fsm.ctx->digit_vals[1] == 0 && g_clock_fsm.ctx->digit_vals[6] == 1) {
-            g_clock_fsm.ctx->digit_vals[6] = 0;
-        }
-    }
-    else if (timeFormat == TRAD_24H)
-    {
-        if (sel == 0)
-            *val = (*val + 3 - 1) % 3;
-        else if (sel == 1) 
-        {
-            if (g_clock_fsm.ctx->digit_vals[0] == 2)
-                *val = (*val + 4 - 1) % 4;
-            else
-                *val = (*val + 10 - 1) % 10;
-        }
-        else if (sel == 2 || sel == 4)
-            *val = (*val + 6 - 1) % 6;
-        else if (sel == 3 || sel == 5)
-            *val = (*val + 10 - 1) % 10;
-
-
-        if (g_clock_fsm.ctx->digit_vals[0] == 2 && g_clock_fsm.ctx->digit_vals[1] > 3)
-                g_clock_fsm.ctx->digit_vals[1] = 0;
-    }
-    else if (timeFormat == DOZ_DRN4)
-    {
-        *val = (*val + 12 - 1) % 12;
-    }
-    else if (timeFormat == DOZ_DRN5)
+    if (Rtc_GetCalibrationStep(&step_ppb, &max_calib) == CLOCK_OK)
     {
-        *val = (*val + 12 - 1) % 12;
+        if (calib > max_calib)
+            calib = max_calib;
+        else if (calib < -max_calib)
+            calib = -max_calib;
     }
-    else if (timeFormat == DOZ_SEMI)
+    if (calib != g_clock_fsm.ctx->rtc_calib && Rtc_SetCalibration(calib) == CLOCK_OK)
     {
-        if (sel == 0)
-            *val = (*val + 2 - 1) % 2;
-        else
-            *val = (*val + 12 - 1) % 12;
+        g_clock_fsm.ctx->rtc_calib = calib;
     }
 }
 
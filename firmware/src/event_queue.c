@@ -1,49 +1,111 @@
 #include "event_queue.h"
 
+/*
+ * One multi-producer, single-consumer lane per priority class (bounded,
+ * sequence numbered slots). Producers run in any ISR and claim a slot by
+ * compare-and-swap on the lane's enqueue_pos, then publish it by writing the
+ * slot sequence. Only the main loop consumes. A producer preempted while it
+ * holds a claimed slot just delays the consumer, nothing is ever overwritten.
+ *
+ * Each class has its own slots so a burst of button presses can never take
+ * the room an alarm needs. The consumer serves the highest class with an
+ * event waiting, except that a lower class passed over EVENTQ_STARVE_LIMIT
+ * times in a row is served next.
+ *
+ * Redundant events are coalesced as they are read: a run of light changes
+ * becomes the last one and a run of held UP or DOWN repeats becomes one
+ * event carrying the total. Short presses are kept apart, each one counts.
+ *
+ * Producers never touch a published slot again, so coalescing is done on
+ * the consumer side.
+ */
+typedef struct
+{
+    volatile uint32_t   seq;    // pos + 1 once written, pos + depth once read
+    ClockEvent          event;
+} Slot;
+
+typedef struct
+{
+    Slot                *slots;
+    uint32_t            mask;           // Depth - 1
+    volatile uint32_t   enqueue_pos;    // Shared by producers
+    volatile uint32_t   dequeue_pos;    // Main loop only, read by producers for stats
+} Lane;
 
-static struct {
-    EventId buffer[BUFFER_SIZE];
-    uint8_t head;
-    uint8_t tail;
-    bool is_empty;
-}ring_buff;  // Ring buffer data structure
+static ClockStatus queuePush(EventId id, uint16_t payload, EventClass lane_id);
+static ClockStatus queuePop(ClockEvent *event);
+static ClockStatus lanePop(Lane *lane, ClockEvent *event);
+static bool laneReady(Lane *lane);
+static bool mergeEvents(ClockEvent *into, const ClockEvent *next);
+static bool atomicCas(volatile uint32_t *addr, uint32_t *expected, uint32_t desired);
+static void atomicAdd(volatile uint32_t *addr, uint32_t val);
+static void atomicMax(volatile uint32_t *addr, uint32_t val);
 
-static void bufferPush(EventId event);
-static EventId bufferPop(void);
-static bool bufferFull(void);
-static bool bufferEmpty(void);
+static Slot alarm_slots[EVENTQ_ALARM_DEPTH];
+static Slot input_slots[EVENTQ_INPUT_DEPTH];
+static Slot ambient_slots[EVENTQ_AMBIENT_DEPTH];
+static Lane lanes[NUM_EVENT_CLASSES] = {
+    [EVENT_CLASS_ALARM]     = {alarm_slots, EVENTQ_ALARM_DEPTH - 1, 0, 0},
+    [EVENT_CLASS_INPUT]     = {input_slots, EVENTQ_INPUT_DEPTH - 1, 0, 0},
+    [EVENT_CLASS_AMBIENT]   = {ambient_slots, EVENTQ_AMBIENT_DEPTH - 1, 0, 0},
+};
+static uint8_t passed_over[NUM_EVENT_CLASSES];  // Main loop only
+static uint32_t coalesced;                      // Main loop only
+static uint32_t (*get_tick)(void) = NULL;
+static volatile uint32_t overflow[NUM_EVENT_CLASSES];
+static volatile uint32_t high_water[NUM_EVENT_CLASSES];
 
 /*
  *  Public functions
 */
 ClockStatus EventQ_Init()
 {
-    // Reset ring buffer
-    ring_buff.head = 0;
-    ring_buff.tail = 0;
-    ring_buff.is_empty = 1;
+    // Not safe against running producers, call before interrupts are enabled
+    for (int c = 0; c < NUM_EVENT_CLASSES; c++)
+    {
+        for (uint32_t i = 0; i <= lanes[c].mask; i++)
+        {
+            lanes[c].slots[i].seq = i;
+            lanes[c].slots[i].event.id = E_NONE;
+        }
+        lanes[c].enqueue_pos = 0;
+        lanes[c].dequeue_pos = 0;
+        passed_over[c] = 0;
+    }
+    memset((void *)overflow, 0, sizeof(overflow));
+    memset((void *)high_water, 0, sizeof(high_water));
+    coalesced = 0;
     return CLOCK_OK;
 }
 
-ClockStatus EventQ_GetEvent(EventId *event)
+// Optional, stamps each event with the tick it was raised at
+void EventQ_SetTickSource(uint32_t (*getTick)(void))
+{
+    get_tick = getTick;
+}
+
+ClockStatus EventQ_GetEvent(ClockEvent *event)
+{
+    return queuePop(event);
+}
+
+// Safe with interrupts masked, e.g. to check nothing arrived just before sleeping
+bool EventQ_Pending(void)
 {
-    if (bufferEmpty())
+    for (int c = 0; c < NUM_EVENT_CLASSES; c++)
     {
-        *event = E_NONE;
-        return CLOCK_FAIL;
+        if (laneReady(&lanes[c]))
+        {
+            return true;
+        }
     }
-    // Remove event from buffer
-    *event = bufferPop();
-    return CLOCK_OK;
+    return false;
 }
 
 ClockStatus EventQ_TriggerButtonEvent(BtnId button, BtnPressType type)
 {
     EventId btn_event = E_NONE;
-    if (bufferFull())
-    {
-        return CLOCK_FAIL;
-    }
     switch (button)
     {
         case B_DISPLAY:
@@ -92,89 +154,239 @@ ClockStatus EventQ_TriggerButtonEvent(BtnId button, BtnPressType type)
     else
     {
         // Add event to buffer
-        bufferPush(btn_event);
-        return CLOCK_OK;
+        return queuePush(btn_event, 1, EVENT_CLASS_INPUT);
     }
 }
 
-ClockStatus EventQ_TriggerLightEvent(LightEventType type)
+// A held key, one event carrying every step since the last one
+ClockStatus EventQ_TriggerButtonRepeat(BtnId button, uint16_t steps)
 {
-    if (bufferFull())
+    if (steps == 0)
     {
         return CLOCK_FAIL;
     }
+    switch (button)
+    {
+        case B_UP:
+            return queuePush(E_UP_REPEAT, steps, EVENT_CLASS_INPUT);
+        case B_DOWN:
+            return queuePush(E_DOWN_REPEAT, steps, EVENT_CLASS_INPUT);
+        default:
+            return CLOCK_FAIL;
+    }
+}
+
+ClockStatus EventQ_TriggerLightEvent(LightEventType type)
+{
     switch (type)
     {
         // Add event to buffer
         case LIGHT_ROOM:
-            bufferPush(E_ROOM_LIGHT);
-            break;
+            return queuePush(E_ROOM_LIGHT, 1, EVENT_CLASS_AMBIENT);
         case DARK_ROOM:
-            bufferPush(E_ROOM_DARK);
-            break;
+            return queuePush(E_ROOM_DARK, 1, EVENT_CLASS_AMBIENT);
         default:
             return CLOCK_FAIL;
     }
-    return CLOCK_OK;
 }
 
 ClockStatus EventQ_TriggerAlarmEvent(AlarmEventType type)
 {
-    if (bufferFull())
-    {
-        return CLOCK_FAIL;
-    }
     switch (type)
     {
         // Add event to buffer
         case ALARM_TRIG:
-            bufferPush(E_ALARM_TRIG);
-            break;
+            return queuePush(E_ALARM_TRIG, 1, EVENT_CLASS_ALARM);
         case TIMER_TRIG:
-            bufferPush(E_TIMER_TRIG);
-            break;
+            return queuePush(E_TIMER_TRIG, 1, EVENT_CLASS_ALARM);
         default:
             return CLOCK_FAIL;
     }
-    return CLOCK_OK;
+}
+
+void EventQ_GetStats(EventQStats *stats)
+{
+    for (int i = 0; i < NUM_EVENT_CLASSES; i++)
+    {
+        stats->overflow[i] = overflow[i];
+        stats->high_water[i] = high_water[i];
+    }
+    stats->coalesced = coalesced;
 }
 
 /*
  *  Private functions
 */
-void bufferPush(EventId event)
+ClockStatus queuePush(EventId id, uint16_t payload, EventClass lane_id)
 {
-    if (!bufferFull())
+    uint32_t now_ms = (get_tick != NULL) ? get_tick() : 0;
+    Lane *lane = &lanes[lane_id];
+    uint32_t pos = __atomic_load_n(&lane->enqueue_pos, __ATOMIC_RELAXED);
+    Slot *slot;
+
+    for (;;)
+    {
+        slot = &lane->slots[pos & lane->mask];
+        int32_t diff = (int32_t)(__atomic_load_n(&slot->seq, __ATOMIC_ACQUIRE) - pos);
+        if (diff == 0)
+        {
+            // Slot free, claim it unless another producer got there first
+            if (atomicCas(&lane->enqueue_pos, &pos, pos + 1))
+            {
+                break;
+            }
+        }
+        else if (diff < 0)
+        {
+            // Slot still holds an unread event a lap behind, lane is full
+            atomicAdd(&overflow[lane_id], 1);
+            return CLOCK_FAIL;
+        }
+        else
+        {
+            // Another producer claimed it, try the next position
+            pos = __atomic_load_n(&lane->enqueue_pos, __ATOMIC_RELAXED);
+        }
+    }
+    slot->event.id = id;
+    slot->event.timestamp_ms = now_ms;
+    slot->event.payload = payload;
+    __atomic_store_n(&slot->seq, pos + 1, __ATOMIC_RELEASE);
+    // The consumer may already have read past this event, only count a positive depth
+    int32_t depth = (int32_t)(pos + 1 - __atomic_load_n(&lane->dequeue_pos, __ATOMIC_RELAXED));
+    if (depth > 0)
     {
-        // Add event to tail and increment tail
-        ring_buff.buffer[ring_buff.tail] = event;
-        ring_buff.is_empty = 0;
-        ring_buff.tail = (ring_buff.tail + 1) % BUFFER_SIZE;
+        atomicMax(&high_water[lane_id], depth);
     }
+    return CLOCK_OK;
 }
 
-EventId bufferPop(void)
+ClockStatus queuePop(ClockEvent *event)
 {
-    EventId event = E_NONE;
-    if (!bufferEmpty())
+    int chosen = -1;
+
+    // A lower class that has waited long enough goes first, lowest class first so it cannot be starved by the middle one
+    for (int c = NUM_EVENT_CLASSES - 1; c > 0 && chosen < 0; c--)
     {
-        // Take event from head and increment head
-        event = ring_buff.buffer[ring_buff.head];
-        ring_buff.head = (ring_buff.head + 1) % BUFFER_SIZE;
-        if (ring_buff.head == ring_buff.tail)
+        if (passed_over[c] >= EVENTQ_STARVE_LIMIT && laneReady(&lanes[c]))
         {
-            ring_buff.is_empty = 1;
+            chosen = c;
         }
     }
-    return event;
+    // Otherwise strict priority
+    for (int c = 0; c < NUM_EVENT_CLASSES && chosen < 0; c++)
+    {
+        if (laneReady(&lanes[c]))
+        {
+            chosen = c;
+        }
+    }
+    if (chosen < 0)
+    {
+        event->id = E_NONE;
+        return CLOCK_FAIL;
+    }
+
+    passed_over[chosen] = 0;
+    for (int c = chosen + 1; c < NUM_EVENT_CLASSES; c++)
+    {
+        passed_over[c] = laneReady(&lanes[c]) ? passed_over[c] + 1 : 0;
+    }
+    ClockStatus status = lanePop(&lanes[chosen], event);
+    while (status == CLOCK_OK && laneReady(&lanes[chosen]) &&
+           mergeEvents(event, &lanes[chosen].slots[lanes[chosen].dequeue_pos & lanes[chosen].mask].event))
+    {
+        ClockEvent merged;
+        lanePop(&lanes[chosen], &merged);
+        coalesced++;
+    }
+    return status;
+}
+
+ClockStatus lanePop(Lane *lane, ClockEvent *event)
+{
+    uint32_t pos = lane->dequeue_pos;
+    Slot *slot = &lane->slots[pos & lane->mask];
+
+    if ((int32_t)(__atomic_load_n(&slot->seq, __ATOMIC_ACQUIRE) - (pos + 1)) < 0)
+    {
+        // Empty, or the next producer has not finished writing yet
+        event->id = E_NONE;
+        return CLOCK_FAIL;
+    }
+    *event = slot->event;
+    __atomic_store_n(&slot->seq, pos + lane->mask + 1, __ATOMIC_RELEASE);
+    __atomic_store_n(&lane->dequeue_pos, pos + 1, __ATOMIC_RELAXED);
+    return CLOCK_OK;
+}
+
+bool laneReady(Lane *lane)
+{
+    uint32_t pos = lane->dequeue_pos;
+    return __atomic_load_n(&lane->slots[pos & lane->mask].seq, __ATOMIC_ACQUIRE) == pos + 1;
+}
+
+// Fold next into the event before it when handling both adds nothing over handling one
+bool mergeEvents(ClockEvent *into, const ClockEvent *next)
+{
+    bool into_light = (into->id == E_ROOM_LIGHT || into->id == E_ROOM_DARK);
+    bool next_light = (next->id == E_ROOM_LIGHT || next->id == E_ROOM_DARK);
+
+    if (into_light && next_light)
+    {
+        // Only where the light settled matters
+        *into = *next;
+        return true;
+    }
+    if ((into->id == E_UP_REPEAT || into->id == E_DOWN_REPEAT) && next->id == into->id &&
+        (uint32_t)into->payload + next->payload <= UINT16_MAX)
+    {
+        // Keep the first timestamp, the steps started then
+        into->payload += next->payload;
+        return true;
+    }
+    return false;
+}
+
+#if defined(__ARM_ARCH_6M__)
+// Cortex-M0 has no exclusive access instructions, mask interrupts for the compare and store instead
+bool atomicCas(volatile uint32_t *addr, uint32_t *expected, uint32_t desired)
+{
+    uint32_t primask;
+    bool swapped;
+    __asm volatile ("mrs %0, primask\n\tcpsid i" : "=r" (primask) :: "memory");
+    swapped = (*addr == *expected);
+    if (swapped)
+    {
+        *addr = desired;
+    }
+    else
+    {
+        *expected = *addr;
+    }
+    __asm volatile ("msr primask, %0" :: "r" (primask) : "memory");
+    return swapped;
 }
+#else
+// Cortex-M3/M4 builds this from LDREX/STREX, host builds and tests use the compiler's own
+bool atomicCas(volatile uint32_t *addr, uint32_t *expected, uint32_t desired)
+{
+    return __atomic_compare_exchange_n(addr, expected, desired, false, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE);
+}
+#endif
 
-bool bufferFull(void)
+void atomicAdd(volatile uint32_t *addr, uint32_t val)
 {
-    return !ring_buff.is_empty && (ring_buff.head == ring_buff.tail);
+    uint32_t current = __atomic_load_n(addr, __ATOMIC_RELAXED);
+    while (!atomicCas(addr, &current, current + val))
+    {
+    }
 }
 
-bool bufferEmpty(void)
+void atomicMax(volatile uint32_t *addr, uint32_t val)
 {
-    return ring_buff.is_empty && (ring_buff.head == ring_buff.tail);
+    uint32_t current = __atomic_load_n(addr, __ATOMIC_RELAXED);
+    while (current < val && !atomicCas(addr, &current, val))
+    {
+    }
 }
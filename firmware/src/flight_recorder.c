@@ -0,0 +1,180 @@
+/*
+ * flight_recorder.c
+ * Ring buffer of recent events, state changes and time syncs
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: Matt L.
+ *
+ * Only the main loop logs, so no locking. The dump is plain text so any
+ * serial terminal can capture it:
+ *
+ *     FLIGHTREC <version> <records> <overwritten>
+ *     <tick><value><arg><code><type>   one line per record, oldest first, hex
+ *     END
+ */
+
+#include "flight_recorder.h"
+
+/*
+    Private function definitions
+*/
+static uint8_t putHex(uint8_t *buf, uint32_t val, uint8_t digits);
+static uint8_t putDec(uint8_t *buf, uint32_t val);
+static bool parseHex(const char *str, uint8_t digits, uint32_t *val);
+
+/*
+    Private variables
+*/
+static FlightRecord records[FLIGHTREC_DEPTH];
+static uint32_t total;      // Records ever logged, the newest is at (total - 1) % FLIGHTREC_DEPTH
+static uint32_t (*get_tick)(void) = NULL;
+
+/*
+    Public functions
+*/
+void FlightRec_Init(uint32_t (*getTick)(void))
+{
+    get_tick = getTick;
+    total = 0;
+    FlightRec_Log(REC_BOOT, FLIGHTREC_VERSION, 0, 0);
+}
+
+void FlightRec_Log(FlightRecType type, uint8_t code, uint16_t arg, uint32_t value)
+{
+    FlightRecord *record = &records[total % FLIGHTREC_DEPTH];
+
+    record->tick_ms = (get_tick != NULL) ? get_tick() : 0;
+    record->value = value;
+    record->arg = arg;
+    record->code = code;
+    record->type = type;
+    total++;
+}
+
+uint16_t FlightRec_Count(void)
+{
+    return (total < FLIGHTREC_DEPTH) ? total : FLIGHTREC_DEPTH;
+}
+
+// Index 0 is the oldest record still held
+ClockStatus FlightRec_Get(uint16_t index, FlightRecord *record)
+{
+    if (index >= FlightRec_Count())
+    {
+        return CLOCK_FAIL;
+    }
+    *record = records[(total - FlightRec_Count() + index) % FLIGHTREC_DEPTH];
+    return CLOCK_OK;
+}
+
+void FlightRec_Dump(void (*write)(uint8_t *buf, uint16_t len))
+{
+    uint8_t line[40];
+    uint8_t size;
+    FlightRecord record;
+
+    memcpy(line, "FLIGHTREC ", 10);
+    size = 10;
+    size += putDec(&line[size], FLIGHTREC_VERSION);
+    line[size++] = ' ';
+    size += putDec(&line[size], FlightRec_Count());
+    line[size++] = ' ';
+    size += putDec(&line[size], total - FlightRec_Count());
+    line[size++] = '\r';
+    line[size++] = '\n';
+    write(line, size);
+
+    for (uint16_t i = 0; i < FlightRec_Count(); i++)
+    {
+        FlightRec_Get(i, &record);
+        size = putHex(line, record.tick_ms, 8);
+        size += putHex(&line[size], record.value, 8);
+        size += putHex(&line[size], record.arg, 4);
+        size += putHex(&line[size], record.code, 2);
+        size += putHex(&line[size], record.type, 2);
+        line[size++] = '\r';
+        line[size++] = '\n';
+        write(line, size);
+    }
+    write((uint8_t *)"END\r\n", 5);
+}
+
+// Reads back one record line of a dump, fails on the header, END or anything garbled
+ClockStatus FlightRec_ParseLine(const char *line, FlightRecord *record)
+{
+    uint32_t tick_ms, value, arg, code, type;
+
+    if (!parseHex(line, 8, &tick_ms) ||
+        !parseHex(&line[8], 8, &value) ||
+        !parseHex(&line[16], 4, &arg) ||
+        !parseHex(&line[20], 2, &code) ||
+        !parseHex(&line[22], 2, &type) ||
+        type >= NUM_REC_TYPES)
+    {
+        return CLOCK_FAIL;
+    }
+    record->tick_ms = tick_ms;
+    record->value = value;
+    record->arg = arg;
+    record->code = code;
+    record->type = type;
+    return CLOCK_OK;
+}
+
+/*
+    Private functions
+*/
+static uint8_t putHex(uint8_t *buf, uint32_t val, uint8_t digits)
+{
+    for (int i = digits - 1; i >= 0; i--)
+    {
+        buf[i] = "0123456789ABCDEF"[val & 0xF];
+        val >>= 4;
+    }
+    return digits;
+}
+
+static uint8_t putDec(uint8_t *buf, uint32_t val)
+{
+    uint8_t digits[10];
+    uint8_t len = 0;
+
+    do
+    {
+        digits[len++] = '0' + val % 10;
+        val /= 10;
+    } while (val > 0);
+    for (int i = 0; i < len; i++)
+    {
+        buf[i] = digits[len - 1 - i];
+    }
+    return len;
+}
+
+static bool parseHex(const char *str, uint8_t digits, uint32_t *val)
+{
+    *val = 0;
+    for (int i = 0; i < digits; i++)
+    {
+        char c = str[i];
+        uint8_t nibble;
+        if (c >= '0' && c <= '9')
+        {
+            nibble = c - '0';
+        }
+        else if (c >= 'A' && c <= 'F')
+        {
+            nibble = c - 'A' + 10;
+        }
+        else if (c >= 'a' && c <= 'f')
+        {
+            nibble = c - 'a' + 10;
+        }
+        else
+        {
+            return false;
+        }
+        *val = (*val << 4) | nibble;
+    }
+    return true;
+}
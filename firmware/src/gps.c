@@ -1,10 +1,33 @@
 #include "gps.h"
 
+#define GPS_DAY_MS          86400000
+#define GPS_PPS_PAIR_US     900000  // A sentence starting this long after a pulse still labels it
+#define GPS_PPS_TOL_US      1000    // Pulses further than this per second from whole seconds after the last are noise
+#define GPS_PPS_MAX_GAP_S   8       // A label is carried over at most this many missed pulses
+#define GPS_PPS_MAX_REJECT  3       // Rejected in a row and the pulse train has moved, start again from the next
+
 static Gps *g_gps;
 
+// Pulses from the capture interrupt, taken and labelled from the main loop
+static volatile uint32_t pps_edge_us;
+static volatile uint32_t pps_edge_count;
+static uint32_t pps_edges_seen;
+static uint8_t pps_rejects;
+static uint32_t pps_sentence_edge;      // Last pulse a sentence labelled, by its count
+static GpsPps pps;
+
+static void takeEdge(uint32_t edge_us);
+static void labelEdge(void);
+static void parseUtc(float utc, GpsTime *time);
+static void parseDate(uint32_t ddmmyy, ClockDate *date);
+
 ClockStatus Gps_Init(Gps *self)
 {
     g_gps = self;
+    memset(&pps, 0, sizeof(pps));
+    pps_edges_seen = pps_edge_count;
+    pps_rejects = 0;
+    pps_sentence_edge = 0;
     return CLOCK_OK;
 }
 ClockStatus Gps_Connected()
@@ -15,17 +38,141 @@ ClockStatus Gps_Connected()
     }
     return CLOCK_FAIL;
 }
+// The time from the last sentence. With a stamp, at_us is when that time was current,
+// so the sentence's own delay and however long it has waited since do not count.
+// The pulse that sentence labelled, when there is one, is closer still.
 GpsTime Gps_GetTime()
 {
     GpsTime time = { 0 };
+    GpsPps pulse;
+    uint32_t dollar_us;
+
     if (g_gps->getUtcTime != NULL)
     {
-        int utc_time = (int)g_gps->getUtcTime();
-        time.sec = utc_time % 100;
-        utc_time = utc_time/100;
-        time.min = utc_time % 100;
-        utc_time = utc_time/100;
-        time.hr  = utc_time % 100;
+        parseUtc(g_gps->getUtcTime(), &time);
+    }
+    time.fix = (g_gps->getFix != NULL) ? g_gps->getFix() : GPS_FIX_UNKNOWN;
+    if (g_gps->getDate != NULL)
+    {
+        parseDate(g_gps->getDate(), &time.date);
+    }
+    if (g_gps->getUtcTimeUs != NULL)
+    {
+        dollar_us = g_gps->getUtcTimeUs();
+        time.stamped = true;
+        time.at_us = dollar_us - g_gps->latency_us;
+        if (Gps_GetPps(&pulse) == CLOCK_OK && dollar_us - pulse.at_us < GPS_PPS_PAIR_US)
+        {
+            time.hr  = pulse.ms / 3600000;
+            time.min = pulse.ms / 60000 % 60;
+            time.sec = pulse.ms / 1000 % 60;
+            time.ms  = 0;
+            time.at_us = pulse.at_us;
+        }
     }
     return time;
 }
+
+// From the PPS capture interrupt, at_us is the microsecond source at the pulse's edge
+void Gps_PpsEdge(uint32_t at_us)
+{
+    pps_edge_us = at_us;
+    pps_edge_count++;
+}
+
+// The last pulse and the time of day it marks, fails until a pulse is labelled. A pulse is
+// labelled by the first sentence that starts within GPS_PPS_PAIR_US after it, or when that
+// sentence is missing by the last label moved on by the whole seconds in between.
+ClockStatus Gps_GetPps(GpsPps *output)
+{
+    if (pps_edge_count != pps_edges_seen)
+    {
+        pps_edges_seen = pps_edge_count;
+        takeEdge(pps_edge_us);
+    }
+    labelEdge();
+    *output = pps;
+    return pps.labelled ? CLOCK_OK : CLOCK_FAIL;
+}
+
+void takeEdge(uint32_t edge_us)
+{
+    uint32_t since_us = edge_us - pps.at_us;
+    uint32_t gap_s = (since_us + 500000) / 1000000;
+    int32_t off_us = (int32_t)(since_us - gap_s * 1000000);
+
+    labelEdge();    // The last pulse's sentence may have come in since the last look
+    if (pps.edges > 0 && gap_s <= GPS_PPS_MAX_GAP_S)
+    {
+        if ((gap_s == 0 || off_us > (int32_t)(GPS_PPS_TOL_US * gap_s) || off_us < -(int32_t)(GPS_PPS_TOL_US * gap_s))
+            && ++pps_rejects < GPS_PPS_MAX_REJECT)
+        {
+            // Not a whole number of seconds on, a glitch on the line
+            pps.rejected++;
+            return;
+        }
+        if (pps_rejects >= GPS_PPS_MAX_REJECT)
+        {
+            pps.labelled = false;
+        }
+        else if (pps.labelled)
+        {
+            pps.ms = (pps.ms + gap_s * 1000) % GPS_DAY_MS;
+        }
+    }
+    else
+    {
+        // First pulse or a long gap, wait for a sentence
+        pps.labelled = false;
+    }
+    pps_rejects = 0;
+    pps.at_us = edge_us;
+    pps.edges++;
+}
+
+// The sentence for this pulse's second has the final say over a carried label
+void labelEdge(void)
+{
+    GpsTime sentence = { 0 };
+
+    if (pps.edges == pps_sentence_edge || g_gps->getUtcTime == NULL || g_gps->getUtcTimeUs == NULL
+        || g_gps->getUtcTimeUs() - pps.at_us >= GPS_PPS_PAIR_US)
+    {
+        return;
+    }
+    parseUtc(g_gps->getUtcTime(), &sentence);
+    if (sentence.ms == 0)
+    {
+        pps_sentence_edge = pps.edges;
+        pps.ms = Epoch_HmsToMs(sentence.hr, sentence.min, sentence.sec);
+        pps.labelled = true;
+        pps.labels++;
+    }
+}
+
+void parseUtc(float utc, GpsTime *time)
+{
+    int utc_time = (int)utc;
+    time->ms  = (uint16_t)((utc - utc_time) * 100 + 0.5f) * 10;
+    time->sec = utc_time % 100;
+    utc_time = utc_time/100;
+    time->min = utc_time % 100;
+    utc_time = utc_time/100;
+    time->hr  = utc_time % 100;
+    if (time->ms > 990)
+    {
+        time->ms = 990;
+    }
+}
+
+// Left all zero when the RMC had no date or a bad one
+void parseDate(uint32_t ddmmyy, ClockDate *date)
+{
+    date->day   = ddmmyy / 10000;
+    date->month = ddmmyy / 100 % 100;
+    date->year  = EPOCH_BASE_YEAR + ddmmyy % 100;
+    if (ddmmyy == 0 || Epoch_CheckDate(date) != CLOCK_OK)
+    {
+        memset(date, 0, sizeof(*date));
+    }
+}
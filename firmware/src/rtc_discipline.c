@@ -0,0 +1,336 @@
+/*
+ * rtc_discipline.c
+ * Trims the RTC calibration from the offsets measured at each GPS sync
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: Matt L.
+ *
+ * Every GPS sync measures how far the RTC drifted since the last one and
+ * then steps it back. Adding the offsets up undoes the steps, and adding
+ * back what the calibration took off gives the phase of the RTC as if it
+ * had never been calibrated. The RTC is stepped to the same GPS reading
+ * the offset was measured against, so GPS read errors telescope in that
+ * sum and each phase is only ever off by one of them. RTC read errors do
+ * add up, a floored millisecond would drag the rate by up to 0.28 ppm, so
+ * the caller rounds.
+ *
+ * The phases are averaged into daily bins, which cancels the daily
+ * temperature swing and most of the read noise, and the rate is the least
+ * squares slope through the bins kept. Old bins age out so slow crystal
+ * ageing is followed. The rate rarely lands on a whole calibration step,
+ * so the calibration is dithered between the two nearest steps to average
+ * out at the fraction.
+ *
+ * When the RTC reports its crystal temperature the rate is modelled as a
+ * tuning fork parabola, rate = base - curve * (T - turnover)^2. The square
+ * is integrated every second next to the phase, so each bin also knows the
+ * mean of it since the bin before. Days warmer or colder than the rest show
+ * the curve, it is fitted through them and pulled towards the datasheet
+ * value by DISC_CURVE_WEIGHT so a few noisy days cannot swing it. The base
+ * rate is then the slope through the phases with the curve taken out, and
+ * every dither step programs the rate for the temperature right now.
+ */
+
+#include "rtc_discipline.h"
+
+#include "flight_recorder.h"
+#include "rtc_module.h"
+
+typedef struct disc_bin_t
+{
+    uint32_t    t_s;            // Mean time of the syncs in the bin
+    int64_t     x_us;           // Mean free-running phase
+    int64_t     u_s;            // Mean integral of (T - turnover)^2, 0.01 C^2 seconds
+} DiscBin;
+
+/*
+    Private function definitions
+*/
+static void restart(void);
+static void closeBin(void);
+static void estimate(void);
+static int32_t fitCurve(void);
+static void retarget(void);
+static void dither(void);
+static void readTemperature(void);
+static int32_t floorSteps(int32_t q8);
+static DiscBin *binAt(uint8_t age);
+
+/*
+    Private variables
+*/
+static DiscStats stats;
+static int32_t step_ppb, max_calib;
+static uint32_t uptime_s;
+static int64_t corr_ns;         // What the calibration has taken off the RTC
+static int64_t phase_us;        // RTC minus GPS with the steps undone
+static uint32_t last_sync_s;
+static int32_t dither_q8;
+
+// Temperature, all zero without a sensor so the model is just the base rate
+static int32_t square_c2;       // (T - turnover)^2 now, 0.01 C^2
+static int64_t square_sum;      // Integral of square_c2 over seconds
+
+static DiscBin bins[DISC_BINS];
+static uint8_t num_bins, next_bin;
+static uint64_t bin_t_sum;
+static int64_t bin_x_sum, bin_u_sum;
+static uint32_t bin_n, bin_start_s;
+
+/*
+    Public functions
+*/
+// Call after Rtc_Init, fails and does nothing after when the RTC cannot be calibrated
+ClockStatus Discipline_Init(void)
+{
+    memset(&stats, 0, sizeof(stats));
+    stats.curve_ppt = DISC_CURVE_PPT;
+    uptime_s = 0;
+    corr_ns = 0;
+    phase_us = 0;
+    dither_q8 = 0;
+    square_c2 = 0;
+    square_sum = 0;
+    restart();
+    if (Rtc_GetCalibrationStep(&step_ppb, &max_calib) != CLOCK_OK
+        || Rtc_GetCalibration(&stats.calib) != CLOCK_OK)
+    {
+        return CLOCK_FAIL;
+    }
+    stats.active = true;
+    readTemperature();
+    return CLOCK_OK;
+}
+
+// Once per RTC second
+void Discipline_Tick(void)
+{
+    if (!stats.active)
+    {
+        return;
+    }
+    uptime_s++;
+    corr_ns += (int64_t)stats.calib * step_ppb;
+    square_sum += square_c2;
+    if (uptime_s % DISC_DITHER_S == 0)
+    {
+        readTemperature();
+        if (stats.locked)
+        {
+            retarget();
+            dither();
+        }
+    }
+}
+
+// RTC minus GPS in ms, measured at a sync just before the RTC is stepped to GPS
+ClockStatus Discipline_Measure(int32_t offset_ms)
+{
+    uint32_t since_s = uptime_s - last_sync_s;
+    int32_t limit_ms = (since_s > INT32_MAX / DISC_STEP_PPM) ? INT32_MAX : since_s * DISC_STEP_PPM / 1000 + 1000;
+    int64_t x_us;
+
+    if (!stats.active)
+    {
+        return CLOCK_FAIL;
+    }
+    last_sync_s = uptime_s;
+    stats.syncs++;
+
+    // The first sync carries whatever the RTC was set to, it is the same in every phase after it
+    if (stats.syncs > 1 && (offset_ms > limit_ms || offset_ms < -limit_ms))
+    {
+        stats.restarts++;
+        restart();
+        return CLOCK_OK;
+    }
+    phase_us += (int64_t)offset_ms * 1000;
+    x_us = phase_us + corr_ns / 1000;
+
+    if (bin_n > 0 && uptime_s - bin_start_s >= DISC_BIN_S)
+    {
+        closeBin();
+        estimate();
+    }
+    if (bin_n == 0)
+    {
+        bin_start_s = uptime_s;
+    }
+    bin_t_sum += uptime_s;
+    bin_x_sum += x_us;
+    bin_u_sum += square_sum;
+    bin_n++;
+    return CLOCK_OK;
+}
+
+void Discipline_GetStats(DiscStats *output)
+{
+    *output = stats;
+}
+
+/*
+    Private functions
+*/
+// The phase jumped, nothing before it can be compared with what comes after. The model is kept.
+static void restart(void)
+{
+    num_bins = 0;
+    next_bin = 0;
+    bin_t_sum = 0;
+    bin_x_sum = 0;
+    bin_u_sum = 0;
+    bin_n = 0;
+}
+
+static void closeBin(void)
+{
+    bins[next_bin].t_s = bin_t_sum / bin_n;
+    bins[next_bin].x_us = bin_x_sum / bin_n;
+    bins[next_bin].u_s = bin_u_sum / bin_n;
+    next_bin = (next_bin + 1) % DISC_BINS;
+    if (num_bins < DISC_BINS)
+    {
+        num_bins++;
+    }
+    bin_t_sum = 0;
+    bin_x_sum = 0;
+    bin_u_sum = 0;
+    bin_n = 0;
+}
+
+// Least squares slope through the bins with the temperature curve taken out, in ppb.
+// Times and phases are taken from the oldest bin so the sums stay well inside 64 bits.
+static void estimate(void)
+{
+    DiscBin *oldest = binAt(0), *bin;
+    int64_t t_sum = 0, x_sum = 0, dt, dx, sxx = 0, sxy = 0;
+    int64_t x_us[DISC_BINS];
+
+    if (num_bins < 2)
+    {
+        return;
+    }
+    stats.curve_ppt = fitCurve();
+    for (int i = 0; i < num_bins; i++)
+    {
+        bin = binAt(i);
+        // The curve slowed the crystal by curve * integral, put it back
+        x_us[i] = bin->x_us - oldest->x_us + (int64_t)stats.curve_ppt * (bin->u_s - oldest->u_s) / 100000000;
+        t_sum += bin->t_s - oldest->t_s;
+        x_sum += x_us[i];
+    }
+    for (int i = 0; i < num_bins; i++)
+    {
+        dt = (int64_t)(binAt(i)->t_s - oldest->t_s) * num_bins - t_sum;
+        dx = x_us[i] * num_bins - x_sum;
+        sxx += dt * dt / num_bins;
+        sxy += dt * dx / num_bins;
+    }
+    if (sxx < 1000)
+    {
+        return;
+    }
+    stats.base_ppb = sxy / (sxx / 1000);
+    stats.locked = true;
+    retarget();
+    FlightRec_Log(REC_RTC_TRIM, 0, (uint16_t)floorSteps(stats.target_q8 + 128), stats.freq_ppb);
+}
+
+// Ridge fit of the rate between neighbouring bins against their mean (T - turnover)^2,
+// in parts per trillion per C^2. With no spread in temperature it stays on the datasheet value.
+static int32_t fitCurve(void)
+{
+    int64_t rate_ppb[DISC_BINS - 1], square[DISC_BINS - 1];
+    int64_t rate_sum = 0, square_mean_sum = 0, du, dr, suu = 0, sur = 0;
+    uint32_t span_s;
+    int n = num_bins - 1;
+
+    if (n < 2)
+    {
+        return stats.curve_ppt;
+    }
+    for (int i = 0; i < n; i++)
+    {
+        span_s = binAt(i + 1)->t_s - binAt(i)->t_s;
+        if (span_s == 0)
+        {
+            return stats.curve_ppt;
+        }
+        rate_ppb[i] = (binAt(i + 1)->x_us - binAt(i)->x_us) * 1000 / span_s;
+        square[i] = (binAt(i + 1)->u_s - binAt(i)->u_s) / span_s;
+        rate_sum += rate_ppb[i];
+        square_mean_sum += square[i];
+    }
+    for (int i = 0; i < n; i++)
+    {
+        du = square[i] * n - square_mean_sum;
+        dr = rate_ppb[i] * n - rate_sum;
+        suu += du * du / n / n;
+        sur += du * dr / n / n;
+    }
+    // rate = base - curve_ppt * square / 10^5, so the slope in ppb per 0.01 C^2 is -curve / 10^5
+    return (int32_t)(((int64_t)DISC_CURVE_WEIGHT * DISC_CURVE_PPT - sur * 100000) / (suu + DISC_CURVE_WEIGHT));
+}
+
+// Rate for the temperature now, then in 1/256 calibration steps
+static void retarget(void)
+{
+    int64_t target_q8;
+
+    stats.freq_ppb = stats.base_ppb - (int64_t)stats.curve_ppt * square_c2 / 100000;
+    target_q8 = (int64_t)stats.freq_ppb * 256 / step_ppb;
+    if (target_q8 > (int64_t)max_calib * 256)
+    {
+        target_q8 = (int64_t)max_calib * 256;
+    }
+    else if (target_q8 < -(int64_t)max_calib * 256)
+    {
+        target_q8 = -(int64_t)max_calib * 256;
+    }
+    stats.target_q8 = target_q8;
+}
+
+// First order sigma-delta, the calibration averages out at the target over a few steps
+static void dither(void)
+{
+    int32_t now, next;
+
+    // Set by hand since the last step, count it from here
+    if (Rtc_GetCalibration(&now) == CLOCK_OK && now != stats.calib)
+    {
+        stats.calib = now;
+    }
+    dither_q8 += stats.target_q8;
+    next = floorSteps(dither_q8);
+    dither_q8 -= next * 256;
+    if (next != stats.calib && Rtc_SetCalibration(next) == CLOCK_OK)
+    {
+        stats.calib = next;
+    }
+}
+
+// Keeps the last reading when the sensor has nothing new
+static void readTemperature(void)
+{
+    int16_t centi_c;
+    int32_t delta;
+
+    if (Rtc_GetTemperature(&centi_c) != CLOCK_OK)
+    {
+        return;
+    }
+    delta = centi_c - DISC_TURNOVER_C100;
+    stats.temp_c100 = centi_c;
+    square_c2 = delta * delta / 100;
+}
+
+static int32_t floorSteps(int32_t q8)
+{
+    return (q8 >= 0) ? q8 / 256 : -((255 - q8) / 256);
+}
+
+// 0 is the oldest bin kept
+static DiscBin *binAt(uint8_t age)
+{
+    return &bins[(next_bin + DISC_BINS - num_bins + age) % DISC_BINS];
+}
@@ -12,23 +12,43 @@ ClockStatus Rtc_Init(Rtc *self)
     return CLOCK_OK;
 }
 
+// Time of day only, the date carries on
 ClockStatus Rtc_SetTime(RtcTime *time)
 {
-    if (g_rtc->setRtcTime == NULL) {
+    ClockDate date;
+
+    if (g_rtc->setRtcTime != NULL) {
+        g_rtc->setRtcTime(
+                time->hr,
+                time->min,
+                time->sec);
+        return CLOCK_OK;
+    }
+
+    if (g_rtc->setTimeDate == NULL || Rtc_GetDate(&date) != CLOCK_OK) {
         return CLOCK_FAIL;
     }
+    g_rtc->setTimeDate(time->hr, time->min, time->sec, date.day, date.month);
 
-    g_rtc->setRtcTime(
-            time->hr,
-            time->min,
-            time->sec);
+    return CLOCK_OK;
+}
 
-    if (g_rtc->setDay == NULL || g_rtc->setMonth == NULL) {
+// In one write when the RTC can, the year goes after as it only changes at New Year
+ClockStatus Rtc_SetTimeDate(RtcTime *time, ClockDate *date)
+{
+    if (g_rtc->setTimeDate != NULL) {
+        g_rtc->setTimeDate(time->hr, time->min, time->sec, date->day, date->month);
+    } else if (g_rtc->setRtcTime != NULL && g_rtc->setDay != NULL && g_rtc->setMonth != NULL) {
+        g_rtc->setRtcTime(time->hr, time->min, time->sec);
+        g_rtc->setDay(date->day);
+        g_rtc->setMonth(date->month);
+    } else {
         return CLOCK_FAIL;
     }
 
-    g_rtc->setDay(1);
-    g_rtc->setMonth(1);
+    if (g_rtc->setYear != NULL) {
+        g_rtc->setYear(date->year);
+    }
 
     return CLOCK_OK;
 }
@@ -43,16 +63,29 @@ ClockStatus Rtc_GetTime(RtcTime *time)
     return CLOCK_OK;
 }
 
-ClockStatus Rtc_IsValid()
+// Fails without touching the RTC when it only counts whole seconds
+ClockStatus Rtc_GetTimeMs(RtcTime *time, uint16_t *ms)
 {
-    if (g_rtc->getDay == NULL || g_rtc->getMonth == NULL) {
+    if (g_rtc->getTimeMs == NULL) {
         return CLOCK_FAIL;
     }
+    g_rtc->getTimeMs(&time->hr, &time->min, &time->sec, ms);
 
-    if (g_rtc->getDay() > MAX_NO_DAYS_RESET || g_rtc->getMonth() > 1) {
+    return CLOCK_OK;
+}
+
+// Fails when the RTC keeps no date or the one it has is not a real day
+ClockStatus Rtc_GetDate(ClockDate *date)
+{
+    if (g_rtc->getDay == NULL || g_rtc->getMonth == NULL) {
         return CLOCK_FAIL;
     }
-    return CLOCK_OK;
+
+    date->day = g_rtc->getDay();
+    date->month = g_rtc->getMonth();
+    date->year = (g_rtc->getYear != NULL) ? g_rtc->getYear() : EPOCH_BASE_YEAR;
+
+    return Epoch_CheckDate(date);
 }
 
 ClockStatus Rtc_SetAlarm(RtcTime *time, AlarmId id)
@@ -118,3 +151,25 @@ ClockStatus Rtc_GetCalibration(int32_t *val)
     *val = g_rtc->getCalibration();
     return CLOCK_OK;
 }
+
+// Fails when the RTC cannot be calibrated or has not said how big a step is
+ClockStatus Rtc_GetCalibrationStep(int32_t *step_ppb, int32_t *max)
+{
+    if (g_rtc->setCalibration == NULL || g_rtc->getCalibration == NULL || g_rtc->calib_ppb <= 0)
+    {
+        return CLOCK_FAIL;
+    }
+    *step_ppb = g_rtc->calib_ppb;
+    *max = g_rtc->max_calib;
+    return CLOCK_OK;
+}
+
+// 1/100 C
+ClockStatus Rtc_GetTemperature(int16_t *centi_c)
+{
+    if (g_rtc->getTemperature == NULL || !g_rtc->getTemperature(centi_c))
+    {
+        return CLOCK_FAIL;
+    }
+    return CLOCK_OK;
+}
@@ -0,0 +1,402 @@
+/*
+ * scheduler.c
+ * Cooperative run-to-completion scheduler driven by a hierarchical timer wheel
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: Matt L.
+ *
+ * Level 0 has one slot per millisecond tick, each higher level one slot per
+ * full turn of the level below. A task sits in the lowest level that covers
+ * its due time and drops a level each time the level above turns over, so
+ * starting, cancelling and expiring are all O(1). Tasks only ever run from
+ * Sched_Run in the main loop, nothing here is touched from an interrupt.
+ *
+ * Between passes Sched_Idle sleeps until the next task is due. The wheel
+ * knows that without looking at every tick: a level 0 slot only holds tasks
+ * due on its own tick, and a higher slot only needs a look when it is about
+ * to cascade. Interrupts that queue work end the sleep early and tasks with
+ * a ready check pick it up on the next pass.
+ */
+
+#include "scheduler.h"
+
+#define WHEEL_MASK      (SCHED_WHEEL_SLOTS - 1)
+
+/*
+    Private function definitions
+*/
+static void insert(SchedTask *task, uint32_t due_ms);
+static void push(SchedTask **head, SchedTask *task);
+static void detach(SchedTask *task);
+static void cascade(uint8_t level);
+static void runTask(SchedTask *task);
+static void execute(SchedTask *task);
+static void watch(SchedTask *task, bool on);
+static uint32_t nowUs(void);
+
+/*
+    Private variables
+*/
+static SchedTask *wheel[SCHED_WHEEL_LEVELS][SCHED_WHEEL_SLOTS];
+static uint32_t wheel_ms;       // Last tick the wheel has handled
+static uint32_t now_ms;         // Tick at the start of the current Sched_Run
+static uint32_t (*get_tick)(void) = NULL;
+static uint32_t (*get_us)(void) = NULL;
+static void (*sleep_for)(uint32_t max_ms) = NULL;
+static SchedTask *watched[SCHED_MAX_WATCHED];
+static uint8_t num_watched;
+
+static SchedStats stats;
+static uint32_t window_start_ms;
+static uint64_t window_busy_us;
+static uint64_t window_sleep_us;
+
+/*
+    Public functions
+*/
+// getUs is optional, without it tasks are counted but not timed
+void Sched_Init(uint32_t (*getTick)(void), uint32_t (*getUs)(void))
+{
+    // Let go of anything started before, its links point into the old wheel
+    for (int level = 0; level < SCHED_WHEEL_LEVELS; level++)
+    {
+        for (uint32_t slot = 0; slot < SCHED_WHEEL_SLOTS; slot++)
+        {
+            while (wheel[level][slot] != NULL)
+            {
+                Sched_Cancel(wheel[level][slot]);
+            }
+        }
+    }
+    num_watched = 0;
+    get_tick = getTick;
+    get_us = getUs;
+    sleep_for = NULL;
+    wheel_ms = get_tick();
+    now_ms = wheel_ms;
+    memset(&stats, 0, sizeof(stats));
+    window_start_ms = wheel_ms;
+    window_busy_us = 0;
+    window_sleep_us = 0;
+}
+
+// Run the task delay_ms from now, then every period_ms if it has one. Restarting moves it.
+ClockStatus Sched_Start(SchedTask *task, uint32_t delay_ms)
+{
+    if (get_tick == NULL || task == NULL || task->run == NULL)
+    {
+        return CLOCK_FAIL;
+    }
+    if (task->ready != NULL && !task->armed && num_watched >= SCHED_MAX_WATCHED)
+    {
+        return CLOCK_FAIL;
+    }
+    detach(task);
+    if (task->ready != NULL && !task->armed)
+    {
+        watch(task, true);
+    }
+    task->armed = true;
+    insert(task, get_tick() + delay_ms);
+    return CLOCK_OK;
+}
+
+void Sched_Cancel(SchedTask *task)
+{
+    detach(task);
+    if (task->armed && task->ready != NULL)
+    {
+        watch(task, false);
+    }
+    task->armed = false;
+}
+
+// Call from the main loop, runs everything that has come due since the last call
+void Sched_Run(void)
+{
+    uint32_t elapsed_ms;
+
+    if (get_tick == NULL)
+    {
+        return;
+    }
+    now_ms = get_tick();
+
+    while ((int32_t)(now_ms - wheel_ms) > 0)
+    {
+        wheel_ms++;
+        for (int level = SCHED_WHEEL_LEVELS - 1; level > 0; level--)
+        {
+            // A level turns over when every level below it wraps to slot 0
+            if ((wheel_ms & ((1UL << (SCHED_WHEEL_BITS * level)) - 1)) == 0)
+            {
+                cascade(level);
+            }
+        }
+        while (wheel[0][wheel_ms & WHEEL_MASK] != NULL)
+        {
+            runTask(wheel[0][wheel_ms & WHEEL_MASK]);
+        }
+    }
+
+    // Work queued by interrupts, run it now rather than on the task's next period.
+    // Backwards so a task that cancels itself does not skip the next one.
+    for (int i = num_watched - 1; i >= 0; i--)
+    {
+        if (watched[i]->ready())
+        {
+            execute(watched[i]);
+        }
+    }
+
+    elapsed_ms = now_ms - window_start_ms;
+    if (elapsed_ms >= SCHED_LOAD_WINDOW_MS)
+    {
+        // busy_us / (elapsed_ms * 1000) * 1000
+        stats.load_permille = (window_busy_us >= elapsed_ms * 1000ULL) ? 1000 : window_busy_us / elapsed_ms;
+        if (stats.load_permille > stats.peak_permille)
+        {
+            stats.peak_permille = stats.load_permille;
+        }
+        stats.sleep_permille = (window_sleep_us >= elapsed_ms * 1000ULL) ? 1000 : window_sleep_us / elapsed_ms;
+        window_start_ms = now_ms;
+        window_busy_us = 0;
+        window_sleep_us = 0;
+    }
+}
+
+// The board's sleep, it returns after max_ms or as soon as an interrupt fires. It must check
+// Sched_Ready with interrupts masked before it sleeps so work queued just before is not missed.
+void Sched_SetSleep(void (*sleep)(uint32_t max_ms))
+{
+    sleep_for = sleep;
+}
+
+// Milliseconds until a task is due, 0 if one is due now or has work ready
+uint32_t Sched_IdleMs(uint32_t max_ms)
+{
+    uint32_t behind, best = max_ms, tick;
+    SchedTask *task;
+
+    if (get_tick == NULL || Sched_Ready())
+    {
+        return 0;
+    }
+    behind = get_tick() - wheel_ms;
+    if (behind >= max_ms)
+    {
+        return 0;
+    }
+    best += behind;
+
+    for (uint32_t ms = 1; ms < best; ms++)
+    {
+        tick = wheel_ms + ms;
+        if (wheel[0][tick & WHEEL_MASK] != NULL)
+        {
+            best = ms;
+            break;
+        }
+        for (int level = 1; level < SCHED_WHEEL_LEVELS; level++)
+        {
+            if ((tick & ((1UL << (SCHED_WHEEL_BITS * level)) - 1)) != 0)
+            {
+                break;
+            }
+            // Cascades here, the earliest task in the slot bounds the sleep
+            for (task = wheel[level][(tick >> (SCHED_WHEEL_BITS * level)) & WHEEL_MASK]; task != NULL;
+                 task = task->next)
+            {
+                if (task->due_ms - wheel_ms < best)
+                {
+                    best = task->due_ms - wheel_ms;
+                }
+            }
+        }
+    }
+    return (best > behind) ? best - behind : 0;
+}
+
+bool Sched_Ready(void)
+{
+    for (int i = 0; i < num_watched; i++)
+    {
+        if (watched[i]->ready())
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+// Call from the main loop after Sched_Run, sleeps until the next task unless something is ready
+void Sched_Idle(void)
+{
+    uint32_t idle_ms, start_us, slept_us;
+
+    if (sleep_for == NULL)
+    {
+        return;
+    }
+    idle_ms = Sched_IdleMs(SCHED_MAX_SLEEP_MS);
+    if (idle_ms == 0)
+    {
+        return;
+    }
+    start_us = nowUs();
+    sleep_for(idle_ms);
+    slept_us = nowUs() - start_us;
+    stats.sleeps++;
+    stats.sleep_us += slept_us;
+    window_sleep_us += slept_us;
+}
+
+void Sched_GetStats(SchedStats *output)
+{
+    *output = stats;
+}
+
+/*
+    Private functions
+*/
+// Tasks already due go in the next tick, the wheel has finished with this one
+static void insert(SchedTask *task, uint32_t due_ms)
+{
+    uint32_t delta, slot_ms;
+    uint8_t level = 0;
+
+    if ((int32_t)(due_ms - wheel_ms) <= 0)
+    {
+        due_ms = wheel_ms + 1;
+    }
+    task->due_ms = due_ms;
+    delta = due_ms - wheel_ms;
+
+    // Further out than the wheel reaches, park it in the last slot and re-cascade from there
+    slot_ms = (delta < SCHED_WHEEL_SPAN) ? due_ms : wheel_ms + SCHED_WHEEL_SPAN - 1;
+    while (level < SCHED_WHEEL_LEVELS - 1 && delta >= (1UL << (SCHED_WHEEL_BITS * (level + 1))))
+    {
+        level++;
+    }
+
+    push(&wheel[level][(slot_ms >> (SCHED_WHEEL_BITS * level)) & WHEEL_MASK], task);
+}
+
+static void push(SchedTask **head, SchedTask *task)
+{
+    task->next = *head;
+    task->pprev = head;
+    if (*head != NULL)
+    {
+        (*head)->pprev = &task->next;
+    }
+    *head = task;
+}
+
+static void detach(SchedTask *task)
+{
+    if (task->pprev == NULL)
+    {
+        return;
+    }
+    *task->pprev = task->next;
+    if (task->next != NULL)
+    {
+        task->next->pprev = task->pprev;
+    }
+    task->next = NULL;
+    task->pprev = NULL;
+}
+
+// Move every task in the current slot of a level down to the levels below
+static void cascade(uint8_t level)
+{
+    SchedTask **head = &wheel[level][(wheel_ms >> (SCHED_WHEEL_BITS * level)) & WHEEL_MASK];
+    SchedTask *task;
+
+    while (*head != NULL)
+    {
+        task = *head;
+        detach(task);
+        if (task->due_ms == wheel_ms)
+        {
+            // Lands in the slot about to run, insert would move it to the next tick
+            push(&wheel[0][wheel_ms & WHEEL_MASK], task);
+        }
+        else
+        {
+            insert(task, task->due_ms);
+        }
+    }
+}
+
+static void runTask(SchedTask *task)
+{
+    uint32_t due_ms = task->due_ms;
+
+    detach(task);
+    if (task->period_ms == 0)
+    {
+        Sched_Cancel(task);
+    }
+    else if (now_ms - due_ms >= task->period_ms)
+    {
+        task->late++;
+        stats.late++;
+    }
+    execute(task);
+
+    // Keep the phase so a periodic task catches up after a slow pass,
+    // unless it restarted or cancelled itself while running
+    if (task->armed && task->pprev == NULL)
+    {
+        insert(task, due_ms + task->period_ms);
+    }
+}
+
+static void execute(SchedTask *task)
+{
+    uint32_t start_us = 0, busy_us;
+
+    if (get_us != NULL)
+    {
+        start_us = get_us();
+    }
+    task->run();
+    if (get_us != NULL)
+    {
+        busy_us = get_us() - start_us;
+        task->busy_us += busy_us;
+        window_busy_us += busy_us;
+        if (busy_us > task->max_us)
+        {
+            task->max_us = busy_us;
+        }
+    }
+    task->runs++;
+    stats.runs++;
+}
+
+static void watch(SchedTask *task, bool on)
+{
+    for (int i = 0; i < num_watched; i++)
+    {
+        if (watched[i] == task)
+        {
+            if (!on)
+            {
+                watched[i] = watched[--num_watched];
+            }
+            return;
+        }
+    }
+    if (on && num_watched < SCHED_MAX_WATCHED)
+    {
+        watched[num_watched++] = task;
+    }
+}
+
+static uint32_t nowUs(void)
+{
+    return (get_us != NULL) ? get_us() : get_tick() * 1000;
+}
@@ -0,0 +1,52 @@
+/*
+ * time_format.c
+ * Conversions from milliseconds into displayed time digits
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: Matt L.
+ *
+ * One diurnal increment is 1/12^5 of a day, exactly 3125/9 ms, and one
+ * semi-diurnal increment 6250/3 ms, so both round to nearest in integers.
+ */
+
+#include "time_format.h"
+
+void msToTrad(uint32_t time_ms, uint8_t *hr_24, uint8_t *min, uint8_t *sec)
+{
+    time_ms = time_ms / 1000;
+    *sec = time_ms % 60;
+    time_ms = time_ms / 60;
+    *min = time_ms % 60;
+    time_ms = time_ms / 60;
+    *hr_24 = time_ms % 24;
+}
+
+void msToDiurn(uint32_t time_ms, uint8_t *digit1, uint8_t *digit2, uint8_t *digit3, uint8_t *digit4, uint8_t *digit5)
+{
+    uint32_t increments = (time_ms * 9 + 3125 / 2) / 3125;
+
+    *digit5 = increments % 12;
+    increments /= 12;
+    *digit4 = increments % 12;
+    increments /= 12;
+    *digit3 = increments % 12;
+    increments /= 12;
+    *digit2 = increments % 12;
+    increments /= 12;
+    *digit1 = increments % 12;
+}
+
+void msToSemiDiurn(uint32_t time_ms, uint8_t *digit1, uint8_t *digit2, uint8_t *digit3, uint8_t *digit4, uint8_t *digit5)
+{
+    uint32_t increments = (time_ms * 3 + 6250 / 2) / 6250;
+
+    *digit5 = increments % 12;
+    increments /= 12;
+    *digit4 = increments % 12;
+    increments /= 12;
+    *digit3 = increments % 12;
+    increments /= 12;
+    *digit2 = increments % 12;
+    increments /= 12;
+    *digit1 = increments % 2;
+}
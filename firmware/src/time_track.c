@@ -9,142 +9,778 @@
 #include <rtc_module.h>
 #include "time_track.h"
 
+#include "flight_recorder.h"
 #include "gps.h"
+#include "rtc_discipline.h"
 #include "rtc_module.h"
 
+#define RESYNC_LOG_MS   1000    // Smaller RTC corrections are just the 6 Hz tick catching up
+#define EDGE_DRIFT_US   100     // Allowed drift between the RTC and the microsecond source per second
+#define EDGE_MAX_GAP_S  60      // Windows further apart than this are not compared
+#define SLEW_MAX_MS     1000    // Corrections this big or bigger step
+#define SLEW_PERMILLE   50      // Fastest the shown time runs off true while slewing
+#define EDGE_LOST_MS    2500    // No 1 Hz interrupt for this long and the RTC is polled again
+#define GPS_MAX_AGE_US  2000000 // Older stamps are from a GPS that stopped talking, the reading is rejected
+#define GPS_SET_SPIN_US 2000    // Longest busy wait for the GPS second
+#define GPS_SET_LATE_US 1000    // Later than this past the GPS second and the write waits for the next one
+#define PPS_LOST_US     1500000 // No labelled pulse for this long and the RTC leads again
+#define PPS_UNCERT_US       50      // A captured pulse against the microsecond source
+#define GPS_STAMP_UNCERT_US 20000   // A stamped sentence, the module's latency varies by about this much
+#define GPS_PLAIN_UNCERT_US 1000000 // An unstamped one lands up to a second after the time it gives
+#define DRIFT_FREE_PPB      20000   // Worst RTC rate error until the discipline has fitted one
+#define DRIFT_DISC_PPB      2000    // And once it is trimming the calibration
+#define GPS_OUTLIER_US      50000   // Allowed on top of both bounds before a reading is an outlier
+#define GPS_CONFIRM_MS      50      // Outliers this close to each other agree, plus the reading's own bound
+#define GPS_CONFIRM_RUN     3       // Agreeing outliers in a row and it is the time kept that is wrong
+
 uint8_t check_rtc = 0;
 uint8_t gps_lost = 0;
 uint16_t n = 0;
 
-uint32_t time_ms = 0;
-static RtcTime rtc_time = { 0 }, prev_rtc_time = { 0 };
+uint32_t time_ms = 0;                   // Time of day of epoch_ms
+static EpochMs epoch_ms;                // Stepped on by PeriodicCallback without a microsecond source, else the last shown
+static uint32_t rtc_ms = 0, prev_rtc_ms = 0;   // Whole seconds the RTC last showed, as a time of day
 static GpsTime gps_time = { 0 };
 
-static uint8_t rtcTimesEqual(RtcTime *time_a, RtcTime *time_b);
-static uint32_t rtcTimeToMs(RtcTime *time);
-static uint32_t gpsTimeToMs(GpsTime *time);
+// Interpolation, only used with a microsecond source
+static uint32_t (*get_us)(void) = NULL;
+static bool has_sub_ms = false;
+static uint16_t rtc_sub_ms;
+static EpochMs base_ms;                 // RTC time at base_us
+static uint32_t base_us;
+static uint32_t read_us;                // Last RTC read
+static bool edge_locked = false;
+static uint32_t edge_lo_us, edge_hi_us; // Window holding the edge into base_ms, seconds only RTCs
+
+// Shown minus reference, taken out as the reference moves on
+static int32_t slew_us = 0;
+static int64_t last_ref_us;             // Reference when the slew was last taken down, microsecond source only
+static TimeSlew slew_stats;
+
+// Set from the RTC's 1 Hz interrupt
+static volatile bool edge_pending = false;
+static volatile uint32_t edge_us;
+static bool edge_driven = false;
+static uint32_t since_edge_ms;
+
+// GPS sync waiting for the GPS's next whole second, stamped GPS only
+static bool gps_pending = false;
+static EpochMs gps_due_ms;
+static uint32_t gps_due_us;
+
+// Following the GPS's pulses, microsecond source only
+static bool pps_locked = false;
+static uint32_t pps_edges;
+
+// Source arbitration
+static TimeQuality quality;
+static bool synced = false;             // Some GPS time has been taken since the time was set
+static bool holdover = false;           // The last GPS reading was lost or rejected
+static uint32_t sync_uncert_us;         // Bound right after the last sync
+static uint32_t gps_uncert_us;          // Bound of the reading being synced to
+static uint32_t gps_seen_ms;            // Last reading scored, the same one is not scored twice
+static int64_t outlier_ms;              // Offset of the last outlier
+static uint8_t outlier_run;
+
+static ClockStatus checkRtc(bool at_edge, uint32_t at_us);
+static ClockStatus readRtc(void);
+static EpochMs rtcDatedMs(EpochMs near_ms);
+static void rebase(EpochMs ms, uint32_t at_us);
+static void correct(EpochMs ms, uint32_t at_us);
+static int64_t referenceUs(uint32_t now_us);
+static int64_t shownUs(uint32_t now_us);
+static void lockEdge(uint32_t rtc_ms, uint32_t lo_us, uint32_t hi_us);
+static int32_t offsetMs(uint32_t from_ms, uint32_t to_ms);
+static ClockStatus syncToGps(EpochMs gps_ms, uint32_t at_us);
+static ClockStatus gpsSecond(void);
+static void followPps(void);
+static void followRtc(uint32_t ms, uint32_t at_us);
+static EpochMs gpsEpoch(GpsTime *time, uint32_t ms, uint32_t at_us);
+static ClockStatus acceptGps(GpsTime *time, EpochMs gps_ms, uint32_t at_us);
+static void enterHoldover(void);
+static void chooseSource(void);
+static uint32_t uncertaintyUs(void);
+static EpochMs keptAt(uint32_t at_us);
+
+// Optional, call before TimeTrack_Init. Without it time moves in PeriodicCallback steps.
+void TimeTrack_SetUsSource(uint32_t (*getUs)(void))
+{
+    get_us = getUs;
+}
 
 ClockStatus TimeTrack_Init()
 {
     n = 0;
-    if (Rtc_GetTime(&rtc_time) != CLOCK_OK)
+    if (readRtc() != CLOCK_OK)
     {
         return CLOCK_FAIL;
     }
-    time_ms = rtcTimeToMs(&rtc_time);
-    prev_rtc_time = rtc_time;
+    epoch_ms = rtcDatedMs(rtc_ms);     // 2000-01-01 without a date
+    time_ms = Epoch_TimeOfDay(epoch_ms);
+    prev_rtc_ms = rtc_ms;
+    edge_locked = false;
+    edge_driven = false;
+    gps_pending = false;
+    pps_locked = false;
+    synced = false;
+    holdover = false;
+    gps_seen_ms = UINT32_MAX;
+    outlier_run = 0;
+    memset(&quality, 0, sizeof(quality));
+    rebase(epoch_ms, read_us);
+    memset(&slew_stats, 0, sizeof(slew_stats));
+    FlightRec_Log(REC_RTC_SYNC, 0, 0, time_ms);
+    Discipline_Init();     // Fails quietly on RTCs that cannot be calibrated
     return CLOCK_OK;
 }
 
 ClockStatus TimeTrack_SyncToRtc()
 {
-    if (Rtc_GetTime(&rtc_time) != CLOCK_OK)
+    if (readRtc() != CLOCK_OK)
     {
         return CLOCK_FAIL;
     }
-    prev_rtc_time = rtc_time;
-    time_ms = rtcTimeToMs(&rtc_time);
+    prev_rtc_ms = rtc_ms;
+    edge_locked = false;
+    correct(rtcDatedMs(keptAt(read_us)), read_us);
+    FlightRec_Log(REC_RTC_SYNC, 0, 0, rtc_ms + rtc_sub_ms);
+
+    // Set by hand, whatever the GPS said before no longer bounds it
+    synced = false;
+    holdover = false;
+    chooseSource();
     return CLOCK_OK;
 }
 
 ClockStatus TimeTrack_Update()
 {
-    if (check_rtc)
+    followPps();
+    if (edge_pending)
     {
-        check_rtc = 0;
-        if (Rtc_GetTime(&rtc_time) != CLOCK_OK)
+        edge_pending = false;
+        edge_driven = true;
+        since_edge_ms = 0;
+        if (checkRtc(true, edge_us) != CLOCK_OK)
         {
             return CLOCK_FAIL;
         }
-        if (!rtcTimesEqual(&rtc_time, &prev_rtc_time))
+    }
+    if (check_rtc)
+    {
+        check_rtc = 0;
+        if (checkRtc(false, 0) != CLOCK_OK)
         {
-            // Re-sync internal time to RTC when it updates
-            time_ms = rtcTimeToMs(&rtc_time);
-            prev_rtc_time = rtc_time;
-            n++;
+            return CLOCK_FAIL;
         }
     }
+    if (gps_pending)
+    {
+        return gpsSecond();
+    }
     if (n >= 3600)
     {
         // Attempt to re-sync internal time and RTC to GPS every hour
         if (Gps_Connected() == CLOCK_OK)
         {
+            uint32_t now_us, since_us, gps_ms;
+            EpochMs gps_epoch_ms;
+
             // GPS connected
             gps_lost = 0;
             gps_time = Gps_GetTime();
+            gps_ms = Epoch_HmsToMs(gps_time.hr, gps_time.min, gps_time.sec) + gps_time.ms;
+            now_us = (get_us != NULL) ? get_us() : 0;
+            if (gps_ms == gps_seen_ms)
+            {
+                // Already scored, wait for the next sentence
+                return CLOCK_OK;
+            }
+            gps_seen_ms = gps_ms;
 
-            time_ms = gpsTimeToMs(&gps_time);   // Sync internal time to GPS
-
-            msToRtcTime(time_ms, &rtc_time);
-
-            // Sync RTC to GPS
-            if (Rtc_SetTime(&rtc_time) != CLOCK_OK)
+            if (get_us == NULL || !gps_time.stamped)
             {
-                return CLOCK_FAIL;
+                // As if the sentence were current
+                gps_epoch_ms = gpsEpoch(&gps_time, gps_ms - gps_time.ms, now_us);
+                if (acceptGps(&gps_time, gps_epoch_ms, now_us) != CLOCK_OK)
+                {
+                    return CLOCK_OK;
+                }
+                return syncToGps(gps_epoch_ms, now_us);
             }
-            prev_rtc_time = rtc_time;
-            n = 0;
+            gps_epoch_ms = gpsEpoch(&gps_time, gps_ms, gps_time.at_us);
+            if (acceptGps(&gps_time, gps_epoch_ms, gps_time.at_us) != CLOCK_OK)
+            {
+                return CLOCK_OK;
+            }
+
+            // The GPS's next whole second, the sentence may be from the one before last
+            since_us = (gps_ms % 1000) * 1000 + (now_us - gps_time.at_us);
+            gps_due_us = now_us + 1000000 - since_us % 1000000;
+            gps_due_ms = gps_epoch_ms - gps_ms % 1000 + (since_us / 1000000 + 1) * 1000;
+            gps_pending = true;
+            return gpsSecond();
         }
         else
         {
             // GPS disconnected
             gps_lost = 1;
+            enterHoldover();
         }
     }
     return CLOCK_OK;
 }
 
+// Extra read between the periodic ones, see TimeTrack_NextEdgeMs
+ClockStatus TimeTrack_Probe()
+{
+    if (gps_pending)
+    {
+        return gpsSecond();
+    }
+    return checkRtc(false, 0);
+}
+
+// From the RTC's 1 Hz interrupt as the second changes, at_us is the microsecond source there.
+// The RTC is then only read straight after the edge and the edge's own stamp is the phase,
+// the 6 Hz polling and edge probes stop until the interrupt has been missing for EDGE_LOST_MS.
+void TimeTrack_SecondEdge(uint32_t at_us)
+{
+    edge_us = at_us;
+    edge_pending = true;
+}
+
+// Milliseconds until a seconds-only RTC should tick over. A probe read there halves the window.
+// While a GPS sync waits for its second, milliseconds until that instead, rounded down.
+ClockStatus TimeTrack_NextEdgeMs(uint32_t *delay_ms)
+{
+    uint32_t since_us;
+
+    if (gps_pending)
+    {
+        since_us = gps_due_us - get_us();
+        *delay_ms = ((int32_t)since_us > 0) ? since_us / 1000 : 0;
+        return CLOCK_OK;
+    }
+    if (get_us == NULL || has_sub_ms || !edge_locked || edge_driven || pps_locked)
+    {
+        return CLOCK_FAIL;
+    }
+    since_us = (get_us() - base_us) % 1000000;
+    *delay_ms = (1000000 - since_us + 500) / 1000;
+    return CLOCK_OK;
+}
+
 ClockStatus TimeTrack_PeriodicCallback(uint32_t period_ms)
 {
-    time_ms = (time_ms + period_ms) % TIME_24H_MS;
-    check_rtc = 1;
+    int32_t max_us = period_ms * SLEW_PERMILLE, take_us;
+
+    if (get_us == NULL)
+    {
+        // Whole milliseconds of the slew, at most SLEW_PERMILLE of the period
+        take_us = (slew_us > max_us) ? max_us : (slew_us < -max_us) ? -max_us : slew_us;
+        take_us -= take_us % 1000;
+        slew_us -= take_us;
+        epoch_ms += (int64_t)period_ms - take_us / 1000;
+        time_ms = Epoch_TimeOfDay(epoch_ms);
+    }
+    if (edge_driven && (since_edge_ms += period_ms) > EDGE_LOST_MS)
+    {
+        edge_driven = false;
+    }
+    if (!edge_driven)
+    {
+        check_rtc = 1;
+    }
     return CLOCK_OK;
 }
 
+// Time of day view of TimeTrack_GetEpochMs
 ClockStatus TimeTrack_GetTimeMs(uint32_t *output_ms)
 {
-    *output_ms = time_ms;
+    EpochMs now_ms;
+
+    TimeTrack_GetEpochMs(&now_ms);
+    *output_ms = Epoch_TimeOfDay(now_ms);
+    return CLOCK_OK;
+}
+
+// Milliseconds since 2000-01-01, never wraps so anything due later is just a bigger count.
+// The date comes from the RTC at start-up and when the time is set, and from the GPS's RMC at each sync.
+ClockStatus TimeTrack_GetEpochMs(EpochMs *output_ms)
+{
+    int64_t shown_us;
+
+    if (get_us != NULL)
+    {
+        shown_us = shownUs(get_us());
+        epoch_ms = (shown_us > 0) ? shown_us / 1000 : 0;
+        time_ms = Epoch_TimeOfDay(epoch_ms);
+    }
+    *output_ms = epoch_ms;
+    return CLOCK_OK;
+}
+
+void TimeTrack_GetDate(ClockDate *output)
+{
+    EpochMs now_ms;
+
+    TimeTrack_GetEpochMs(&now_ms);
+    Epoch_ToDate(now_ms, output);
+}
+
+// Correction still to be taken out, positive while the shown time is ahead
+void TimeTrack_GetSlew(TimeSlew *output)
+{
+    *output = slew_stats;
+    output->residual_us = slew_us;
+}
+
+// Source followed now and how far off the time kept may be
+void TimeTrack_GetQuality(TimeQuality *output)
+{
+    *output = quality;
+    output->uncertainty_us = uncertaintyUs();
+}
+
+// Read the RTC and move the time on when its second has changed. At an edge the second
+// shown started at at_us, unless the main loop only got to it a second or more later.
+ClockStatus checkRtc(bool at_edge, uint32_t at_us)
+{
+    uint32_t prev_read_us;
+
+    prev_read_us = read_us;
+    if (readRtc() != CLOCK_OK)
+    {
+        return CLOCK_FAIL;
+    }
+    if (at_edge && get_us != NULL && read_us - at_us >= 1000000)
+    {
+        at_edge = false;
+    }
+    if (get_us != NULL && has_sub_ms && !at_edge)
+    {
+        followRtc(rtc_ms + rtc_sub_ms, read_us);
+    }
+    if (rtc_ms != prev_rtc_ms)
+    {
+        // Re-sync internal time to RTC when it updates
+        uint32_t error_ms = (rtc_ms > time_ms) ? rtc_ms - time_ms : time_ms - rtc_ms;
+        if (error_ms >= RESYNC_LOG_MS && TIME_24H_MS - error_ms >= RESYNC_LOG_MS)
+        {
+            FlightRec_Log(REC_RTC_SYNC, 0, 0, rtc_ms);
+        }
+        if (at_edge)
+        {
+            followRtc(rtc_ms, at_us);
+            if (get_us != NULL)
+            {
+                edge_locked = true;
+                edge_lo_us = at_us;
+                edge_hi_us = at_us;
+            }
+        }
+        else if (get_us != NULL && !has_sub_ms && rtc_ms == (prev_rtc_ms + 1000) % TIME_24H_MS)
+        {
+            // The edge came after the last read that still showed the old second.
+            // Anything but the next second is the RTC jumping mid-second, the next edge gives its phase.
+            lockEdge(rtc_ms, prev_read_us, read_us);
+        }
+        else if (get_us == NULL)
+        {
+            followRtc(rtc_ms, 0);
+        }
+        prev_rtc_ms = rtc_ms;
+        n++;
+        quality.since_sync_s++;
+        Discipline_Tick();
+    }
     return CLOCK_OK;
 }
 
-uint8_t rtcTimesEqual(RtcTime *time_a, RtcTime *time_b)
+// Sub-second read when the RTC has one (the STM32 sub-second register), stamped with the
+// microsecond source. That gives the phase on every read, a seconds-only RTC needs lockEdge.
+ClockStatus readRtc(void)
 {
-    if (time_a->sec != time_b->sec)
+    RtcTime rtc_time;
+
+    has_sub_ms = (Rtc_GetTimeMs(&rtc_time, &rtc_sub_ms) == CLOCK_OK);
+    if (!has_sub_ms)
     {
-        return 0;
+        rtc_sub_ms = 0;
+        if (Rtc_GetTime(&rtc_time) != CLOCK_OK)
+        {
+            return CLOCK_FAIL;
+        }
     }
-    else if (time_a->min != time_b->min)
+    rtc_ms = Epoch_HmsToMs(rtc_time.hr, rtc_time.min, rtc_time.sec);
+    if (get_us != NULL)
+    {
+        read_us = get_us();
+    }
+    return CLOCK_OK;
+}
+
+// The RTC's own date with the time just read, or the day nearest near_ms when it keeps none
+EpochMs rtcDatedMs(EpochMs near_ms)
+{
+    ClockDate date;
+    uint32_t ms = rtc_ms + rtc_sub_ms;
+
+    if (Rtc_GetDate(&date) == CLOCK_OK)
     {
-        return 0;
+        return Epoch_FromDate(&date, ms);
     }
-    else if (time_a->hr != time_b->hr)
+    return Epoch_Nearest(near_ms, ms);
+}
+
+// Step straight to ms at at_us, nothing left to slew
+void rebase(EpochMs ms, uint32_t at_us)
+{
+    base_ms = ms;
+    base_us = at_us;
+    slew_us = 0;
+    last_ref_us = (get_us != NULL) ? referenceUs(get_us()) : 0;
+}
+
+// Move the reference to ms at at_us, keeping what is shown now and slewing the difference out.
+// The shown time runs up to SLEW_PERMILLE fast or slow until it meets the reference, so the
+// display never jumps back or skips a digit. From SLEW_MAX_MS up it is a real change (first
+// sync, GPS after a long outage, the time being set) and steps straight there.
+void correct(EpochMs ms, uint32_t at_us)
+{
+    int64_t diff_us;
+    uint32_t now_us;
+
+    if (get_us == NULL)
     {
-        return 0;
+        diff_us = ((int64_t)epoch_ms - (int64_t)ms) * 1000;
+        if (diff_us <= -SLEW_MAX_MS * 1000 || diff_us >= SLEW_MAX_MS * 1000)
+        {
+            epoch_ms = ms;
+            time_ms = Epoch_TimeOfDay(ms);
+        }
     }
     else
     {
-        return 1;
+        now_us = get_us();
+        diff_us = shownUs(now_us);
+        base_ms = ms;
+        base_us = at_us;
+        last_ref_us = referenceUs(now_us);
+        diff_us -= last_ref_us;
+        if (!has_sub_ms && !edge_locked && !pps_locked && diff_us < 0)
+        {
+            // Until the edge is found the shown time is only good to the second, catch up straight away
+            slew_us = 0;
+            return;
+        }
     }
+
+    if (diff_us <= -SLEW_MAX_MS * 1000 || diff_us >= SLEW_MAX_MS * 1000)
+    {
+        slew_us = 0;
+        slew_stats.steps++;
+    }
+    else
+    {
+        slew_stats.slews += (diff_us != 0);
+        slew_us = diff_us;
+    }
+}
+
+// Microseconds since the epoch
+int64_t referenceUs(uint32_t now_us)
+{
+    uint32_t delta_us = now_us - base_us;
+    int64_t elapsed_us = ((int32_t)delta_us > 0) ? delta_us : 0;
+
+    if (!has_sub_ms && !edge_locked && !pps_locked && elapsed_us > 999999)
+    {
+        // Edge not known yet, hold at the end of the second until a read shows the next one
+        elapsed_us = 999999;
+    }
+    return (int64_t)base_ms * 1000 + elapsed_us;
+}
+
+// The slew comes out at SLEW_PERMILLE of the reference's own progress, so a held reference holds the shown time too
+int64_t shownUs(uint32_t now_us)
+{
+    int64_t ref_us = referenceUs(now_us);
+    int64_t take_us = (ref_us - last_ref_us) * SLEW_PERMILLE / 1000;
+
+    if (take_us > 0 && slew_us != 0)
+    {
+        if (take_us >= (slew_us > 0 ? slew_us : -slew_us))
+        {
+            slew_us = 0;
+        }
+        else
+        {
+            slew_us += (slew_us > 0) ? -take_us : take_us;
+        }
+    }
+    last_ref_us = ref_us;
+    return ref_us + slew_us;
+}
+
+// A seconds-only RTC (DS3231) gives a window each time its second changes, the edge lies between
+// that read and the one before. Narrow the new window with the last one moved on by the seconds in
+// between. A probe where the next edge should be lands on one side of it, so each second the
+// window halves until it is down to the drift between the two clocks.
+void lockEdge(uint32_t rtc_ms, uint32_t lo_us, uint32_t hi_us)
+{
+    uint32_t gap_s = ((rtc_ms + TIME_24H_MS - Epoch_TimeOfDay(base_ms)) % TIME_24H_MS) / 1000;
+    uint32_t moved_lo_us, moved_hi_us;
+
+    if (edge_locked && gap_s > 0 && gap_s <= EDGE_MAX_GAP_S)
+    {
+        moved_lo_us = edge_lo_us + gap_s * (1000000 - EDGE_DRIFT_US);
+        moved_hi_us = edge_hi_us + gap_s * (1000000 + EDGE_DRIFT_US);
+        if ((int32_t)(moved_lo_us - lo_us) < 0)
+        {
+            moved_lo_us = lo_us;
+        }
+        if ((int32_t)(moved_hi_us - hi_us) > 0)
+        {
+            moved_hi_us = hi_us;
+        }
+        // No overlap means the RTC or the source jumped, start again from the new window
+        if ((int32_t)(moved_hi_us - moved_lo_us) >= 0)
+        {
+            lo_us = moved_lo_us;
+            hi_us = moved_hi_us;
+        }
+    }
+    followRtc(rtc_ms, lo_us + (hi_us - lo_us) / 2);
+    edge_locked = true;
+    edge_lo_us = lo_us;
+    edge_hi_us = hi_us;
+}
+
+// Write the RTC and the internal time to gps_ms, the time the GPS gave for at_us
+ClockStatus syncToGps(EpochMs gps_ms, uint32_t at_us)
+{
+    uint32_t kept_ms;
+    RtcTime rtc_time;
+    ClockDate date;
+
+    // How far the RTC drifted since the last sync, the discipline trims its rate with it.
+    // Needs the interpolated time, the stepped one is a tick behind.
+    if (get_us != NULL)
+    {
+        kept_ms = Epoch_TimeOfDay(base_ms + (at_us - base_us + 500) / 1000);
+        Discipline_Measure(offsetMs(Epoch_TimeOfDay(gps_ms), kept_ms));
+    }
+
+    FlightRec_Log(REC_GPS_SYNC, 0, 0, Epoch_TimeOfDay(gps_ms));
+
+    Epoch_MsToHms(Epoch_TimeOfDay(gps_ms), &rtc_time.hr, &rtc_time.min, &rtc_time.sec);
+    Epoch_ToDate(gps_ms, &date);
+
+    // Sync RTC to GPS
+    if (Rtc_SetTimeDate(&rtc_time, &date) != CLOCK_OK)
+    {
+        return CLOCK_FAIL;
+    }
+    prev_rtc_ms = Epoch_TimeOfDay(gps_ms) / 1000 * 1000;
+    n = 0;
+
+    // Writing the seconds restarts the RTC's count, so the edge is now
+    if (get_us != NULL)
+    {
+        read_us = get_us();
+        edge_lo_us = read_us;
+        edge_hi_us = read_us;
+        edge_locked = true;
+    }
+    correct(gps_ms, read_us);   // Sync internal time to GPS
+
+    synced = true;
+    holdover = false;
+    sync_uncert_us = gps_uncert_us;
+    quality.since_sync_s = 0;
+    quality.syncs++;
+    chooseSource();
+    return CLOCK_OK;
 }
 
-uint32_t rtcTimeToMs(RtcTime *time)
+// A sentence says what the time was at the top of its second but lands hundreds of milliseconds
+// later. From its stamp and the module's latency the GPS's next whole second is known, write the
+// RTC on it so its second starts in phase, waiting out at most GPS_SET_SPIN_US. A later second if
+// that one was missed.
+ClockStatus gpsSecond(void)
 {
-    return (uint32_t) time->sec * 1000 + (uint32_t) time->min * 60000
-            + (uint32_t) time->hr * 3600000;
+    int32_t left_us = gps_due_us - get_us();
+
+    if (left_us > GPS_SET_SPIN_US)
+    {
+        return CLOCK_OK;
+    }
+    if (left_us < -GPS_SET_LATE_US)
+    {
+        left_us = -left_us / 1000000 + 1;
+        gps_due_us += left_us * 1000000;
+        gps_due_ms += left_us * 1000;
+        return CLOCK_OK;
+    }
+    while ((int32_t)(gps_due_us - get_us()) > 0)
+    {
+    }
+    gps_pending = false;
+    return syncToGps(gps_due_ms, gps_due_us);
 }
 
-uint32_t gpsTimeToMs(GpsTime *time)
+// Each newly labelled pulse moves the reference to it, so the digits change within microseconds
+// of the GPS's second. The RTC is still read but only leads again after PPS_LOST_US without one.
+void followPps(void)
 {
-    return (uint32_t) time->sec * 1000 + (uint32_t) time->min * 60000
-            + (uint32_t) time->hr * 3600000;
+    GpsPps pulse;
+
+    if (get_us == NULL)
+    {
+        return;
+    }
+    if (Gps_GetPps(&pulse) != CLOCK_OK || get_us() - pulse.at_us > PPS_LOST_US)
+    {
+        if (pps_locked)
+        {
+            // Carries on from the last pulse
+            pps_locked = false;
+            enterHoldover();
+        }
+        return;
+    }
+    if (pulse.edges != pps_edges)
+    {
+        pps_edges = pulse.edges;
+        correct(Epoch_Nearest(keptAt(pulse.at_us), pulse.ms), pulse.at_us);
+        pps_locked = true;
+        synced = true;
+        sync_uncert_us = PPS_UNCERT_US;
+        quality.since_sync_s = 0;
+        chooseSource();
+    }
+}
+
+// RTC readings only move the reference while there are no pulses to follow
+void followRtc(uint32_t ms, uint32_t at_us)
+{
+    if (!pps_locked)
+    {
+        correct(Epoch_Nearest(keptAt(at_us), ms), at_us);
+    }
+}
+
+// The GPS's own date when the RMC gave one, otherwise the day nearest the time kept
+EpochMs gpsEpoch(GpsTime *time, uint32_t ms, uint32_t at_us)
+{
+    if (time->date.year != 0)
+    {
+        return Epoch_FromDate(&time->date, ms);
+    }
+    return Epoch_Nearest(keptAt(at_us), ms);
+}
+
+// Score a GPS reading of gps_ms at at_us. Fails when it is not fit to sync to and the RTC holds over.
+// No fix or a stale stamp is rejected outright. Further off the time kept than both error bounds
+// allow is an outlier, only taken once GPS_CONFIRM_RUN readings in a row agree with each other.
+ClockStatus acceptGps(GpsTime *time, EpochMs gps_ms, uint32_t at_us)
+{
+    uint32_t kept_us = uncertaintyUs();
+    uint64_t bound_us;
+    int64_t offset_ms, apart_ms;
+
+    if (time->fix == 0)
+    {
+        // Valid sentences, but the time is the receiver's own guess
+        quality.no_fix++;
+        enterHoldover();
+        return CLOCK_FAIL;
+    }
+    if (get_us != NULL && time->stamped && get_us() - at_us > GPS_MAX_AGE_US)
+    {
+        quality.stale++;
+        enterHoldover();
+        return CLOCK_FAIL;
+    }
+    gps_uncert_us = (get_us != NULL && time->stamped) ? GPS_STAMP_UNCERT_US : GPS_PLAIN_UNCERT_US;
+
+    if (kept_us != TIME_UNCERT_UNKNOWN)
+    {
+        offset_ms = (int64_t)gps_ms - (int64_t)keptAt(at_us);
+        bound_us = (uint64_t)kept_us + gps_uncert_us + GPS_OUTLIER_US;
+        if ((uint64_t)((offset_ms < 0) ? -offset_ms : offset_ms) * 1000 > bound_us)
+        {
+            // Taken anyway once enough in a row agree, the time kept is what jumped
+            apart_ms = (offset_ms > outlier_ms) ? offset_ms - outlier_ms : outlier_ms - offset_ms;
+            outlier_run = (outlier_run > 0 && apart_ms <= GPS_CONFIRM_MS + gps_uncert_us / 1000)
+                ? outlier_run + 1 : 1;
+            outlier_ms = offset_ms;
+            quality.outliers++;
+            if (outlier_run < GPS_CONFIRM_RUN)
+            {
+                enterHoldover();
+                return CLOCK_FAIL;
+            }
+        }
+    }
+    outlier_run = 0;
+    return CLOCK_OK;
+}
+
+// Running on the RTC alone, from a GPS time when there has been one
+void enterHoldover(void)
+{
+    holdover = true;
+    chooseSource();
+}
+
+// Log each change of source with the bound as it changes
+void chooseSource(void)
+{
+    TimeSource source = pps_locked ? TIME_SRC_PPS
+        : !synced ? TIME_SRC_RTC
+        : holdover ? TIME_SRC_HOLDOVER : TIME_SRC_GPS;
+
+    if (source != quality.source)
+    {
+        FlightRec_Log(REC_TIME_SOURCE, source, quality.source, uncertaintyUs());
+        quality.source = source;
+    }
+}
+
+// The last sync's own bound plus the RTC's worst drift since
+uint32_t uncertaintyUs(void)
+{
+    DiscStats disc;
+    uint64_t bound_us;
+
+    if (!synced)
+    {
+        return TIME_UNCERT_UNKNOWN;
+    }
+    Discipline_GetStats(&disc);
+    bound_us = sync_uncert_us
+        + (uint64_t)quality.since_sync_s * (disc.locked ? DRIFT_DISC_PPB : DRIFT_FREE_PPB) / 1000;
+    return (bound_us < TIME_UNCERT_UNKNOWN) ? bound_us : TIME_UNCERT_UNKNOWN;
+}
+
+// Time kept for at_us, which may be before base_us
+EpochMs keptAt(uint32_t at_us)
+{
+    int64_t at_ms;
+
+    if (get_us == NULL)
+    {
+        return epoch_ms;
+    }
+    at_ms = (int64_t)base_ms + (int32_t)(at_us - base_us) / 1000;
+    return (at_ms > 0) ? at_ms : 0;
 }
 
-void msToRtcTime(uint32_t milliseconds, RtcTime *time)
+// Shortest way round the day from one time to the other
+int32_t offsetMs(uint32_t from_ms, uint32_t to_ms)
 {
-    milliseconds = milliseconds / 1000;
-    time->sec = milliseconds % 60;
-    milliseconds = milliseconds / 60;
-    time->min = milliseconds % 60;
-    milliseconds = milliseconds / 60;
-    time->hr = milliseconds % 24;
+    int32_t offset_ms = (int32_t)((to_ms + TIME_24H_MS - from_ms) % TIME_24H_MS);
+    return (offset_ms > TIME_24H_MS / 2) ? offset_ms - TIME_24H_MS : offset_ms;
 }
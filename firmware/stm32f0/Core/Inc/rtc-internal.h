@@ -16,12 +16,16 @@
 void RTC_Init(RTC_HandleTypeDef *rtc);
 void RTC_SetTime(uint8_t hr, uint8_t min, uint8_t sec);
 void RTC_GetTime(uint8_t *hr, uint8_t *min, uint8_t *sec);
+void RTC_GetTimeMs(uint8_t *hr, uint8_t *min, uint8_t *sec, uint16_t *ms);
 void RTC_SetDay(uint8_t d);
 uint8_t RTC_GetDay(void);
 void RTC_SetMonth(uint8_t m);
 uint8_t RTC_GetMonth(void);
+void RTC_SetYear(uint16_t y);
+uint16_t RTC_GetYear(void);
 void RTC_SetAlarm(uint8_t id, uint8_t hr, uint8_t min, uint8_t sec);
 void RTC_GetAlarm(uint8_t id, uint8_t *hr, uint8_t *min, uint8_t *sec);
 void RTC_EnableAlarm(uint8_t id, bool enable);
+void RTC_EnableSecondEdge(bool enable);
 
 #endif /* INC_RTC_INTERNAL_H_ */
@@ -9,7 +9,9 @@
 #define INC_UART_DISPLAY_H_
 
 #include "main.h"
+#include "chrono_link.h"
 #include "chrono_protocol.h"
+#include "display.h"
 
 bool Esp8266Driver_Init(UART_HandleTypeDef *huart, uint32_t timeout_ms);
 void Esp8266Driver_DisplayOff(void);
@@ -19,5 +21,12 @@ void Esp8266Driver_SetBitmap(uint8_t region_id, uint8_t *bitmap);
 void Esp8266Driver_SetColour(uint8_t region_id, uint8_t colour_id);
 void Esp8266Driver_Show(uint8_t region_id);
 void Esp8266Driver_Hide(uint8_t region_id);
+void Esp8266Driver_SetState(DisplayStateMsg *state);
+
+// Required wherever the driver is used, e.g. a SchedTask with .ready = Esp8266Driver_Pending.
+// Only Poll reads the ACKs, without it the link stops after CHRONO_WINDOW frames.
+void Esp8266Driver_Poll(void);
+bool Esp8266Driver_Pending(void);
+void Esp8266Driver_GetLinkStats(ChronoLinkStats *stats);
 
 #endif /* INC_UART_DISPLAY_H_ */
@@ -23,6 +23,7 @@ typedef struct{
     float nmea_longitude;
     float nmea_latitude;
     float utc_time;
+    uint32_t utc_time_us;   // '$' of the first sentence with this utc_time, see GPS_SetUsSource
     char ns, ew;
     int lock;
     int satelites;
@@ -51,6 +52,7 @@ typedef struct{
     unsigned gps_connected;
 } GPS_t;
 
+void GPS_SetUsSource(uint32_t (*getUs)(void));
 void GPS_Init(UART_HandleTypeDef *huart);
 void GSP_USBPrint(char *data);
 void GPS_print_val(char *data, int value);
@@ -59,6 +61,10 @@ int GPS_validate(char *nmeastr);
 void GPS_parse(char *GPSstrParse);
 float GPS_nmea_to_dec(float deg_coord, char nsew);
 float GPS_get_utc_time();
+uint32_t GPS_get_utc_time_us();
+uint8_t GPS_get_fix();
+uint32_t GPS_get_date();
 unsigned GPS_get_gps_connected();
+uint32_t GPS_get_lines_dropped();
 
 #endif /* INC_UART_GPS_H_ */
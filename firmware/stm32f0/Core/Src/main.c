@@ -32,12 +32,14 @@
 /* USER CODE BEGIN Includes */
 
 #include "clock_types.h"
+#include "deferred.h"
 #include "doz_clock.h"
 #include "event_queue.h"
 #include "rtc_module.h"
 
 #include "buzzer.h"
 #include "display.h"
+#include "display_mux.h"
 #include "gps.h"
 #include "adc-light-sens.h"
 #include "hub75-driver.h"
@@ -46,6 +48,7 @@
 #include "gpio-buttons.h"
 #include "pwm-buzzer.h"
 #include "rtc-internal.h"
+//#include "uart-display.h"
 
 /* USER CODE END Includes */
 
@@ -56,6 +59,7 @@
 
 /* Private define ------------------------------------------------------------*/
 /* USER CODE BEGIN PD */
+#define LIGHT_PERIOD_MS 500     // Light sensor sample rate
 /* USER CODE END PD */
 
 /* Private macro -------------------------------------------------------------*/
@@ -69,6 +73,8 @@
 DozClock doz_clock;
 
 Display rgb_matrix;
+//Display esp_display;
+DisplayMux display_mux;
 Gps neo6m;
 Rtc rtc_internal;
 Rtc ds3231;
@@ -79,11 +85,124 @@ Buzzer buzzer;
 /* Private function prototypes -----------------------------------------------*/
 void SystemClock_Config(void);
 /* USER CODE BEGIN PFP */
+static void FlightRec_UartWrite(uint8_t *buf, uint16_t len);
+static uint32_t Sched_SysTickUs(void);
+static void Sched_TicklessSleep(uint32_t max_ms);
+static void Buttons_Task(void);
+static void RtcAlarm_Work(uint32_t arg);
 
 /* USER CODE END PFP */
 
 /* Private user code ---------------------------------------------------------*/
 /* USER CODE BEGIN 0 */
+// Flight recorder dump goes out on USART2, the header next to the debugger
+static void FlightRec_UartWrite(uint8_t *buf, uint16_t len)
+{
+  HAL_UART_Transmit(&huart2, buf, len, HAL_MAX_DELAY);
+}
+
+// Microseconds for task timing, the HAL tick plus how far SysTick has counted into the next one
+static uint32_t Sched_SysTickUs(void)
+{
+  uint32_t ms, val;
+  do
+  {
+    ms = HAL_GetTick();
+    val = SysTick->VAL;
+  } while (ms != HAL_GetTick());
+  return ms * 1000 + ((SysTick->LOAD - val) * 1000) / (SysTick->LOAD + 1);
+}
+
+// Tickless sleep. SysTick is stretched over the whole sleep so the core is not woken every
+// millisecond, then the HAL tick is moved on by however long the sleep really lasted.
+static void Sched_TicklessSleep(uint32_t max_ms)
+{
+  uint32_t tick_cycles = SysTick->LOAD + 1;
+  uint32_t ctrl, to_next, sleep_cycles, done, remaining;
+
+  if (max_ms > (SysTick_LOAD_RELOAD_Msk + 1) / tick_cycles)
+  {
+    max_ms = (SysTick_LOAD_RELOAD_Msk + 1) / tick_cycles;
+  }
+
+  __disable_irq();
+  if (Sched_Ready() || (SCB->ICSR & SCB_ICSR_PENDSTSET_Msk))
+  {
+    // Work or a tick came in since the scheduler looked
+    __enable_irq();
+    return;
+  }
+  if (max_ms <= 1)
+  {
+    // The next tick is soon enough, no need to touch SysTick
+    __DSB();
+    __WFI();
+    __enable_irq();
+    return;
+  }
+
+  ctrl = SysTick->CTRL;     // Reading clears COUNTFLAG
+  SysTick->CTRL = ctrl & ~SysTick_CTRL_ENABLE_Msk;
+  to_next = SysTick->VAL;
+  sleep_cycles = to_next + (max_ms - 1) * tick_cycles;
+  SysTick->LOAD = sleep_cycles - 1;
+  SysTick->VAL = 0;
+  SysTick->CTRL = ctrl | SysTick_CTRL_ENABLE_Msk;
+
+  __DSB();
+  __WFI();
+
+  ctrl = SysTick->CTRL;
+  SysTick->CTRL = ctrl & ~SysTick_CTRL_ENABLE_Msk;
+  if (ctrl & SysTick_CTRL_COUNTFLAG_Msk)
+  {
+    // Slept it all, the pending SysTick interrupt adds the last millisecond
+    uwTick += max_ms - 1;
+    remaining = tick_cycles;
+  }
+  else
+  {
+    // Woken early, count the whole ticks that went by and finish the one in progress
+    done = (tick_cycles - to_next) + (sleep_cycles - 1 - SysTick->VAL);
+    uwTick += done / tick_cycles;
+    remaining = tick_cycles - done % tick_cycles;
+  }
+  SysTick->LOAD = remaining - 1;
+  SysTick->VAL = 0;
+  SysTick->CTRL = ctrl | SysTick_CTRL_ENABLE_Msk;
+  SysTick->LOAD = tick_cycles - 1;  // Used from the next reload on
+  __enable_irq();
+}
+
+static void Buttons_Task(void)
+{
+  Buttons_TimerCallback(TIMER_PERIOD_MS);
+}
+
+static uint8_t rtc_alarm_flags;
+
+// Posted by the SQW pin, reading the alarm flags is a blocking I2C transfer.
+// With the square wave on, the pin pulses every second and a flag stays set until its alarm is set again, so only a new one counts.
+static void RtcAlarm_Work(uint32_t arg)
+{
+  uint8_t flags = DS3231_GetRegByte(DS3231_REG_STATUS) & ((1 << DS3231_A1F) | (1 << DS3231_A2F));
+
+  if (flags & ~rtc_alarm_flags & (1 << DS3231_A1F)) {
+    EventQ_TriggerAlarmEvent(ALARM_TRIG);
+  }
+  if (flags & ~rtc_alarm_flags & (1 << DS3231_A2F)) {
+    EventQ_TriggerAlarmEvent(TIMER_TRIG);
+  }
+  rtc_alarm_flags = flags;
+}
+
+static DeferWork rtc_alarm_work = {.name = "rtc alarm", .run = RtcAlarm_Work};
+
+static SchedTask buttons_task = {.name = "buttons",   .run = Buttons_Task,                    .period_ms = TIMER_PERIOD_MS};
+static SchedTask light_task   = {.name = "light",     .run = LightSens_AdcStartConversion,    .period_ms = LIGHT_PERIOD_MS};
+static SchedTask mux_task     = {.name = "mux",       .run = DisplayMux_Update,               .period_ms = UPDATE_PERIOD_MS,  .ready = DisplayMux_Pending};
+static SchedTask defer_task   = {.name = "defer",     .run = Defer_Run,                       .period_ms = 1000,              .ready = Defer_Pending};
+//static SchedTask esp_task     = {.name = "esp",       .run = Esp8266Driver_Poll,              .period_ms = 100,               .ready = Esp8266Driver_Pending};
 
 /* USER CODE END 0 */
 
@@ -128,7 +247,9 @@ int main(void)
   MX_RTC_Init();
   /* USER CODE BEGIN 2 */
 
-
+  // Deferred work, registered before anything can post it
+  Defer_Init(Sched_SysTickUs);
+  Defer_Register(&rtc_alarm_work);
 
   // Buzzer
   PKM22E_Init(&htim3, TIM_CHANNEL_1);
@@ -143,12 +264,16 @@ int main(void)
    rtc_internal.getAlarm     = RTC_GetAlarm;
    rtc_internal.getDay       = RTC_GetDay;
    rtc_internal.getMonth     = RTC_GetMonth;
+   rtc_internal.getYear      = RTC_GetYear;
    rtc_internal.getTime      = RTC_GetTime;
+   rtc_internal.getTimeMs    = RTC_GetTimeMs;
    rtc_internal.setAlarm     = RTC_SetAlarm;
    rtc_internal.setDay       = RTC_SetDay;
    rtc_internal.setMonth     = RTC_SetMonth;
+   rtc_internal.setYear      = RTC_SetYear;
    rtc_internal.setRtcTime   = RTC_SetTime;
    doz_clock.rtc = &rtc_internal;
+   RTC_EnableSecondEdge(true);     // The time is read once a second on the wakeup interrupt, not polled
 
   // External RTC
 //  DS3231_Init(&hi2c1);
@@ -157,10 +282,18 @@ int main(void)
 //  ds3231.getTime = DS3231_GetTime;
 //  ds3231.getDay = DS3231_GetDate;
 //  ds3231.getMonth = DS3231_GetMonth;
+//  ds3231.getYear = DS3231_GetYear;
 //  ds3231.setAlarm = DS3231_SetAlarm;
 //  ds3231.setDay = DS3231_SetDate;
 //  ds3231.setMonth = DS3231_SetMonth;
+//  ds3231.setYear = DS3231_SetYear;
 //  ds3231.setRtcTime = DS3231_SetTime;
+//  ds3231.setTimeDate = DS3231_SetTimeDate;
+//  ds3231.setCalibration = DS3231_SetAgingOffset;
+//  ds3231.getCalibration = DS3231_GetAgingOffset;
+//  ds3231.max_calib = DS3231_MAX_AGING;
+//  ds3231.calib_ppb = DS3231_AGING_PPB;
+//  DS3231_EnableSecondEdge(true);
 //  doz_clock.rtc = &ds3231;
 
   // Display
@@ -172,25 +305,49 @@ int main(void)
   rgb_matrix.setColour      = HUB75_SetColour;
   rgb_matrix.show           = HUB75_Show;
   rgb_matrix.hide           = HUB75_Hide;
-  doz_clock.display = &rgb_matrix;
-
-
-  // Doz Clock
+  display_mux.getTick       = HAL_GetTick;
+  DisplayMux_Init(&display_mux);
+  DisplayMux_AddSink(&rgb_matrix, 0, NULL);     // Panel written straight through
+  doz_clock.display = &display_mux.display;
+
+//  // ESP8266 display, esp_task must be started too or its link stalls waiting for ACKs
+//  Esp8266Driver_Init(&huart1, 2000);
+//  esp_display.displayOff    = Esp8266Driver_DisplayOff;
+//  esp_display.displayOn     = Esp8266Driver_DisplayOn;
+//  esp_display.setBrightness = Esp8266Driver_SetDisplayBrightness;
+//  esp_display.setBitmap     = Esp8266Driver_SetBitmap;
+//  esp_display.setColour     = Esp8266Driver_SetColour;
+//  esp_display.show          = Esp8266Driver_Show;
+//  esp_display.hide          = Esp8266Driver_Hide;
+//  esp_display.setState      = Esp8266Driver_SetState;
+//  DisplayMux_AddSink(&esp_display, 0, NULL);
+
+
+  // Flight recorder, first so it catches the boot
+  FlightRec_Init(HAL_GetTick);
+
+  // Doz Clock, time is interpolated between RTC reads with the SysTick microseconds
   doz_clock.error_handler = Error_Handler;
+  TimeTrack_SetUsSource(Sched_SysTickUs);
   DozClock_Init(&doz_clock);
 
 
-  // Buttons
+  // Buttons, events are stamped with the tick they were pressed at
+  EventQ_SetTickSource(HAL_GetTick);
   Buttons_Init();
 
   // Light sensor
   LightSens_Init(&hadc, 1600);
 
-  // Start 2Hz timer
-  HAL_TIM_Base_Start_IT(&htim6);
-
-  // Start 6Hz timer
-  HAL_TIM_Base_Start_IT(&htim7);
+  // Scheduler, all periodic work runs from the main loop off the HAL tick
+  Sched_Init(HAL_GetTick, Sched_SysTickUs);
+  Sched_SetSleep(Sched_TicklessSleep);
+  DozClock_StartTasks();
+  Sched_Start(&buttons_task, 0);
+  Sched_Start(&light_task, 0);
+  Sched_Start(&mux_task, 0);
+  Sched_Start(&defer_task, 0);
+//  Sched_Start(&esp_task, 0);
 
   /* USER CODE END 2 */
 
@@ -198,11 +355,14 @@ int main(void)
   /* USER CODE BEGIN WHILE */
   while (1)
   {
-    DozClock_Update();
+    Sched_Run();
+    Sched_Idle();
 
-      utc = GPS_get_utc_time();
-      status = GPS_get_gps_connected();
-      HAL_Delay(500);
+    // Send 'D' on USART2 to dump the flight recorder
+    if (__HAL_UART_GET_FLAG(&huart2, UART_FLAG_RXNE) && (uint8_t)huart2.Instance->RDR == 'D')
+    {
+      FlightRec_Dump(FlightRec_UartWrite);
+    }
     /* USER CODE END WHILE */
 
 
@@ -270,28 +430,20 @@ void HAL_GPIO_EXTI_Callback(uint16_t pin)
     }
     else
     {
-    	if (DS3231_IsAlarm1Triggered()) {
-    		EventQ_TriggerAlarmEvent(ALARM_TRIG);
-    	} else if (DS3231_IsAlarm2Triggered()) {
-    		EventQ_TriggerAlarmEvent(TIMER_TRIG);
-    	}
+        // Falling edge only, the alarm or with DS3231_EnableSecondEdge every second. Either way the seconds just moved on.
+        TimeTrack_SecondEdge(Sched_SysTickUs());
+        Defer_Post(&rtc_alarm_work, 0);
     }
 }
 
+void HAL_RTCEx_WakeUpTimerEventCallback(RTC_HandleTypeDef *rtc)
+{
+    TimeTrack_SecondEdge(Sched_SysTickUs());
+}
+
 void HAL_TIM_PeriodElapsedCallback(TIM_HandleTypeDef *htim)
 {
-    if(htim == &htim7)
-    {
-        // 6 Hz freq
-        Buttons_TimerCallback(167);
-        DozClock_TimerCallback();
-    }
-    else if(htim == &htim6)
-    {
-        // 2 Hz freq
-        LightSens_AdcStartConversion();
-    }
-    else if(htim == &htim15)
+    if(htim == &htim15)
     {
         HUB75_PwmStartPulse();
     }
@@ -313,6 +465,7 @@ void Error_Handler(void)
   /* USER CODE BEGIN Error_Handler_Debug */
   /* User can add his own implementation to report the HAL error return state */
   __disable_irq();
+  FlightRec_Dump(FlightRec_UartWrite);
   while (1)
   {
   }
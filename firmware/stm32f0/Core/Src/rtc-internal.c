@@ -50,6 +50,17 @@ void RTC_GetTime(uint8_t *hr, uint8_t *min, uint8_t *sec)
     *sec = sTime.Seconds;
 }
 
+// SSR counts down from PREDIV_S through the second, reading the date after releases the shadow registers
+void RTC_GetTimeMs(uint8_t *hr, uint8_t *min, uint8_t *sec, uint16_t *ms)
+{
+    HAL_RTC_GetTime(hrtc, &sTime, RTC_FORMAT);
+    HAL_RTC_GetDate(hrtc, &sDate, RTC_FORMAT);
+    *hr = sTime.Hours;
+    *min = sTime.Minutes;
+    *sec = sTime.Seconds;
+    *ms = ((sTime.SecondFraction - sTime.SubSeconds) * 1000) / (sTime.SecondFraction + 1);
+}
+
 void RTC_SetDay(uint8_t d)
 {
     if (d <= 31)
@@ -80,6 +91,22 @@ uint8_t RTC_GetMonth(void)
     return sDate.Month;
 }
 
+// Two digits from 2000, the leap years it knows are the ones up to 2099
+void RTC_SetYear(uint16_t y)
+{
+    if (y >= 2000 && y <= 2099)
+    {
+        sDate.Year = y - 2000;
+        HAL_RTC_SetDate(hrtc, &sDate, RTC_FORMAT);
+    }
+}
+
+uint16_t RTC_GetYear(void)
+{
+    HAL_RTC_GetDate(hrtc, &sDate, RTC_FORMAT);
+    return 2000 + sDate.Year;
+}
+
 void RTC_SetAlarm(uint8_t id, uint8_t hr, uint8_t min, uint8_t sec)
 {
     if (hr < 24 && min < 60 && sec < 60)
@@ -138,6 +165,20 @@ void RTC_EnableAlarm(uint8_t id, bool enable)
     }
 }
 
+// 1 Hz interrupt off the ck_spre that moves the seconds on, the board's
+// HAL_RTCEx_WakeUpTimerEventCallback passes it to TimeTrack_SecondEdge
+void RTC_EnableSecondEdge(bool enable)
+{
+    if (enable)
+    {
+        HAL_RTCEx_SetWakeUpTimer_IT(hrtc, 0, RTC_WAKEUPCLOCK_CK_SPRE_16BITS);
+    }
+    else
+    {
+        HAL_RTCEx_DeactivateWakeUpTimer(hrtc);
+    }
+}
+
 void HAL_RTC_AlarmAEventCallback(RTC_HandleTypeDef *rtc)
 {
     if (rtc == hrtc)
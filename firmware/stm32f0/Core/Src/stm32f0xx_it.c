@@ -156,6 +156,7 @@ void RTC_IRQHandler(void)
   /* USER CODE END RTC_IRQn 0 */
   HAL_RTC_AlarmIRQHandler(&hrtc);
   /* USER CODE BEGIN RTC_IRQn 1 */
+  HAL_RTCEx_WakeUpTimerIRQHandler(&hrtc);
 
   /* USER CODE END RTC_IRQn 1 */
 }
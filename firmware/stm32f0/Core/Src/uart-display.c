@@ -8,26 +8,38 @@
 #include "uart-display.h"
 
 #define UART_TIMEOUT    100
+#define RX_BUFFER_SIZE  64      // ACK bytes waiting for Esp8266Driver_Poll, covers a few frames of blocking transmit
 
 static uint8_t start_code       = START_CODE;
-static uint8_t on_code          = ON_CODE;
-static uint8_t off_code         = OFF_CODE;
-static uint8_t brightness_code  = BRIGHTNESS_CODE;
-static uint8_t colour_code      = COLOUR_CODE;
-static uint8_t status_code      = STATUS_CODE;
-static uint8_t bitmap_code      = BITMAP_CODE;
 static uint8_t end_code         = END_CODE;
-static uint8_t status_on        = DISPLAY_ON_ID;
-static uint8_t status_off       = DISPLAY_OFF_ID;
+
+// Link channels, each holds the latest state of one message type
+typedef enum
+{
+    CHANNEL_POWER,
+    CHANNEL_BRIGHTNESS,
+    CHANNEL_BITMAP,                         // One per region, then one for all regions
+    CHANNEL_COLOUR  = CHANNEL_BITMAP + 3,   // Bitmaps differ in size, no channel for all regions
+    CHANNEL_STATUS  = CHANNEL_COLOUR + 4,
+    CHANNEL_STATE   = CHANNEL_STATUS + 4,
+} LinkChannel;
 
 UART_HandleTypeDef *uart;
 uint8_t rx_buff[5];
 static bool device_ready = 0, device_waiting = 0;
+static ChronoLink g_link;
+static uint8_t rx_byte;
+static uint8_t rx_ring[RX_BUFFER_SIZE];
+static volatile uint8_t rx_head = 0, rx_tail = 0;
+
 /*
  * Private function definitions
  */
 static void reset_driver(void);
 static void region_to_chronoId(uint8_t *val);
+static void link_transmit(uint8_t *buf, uint16_t len);
+static void send_ready(void);
+static void submit_region(LinkChannel first, uint8_t code, uint8_t region_id, uint8_t *payload, uint8_t len);
 
 /*
  * Public functions
@@ -35,6 +47,10 @@ static void region_to_chronoId(uint8_t *val);
 bool Esp8266Driver_Init(UART_HandleTypeDef *huart, uint32_t timeout_ms)
 {
     uart = huart;
+    g_link.transmit = link_transmit;
+    g_link.rto_ms = CHRONO_DEFAULT_RTO_MS;
+    g_link.peerWaiting = send_ready;
+    ChronoLink_Init(&g_link);
     HAL_UART_Receive_IT(uart, rx_buff, sizeof(rx_buff));
     reset_driver();
     uint32_t start = HAL_GetTick();
@@ -58,10 +74,7 @@ void HAL_UART_RxCpltCallback(UART_HandleTypeDef *huart)
             {
                 device_waiting = 1;
 
-                // Ready sequence
-                HAL_UART_Transmit(uart, &start_code, 1, UART_TIMEOUT);  // Start
-                HAL_UART_Transmit(uart, &start_code, 1, UART_TIMEOUT);  // Start
-                HAL_UART_Transmit(uart, &end_code, 1, UART_TIMEOUT);    // End transmission
+                send_ready();
                 break;
             }
             else if(rx_buff[i] == START_CODE && device_waiting)
@@ -70,43 +83,70 @@ void HAL_UART_RxCpltCallback(UART_HandleTypeDef *huart)
                 break;
             }
         }
-        HAL_UART_Receive_IT(uart, rx_buff, sizeof(rx_buff));
+        if(device_ready)
+        {
+            // Switch to single bytes for link ACKs
+            HAL_UART_Receive_IT(uart, &rx_byte, 1);
+        }
+        else
+        {
+            HAL_UART_Receive_IT(uart, rx_buff, sizeof(rx_buff));
+        }
     }
+    else
+    {
+        if((uint8_t)(rx_head + 1) % RX_BUFFER_SIZE != rx_tail)
+        {
+            rx_ring[rx_head] = rx_byte;
+            rx_head = (rx_head + 1) % RX_BUFFER_SIZE;
+        }
+        HAL_UART_Receive_IT(uart, &rx_byte, 1);
+    }
+}
 
+// Call from the main loop, processes ACKs and resends anything lost
+void Esp8266Driver_Poll(void)
+{
+    while(rx_tail != rx_head)
+    {
+        ChronoLink_ReceiveByte(rx_ring[rx_tail]);
+        rx_tail = (rx_tail + 1) % RX_BUFFER_SIZE;
+    }
+    ChronoLink_Poll(HAL_GetTick());
+}
 
+// ACK bytes waiting for Esp8266Driver_Poll
+bool Esp8266Driver_Pending(void)
+{
+    return rx_tail != rx_head;
 }
 
-void Esp8266Driver_DisplayOff(void)
+void Esp8266Driver_GetLinkStats(ChronoLinkStats *stats)
 {
-    // Off sequence
-    HAL_UART_Transmit(uart, &start_code, 1, UART_TIMEOUT);  // Start
-    HAL_UART_Transmit(uart, &off_code, 1, UART_TIMEOUT);    // Off
-    HAL_UART_Transmit(uart, &end_code, 1, UART_TIMEOUT);    // End transmission
+    ChronoLink_GetStats(stats);
+}
 
+void Esp8266Driver_DisplayOff(void)
+{
+    ChronoLink_Submit(CHANNEL_POWER, OFF_CODE, NULL, 0, HAL_GetTick());
 }
 
 void Esp8266Driver_DisplayOn(void)
 {
-    // On sequence
-    HAL_UART_Transmit(uart, &start_code, 1, UART_TIMEOUT);  // Start
-    HAL_UART_Transmit(uart, &on_code, 1, UART_TIMEOUT);     // On
-    HAL_UART_Transmit(uart, &end_code, 1, UART_TIMEOUT);    // End transmission
+    ChronoLink_Submit(CHANNEL_POWER, ON_CODE, NULL, 0, HAL_GetTick());
 }
 
 void Esp8266Driver_SetDisplayBrightness(uint8_t brightness)
 {
     if(brightness <= MAX_BRIGHTNESS)
     {
-        // Set brightness sequence
-        HAL_UART_Transmit(uart, &start_code, 1, UART_TIMEOUT);          // Start
-        HAL_UART_Transmit(uart, &brightness_code, 1, UART_TIMEOUT);     // Brightness
-        HAL_UART_Transmit(uart, &brightness, 1, UART_TIMEOUT);          // Send brightness value
-        HAL_UART_Transmit(uart, &end_code, 1, UART_TIMEOUT);            // End transmission
+        ChronoLink_Submit(CHANNEL_BRIGHTNESS, BRIGHTNESS_CODE, &brightness, 1, HAL_GetTick());
     }
 }
 
 void Esp8266Driver_SetBitmap(uint8_t region_id, uint8_t *bitmap)
 {
+    uint8_t payload[LARGE_BITMAP_SIZE + 1];
     region_to_chronoId(&region_id);
     uint8_t size = 0;
     if(region_id == MID_REGION_ID)
@@ -117,44 +157,34 @@ void Esp8266Driver_SetBitmap(uint8_t region_id, uint8_t *bitmap)
     {
         size = SMALL_BITMAP_SIZE;
     }
-
-    // Set bitmap sequence
-    HAL_UART_Transmit(uart, &start_code, 1, UART_TIMEOUT);      // Start
-    HAL_UART_Transmit(uart, &bitmap_code, 1, UART_TIMEOUT);     // Bitmap
-    HAL_UART_Transmit(uart, &region_id, 1, UART_TIMEOUT);       // Send region id value
-    for(int i = 0; i < size; i++)
-    {
-        HAL_UART_Transmit(uart, bitmap+i, 1, UART_TIMEOUT);     // Send bitmap values
-    }
-
-    HAL_UART_Transmit(uart, &end_code, 1, UART_TIMEOUT);        // End transmission
+    payload[0] = region_id;
+    memcpy(payload + 1, bitmap, size);
+    submit_region(CHANNEL_BITMAP, BITMAP_CODE, region_id, payload, size + 1);
 }
 void Esp8266Driver_SetColour(uint8_t region_id, uint8_t colour_id)
 {
     region_to_chronoId(&region_id);
-    HAL_UART_Transmit(uart, &start_code, 1, UART_TIMEOUT);      // Start
-    HAL_UART_Transmit(uart, &colour_code, 1, UART_TIMEOUT);     // Colour
-    HAL_UART_Transmit(uart, &region_id, 1, UART_TIMEOUT);       // Send region id value
-    HAL_UART_Transmit(uart, &colour_id, 1, UART_TIMEOUT);       // Send colour id value
-    HAL_UART_Transmit(uart, &end_code, 1, UART_TIMEOUT);        // End transmission
+    uint8_t payload[2] = {region_id, colour_id};
+    submit_region(CHANNEL_COLOUR, COLOUR_CODE, region_id, payload, sizeof(payload));
 }
 void Esp8266Driver_Show(uint8_t region_id)
 {
     region_to_chronoId(&region_id);
-    HAL_UART_Transmit(uart, &start_code, 1, UART_TIMEOUT);      // Start
-    HAL_UART_Transmit(uart, &status_code, 1, UART_TIMEOUT);     // Status
-    HAL_UART_Transmit(uart, &region_id, 1, UART_TIMEOUT);       // Send region id value
-    HAL_UART_Transmit(uart, &status_on, 1, UART_TIMEOUT);       // Send ON status
-    HAL_UART_Transmit(uart, &end_code, 1, UART_TIMEOUT);        // End transmission
+    uint8_t payload[2] = {region_id, DISPLAY_ON_ID};
+    submit_region(CHANNEL_STATUS, STATUS_CODE, region_id, payload, sizeof(payload));
 }
 void Esp8266Driver_Hide(uint8_t region_id)
 {
     region_to_chronoId(&region_id);
-    HAL_UART_Transmit(uart, &start_code, 1, UART_TIMEOUT);      // Start
-    HAL_UART_Transmit(uart, &status_code, 1, UART_TIMEOUT);     // Status
-    HAL_UART_Transmit(uart, &region_id, 1, UART_TIMEOUT);       // Send region id value
-    HAL_UART_Transmit(uart, &status_off, 1, UART_TIMEOUT);      // Send OFF status
-    HAL_UART_Transmit(uart, &end_code, 1, UART_TIMEOUT);        // End transmission
+    uint8_t payload[2] = {region_id, DISPLAY_OFF_ID};
+    submit_region(CHANNEL_STATUS, STATUS_CODE, region_id, payload, sizeof(payload));
+}
+
+void Esp8266Driver_SetState(DisplayStateMsg *state)
+{
+    uint8_t packed[DISPLAY_STATE_MSG_SIZE];
+    uint8_t size = Display_PackState(state, packed);
+    ChronoLink_Submit(CHANNEL_STATE, STATE_CODE, packed, size, HAL_GetTick());
 }
 
 /*
@@ -168,6 +198,35 @@ void reset_driver(void)
     HAL_GPIO_WritePin(DISP_RESET_GPIO_Port, DISP_RESET_Pin, GPIO_PIN_SET);
 }
 
+// Ready sequence, also sent when the ESP resets and waits again, it answers with RESET_CODE
+void send_ready(void)
+{
+    HAL_UART_Transmit(uart, &start_code, 1, UART_TIMEOUT);  // Start
+    HAL_UART_Transmit(uart, &start_code, 1, UART_TIMEOUT);  // Start
+    HAL_UART_Transmit(uart, &end_code, 1, UART_TIMEOUT);    // End transmission
+}
+
+void link_transmit(uint8_t *buf, uint16_t len)
+{
+    HAL_UART_Transmit(uart, buf, len, UART_TIMEOUT);
+}
+
+void submit_region(LinkChannel first, uint8_t code, uint8_t region_id, uint8_t *payload, uint8_t len)
+{
+    if(region_id == ALL_REGION_ID && first != CHANNEL_BITMAP)
+    {
+        // Replaces any per region message still waiting to be acknowledged
+        ChronoLink_Supersede(first);
+        ChronoLink_Supersede(first + 1);
+        ChronoLink_Supersede(first + 2);
+        ChronoLink_Submit(first + 3, code, payload, len, HAL_GetTick());
+    }
+    else if(region_id >= TOP_REGION_ID && region_id <= BOT_REGION_ID)
+    {
+        ChronoLink_Submit(first + (region_id - TOP_REGION_ID), code, payload, len, HAL_GetTick());
+    }
+}
+
 void region_to_chronoId(uint8_t *region_num)
 {
     switch(*region_num)
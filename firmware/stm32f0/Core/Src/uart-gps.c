@@ -31,8 +31,13 @@
 
 
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
 #include "uart-gps.h"
+#include "deferred.h"
+
+static void GPS_ProcessLine(uint32_t len);
+static const char *GPS_field(const char *sentence, int n);
 
 UART_HandleTypeDef *gps_usart;
 
@@ -40,34 +45,69 @@ uint8_t rx_data = 0;
 uint8_t rx_buffer[GPSBUFSIZE];
 uint8_t rx_index = 0;
 
+// Finished sentence waiting for the main loop, the receive buffer carries on filling
+static uint8_t gps_line[GPSBUFSIZE];
+static uint32_t gps_line_us;            // When its '$' came in
+static volatile uint8_t gps_line_busy = 0;
+static uint32_t rx_start_us;
+static uint32_t (*gps_get_us)(void) = NULL;
+static uint32_t gps_lines_dropped = 0;
+static DeferWork gps_line_work = {.name = "gps line", .run = GPS_ProcessLine};
+
 static GPS_t GPS;
 
 void GPS_Init(UART_HandleTypeDef *huart)
 {
     gps_usart = huart;
-    HAL_UART_Receive_IT(gps_usart, &rx_data, 1);
     GPS.gps_connected = 0;
+    Defer_Register(&gps_line_work);
+    HAL_UART_Receive_IT(gps_usart, &rx_data, 1);
 }
 
 
+// Optional, call before GPS_Init. Each sentence is stamped with it as its '$' arrives.
+void GPS_SetUsSource(uint32_t (*getUs)(void))
+{
+    gps_get_us = getUs;
+}
+
+// Interrupt context, only copies the sentence out and leaves the parsing to the main loop
 void GPS_UART_CallBack(){
-    if (rx_data != '\n' && rx_index < sizeof(rx_buffer)) {
+    if (rx_data == '$' && gps_get_us != NULL) {
+        rx_start_us = gps_get_us();
+    }
+    if (rx_data != '\n' && rx_index < sizeof(rx_buffer) - 1) {
         rx_buffer[rx_index++] = rx_data;
     } else {
-
-        if(GPS_validate((char*) rx_buffer)) {
-            GPS.gps_connected = 1;
-            GPS_parse((char*) rx_buffer);
+        if (!gps_line_busy) {
+            memcpy(gps_line, rx_buffer, rx_index);
+            gps_line[rx_index] = 0;
+            gps_line_us = rx_start_us;
+            gps_line_busy = 1;
+            Defer_Post(&gps_line_work, rx_index);
         } else {
-            GPS.gps_connected = 0;
+            gps_lines_dropped++;    // Main loop still has the last one
         }
-
         rx_index = 0;
-        memset(rx_buffer, 0, sizeof(rx_buffer));
     }
     HAL_UART_Receive_IT(gps_usart, &rx_data, 1);
 }
 
+static void GPS_ProcessLine(uint32_t len){
+    float utc_time = GPS.utc_time;
+
+    if(len > 0 && GPS_validate((char*) gps_line)) {
+        GPS.gps_connected = 1;
+        GPS_parse((char*) gps_line);
+        if (GPS.utc_time != utc_time) {
+            GPS.utc_time_us = gps_line_us;  // First sentence of the second, the rest come later in the burst
+        }
+    } else {
+        GPS.gps_connected = 0;
+    }
+    gps_line_busy = 0;
+}
+
 
 int GPS_validate(char *nmeastr){
     char check[3];
@@ -109,6 +149,7 @@ int GPS_validate(char *nmeastr){
 
 void GPS_parse(char *GPSstrParse){
     if(!strncmp(GPSstrParse, "$GPGGA", 6)){
+        GPS.lock = 0;   // Without a fix the position is empty and the scan stops before the fix field
         if (sscanf(GPSstrParse, "$GPGGA,%f,%f,%c,%f,%c,%d,%d,%f,%f,%c", &GPS.utc_time, &GPS.nmea_latitude, &GPS.ns, &GPS.nmea_longitude, &GPS.ew, &GPS.lock, &GPS.satelites, &GPS.hdop, &GPS.msl_altitude, &GPS.msl_units) >= 1){
             GPS.dec_latitude = GPS_nmea_to_dec(GPS.nmea_latitude, GPS.ns);
             GPS.dec_longitude = GPS_nmea_to_dec(GPS.nmea_longitude, GPS.ew);
@@ -116,9 +157,12 @@ void GPS_parse(char *GPSstrParse){
         }
     }
     else if (!strncmp(GPSstrParse, "$GPRMC", 6)){
-        if(sscanf(GPSstrParse, "$GPRMC,%f,%f,%c,%f,%c,%f,%f,%d", &GPS.utc_time, &GPS.nmea_latitude, &GPS.ns, &GPS.nmea_longitude, &GPS.ew, &GPS.speed_k, &GPS.course_d, &GPS.date) >= 1)
+        GPS.rmc_status = 'V';
+        if(sscanf(GPSstrParse, "$GPRMC,%f,%c", &GPS.utc_time, &GPS.rmc_status) >= 1){
+            // Course is empty while standing still and stops a scan, so the date is taken by position
+            GPS.date = (GPS.rmc_status == 'A') ? atoi(GPS_field(GPSstrParse, 9)) : 0;
             return;
-
+        }
     }
     else if (!strncmp(GPSstrParse, "$GPGLL", 6)){
         if(sscanf(GPSstrParse, "$GPGLL,%f,%c,%f,%c,%f,%c", &GPS.nmea_latitude, &GPS.ns, &GPS.nmea_longitude, &GPS.ew, &GPS.utc_time, &GPS.gll_status) >= 1)
@@ -145,6 +189,32 @@ float GPS_get_utc_time() {
     return GPS.utc_time;
 }
 
+uint32_t GPS_get_utc_time_us() {
+    return GPS.utc_time_us;
+}
+
+uint8_t GPS_get_fix() {
+    return (uint8_t)GPS.lock;
+}
+
+uint32_t GPS_get_date() {
+    return (uint32_t)GPS.date;
+}
+
+// Start of the nth comma separated field, an empty string past the last
+static const char *GPS_field(const char *sentence, int n) {
+    while (n > 0 && *sentence != '\0') {
+        if (*sentence++ == ',') {
+            n--;
+        }
+    }
+    return sentence;
+}
+
 unsigned GPS_get_gps_connected() {
     return GPS.gps_connected;
 }
+
+uint32_t GPS_get_lines_dropped() {
+    return gps_lines_dropped;
+}
@@ -11,8 +11,9 @@
 #include "main.h"
 #include "clock_types.h"
 
-void LightSens_Init(ADC_HandleTypeDef *hadc, TIM_HandleTypeDef *htim, uint16_t threshold);
+void LightSens_Init(ADC_HandleTypeDef *hadc, uint16_t threshold);
 void LightSens_AdcStartConversion(void);
 void LightSens_AdcConversionCallback(void);
+bool LightSens_GetTemperature(int16_t *centi_c);
 
 #endif /* INC_ADC_LIGHT_SENS_H_ */
@@ -0,0 +1,23 @@
+/*
+ * gps-pps.h
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: Matt L.
+ */
+
+#ifndef INC_GPS_PPS_H_
+#define INC_GPS_PPS_H_
+
+#include "main.h"
+#include "clock_types.h"
+
+#define PPS_TIM             TIM15
+#define PPS_TIM_CHANNEL     TIM_CHANNEL_1
+#define PPS_Pin             GPIO_PIN_2      // NEO-6M PPS, TIM15_CH1
+#define PPS_GPIO_Port       GPIOA
+
+void PPS_Init(uint32_t (*getUs)(void));
+void PPS_IRQHandler(void);
+void PPS_CaptureCallback(TIM_HandleTypeDef *htim);
+
+#endif /* INC_GPS_PPS_H_ */
@@ -52,11 +52,15 @@
     #define DS3231_A1F          0
 
 #define DS3231_AGING        0x10
+    #define DS3231_MAX_AGING    127
+    #define DS3231_AGING_PPB    100     // Roughly, at 25C. A positive offset slows the oscillator.
 
 #define DS3231_TEMP_MSB     0x11
 #define DS3231_TEMP_LSB     0x12
 
 #define DS3231_TIMEOUT      HAL_MAX_DELAY
+#define DS3231_DMA_TIMEOUT_MS   10      // Longest a blocking call waits for a DMA block to finish
+#define DS3231_SNAPSHOT_MS      500     // DS3231_GetTime answers from a snapshot this young, it was taken just after an edge
 
 #define ALARM_ID    1
 #define TIMER_ID    2
@@ -81,12 +85,33 @@ typedef enum D3231_Alarm2Mode{
     DS3231_A2_EVERY_M = 0x07, DS3231_A2_MATCH_M = 0x06, DS3231_A2_MATCH_M_H = 0x04, DS3231_A2_MATCH_M_H_DATE = 0x00, DS3231_A2_MATCH_M_H_DAY = 0x80,
 }DS3231_Alarm2Mode;
 
+// Staged register changes written by DS3231_Commit in one burst
+typedef struct DS3231_Transaction{
+    uint8_t first, last;                    // Registers touched, first > last while empty
+    uint8_t val[DS3231_REG_STATUS + 1];
+    uint8_t mask[DS3231_REG_STATUS + 1];    // Bits staged, the rest keep what the DS3231 has
+}DS3231_Transaction;
+
 extern I2C_HandleTypeDef *_ds3231_ui2c;
 
 void DS3231_Init(I2C_HandleTypeDef *hi2c);
 
 void DS3231_SetRegByte(uint8_t regAddr, uint8_t val);
 uint8_t DS3231_GetRegByte(uint8_t regAddr);
+bool DS3231_GetRegBlock(uint8_t regAddr, uint8_t *buf, uint16_t len);
+bool DS3231_SetRegBlock(uint8_t regAddr, const uint8_t *buf, uint16_t len);
+bool DS3231_GetRegBlockAsync(uint8_t regAddr, uint8_t *buf, uint16_t len, void (*done)(bool ok));
+bool DS3231_SetRegBlockAsync(uint8_t regAddr, const uint8_t *buf, uint16_t len, void (*done)(bool ok));
+bool DS3231_RefreshAsync(void (*done)(bool ok));
+uint8_t DS3231_GetSnapshotStatus(void);
+
+void DS3231_Begin(DS3231_Transaction *t);
+void DS3231_StageTime(DS3231_Transaction *t, uint8_t hour_24mode, uint8_t minute, uint8_t second);
+void DS3231_StageDate(DS3231_Transaction *t, uint8_t date, uint8_t month);
+void DS3231_StageAlarm1(DS3231_Transaction *t, uint8_t hour_24mode, uint8_t minute, uint8_t second);
+void DS3231_StageAlarm2(DS3231_Transaction *t, uint8_t hour_24mode, uint8_t minute);
+bool DS3231_Commit(const DS3231_Transaction *t);
+void DS3231_SetTimeDate(uint8_t hour_24mode, uint8_t minute, uint8_t second, uint8_t date, uint8_t month);
 
 uint8_t DS3231_GetDayOfWeek(void);
 uint8_t DS3231_GetDate(void);
@@ -115,6 +140,7 @@ uint8_t DS3231_EncodeBCD(uint8_t dec);
 void DS3231_EnableBatterySquareWave(bool enable);
 void DS3231_SetInterruptMode(DS3231_InterruptMode mode);
 void DS3231_SetRateSelect(DS3231_Rate rate);
+void DS3231_EnableSecondEdge(bool enable);
 void DS3231_EnableOscillator(bool enable);
 
 void DS3231_EnableAlarm2(bool enable);
@@ -144,6 +170,9 @@ uint8_t DS3231_IsAlarm2Triggered();
 int8_t DS3231_GetTemperatureInteger();
 uint8_t DS3231_GetTemperatureFraction();
 
+bool DS3231_SetAgingOffset(int32_t offset);
+int32_t DS3231_GetAgingOffset();
+
 void DS3231_SetTime(uint8_t hour_24mode, uint8_t minute, uint8_t second);
 void DS3231_GetTime(uint8_t *hour_24mode, uint8_t *minute, uint8_t *second);
 void DS3231_EnableAlarm(uint8_t alarm_id, bool enable);
@@ -9,27 +9,30 @@
 #include "adc-light-sens.h"
 #include "event_queue.h"
 
+#define ADC_CHANNELS    2       // Light sensor then the die temperature, one pair per scan
 #define ADC_BUF_LENGTH  10
 #define MAX_LIGHT_LEVEL 4095    // Max value on 12-bit ADC
 #define ALPHA           60      // Alpha value for moving avg. (out of 100)
 #define TRANSITION_BUFF 200
+#define VDDA_MV         3300
 
 ADC_HandleTypeDef *adc;
-TIM_HandleTypeDef *tim;
 static uint16_t light_threshold;
 static uint16_t adc_buffer[ADC_BUF_LENGTH];
 static uint32_t sample_avg;
 static uint32_t moving_avg;
 static bool is_dark_room;
+static int32_t temp_avg;        // 1/100 C
+static bool has_temp;
 
-void LightSens_Init(ADC_HandleTypeDef *hadc, TIM_HandleTypeDef *htim, uint16_t threshold)
+static int32_t sensorToCentiC(uint32_t raw);
+
+void LightSens_Init(ADC_HandleTypeDef *hadc, uint16_t threshold)
 {
     adc = hadc;
-    tim = htim;
     is_dark_room = 0;
     light_threshold = threshold;
     moving_avg = MAX_LIGHT_LEVEL;
-    HAL_TIM_Base_Start_IT(tim);
 }
 
 void LightSens_AdcStartConversion(void)
@@ -39,14 +42,29 @@ void LightSens_AdcStartConversion(void)
 
 void LightSens_AdcConversionCallback(void)
 {
+    uint32_t temp_raw = 0;
+
     HAL_ADC_Stop_DMA(adc);
     // Basic average calculation for current sample
     sample_avg = 0;
-    for(int i = 0; i < ADC_BUF_LENGTH; i++)
+    for(int i = 0; i < ADC_BUF_LENGTH; i += ADC_CHANNELS)
     {
         sample_avg += adc_buffer[i];
+        temp_raw += adc_buffer[i + 1];
+    }
+    sample_avg = sample_avg / (ADC_BUF_LENGTH / ADC_CHANNELS);
+
+    // Same filter on the die temperature, the RTC crystal sits next to it
+    temp_raw = temp_raw / (ADC_BUF_LENGTH / ADC_CHANNELS);
+    if (has_temp)
+    {
+        temp_avg = (temp_avg * ALPHA + sensorToCentiC(temp_raw) * (100-ALPHA)) / 100;
+    }
+    else
+    {
+        temp_avg = sensorToCentiC(temp_raw);
+        has_temp = 1;
     }
-    sample_avg = sample_avg / ADC_BUF_LENGTH;
 
     // Moving average filter applied to samples
     moving_avg = (moving_avg * ALPHA + sample_avg * (100-ALPHA)) / 100;
@@ -62,3 +80,25 @@ void LightSens_AdcConversionCallback(void)
         EventQ_TriggerLightEvent(DARK_ROOM);
     }
 }
+
+// For the RTC temperature model, false until the first scan
+bool LightSens_GetTemperature(int16_t *centi_c)
+{
+    if (!has_temp)
+    {
+        return 0;
+    }
+    *centi_c = (int16_t)temp_avg;
+    return 1;
+}
+
+// Two point factory calibration, scaled from the 3.0 V it was taken at
+static int32_t sensorToCentiC(uint32_t raw)
+{
+    int32_t cal1 = *TEMPSENSOR_CAL1_ADDR;
+    int32_t cal2 = *TEMPSENSOR_CAL2_ADDR;
+    int32_t scaled = (int32_t)(raw * VDDA_MV / TEMPSENSOR_CAL_VREFANALOG);
+
+    return (scaled - cal1) * (TEMPSENSOR_CAL2_TEMP - TEMPSENSOR_CAL1_TEMP) * 100 / (cal2 - cal1)
+           + TEMPSENSOR_CAL1_TEMP * 100;
+}
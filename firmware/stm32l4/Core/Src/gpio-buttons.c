@@ -8,14 +8,18 @@
 #include "gpio-buttons.h"
 #include "event_queue.h"
 
-#define BTN_LONG_HOLD_MS    1000
-#define BTN_SHORT_PRESS_MS  100
+#define BTN_LONG_HOLD_MS        1000
+#define BTN_SHORT_PRESS_MS      100
+#define BTN_REPEAT_DELAY_MS     500     // Hold before a repeating button starts stepping
+#define BTN_REPEAT_RAMP_MS      1000    // Steps per tick double this often while held
+#define BTN_REPEAT_MAX_SHIFT    2       // Up to 4 steps per tick
 
 typedef struct button_t
 {
     BtnId id;
     uint16_t pin;
     GPIO_TypeDef *port;
+    bool repeat;
 }Button;
 
 static Button buttons[NUM_BUTTONS] =
@@ -25,8 +29,8 @@ static Button buttons[NUM_BUTTONS] =
         {.id = B_TRAD,    .pin = BTN3_IN_Pin,     .port = BTN3_IN_GPIO_Port},
         {.id = B_LEFT,    .pin = BTN4_IN_Pin,     .port = BTN4_IN_GPIO_Port},
         {.id = B_RIGHT,   .pin = BTN5_IN_Pin,     .port = BTN5_IN_GPIO_Port},
-        {.id = B_UP,      .pin = BTN6_IN_Pin,     .port = BTN6_IN_GPIO_Port},
-        {.id = B_DOWN,    .pin = BTN7_IN_Pin,     .port = BTN7_IN_GPIO_Port},
+        {.id = B_UP,      .pin = BTN6_IN_Pin,     .port = BTN6_IN_GPIO_Port,  .repeat = true},
+        {.id = B_DOWN,    .pin = BTN7_IN_Pin,     .port = BTN7_IN_GPIO_Port,  .repeat = true},
         {.id = B_ALARM,   .pin = BTN8_IN_Pin,     .port = BTN8_IN_GPIO_Port},
         {.id = B_TIMER,   .pin = BTN9_IN_Pin,     .port = BTN9_IN_GPIO_Port},
         {.id = B_VOLUP,   .pin = BTN10_IN_Pin,    .port = BTN10_IN_GPIO_Port},
@@ -36,12 +40,14 @@ static Button buttons[NUM_BUTTONS] =
 static Button *active_btn;
 static uint32_t hold_time_ms = 0;
 static uint8_t btn_released = 0;
+static uint8_t btn_repeating = 0;
 
 void Buttons_Init(void)
 {
     active_btn = NULL;
     hold_time_ms = 0;
     btn_released = 0;
+    btn_repeating = 0;
 }
 
 void Buttons_GpioCallback(uint16_t pin)
@@ -87,7 +93,7 @@ void Buttons_TimerCallback(uint32_t period_ms)
         if(btn_released)
         {
             // Button has already been released
-            if(hold_time_ms < BTN_LONG_HOLD_MS)
+            if(hold_time_ms < BTN_LONG_HOLD_MS && !btn_repeating)
             {
                 // Short press trigger
                 EventQ_TriggerButtonEvent(active_btn->id, SHORT);
@@ -95,14 +101,26 @@ void Buttons_TimerCallback(uint32_t period_ms)
             active_btn = NULL;
             hold_time_ms = 0;
             btn_released = 0;
+            btn_repeating = 0;
         }
-        else if(hold_time_ms < BTN_LONG_HOLD_MS)
+        else if(hold_time_ms < BTN_LONG_HOLD_MS || active_btn->repeat)
         {
             // Button is pressed, waiting to see if it's a long press
             hold_time_ms += period_ms;
-            if (hold_time_ms >= BTN_LONG_HOLD_MS)
+            if (active_btn->repeat && hold_time_ms >= BTN_REPEAT_DELAY_MS)
             {
-                // long press trigger
+                // Auto repeat, steps faster the longer it is held
+                uint32_t shift = (hold_time_ms - BTN_REPEAT_DELAY_MS) / BTN_REPEAT_RAMP_MS;
+                if (shift > BTN_REPEAT_MAX_SHIFT)
+                {
+                    shift = BTN_REPEAT_MAX_SHIFT;
+                }
+                EventQ_TriggerButtonRepeat(active_btn->id, 1 << shift);
+                btn_repeating = 1;
+            }
+            if (!active_btn->repeat && hold_time_ms >= BTN_LONG_HOLD_MS && hold_time_ms - period_ms < BTN_LONG_HOLD_MS)
+            {
+                // long press trigger, a repeating button is already stepping instead
                 EventQ_TriggerButtonEvent(active_btn->id, LONG);
             }
         }
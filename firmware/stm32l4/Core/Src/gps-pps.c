@@ -0,0 +1,86 @@
+/*
+ * gps-pps.c
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: Matt L.
+ *
+ * The NEO-6M's PPS rising edge is captured by TIM15 running at 1 MHz. The
+ * capture interrupt may come in late, so the edge's time is the microsecond
+ * source at the interrupt less how far the timer has counted since the
+ * capture. Labelling the pulse with its time of day is left to Gps_GetPps.
+ */
+
+
+#include "gps-pps.h"
+#include "gps.h"
+
+#define PPS_TIM_HZ      1000000     // One count per microsecond, wraps every 65.5 ms
+#define PPS_FILTER      0x3         // Edge must hold for 8 timer clocks, about 0.1 us at 80 MHz
+
+static TIM_HandleTypeDef htim_pps;
+static uint32_t (*pps_get_us)(void) = NULL;
+
+// Sets up TIM15 and its pin itself, they are not in the .ioc
+void PPS_Init(uint32_t (*getUs)(void))
+{
+    GPIO_InitTypeDef GPIO_InitStruct = {0};
+    TIM_IC_InitTypeDef sConfigIC = {0};
+    uint32_t tim_clk = HAL_RCC_GetPCLK2Freq();
+
+    pps_get_us = getUs;
+
+    // APB2 timers run at twice PCLK2 when it is divided down
+    if ((RCC->CFGR & RCC_CFGR_PPRE2) != RCC_CFGR_PPRE2_DIV1) {
+        tim_clk *= 2;
+    }
+
+    __HAL_RCC_TIM15_CLK_ENABLE();
+    __HAL_RCC_GPIOA_CLK_ENABLE();
+    GPIO_InitStruct.Pin = PPS_Pin;
+    GPIO_InitStruct.Mode = GPIO_MODE_AF_PP;
+    GPIO_InitStruct.Pull = GPIO_PULLDOWN;
+    GPIO_InitStruct.Speed = GPIO_SPEED_FREQ_LOW;
+    GPIO_InitStruct.Alternate = GPIO_AF14_TIM15;
+    HAL_GPIO_Init(PPS_GPIO_Port, &GPIO_InitStruct);
+
+    htim_pps.Instance = PPS_TIM;
+    htim_pps.Init.Prescaler = tim_clk / PPS_TIM_HZ - 1;
+    htim_pps.Init.CounterMode = TIM_COUNTERMODE_UP;
+    htim_pps.Init.Period = 0xFFFF;
+    htim_pps.Init.ClockDivision = TIM_CLOCKDIVISION_DIV1;
+    htim_pps.Init.RepetitionCounter = 0;
+    htim_pps.Init.AutoReloadPreload = TIM_AUTORELOAD_PRELOAD_DISABLE;
+    if (HAL_TIM_IC_Init(&htim_pps) != HAL_OK) {
+        Error_Handler();
+    }
+    sConfigIC.ICPolarity = TIM_INPUTCHANNELPOLARITY_RISING;
+    sConfigIC.ICSelection = TIM_ICSELECTION_DIRECTTI;
+    sConfigIC.ICPrescaler = TIM_ICPSC_DIV1;
+    sConfigIC.ICFilter = PPS_FILTER;
+    if (HAL_TIM_IC_ConfigChannel(&htim_pps, &sConfigIC, PPS_TIM_CHANNEL) != HAL_OK) {
+        Error_Handler();
+    }
+
+    HAL_NVIC_SetPriority(TIM1_BRK_TIM15_IRQn, 0, 0);
+    HAL_NVIC_EnableIRQ(TIM1_BRK_TIM15_IRQn);
+    HAL_TIM_IC_Start_IT(&htim_pps, PPS_TIM_CHANNEL);
+}
+
+void PPS_IRQHandler(void)
+{
+    HAL_TIM_IRQHandler(&htim_pps);
+}
+
+// Interrupt context, from HAL_TIM_IC_CaptureCallback
+void PPS_CaptureCallback(TIM_HandleTypeDef *htim)
+{
+    uint16_t since;
+    uint32_t now_us;
+
+    if (htim != &htim_pps || pps_get_us == NULL) {
+        return;
+    }
+    since = (uint16_t)__HAL_TIM_GET_COUNTER(htim) - (uint16_t)HAL_TIM_ReadCapturedValue(htim, PPS_TIM_CHANNEL);
+    now_us = pps_get_us();
+    Gps_PpsEdge(now_us - since);
+}
@@ -10,12 +10,26 @@
 /* Library by @eepj www.github.com/eepj */
 #include "i2c-rtc.h"
 #include "main.h"
+
+#include <string.h>
 #ifdef __cplusplus
 extern "C"{
 #endif
 
 I2C_HandleTypeDef *_ds3231_ui2c;
 static uint8_t Alarm2Seconds = 0;
+static bool SecondEdge = false;
+
+// Registers from the time to the status, read in one DMA burst
+static uint8_t Snapshot[DS3231_REG_STATUS + 1];
+static volatile bool SnapshotFresh = false;
+static volatile uint32_t SnapshotTick;
+static void (*SnapshotDone)(bool ok) = NULL;
+static void (*volatile AsyncDone)(bool ok) = NULL;
+
+static void DS3231_WaitIdle(void);
+static void DS3231_SnapshotComplete(bool ok);
+static void DS3231_Stage(DS3231_Transaction *t, uint8_t regAddr, uint8_t val, uint8_t mask);
 
 /**
  * @brief Initializes the DS3231 module. Set clock halt bit to 0 to start timing.
@@ -38,8 +52,7 @@ void DS3231_Init(I2C_HandleTypeDef *hi2c) {
  * @param val Value to set, 0 to 255.
  */
 void DS3231_SetRegByte(uint8_t regAddr, uint8_t val) {
-    uint8_t bytes[2] = { regAddr, val };
-    HAL_I2C_Master_Transmit(_ds3231_ui2c, DS3231_I2C_ADDR << 1, bytes, 2, DS3231_TIMEOUT);
+    DS3231_SetRegBlock(regAddr, &val, 1);
 }
 
 /**
@@ -48,12 +61,202 @@ void DS3231_SetRegByte(uint8_t regAddr, uint8_t val) {
  * @return Value stored in the register, 0 to 255.
  */
 uint8_t DS3231_GetRegByte(uint8_t regAddr) {
-    uint8_t val;
-    HAL_I2C_Master_Transmit(_ds3231_ui2c, DS3231_I2C_ADDR << 1, &regAddr, 1, DS3231_TIMEOUT);
-    HAL_I2C_Master_Receive(_ds3231_ui2c, DS3231_I2C_ADDR << 1, &val, 1, DS3231_TIMEOUT);
+    uint8_t val = 0;
+    DS3231_GetRegBlock(regAddr, &val, 1);
     return val;
 }
 
+/**
+ * @brief Reads consecutive registers in one transfer. The DS3231 copies the time registers
+ * to its buffer at the START, so a block across them cannot tear over a rollover.
+ * @param regAddr First register address to read.
+ * @param buf Buffer for len registers.
+ * @param len Number of registers.
+ * @return true when the transfer completed.
+ */
+bool DS3231_GetRegBlock(uint8_t regAddr, uint8_t *buf, uint16_t len) {
+    DS3231_WaitIdle();
+    return HAL_I2C_Mem_Read(_ds3231_ui2c, DS3231_I2C_ADDR << 1, regAddr, I2C_MEMADD_SIZE_8BIT, buf, len, DS3231_TIMEOUT) == HAL_OK;
+}
+
+/**
+ * @brief Writes consecutive registers in one transfer.
+ * @param regAddr First register address to write.
+ * @param buf Values for len registers.
+ * @param len Number of registers.
+ * @return true when the transfer completed.
+ */
+bool DS3231_SetRegBlock(uint8_t regAddr, const uint8_t *buf, uint16_t len) {
+    DS3231_WaitIdle();
+    SnapshotFresh = false;
+    return HAL_I2C_Mem_Write(_ds3231_ui2c, DS3231_I2C_ADDR << 1, regAddr, I2C_MEMADD_SIZE_8BIT, (uint8_t *)buf, len, DS3231_TIMEOUT) == HAL_OK;
+}
+
+/**
+ * @brief Starts reading consecutive registers through the I2C DMA. Call from the main loop, not an interrupt.
+ * @param regAddr First register address to read.
+ * @param buf Buffer for len registers, left alone until done runs.
+ * @param len Number of registers.
+ * @param done Runs from the interrupt when the transfer ends, ok is false on a bus error. May be NULL.
+ * @return false when the bus was busy and nothing was started.
+ */
+bool DS3231_GetRegBlockAsync(uint8_t regAddr, uint8_t *buf, uint16_t len, void (*done)(bool ok)) {
+    AsyncDone = done;
+    if (HAL_I2C_Mem_Read_DMA(_ds3231_ui2c, DS3231_I2C_ADDR << 1, regAddr, I2C_MEMADD_SIZE_8BIT, buf, len) != HAL_OK) {
+        AsyncDone = NULL;
+        return false;
+    }
+    return true;
+}
+
+/**
+ * @brief Starts writing consecutive registers through the I2C DMA. Call from the main loop, not an interrupt.
+ * @param regAddr First register address to write.
+ * @param buf Values for len registers, must stay valid until done runs.
+ * @param len Number of registers.
+ * @param done Runs from the interrupt when the transfer ends, ok is false on a bus error. May be NULL.
+ * @return false when the bus was busy and nothing was started.
+ */
+bool DS3231_SetRegBlockAsync(uint8_t regAddr, const uint8_t *buf, uint16_t len, void (*done)(bool ok)) {
+    AsyncDone = done;
+    SnapshotFresh = false;
+    if (HAL_I2C_Mem_Write_DMA(_ds3231_ui2c, DS3231_I2C_ADDR << 1, regAddr, I2C_MEMADD_SIZE_8BIT, (uint8_t *)buf, len) != HAL_OK) {
+        AsyncDone = NULL;
+        return false;
+    }
+    return true;
+}
+
+/**
+ * @brief Starts a DMA read of every register from the time to the status in one burst. For
+ * DS3231_SNAPSHOT_MS after it lands DS3231_GetTime answers from it without touching the bus.
+ * @param done Runs from the interrupt when the snapshot is in, may be NULL.
+ * @return false when the bus was busy.
+ */
+bool DS3231_RefreshAsync(void (*done)(bool ok)) {
+    SnapshotFresh = false;
+    SnapshotDone = done;
+    return DS3231_GetRegBlockAsync(DS3231_REG_SECOND, Snapshot, sizeof(Snapshot), DS3231_SnapshotComplete);
+}
+
+/**
+ * @brief Status register as of the last snapshot, e.g. the alarm flags.
+ * @return Status register, 0 to 255.
+ */
+uint8_t DS3231_GetSnapshotStatus(void) {
+    return Snapshot[DS3231_REG_STATUS];
+}
+
+/**
+ * @brief Starts an empty transaction, stage what to change then DS3231_Commit it.
+ * @param t Transaction to clear.
+ */
+void DS3231_Begin(DS3231_Transaction *t) {
+    memset(t, 0, sizeof(*t));
+    t->first = sizeof(t->val);
+}
+
+/**
+ * @brief Stages the time. Writing the seconds restarts the DS3231's countdown, so the second starts at the commit.
+ * @param t Transaction to add to.
+ * @param hour_24mode Hour in 24h format, 0 to 23.
+ * @param minute Minute, 0 to 59.
+ * @param second Second, 0 to 59.
+ */
+void DS3231_StageTime(DS3231_Transaction *t, uint8_t hour_24mode, uint8_t minute, uint8_t second) {
+    DS3231_Stage(t, DS3231_REG_SECOND, DS3231_EncodeBCD(second), 0xff);
+    DS3231_Stage(t, DS3231_REG_MINUTE, DS3231_EncodeBCD(minute), 0xff);
+    DS3231_Stage(t, DS3231_REG_HOUR, DS3231_EncodeBCD(hour_24mode) & 0x3f, 0xff);
+}
+
+/**
+ * @brief Stages the date, the century bit is kept.
+ * @param t Transaction to add to.
+ * @param date Day of month, 1 to 31.
+ * @param month Month, 1 to 12.
+ */
+void DS3231_StageDate(DS3231_Transaction *t, uint8_t date, uint8_t month) {
+    DS3231_Stage(t, DS3231_REG_DATE, DS3231_EncodeBCD(date), 0xff);
+    DS3231_Stage(t, DS3231_REG_MONTH, DS3231_EncodeBCD(month), 0x7f);
+}
+
+/**
+ * @brief Stages alarm 1 and clears its flag. The matching mode bits are kept.
+ * @param t Transaction to add to.
+ * @param hour_24mode Hour in 24h format, 0 to 23.
+ * @param minute Minute, 0 to 59.
+ * @param second Second, 0 to 59.
+ */
+void DS3231_StageAlarm1(DS3231_Transaction *t, uint8_t hour_24mode, uint8_t minute, uint8_t second) {
+    DS3231_Stage(t, DS3231_A1_SECOND, DS3231_EncodeBCD(second), 0x7f);
+    DS3231_Stage(t, DS3231_A1_MINUTE, DS3231_EncodeBCD(minute), 0x7f);
+    DS3231_Stage(t, DS3231_A1_HOUR, DS3231_EncodeBCD(hour_24mode) & 0x3f, 0x7f);
+    DS3231_Stage(t, DS3231_REG_STATUS, 0, 0x01 << DS3231_A1F);
+}
+
+/**
+ * @brief Stages alarm 2 and clears its flag. The matching mode bits are kept.
+ * @param t Transaction to add to.
+ * @param hour_24mode Hour in 24h format, 0 to 23.
+ * @param minute Minute, 0 to 59.
+ */
+void DS3231_StageAlarm2(DS3231_Transaction *t, uint8_t hour_24mode, uint8_t minute) {
+    DS3231_Stage(t, DS3231_A2_MINUTE, DS3231_EncodeBCD(minute), 0x7f);
+    DS3231_Stage(t, DS3231_A2_HOUR, DS3231_EncodeBCD(hour_24mode) & 0x3f, 0x7f);
+    DS3231_Stage(t, DS3231_REG_STATUS, 0, 0x01 << DS3231_A2F);
+}
+
+/**
+ * @brief Writes everything staged in one burst from the first register touched to the last. When some
+ * bits in that range are not staged the range is read first, so that is two transfers. Flags read
+ * back as 1 are written as 1, which leaves them alone.
+ * @param t Transaction to write.
+ * @return true when it was written.
+ */
+bool DS3231_Commit(const DS3231_Transaction *t) {
+    uint8_t regs[sizeof(t->val)];
+    uint8_t len;
+    bool partial = false;
+
+    if (t->first > t->last) {
+        return true;
+    }
+    len = t->last - t->first + 1;
+    for (uint8_t i = t->first; i <= t->last; i++) {
+        partial = partial || t->mask[i] != 0xff;
+    }
+    if (partial && !DS3231_GetRegBlock(t->first, regs, len)) {
+        return false;
+    }
+    for (uint8_t i = t->first; i <= t->last; i++) {
+        regs[i - t->first] = (regs[i - t->first] & ~t->mask[i]) | (t->val[i] & t->mask[i]);
+    }
+    return DS3231_SetRegBlock(t->first, regs, len);
+}
+
+/**
+ * @brief Set the time, day of month and month in one transaction.
+ * @param hour_24mode Hour in 24h format, 0 to 23.
+ * @param minute Minute, 0 to 59.
+ * @param second Second, 0 to 59.
+ * @param date Day of month, 1 to 31.
+ * @param month Month, 1 to 12.
+ */
+void DS3231_SetTimeDate(uint8_t hour_24mode, uint8_t minute, uint8_t second, uint8_t date, uint8_t month) {
+    DS3231_Transaction t;
+    DS3231_Begin(&t);
+    DS3231_StageTime(&t, hour_24mode, minute, second);
+    DS3231_StageDate(&t, date, month);
+    DS3231_Commit(&t);
+}
+
+static void DS3231_Stage(DS3231_Transaction *t, uint8_t regAddr, uint8_t val, uint8_t mask) {
+    t->val[regAddr] = (t->val[regAddr] & ~mask) | (val & mask);
+    t->mask[regAddr] |= mask;
+    t->first = (regAddr < t->first) ? regAddr : t->first;
+    t->last = (regAddr > t->last) ? regAddr : t->last;
+}
+
 /**
  * @brief Enables battery-backed square wave output at the INT#/SQW pin.
  * @param enable Enable, true or false.
@@ -81,6 +284,17 @@ void DS3231_SetRateSelect(DS3231_Rate rate){
     DS3231_SetRegByte(DS3231_REG_CONTROL, (control & 0xe7) | ((rate & 0x03) << DS3231_RS1));
 }
 
+/**
+ * @brief Puts the 1 Hz square wave on INT#/SQW in place of the alarm interrupt, its falling edge is the seconds
+ * changing. The alarm flags are still set on a match and have to be polled, enabling an alarm no longer takes the pin back.
+ * @param enable Enable, true or false.
+ */
+void DS3231_EnableSecondEdge(bool enable){
+    SecondEdge = enable;
+    DS3231_SetRateSelect(DS3231_1HZ);
+    DS3231_SetInterruptMode(enable ? DS3231_SQUARE_WAVE_INTERRUPT : DS3231_ALARM_INTERRUPT);
+}
+
 /**
  * @brief Enables clock oscillator.
  * @param enable Enable, true or false.
@@ -97,7 +311,9 @@ void DS3231_EnableOscillator(bool enable){
 void DS3231_EnableAlarm2(bool enable){
     uint8_t control = DS3231_GetRegByte(DS3231_REG_CONTROL);
     DS3231_SetRegByte(DS3231_REG_CONTROL, (control & 0xfd) | ((enable & 0x01) << DS3231_A2IE));
-    DS3231_SetInterruptMode(DS3231_ALARM_INTERRUPT);
+    if (!SecondEdge) {
+        DS3231_SetInterruptMode(DS3231_ALARM_INTERRUPT);
+    }
 }
 
 /**
@@ -169,7 +385,9 @@ void DS3231_SetAlarm2Mode(DS3231_Alarm2Mode alarmMode){
 void DS3231_EnableAlarm1(bool enable){
     uint8_t control = DS3231_GetRegByte(DS3231_REG_CONTROL);
     DS3231_SetRegByte(DS3231_REG_CONTROL, (control & 0xfe) | ((enable & 0x01) << DS3231_A1IE));
-    DS3231_SetInterruptMode(DS3231_ALARM_INTERRUPT);
+    if (!SecondEdge) {
+        DS3231_SetInterruptMode(DS3231_ALARM_INTERRUPT);
+    }
 }
 
 /**
@@ -403,9 +621,7 @@ void DS3231_SetSecond(uint8_t second) {
  * @param second Second, 0 to 59.
  */
 void DS3231_SetFullTime(uint8_t  hour_24mode, uint8_t minute, uint8_t second){
-    DS3231_SetHour(hour_24mode);
-    DS3231_SetMinute(minute);
-    DS3231_SetSecond(second);
+    DS3231_SetTime(hour_24mode, minute, second);
 }
 
 /**
@@ -465,6 +681,31 @@ uint8_t DS3231_GetTemperatureFraction(){
     return (DS3231_GetRegByte(DS3231_TEMP_LSB) >> 6) * 25;
 }
 
+/**
+ * @brief Set the aging offset that trims the oscillator, about 0.1 ppm per step.
+ * @param offset Aging offset, -128 to 127. Positive slows the clock.
+ * @return true when it was in range and written.
+ */
+bool DS3231_SetAgingOffset(int32_t offset){
+    if (offset < -DS3231_MAX_AGING - 1 || offset > DS3231_MAX_AGING) {
+        return false;
+    }
+    DS3231_SetRegByte(DS3231_AGING, (uint8_t)(int8_t)offset);
+
+    // The offset only takes effect at the next temperature conversion, start one now
+    uint8_t control = DS3231_GetRegByte(DS3231_REG_CONTROL);
+    DS3231_SetRegByte(DS3231_REG_CONTROL, control | (0x01 << DS3231_CONV));
+    return true;
+}
+
+/**
+ * @brief Get the aging offset.
+ * @return Aging offset, -128 to 127.
+ */
+int32_t DS3231_GetAgingOffset(){
+    return (int8_t)DS3231_GetRegByte(DS3231_AGING);
+}
+
 
 /**
  * @brief Set the current hour, minute, second
@@ -473,16 +714,25 @@ uint8_t DS3231_GetTemperatureFraction(){
  * @param second Second, 0 to 59.
  */
 void DS3231_SetTime(uint8_t  hour_24mode, uint8_t minute, uint8_t second){
-    DS3231_SetHour(hour_24mode);
-    DS3231_SetMinute(minute);
-    DS3231_SetSecond(second);
+    DS3231_Transaction t;
+    DS3231_Begin(&t);
+    DS3231_StageTime(&t, hour_24mode, minute, second);
+    DS3231_Commit(&t);
 }
 
 void DS3231_GetTime(uint8_t *hour_24mode, uint8_t *minute, uint8_t *second)
 {
-    *hour_24mode    = DS3231_GetHour();
-    *minute         = DS3231_GetMinute();
-    *second         = DS3231_GetSecond();
+    uint8_t regs[3] = { 0 };
+
+    DS3231_WaitIdle();
+    if (SnapshotFresh && HAL_GetTick() - SnapshotTick < DS3231_SNAPSHOT_MS) {
+        memcpy(regs, Snapshot, sizeof(regs));
+    } else {
+        DS3231_GetRegBlock(DS3231_REG_SECOND, regs, sizeof(regs));
+    }
+    *hour_24mode    = DS3231_DecodeBCD(regs[2] & 0x3f);
+    *minute         = DS3231_DecodeBCD(regs[1]);
+    *second         = DS3231_DecodeBCD(regs[0]);
 }
 
 /**
@@ -508,17 +758,15 @@ void DS3231_EnableAlarm(uint8_t alarm_id, bool enable) {
  * @param second Second, 0 to 59.
  */
 void DS3231_SetAlarm(uint8_t alarm_id, uint8_t hour_24mode, uint8_t minute, uint8_t second) {
+    DS3231_Transaction t;
+    DS3231_Begin(&t);
     if (alarm_id == TIMER_ID) {
-        DS3231_SetAlarm1Second(second);
-        DS3231_SetAlarm1Minute(minute);
-        DS3231_SetAlarm1Hour(hour_24mode);
-        DS3231_ClearAlarm1Flag();
+        DS3231_StageAlarm1(&t, hour_24mode, minute, second);
     } else if (alarm_id == ALARM_ID) {
         Alarm2Seconds = second;
-        DS3231_SetAlarm2Minute(minute);
-        DS3231_SetAlarm2Hour(hour_24mode);
-        DS3231_ClearAlarm2Flag();
+        DS3231_StageAlarm2(&t, hour_24mode, minute);
     }
+    DS3231_Commit(&t);
 }
 
 void DS3231_GetAlarm(uint8_t alarm_id, uint8_t *hour_24mode, uint8_t *minute, uint8_t *second)
@@ -570,6 +818,47 @@ uint8_t DS3231_GetAlarmSecond(uint8_t alarm_id) {
     return 0;
 }
 
+// A DMA block may still be running, the blocking calls wait it out
+static void DS3231_WaitIdle(void) {
+    uint32_t start = HAL_GetTick();
+    while (HAL_I2C_GetState(_ds3231_ui2c) != HAL_I2C_STATE_READY && HAL_GetTick() - start < DS3231_DMA_TIMEOUT_MS) {
+    }
+}
+
+static void DS3231_AsyncComplete(bool ok) {
+    void (*done)(bool ok) = AsyncDone;
+    AsyncDone = NULL;
+    if (done != NULL) {
+        done(ok);
+    }
+}
+
+static void DS3231_SnapshotComplete(bool ok) {
+    SnapshotTick = HAL_GetTick();
+    SnapshotFresh = ok;
+    if (SnapshotDone != NULL) {
+        SnapshotDone(ok);
+    }
+}
+
+void HAL_I2C_MemRxCpltCallback(I2C_HandleTypeDef *hi2c) {
+    if (hi2c == _ds3231_ui2c) {
+        DS3231_AsyncComplete(true);
+    }
+}
+
+void HAL_I2C_MemTxCpltCallback(I2C_HandleTypeDef *hi2c) {
+    if (hi2c == _ds3231_ui2c) {
+        DS3231_AsyncComplete(true);
+    }
+}
+
+void HAL_I2C_ErrorCallback(I2C_HandleTypeDef *hi2c) {
+    if (hi2c == _ds3231_ui2c) {
+        DS3231_AsyncComplete(false);
+    }
+}
+
 #ifdef __cplusplus
 }
 #endif
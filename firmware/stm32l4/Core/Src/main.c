@@ -32,6 +32,7 @@
 /* USER CODE BEGIN Includes */
 #include "buzzer.h"
 #include "clock_types.h"
+#include "deferred.h"
 #include "display.h"
 #include "event_queue.h"
 #include "doz_clock.h"
@@ -39,6 +40,7 @@
 #include "adc-light-sens.h"
 #include "dac-buzzer.h"
 #include "gpio-buttons.h"
+#include "gps-pps.h"
 #include "hub75-driver.h"
 #include "i2c-rtc.h"
 #include "pwm-buzzer.h"
@@ -53,6 +55,8 @@
 
 /* Private define ------------------------------------------------------------*/
 /* USER CODE BEGIN PD */
+#define LIGHT_PERIOD_MS 500     // Light sensor sample rate
+#define NEO6M_LATENCY_US 100000 // NEO-6M top of the second to its first '$' at 1 Hz, trim against its PPS
 /* USER CODE END PD */
 
 /* Private macro -------------------------------------------------------------*/
@@ -82,11 +86,128 @@ Rtc rtc_internal;
 /* Private function prototypes -----------------------------------------------*/
 void SystemClock_Config(void);
 /* USER CODE BEGIN PFP */
+static uint32_t Sched_SysTickUs(void);
+static void Sched_TicklessSleep(uint32_t max_ms);
+static void Buttons_Task(void);
+#ifdef USE_EXTERNAL_RTC
+static void RtcAlarm_Work(uint32_t arg);
+#endif
 
 /* USER CODE END PFP */
 
 /* Private user code ---------------------------------------------------------*/
 /* USER CODE BEGIN 0 */
+// Microseconds for task timing, the HAL tick plus how far SysTick has counted into the next one
+static uint32_t Sched_SysTickUs(void)
+{
+  uint32_t ms, val;
+  do
+  {
+    ms = HAL_GetTick();
+    val = SysTick->VAL;
+  } while (ms != HAL_GetTick());
+  return ms * 1000 + ((SysTick->LOAD - val) * 1000) / (SysTick->LOAD + 1);
+}
+
+// Tickless sleep. SysTick is stretched over the whole sleep so the core is not woken every
+// millisecond, then the HAL tick is moved on by however long the sleep really lasted.
+static void Sched_TicklessSleep(uint32_t max_ms)
+{
+  uint32_t tick_cycles = SysTick->LOAD + 1;
+  uint32_t ctrl, to_next, sleep_cycles, done, remaining;
+
+  if (max_ms > (SysTick_LOAD_RELOAD_Msk + 1) / tick_cycles)
+  {
+    max_ms = (SysTick_LOAD_RELOAD_Msk + 1) / tick_cycles;
+  }
+
+  __disable_irq();
+  if (Sched_Ready() || (SCB->ICSR & SCB_ICSR_PENDSTSET_Msk))
+  {
+    // Work or a tick came in since the scheduler looked
+    __enable_irq();
+    return;
+  }
+  if (max_ms <= 1)
+  {
+    // The next tick is soon enough, no need to touch SysTick
+    __DSB();
+    __WFI();
+    __enable_irq();
+    return;
+  }
+
+  ctrl = SysTick->CTRL;     // Reading clears COUNTFLAG
+  SysTick->CTRL = ctrl & ~SysTick_CTRL_ENABLE_Msk;
+  to_next = SysTick->VAL;
+  sleep_cycles = to_next + (max_ms - 1) * tick_cycles;
+  SysTick->LOAD = sleep_cycles - 1;
+  SysTick->VAL = 0;
+  SysTick->CTRL = ctrl | SysTick_CTRL_ENABLE_Msk;
+
+  __DSB();
+  __WFI();
+
+  ctrl = SysTick->CTRL;
+  SysTick->CTRL = ctrl & ~SysTick_CTRL_ENABLE_Msk;
+  if (ctrl & SysTick_CTRL_COUNTFLAG_Msk)
+  {
+    // Slept it all, the pending SysTick interrupt adds the last millisecond
+    uwTick += max_ms - 1;
+    remaining = tick_cycles;
+  }
+  else
+  {
+    // Woken early, count the whole ticks that went by and finish the one in progress
+    done = (tick_cycles - to_next) + (sleep_cycles - 1 - SysTick->VAL);
+    uwTick += done / tick_cycles;
+    remaining = tick_cycles - done % tick_cycles;
+  }
+  SysTick->LOAD = remaining - 1;
+  SysTick->VAL = 0;
+  SysTick->CTRL = ctrl | SysTick_CTRL_ENABLE_Msk;
+  SysTick->LOAD = tick_cycles - 1;  // Used from the next reload on
+  __enable_irq();
+}
+
+static void Buttons_Task(void)
+{
+  Buttons_TimerCallback(TIMER_PERIOD_MS);
+}
+
+#ifdef USE_EXTERNAL_RTC
+static uint8_t rtc_alarm_flags;
+
+// From the DMA interrupt. A flag stays set until its alarm is set again, so only a new one counts.
+static void RtcAlarm_Snapshot(bool ok)
+{
+  uint8_t flags = DS3231_GetSnapshotStatus() & ((1 << DS3231_A1F) | (1 << DS3231_A2F));
+
+  if (!ok) {
+    return;
+  }
+  if (flags & ~rtc_alarm_flags & (1 << DS3231_A1F)) {
+    EventQ_TriggerAlarmEvent(TIMER_TRIG);
+  }
+  if (flags & ~rtc_alarm_flags & (1 << DS3231_A2F)) {
+    EventQ_TriggerAlarmEvent(ALARM_TRIG);
+  }
+  rtc_alarm_flags = flags;
+}
+
+// Posted by the SQW pin once a second, the pin carries the square wave so the alarm flags are polled.
+// One DMA burst brings in the time for TimeTrack and the flags, the main loop does not wait on it.
+static void RtcAlarm_Work(uint32_t arg)
+{
+  DS3231_RefreshAsync(RtcAlarm_Snapshot);
+}
+
+static DeferWork rtc_alarm_work = {.name = "rtc alarm", .run = RtcAlarm_Work};
+#endif
+
+static SchedTask buttons_task = {.name = "buttons",   .run = Buttons_Task,                    .period_ms = TIMER_PERIOD_MS};
+static SchedTask light_task   = {.name = "light",     .run = LightSens_AdcStartConversion,    .period_ms = LIGHT_PERIOD_MS};
+static SchedTask defer_task   = {.name = "defer",     .run = Defer_Run,                       .period_ms = 1000,  .ready = Defer_Pending};
 
 /* USER CODE END 0 */
 
@@ -133,6 +254,12 @@ int main(void)
   MX_USART1_UART_Init();
   /* USER CODE BEGIN 2 */
 
+  // Deferred work, registered before anything can post it
+  Defer_Init(Sched_SysTickUs);
+#ifdef USE_EXTERNAL_RTC
+  Defer_Register(&rtc_alarm_work);
+#endif
+
 #ifdef USE_DAC_BUZZER
   // DAC Buzzer
   PKM22E_DAC_Init(&htim16, &hdac1, DAC_CHANNEL_2);
@@ -169,11 +296,19 @@ int main(void)
   ds3231.getTime        = DS3231_GetTime;
   ds3231.getDay         = DS3231_GetDate;
   ds3231.getMonth       = DS3231_GetMonth;
+  ds3231.getYear        = DS3231_GetYear;
   ds3231.setAlarm       = DS3231_SetAlarm;
   ds3231.setDay         = DS3231_SetDate;
   ds3231.setMonth       = DS3231_SetMonth;
+  ds3231.setYear        = DS3231_SetYear;
   ds3231.setRtcTime     = DS3231_SetTime;
+  ds3231.setTimeDate    = DS3231_SetTimeDate;
+  ds3231.setCalibration = DS3231_SetAgingOffset;
+  ds3231.getCalibration = DS3231_GetAgingOffset;
+  ds3231.max_calib      = DS3231_MAX_AGING;
+  ds3231.calib_ppb      = DS3231_AGING_PPB;
   doz_clock.rtc = &ds3231;
+  DS3231_EnableSecondEdge(true);    // The time is read once a second on the SQW edge, not polled
 #else
   // Internal RTC
   RTC_Init(&hrtc);
@@ -181,36 +316,58 @@ int main(void)
   rtc_internal.getAlarm         = RTC_GetAlarm;
   rtc_internal.getDay           = RTC_GetDay;
   rtc_internal.getMonth         = RTC_GetMonth;
+  rtc_internal.getYear          = RTC_GetYear;
   rtc_internal.getTime          = RTC_GetTime;
+  rtc_internal.getTimeMs        = RTC_GetTimeMs;
   rtc_internal.setAlarm         = RTC_SetAlarm;
   rtc_internal.setDay           = RTC_SetDay;
   rtc_internal.setMonth         = RTC_SetMonth;
+  rtc_internal.setYear          = RTC_SetYear;
   rtc_internal.setRtcTime       = RTC_SetTime;
   rtc_internal.getAlarmStatus   = RTC_CheckAlarmSaved;
   rtc_internal.setCalibration   = RTC_SetCalibration;
   rtc_internal.getCalibration   = RTC_GetCalibration;
   rtc_internal.max_calib        = MAX_CALIBRATION_OFFSET;
+  rtc_internal.calib_ppb        = CALIBRATION_STEP_PPB;
+  rtc_internal.getTemperature   = LightSens_GetTemperature;    // The LSE is not compensated, the DS3231 is
   doz_clock.rtc = &rtc_internal;
+  RTC_EnableSecondEdge(true);       // The time is read once a second on the wakeup interrupt, not polled
 #endif
 
-  // GPS
+  // GPS, sentences are stamped as they start arriving so the hourly sync can take their delay out
+  GPS_SetUsSource(Sched_SysTickUs);
   GPS_Init(&huart1);
   neo6m.gpsConnected    = GPS_get_gps_connected;
   neo6m.getUtcTime      = GPS_get_utc_time;
+  neo6m.getUtcTimeUs    = GPS_get_utc_time_us;
+  neo6m.getFix          = GPS_get_fix;
+  neo6m.getDate         = GPS_get_date;
+  neo6m.latency_us      = NEO6M_LATENCY_US;
+  PPS_Init(Sched_SysTickUs);        // Each pulse is labelled by the sentence after it
   doz_clock.gps = &neo6m;
 
-  // Doz Clock
+  // Flight recorder, first so it catches the boot
+  FlightRec_Init(HAL_GetTick);
+
+  // Doz Clock, time is interpolated between RTC reads with the SysTick microseconds
   doz_clock.error_handler = Error_Handler;
+  TimeTrack_SetUsSource(Sched_SysTickUs);
   DozClock_Init(&doz_clock);
 
-  // Buttons
+  // Buttons, events are stamped with the tick they were pressed at
+  EventQ_SetTickSource(HAL_GetTick);
   Buttons_Init();
 
   // Light sensor
-  LightSens_Init(&hadc1, &htim6, 1000);
+  LightSens_Init(&hadc1, 1000);
 
-  // Start 6Hz timer
-  HAL_TIM_Base_Start_IT(&htim7);
+  // Scheduler, all periodic work runs from the main loop off the HAL tick
+  Sched_Init(HAL_GetTick, Sched_SysTickUs);
+  Sched_SetSleep(Sched_TicklessSleep);
+  DozClock_StartTasks();
+  Sched_Start(&buttons_task, 0);
+  Sched_Start(&light_task, 0);
+  Sched_Start(&defer_task, 0);
 
   /* USER CODE END 2 */
 
@@ -218,7 +375,8 @@ int main(void)
   /* USER CODE BEGIN WHILE */
   while (1)
   {
-      DozClock_Update();
+      Sched_Run();
+      Sched_Idle();
     /* USER CODE END WHILE */
 
     /* USER CODE BEGIN 3 */
@@ -281,17 +439,6 @@ void HAL_TIM_PeriodElapsedCallback(TIM_HandleTypeDef *htim)
     {
         HUB75_PwmStartPulse();
     }
-    else if (htim == &htim6)
-    {
-        // 2 Hz freq
-        LightSens_AdcStartConversion();
-    }
-    else if (htim == &htim7)
-    {
-        // 6 Hz freq
-        Buttons_TimerCallback(167);
-        DozClock_TimerCallback();
-    }
 #ifdef USE_DAC_BUZZER
     else if (htim == &htim16)
     {
@@ -300,6 +447,11 @@ void HAL_TIM_PeriodElapsedCallback(TIM_HandleTypeDef *htim)
 #endif
 }
 
+void HAL_TIM_IC_CaptureCallback(TIM_HandleTypeDef *htim)
+{
+    PPS_CaptureCallback(htim);
+}
+
 void HAL_ADC_ConvCpltCallback(ADC_HandleTypeDef* hadc)
 {
     LightSens_AdcConversionCallback();
@@ -312,19 +464,24 @@ void HAL_GPIO_EXTI_Callback(uint16_t pin)
 	{
 	    Buttons_GpioCallback(pin);
 	}
-	else
+	else if (HAL_GPIO_ReadPin(EXT_RTC_SQW_GPIO_Port, EXT_RTC_SQW_Pin) == GPIO_PIN_RESET)
 	{
-	    if (DS3231_IsAlarm1Triggered()) {
-	    	EventQ_TriggerAlarmEvent(TIMER_TRIG);
-	    } else if (DS3231_IsAlarm2Triggered()) {
-	    	EventQ_TriggerAlarmEvent(ALARM_TRIG);
-	    }
+	    // Falling edge, the DS3231's seconds have just moved on
+	    TimeTrack_SecondEdge(Sched_SysTickUs());
+	    Defer_Post(&rtc_alarm_work, 0);
 	}
 	#else
 	Buttons_GpioCallback(pin);
 	#endif
 }
 
+#ifndef USE_EXTERNAL_RTC
+void HAL_RTCEx_WakeUpTimerEventCallback(RTC_HandleTypeDef *rtc)
+{
+    TimeTrack_SecondEdge(Sched_SysTickUs());
+}
+#endif
+
 void HAL_UART_RxCpltCallback(UART_HandleTypeDef *huart)
 {
     GPS_UART_CallBack();
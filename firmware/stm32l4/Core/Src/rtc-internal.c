@@ -17,6 +17,7 @@
 
 #define CALR_CALP   (hrtc->Instance->CALR & (1<<15))
 #define CALR_CALM   (hrtc->Instance->CALR & 0x1FF)
+#define CALR_PLUS_PULSES    512
 
 static RTC_HandleTypeDef *hrtc;
 static RTC_TimeTypeDef sTime = {0};
@@ -76,6 +77,17 @@ void RTC_GetTime(uint8_t *hr, uint8_t *min, uint8_t *sec)
     *sec = sTime.Seconds;
 }
 
+// SSR counts down from PREDIV_S through the second, reading the date after releases the shadow registers
+void RTC_GetTimeMs(uint8_t *hr, uint8_t *min, uint8_t *sec, uint16_t *ms)
+{
+    HAL_RTC_GetTime(hrtc, &sTime, RTC_FORMAT);
+    HAL_RTC_GetDate(hrtc, &sDate, RTC_FORMAT);
+    *hr = sTime.Hours;
+    *min = sTime.Minutes;
+    *sec = sTime.Seconds;
+    *ms = ((sTime.SecondFraction - sTime.SubSeconds) * 1000) / (sTime.SecondFraction + 1);
+}
+
 void RTC_SetDay(uint8_t d)
 {
     if (d <= 31)
@@ -106,6 +118,22 @@ uint8_t RTC_GetMonth(void)
     return sDate.Month;
 }
 
+// Two digits from 2000, the leap years it knows are the ones up to 2099
+void RTC_SetYear(uint16_t y)
+{
+    if (y >= 2000 && y <= 2099)
+    {
+        sDate.Year = y - 2000;
+        HAL_RTC_SetDate(hrtc, &sDate, RTC_FORMAT);
+    }
+}
+
+uint16_t RTC_GetYear(void)
+{
+    HAL_RTC_GetDate(hrtc, &sDate, RTC_FORMAT);
+    return 2000 + sDate.Year;
+}
+
 void RTC_SetAlarm(uint8_t id, uint8_t hr, uint8_t min, uint8_t sec)
 {
     if (hr < 24 && min < 60 && sec < 60)
@@ -184,30 +212,31 @@ void RTC_EnableAlarm(uint8_t id, bool enable)
     }
 }
 
+// Each step masks one more or one fewer of the 2^20 pulses in the 32 s cycle. Going
+// negative adds the 512 plus pulses and masks fewer of them, so the steps stay even.
 bool RTC_SetCalibration(int32_t calib)
 {
     uint32_t plus_pulse = RTC_SMOOTHCALIB_PLUSPULSES_RESET;
-    if (calib < 0)
+    if (calib > MAX_CALIBRATION_OFFSET || calib < -MAX_CALIBRATION_OFFSET)
     {
-        plus_pulse = RTC_SMOOTHCALIB_PLUSPULSES_SET;
-        calib *= -1;
+        return 0;
     }
-    if (calib < MAX_CALIBRATION_OFFSET)
+    if (calib < 0)
     {
-        HAL_RTCEx_SetSmoothCalib(hrtc, RTC_SMOOTHCALIB_PERIOD_32SEC, plus_pulse, (uint32_t)calib);
-        return 1;
+        plus_pulse = RTC_SMOOTHCALIB_PLUSPULSES_SET;
+        calib += CALR_PLUS_PULSES;
     }
-    return 0;
+    HAL_RTCEx_SetSmoothCalib(hrtc, RTC_SMOOTHCALIB_PERIOD_32SEC, plus_pulse, (uint32_t)calib);
+    return 1;
 }
 
 int32_t RTC_GetCalibration(void)
 {
-    int32_t calib = 1;
     if (CALR_CALP)
     {
-        calib = -1;
+        return (int32_t)CALR_CALM - CALR_PLUS_PULSES;
     }
-    return calib * CALR_CALM;
+    return CALR_CALM;
 }
 
 bool RTC_CheckDataSaved(RTC_HandleTypeDef *rtc)
@@ -234,6 +263,20 @@ bool RTC_CheckAlarmSaved(uint8_t id)
 }
 
 
+// 1 Hz interrupt off the ck_spre that moves the seconds on, the board's
+// HAL_RTCEx_WakeUpTimerEventCallback passes it to TimeTrack_SecondEdge
+void RTC_EnableSecondEdge(bool enable)
+{
+    if (enable)
+    {
+        HAL_RTCEx_SetWakeUpTimer_IT(hrtc, 0, RTC_WAKEUPCLOCK_CK_SPRE_16BITS);
+    }
+    else
+    {
+        HAL_RTCEx_DeactivateWakeUpTimer(hrtc);
+    }
+}
+
 void HAL_RTC_AlarmAEventCallback(RTC_HandleTypeDef *rtc)
 {
     if (rtc == hrtc)
@@ -47,8 +47,8 @@ void MX_RTC_Init(void)
   */
   hrtc.Instance = RTC;
   hrtc.Init.HourFormat = RTC_HOURFORMAT_24;
-  hrtc.Init.AsynchPrediv = 127;
-  hrtc.Init.SynchPrediv = 255;
+  hrtc.Init.AsynchPrediv = 31;
+  hrtc.Init.SynchPrediv = 1023;
   hrtc.Init.OutPut = RTC_OUTPUT_DISABLE;
   hrtc.Init.OutPutRemap = RTC_OUTPUT_REMAP_NONE;
   hrtc.Init.OutPutPolarity = RTC_OUTPUT_POLARITY_HIGH;
@@ -143,7 +143,8 @@ void HAL_RTC_MspInit(RTC_HandleTypeDef* rtcHandle)
     HAL_NVIC_SetPriority(RTC_Alarm_IRQn, 2, 0);
     HAL_NVIC_EnableIRQ(RTC_Alarm_IRQn);
   /* USER CODE BEGIN RTC_MspInit 1 */
-
+    HAL_NVIC_SetPriority(RTC_WKUP_IRQn, 2, 0);
+    HAL_NVIC_EnableIRQ(RTC_WKUP_IRQn);
   /* USER CODE END RTC_MspInit 1 */
   }
 }
@@ -162,7 +163,7 @@ void HAL_RTC_MspDeInit(RTC_HandleTypeDef* rtcHandle)
     /* RTC interrupt Deinit */
     HAL_NVIC_DisableIRQ(RTC_Alarm_IRQn);
   /* USER CODE BEGIN RTC_MspDeInit 1 */
-
+    HAL_NVIC_DisableIRQ(RTC_WKUP_IRQn);
   /* USER CODE END RTC_MspDeInit 1 */
   }
 }
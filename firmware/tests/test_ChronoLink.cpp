@@ -0,0 +1,262 @@
+extern "C"
+{
+#include <string.h>
+
+#include "chrono_link.h"
+#include "clock_types.h"
+}
+#include "CppUTest/TestHarness.h"
+#include "CppUTestExt/MockSupport.h"
+
+static ChronoLink testLink;
+
+// Loopback line, bytes sent by the link are fed back into it
+static uint8_t line[64][CHRONO_MAX_FRAME];
+static uint16_t line_len[64];
+static uint8_t line_head, line_tail;
+static int drop_next_frames;
+static uint8_t credit_adv;
+
+/*
+    Mock Functions
+*/
+static void transmit(uint8_t *buf, uint16_t len)
+{
+    if (drop_next_frames > 0)
+    {
+        drop_next_frames--;
+        return;
+    }
+    memcpy(line[line_tail % 64], buf, len);
+    line_len[line_tail % 64] = len;
+    line_tail++;
+}
+
+static void deliver(uint8_t code, uint8_t *payload, uint8_t len)
+{
+    mock().actualCall("deliver").withParameter("code", code).withParameter("first", len ? payload[0] : 0);
+}
+
+static uint8_t getCredit(void)
+{
+    return credit_adv;
+}
+
+// Feed everything on the line back into the link, including the ACKs this produces
+static void flushLine(void)
+{
+    while (line_head != line_tail)
+    {
+        uint8_t idx = line_head % 64;
+        line_head++;
+        for (int i = 0; i < line_len[idx]; i++)
+        {
+            ChronoLink_ReceiveByte(line[idx][i]);
+        }
+    }
+}
+
+/*
+    Test Groups
+*/
+
+TEST_GROUP(ChronoLinkModule)
+{
+    void setup()
+    {
+        testLink.rto_ms = 100;
+        testLink.transmit = transmit;
+        testLink.deliver = deliver;
+        testLink.getCredit = getCredit;
+        line_head = line_tail = 0;
+        drop_next_frames = 0;
+        credit_adv = CHRONO_WINDOW;
+        ChronoLink_Init(&testLink);
+    }
+
+    void teardown()
+    {
+        mock().clear();
+    }
+};
+
+/*
+    Unit Tests
+*/
+
+TEST(ChronoLinkModule, U51_FrameDeliveredAndAcked)
+{
+    // Setup mock function calls
+    mock().expectOneCall("deliver").withParameter("code", BITMAP_CODE).withParameter("first", START_CODE);
+
+    // Production code
+    uint8_t payload[3] = {START_CODE, END_CODE, ESCAPE_CODE};   // Must survive escaping
+    ChronoLinkStats stats;
+    ChronoLink_Submit(0, BITMAP_CODE, payload, sizeof(payload), 0);
+    flushLine();
+    ChronoLink_GetStats(&stats);
+
+    // Checks
+    mock().checkExpectations();
+    CHECK_EQUAL(1, stats.sent);
+    CHECK_EQUAL(1, stats.acked);
+    CHECK_EQUAL(1, stats.received);
+    CHECK_EQUAL(0, ChronoLink_InFlight());
+}
+
+TEST(ChronoLinkModule, U52_LostFrameRetransmitted)
+{
+    // Setup mock function calls
+    mock().expectOneCall("deliver").withParameter("code", COLOUR_CODE).withParameter("first", 1);
+
+    // Production code
+    uint8_t colour = 1;
+    ChronoLinkStats stats;
+    drop_next_frames = 1;
+    ChronoLink_Submit(0, COLOUR_CODE, &colour, 1, 0);
+    flushLine();
+    ChronoLink_Poll(50);        // Not timed out yet
+    flushLine();
+    ChronoLink_Poll(100);       // Timed out, latest state resent
+    flushLine();
+    ChronoLink_GetStats(&stats);
+
+    // Checks
+    mock().checkExpectations();
+    CHECK_EQUAL(1, stats.retransmitted);
+    CHECK_EQUAL(1, stats.acked);
+    CHECK_EQUAL(0, ChronoLink_InFlight());
+}
+
+TEST(ChronoLinkModule, U53_SupersededFrameNotResent)
+{
+    // Setup mock function calls
+    mock().expectOneCall("deliver").withParameter("code", COLOUR_CODE).withParameter("first", 2);
+    mock().expectOneCall("deliver").withParameter("code", STATUS_CODE).withParameter("first", 3);
+
+    // Production code
+    uint8_t old_colour = 1, new_colour = 2, status = 3;
+    ChronoLinkStats stats;
+    drop_next_frames = 1;
+    ChronoLink_Submit(0, COLOUR_CODE, &old_colour, 1, 0);    // Lost
+    ChronoLink_Submit(0, COLOUR_CODE, &new_colour, 1, 10);   // Replaces it
+    ChronoLink_Submit(1, STATUS_CODE, &status, 1, 10);
+    flushLine();
+    ChronoLink_Poll(200);
+    flushLine();
+    ChronoLink_GetStats(&stats);
+
+    // Checks
+    mock().checkExpectations();
+    CHECK_EQUAL(1, stats.dropped);
+    CHECK_EQUAL(0, stats.retransmitted);
+    CHECK_EQUAL(2, stats.acked);
+    CHECK_EQUAL(0, ChronoLink_InFlight());
+}
+
+TEST(ChronoLinkModule, U54_NoCreditHoldsFrames)
+{
+    // Setup mock function calls
+    mock().expectOneCall("deliver").withParameter("code", BRIGHTNESS_CODE).withParameter("first", 1);
+    mock().expectOneCall("deliver").withParameter("code", BRIGHTNESS_CODE).withParameter("first", 2);
+
+    // Production code
+    uint8_t level1 = 1, level2 = 2, level3 = 3;
+    credit_adv = 0;
+    ChronoLink_Submit(0, BRIGHTNESS_CODE, &level1, 1, 0);
+    flushLine();                                            // ACK grants no credit
+    ChronoLink_Submit(1, BRIGHTNESS_CODE, &level2, 1, 10);  // Held back
+    uint8_t held = line_tail - line_head;
+    credit_adv = CHRONO_WINDOW;
+    ChronoLink_Poll(200);                                   // Credit probe after timeout
+    flushLine();
+    ChronoLink_Submit(2, BRIGHTNESS_CODE, &level3, 1, 210);
+    uint8_t sent = line_tail - line_head;
+
+    // Checks
+    mock().checkExpectations();
+    CHECK_EQUAL(0, held);
+    CHECK_EQUAL(1, sent);
+}
+
+TEST(ChronoLinkModule, U55_CorruptFrameRejected)
+{
+    // Production code
+    uint8_t payload = 7;
+    ChronoLinkStats stats;
+    ChronoLink_Submit(0, ON_CODE, &payload, 1, 0);
+    line[0][3] ^= 0x01;         // Flip a bit in the payload
+    flushLine();
+    ChronoLink_GetStats(&stats);
+
+    // Checks
+    mock().checkExpectations();
+    CHECK_EQUAL(0, stats.received);
+    CHECK_EQUAL(1, stats.rejected);
+    CHECK_EQUAL(1, ChronoLink_InFlight());
+}
+
+TEST(ChronoLinkModule, U56_RepeatedStateNotResent)
+{
+    // Setup mock function calls
+    mock().expectOneCall("deliver").withParameter("code", BITMAP_CODE).withParameter("first", 5);
+    mock().expectOneCall("deliver").withParameter("code", BITMAP_CODE).withParameter("first", 5);
+
+    // Production code
+    uint8_t bitmap[2] = {5, 6};
+    ChronoLinkStats stats;
+    ChronoLink_Submit(0, BITMAP_CODE, bitmap, sizeof(bitmap), 0);
+    ChronoLink_Submit(0, BITMAP_CODE, bitmap, sizeof(bitmap), 10);  // In flight, kept
+    flushLine();
+    ChronoLink_Submit(0, BITMAP_CODE, bitmap, sizeof(bitmap), 20);  // Already shown
+    uint8_t repeated = line_tail - line_head;
+    ChronoLink_Supersede(0);
+    ChronoLink_Submit(0, BITMAP_CODE, bitmap, sizeof(bitmap), 30);  // Replaced on the display, sent again
+    flushLine();
+    ChronoLink_GetStats(&stats);
+
+    // Checks
+    mock().checkExpectations();
+    CHECK_EQUAL(0, repeated);
+    CHECK_EQUAL(2, stats.sent);
+    CHECK_EQUAL(0, stats.dropped);
+}
+
+TEST(ChronoLinkModule, U57_ReceiverResetMidSequence)
+{
+    // Setup mock function calls, the frame after the silent reset, then both held states again
+    mock().expectOneCall("deliver").withParameter("code", COLOUR_CODE).withParameter("first", 40);
+    mock().expectOneCall("deliver").withParameter("code", COLOUR_CODE).withParameter("first", 40);
+    mock().expectOneCall("deliver").withParameter("code", STATUS_CODE).withParameter("first", 9);
+
+    // Production code, 40 frames through so the sequence is well past a receive window
+    uint8_t colour, status = 9;
+    ChronoLinkStats stats;
+    testLink.deliver = NULL;
+    ChronoLink_Submit(1, STATUS_CODE, &status, 1, 0);
+    flushLine();
+    for (colour = 1; colour < 40; colour++)
+    {
+        ChronoLink_Submit(0, COLOUR_CODE, &colour, 1, colour);
+        flushLine();
+    }
+    testLink.deliver = deliver;
+    drop_next_frames = 1;
+    ChronoLink_Reset();                                     // Watchdog reset, RESET_CODE lost
+    ChronoLink_Submit(0, COLOUR_CODE, &colour, 1, 100);
+    flushLine();
+    uint8_t in_flight_after_resync = ChronoLink_InFlight();
+    ChronoLink_Reset();                                     // Handshake gets through
+    flushLine();
+    ChronoLink_Poll(200);
+    flushLine();
+    ChronoLink_GetStats(&stats);
+
+    // Checks
+    mock().checkExpectations();
+    CHECK_EQUAL(0, in_flight_after_resync);
+    CHECK_EQUAL(1, stats.resyncs);
+    CHECK_EQUAL(1, stats.resets);
+    CHECK_EQUAL(0, stats.duplicates);
+    CHECK_EQUAL(0, ChronoLink_InFlight());
+}
@@ -0,0 +1,90 @@
+extern "C"
+{
+#include "clock_epoch.h"
+#include "clock_types.h"
+}
+#include "CppUTest/TestHarness.h"
+
+/*
+    Test Groups
+*/
+
+TEST_GROUP(ClockEpoch)
+{
+    void setup()
+    {
+    }
+
+    void teardown()
+    {
+    }
+};
+
+/*
+    Unit Tests
+*/
+
+TEST(ClockEpoch, U141_DatesRoundTrip)
+{
+    // Production code, every day the RTCs can hold plus a few known ones
+    ClockDate Date, Leap = { 2024, 2, 29 }, Last = { 2099, 12, 31 };
+    bool Round_trip = true;
+    for (uint32_t day = 0; day <= 36524; day++)
+    {
+        Epoch_ToDate(day * EPOCH_DAY_MS + 12345, &Date);
+        Round_trip = Round_trip && Epoch_CheckDate(&Date) == CLOCK_OK
+            && Epoch_FromDate(&Date, 12345) == day * EPOCH_DAY_MS + 12345;
+    }
+    Epoch_ToDate(60 * EPOCH_DAY_MS, &Date);
+
+    // Checks
+    CHECK(Round_trip);
+    CHECK_EQUAL(8825 * EPOCH_DAY_MS + 3600000, Epoch_FromDate(&Leap, 3600000));
+    CHECK_EQUAL(36524 * EPOCH_DAY_MS, Epoch_FromDate(&Last, 0));
+    CHECK_EQUAL(2000, Date.year);
+    CHECK_EQUAL(3, Date.month);
+    CHECK_EQUAL(1, Date.day);
+}
+
+TEST(ClockEpoch, U142_NearestTimeOfDayCrossesMidnight)
+{
+    // Production code, a time of day read from the RTC placed next to the time kept
+    EpochMs Day_ms = 100 * EPOCH_DAY_MS;
+
+    // Checks
+    CHECK_EQUAL(Day_ms + 1000, Epoch_Nearest(Day_ms - 2000, 1000));
+    CHECK_EQUAL(Day_ms - 1000, Epoch_Nearest(Day_ms + 2000, EPOCH_DAY_MS - 1000));
+    CHECK_EQUAL(Day_ms + 43000000, Epoch_Nearest(Day_ms + 1000, 43000000));
+    CHECK_EQUAL(EPOCH_DAY_MS - 1000, Epoch_TimeOfDay(Day_ms - 1000));
+    CHECK_EQUAL(EPOCH_DAY_MS - 1000, Epoch_Nearest(0, EPOCH_DAY_MS - 1000));
+}
+
+TEST(ClockEpoch, U143_RejectsDatesTheRtcCannotHold)
+{
+    // Production code
+    ClockDate Feb29 = { 2023, 2, 29 }, Leap = { 2000, 2, 29 }, Century = { 2100, 1, 1 };
+    ClockDate Reset = { 2000, 0, 0 }, Apr31 = { 2030, 4, 31 };
+
+    // Checks
+    CHECK_EQUAL(CLOCK_FAIL, Epoch_CheckDate(&Feb29));
+    CHECK_EQUAL(CLOCK_OK, Epoch_CheckDate(&Leap));
+    CHECK_EQUAL(CLOCK_FAIL, Epoch_CheckDate(&Century));
+    CHECK_EQUAL(CLOCK_FAIL, Epoch_CheckDate(&Reset));
+    CHECK_EQUAL(CLOCK_FAIL, Epoch_CheckDate(&Apr31));
+}
+
+TEST(ClockEpoch, U144_HoursMinutesSecondsRoundTrip)
+{
+    uint8_t Hr, Min, Sec;
+
+    // Production code and checks, every second of the day comes back unchanged
+    for (uint32_t Ms = 0; Ms < EPOCH_DAY_MS; Ms += 7000)
+    {
+        Epoch_MsToHms(Ms + 999, &Hr, &Min, &Sec);
+        CHECK_EQUAL(Ms, Epoch_HmsToMs(Hr, Min, Sec));
+    }
+    Epoch_MsToHms(EPOCH_DAY_MS + 61000, &Hr, &Min, &Sec);
+    CHECK_EQUAL(0, Hr);
+    CHECK_EQUAL(1, Min);
+    CHECK_EQUAL(1, Sec);
+}
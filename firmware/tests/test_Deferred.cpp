@@ -0,0 +1,130 @@
+extern "C"
+{
+#include "deferred.h"
+#include "clock_types.h"
+}
+#include "CppUTest/TestHarness.h"
+#include "CppUTestExt/MockSupport.h"
+
+/*
+    Mock Functions
+*/
+static uint32_t defer_us;
+static DeferWork AlarmWork, GpsWork, SpareWork[DEFER_BATCH + 1];
+
+static uint32_t DeferTest_GetUs(void)
+{
+    return defer_us;
+}
+
+static void DeferTest_Alarm(uint32_t arg)
+{
+    mock().actualCall("DeferTest_Alarm").withParameter("arg", arg);
+}
+
+static void DeferTest_Gps(uint32_t arg)
+{
+    mock().actualCall("DeferTest_Gps").withParameter("arg", arg);
+    defer_us += 400;    // Parsing takes a while
+}
+
+static void DeferTest_Spare(uint32_t arg)
+{
+    mock().actualCall("DeferTest_Spare").withParameter("arg", arg);
+}
+
+/*
+    Test Groups
+*/
+
+TEST_GROUP(DeferredModule)
+{
+    void setup()
+    {
+        defer_us = 1000;
+        Defer_Init(DeferTest_GetUs);
+        AlarmWork.run = DeferTest_Alarm;
+        GpsWork.run = DeferTest_Gps;
+        Defer_Register(&AlarmWork);
+        Defer_Register(&GpsWork);
+    }
+
+    void teardown()
+    {
+        Defer_Init(NULL);
+        mock().clear();
+    }
+};
+
+/*
+    Unit Tests
+*/
+
+TEST(DeferredModule, U91_PostedWorkRunsLaterWithLatency)
+{
+    // Expectations
+    mock().expectOneCall("DeferTest_Alarm").withParameter("arg", 1);
+    mock().expectOneCall("DeferTest_Gps").withParameter("arg", 42);
+
+    // Production code, both posted from interrupts then the main loop gets to them
+    Defer_Post(&GpsWork, 42);
+    defer_us += 50;
+    Defer_Post(&AlarmWork, 1);
+    bool Pending = Defer_Pending();
+    defer_us += 200;
+    Defer_Run();
+
+    // Checks, the alarm waited for the GPS parse since it has the higher id
+    mock().checkExpectations();
+    CHECK_TRUE(Pending);
+    CHECK_FALSE(Defer_Pending());
+    CHECK_EQUAL(250, GpsWork.max_latency_us);
+    CHECK_EQUAL(200, AlarmWork.max_latency_us);
+    CHECK_EQUAL(1, AlarmWork.runs);
+}
+
+TEST(DeferredModule, U92_RepostMergesIntoOneRun)
+{
+    // Expectations, the newest arg wins
+    mock().expectOneCall("DeferTest_Gps").withParameter("arg", 3);
+
+    // Production code
+    Defer_Post(&GpsWork, 1);
+    defer_us += 100;
+    Defer_Post(&GpsWork, 2);
+    Defer_Post(&GpsWork, 3);
+    Defer_Run();
+    Defer_Run();
+
+    // Checks, latency counts from the first post
+    mock().checkExpectations();
+    CHECK_EQUAL(1, GpsWork.runs);
+    CHECK_EQUAL(2, GpsWork.merged);
+    CHECK_EQUAL(100, GpsWork.max_latency_us);
+}
+
+TEST(DeferredModule, U93_RunIsBoundedPerPass)
+{
+    // Expectations
+    mock().expectNCalls(DEFER_BATCH + 1, "DeferTest_Spare").ignoreOtherParameters();
+
+    // Production code, one more item posted than a pass runs
+    DeferWork Unregistered = {};
+    Unregistered.run = DeferTest_Spare;
+    for (int i = 0; i < DEFER_BATCH + 1; i++) {
+        SpareWork[i].run = DeferTest_Spare;
+        Defer_Register(&SpareWork[i]);
+        Defer_Post(&SpareWork[i], i);
+    }
+    Defer_Run();
+    bool PendingAfterFirst = Defer_Pending();
+    Defer_Run();
+
+    // Checks
+    mock().checkExpectations();
+    CHECK_TRUE(PendingAfterFirst);
+    CHECK_FALSE(Defer_Pending());
+    CHECK_EQUAL(1, SpareWork[DEFER_BATCH].runs);
+    Unregistered.id = 0;
+    CHECK_EQUAL(CLOCK_FAIL, Defer_Post(&Unregistered, 0));
+}
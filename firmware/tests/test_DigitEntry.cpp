@@ -0,0 +1,153 @@
+extern "C"
+{
+#include <string.h>
+
+#include "digit_entry.h"
+#include "time_format.h"
+}
+#include "CppUTest/TestHarness.h"
+#include "CppUTestExt/MockSupport.h"
+
+/*
+    Mock Functions
+*/
+static uint8_t vals[ENTRY_MAX_DIGITS];
+
+static void DigitTest_Set(const uint8_t *digits)
+{
+    memcpy(vals, digits, sizeof(vals));
+}
+
+// Five dozenal digits, most significant first
+static void DigitTest_Split(uint32_t inc)
+{
+    for (int i = 4; i >= 0; i--)
+    {
+        vals[i] = inc % 12;
+        inc /= 12;
+    }
+}
+
+/*
+    Test Groups
+*/
+
+TEST_GROUP(DigitEntryModule)
+{
+    void setup()
+    {
+        memset(vals, 0, sizeof(vals));
+    }
+
+    void teardown()
+    {
+        mock().clear();
+    }
+};
+
+/*
+    Unit Tests
+*/
+
+TEST(DigitEntryModule, U101_DigitsWrapInTheirOwnRadix)
+{
+    // Production code, seconds tens wraps at 6 without touching the minutes
+    const uint8_t Start[ENTRY_MAX_DIGITS] = {0, 9, 5, 9, 5, 9};
+    DigitTest_Set(Start);
+    DigitEntry_Step(DigitEntry_Format(TRAD_24H), vals, 4, true);
+    uint8_t SecTens = vals[4];
+    uint8_t MinUnits = vals[3];
+    DigitEntry_Step(DigitEntry_Format(DOZ_SEMI), vals, 0, false);
+    uint8_t SemiFirst = vals[0];
+    DigitEntry_Step(DigitEntry_Format(DOZ_DRN4), vals, 4, true);   // Past the last position, ignored
+
+    // Checks
+    CHECK_EQUAL(0, SecTens);
+    CHECK_EQUAL(9, MinUnits);
+    CHECK_EQUAL(1, SemiFirst);
+    CHECK_EQUAL(0, vals[4]);
+    CHECK_EQUAL(4, DigitEntry_Format(DOZ_DRN4)->num_digits);
+    CHECK_EQUAL(7, DigitEntry_Format(TRAD_12H)->num_digits);
+}
+
+TEST(DigitEntryModule, U102_HoursCouplingAndMeridiem)
+{
+    // Production code, 19h then the tens goes to 2 and pulls the units back
+    const uint8_t Late[ENTRY_MAX_DIGITS] = {1, 9, 0, 0, 0, 0};
+    DigitTest_Set(Late);
+    DigitEntry_Step(DigitEntry_Format(TRAD_24H), vals, 0, true);
+    uint8_t Tens24 = vals[0];
+    uint8_t Units24 = vals[1];
+    DigitEntry_Step(DigitEntry_Format(TRAD_24H), vals, 1, false);
+    uint8_t Wrapped24 = vals[1];
+
+    // 11 AM up to 12 reads PM, down to 00 through 10 and 00 reads AM
+    const uint8_t Morning[ENTRY_MAX_DIGITS] = {1, 1, 0, 0, 0, 0, 0};
+    DigitTest_Set(Morning);
+    DigitEntry_Step(DigitEntry_Format(TRAD_12H), vals, 1, true);
+    uint8_t Noon = vals[6];
+    DigitEntry_Step(DigitEntry_Format(TRAD_12H), vals, 6, true);   // 12 stays on PM
+    uint8_t StillPm = vals[6];
+    DigitEntry_Step(DigitEntry_Format(TRAD_12H), vals, 0, false);
+    uint8_t Units12 = vals[1];
+    DigitEntry_Step(DigitEntry_Format(TRAD_12H), vals, 1, false);
+    DigitEntry_Step(DigitEntry_Format(TRAD_12H), vals, 1, false);
+    uint8_t Midnight = vals[6];
+
+    // Checks
+    CHECK_EQUAL(2, Tens24);
+    CHECK_EQUAL(0, Units24);
+    CHECK_EQUAL(3, Wrapped24);
+    CHECK_EQUAL(1, Noon);
+    CHECK_EQUAL(1, StillPm);
+    CHECK_EQUAL(2, Units12);
+    CHECK_EQUAL(0, vals[1]);
+    CHECK_EQUAL(0, Midnight);
+}
+
+TEST(DigitEntryModule, U103_ComposedValueRoundTrips)
+{
+    uint8_t d[5];
+    uint32_t Ms;
+
+    // Production code and checks, every diurnal and semi-diurnal digit set comes back unchanged
+    for (uint32_t inc = 0; inc < 248832; inc += 7)
+    {
+        DigitTest_Split(inc);
+        Ms = DigitEntry_ToMs(DigitEntry_Format(DOZ_DRN5), vals);
+        msToDiurn(Ms, &d[0], &d[1], &d[2], &d[3], &d[4]);
+        CHECK_EQUAL(inc, d[0] * 20736 + d[1] * 1728 + d[2] * 144 + d[3] * 12 + d[4]);
+    }
+    for (uint32_t inc = 0; inc < 41472; inc += 5)
+    {
+        DigitTest_Split(inc);
+        Ms = DigitEntry_ToMs(DigitEntry_Format(DOZ_SEMI), vals);
+        msToSemiDiurn(Ms, &d[0], &d[1], &d[2], &d[3], &d[4]);
+        CHECK_EQUAL(inc, d[0] * 20736 + d[1] * 1728 + d[2] * 144 + d[3] * 12 + d[4]);
+    }
+
+    // 12 PM is noon, 1 PM is 13h, DRN4 ignores the fifth digit
+    const uint8_t Noon[ENTRY_MAX_DIGITS] = {1, 2, 3, 0, 1, 5, 1};
+    const uint8_t OnePm[ENTRY_MAX_DIGITS] = {0, 1, 0, 0, 0, 0, 1};
+    const uint8_t Half[ENTRY_MAX_DIGITS] = {6, 0, 0, 0, 11};
+    CHECK_EQUAL(12 * 3600000 + 30 * 60000 + 15000, DigitEntry_ToMs(DigitEntry_Format(TRAD_12H), Noon));
+    CHECK_EQUAL(13 * 3600000, DigitEntry_ToMs(DigitEntry_Format(TRAD_12H), OnePm));
+    CHECK_EQUAL(43200000, DigitEntry_ToMs(DigitEntry_Format(DOZ_DRN4), Half));
+    CHECK_EQUAL(43200000 + 3819, DigitEntry_ToMs(DigitEntry_Format(DOZ_DRN5), Half));
+}
+
+TEST(DigitEntryModule, U104_TimerHoursRunPastADay)
+{
+    // Production code, 19h then the tens goes to 2 and the units stay put
+    const uint8_t Late[ENTRY_MAX_DIGITS] = {1, 9, 0, 0, 0, 0};
+    DigitTest_Set(Late);
+    DigitEntry_Step(DigitEntry_TimerFormat(TRAD_24H), vals, 0, true);
+    uint8_t Units = vals[1];
+    const uint8_t Longest[ENTRY_MAX_DIGITS] = {9, 9, 5, 9, 5, 9};
+
+    // Checks
+    CHECK_EQUAL(9, Units);
+    CHECK_EQUAL(29 * 3600000, DigitEntry_ToMs(DigitEntry_TimerFormat(TRAD_24H), vals));
+    CHECK_EQUAL(359999000, DigitEntry_ToMs(DigitEntry_TimerFormat(TRAD_24H), Longest));
+    CHECK(DigitEntry_Format(DOZ_DRN5) == DigitEntry_TimerFormat(DOZ_DRN5));
+}
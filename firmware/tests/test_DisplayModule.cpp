@@ -10,7 +10,7 @@ extern "C"
 #include "CppUTestExt/MockSupport.h"
 
 Display testDisplay;
-ExternVars testExternVars;
+SnapshotPub testSnapshot;
 uint8_t * mockBitmap;
 
 /*
@@ -97,7 +97,7 @@ TEST(DisplayModule, U31_TimeFormatChangingStates)
 
     // Production code
     TimeFormats Format1, Format2, Format3;
-    Display_Init(&testDisplay, &testExternVars);
+    Display_Init(&testDisplay, &testSnapshot);
     Display_On();
 
     Display_SetFormat(DOZ_DRN4);
@@ -131,7 +131,7 @@ TEST(DisplayModule, U31_TimeFormatChangingStates)
 //     mock().expectNCalls(4,"hide").ignoreOtherParameters();
 
 //     // Production code
-//     Display_Init(&testDisplay, &testExternVars);
+//     Display_Init(&testDisplay, &testSnapshot);
 //     Display_On();
 //     Display_ToggleMode();
 //     Display_ToggleMode();
@@ -233,3 +233,32 @@ TEST(DisplayModule, U38_TradConversionInvalidInput)
     CHECK(min < 60);
     CHECK(sec < 60);
 }
+
+TEST(DisplayModule, U39_RequestsIgnoredOutsideTheirStates)
+{
+    // Setup mock function calls
+
+    // Display Init
+    mock().expectNCalls(1,"setBrightness").ignoreOtherParameters();
+    mock().expectNCalls(3,"setColour").ignoreOtherParameters();
+    mock().expectNCalls(3,"setBitmap").ignoreOtherParameters();
+    mock().expectNCalls(1,"displayOff");
+    // Display Init
+
+    mock().expectNCalls(1,"displayOn");
+    mock().expectNCalls(6,"show").ignoreOtherParameters();  // ShowTime123 then SetTime
+
+    // Production code
+    Display_Init(&testDisplay, &testSnapshot);
+    Display_SetTime();          // Off, ignored
+    Display_ShowTime();         // Off, ignored
+    Display_On();
+    Display_On();               // Already on, ignored
+    Display_ShowTime();         // Not setting anything, ignored
+    Display_SetTime();
+    Display_SetAlarm();         // Already setting the time, ignored
+    Display_Off();              // Only from ShowTime, ignored
+
+    // Checks
+    mock().checkExpectations();
+}
@@ -0,0 +1,173 @@
+extern "C"
+{
+#include <string.h>
+
+#include "display_mux.h"
+#include "clock_types.h"
+}
+#include "CppUTest/TestHarness.h"
+#include "CppUTestExt/MockSupport.h"
+
+static DisplayMux testMux;
+static Display fastSink, slowSink;
+static uint32_t mux_tick;
+
+/*
+    Mock Functions
+*/
+static uint32_t muxGetTick(void)
+{
+    return mux_tick;
+}
+
+static void fastSetBitmap(uint8_t region_id, uint8_t *bitmap)
+{
+    mock().actualCall("fastSetBitmap").withParameter("region_id", region_id).withParameter("first", bitmap[0]);
+}
+
+static void slowSetBitmap(uint8_t region_id, uint8_t *bitmap)
+{
+    mock().actualCall("slowSetBitmap").withParameter("region_id", region_id).withParameter("first", bitmap[0]);
+}
+
+static void slowSetState(DisplayStateMsg *state)
+{
+    mock().actualCall("slowSetState").withParameter("time_ms", state->time_ms);
+}
+
+static void sinkSetColour(uint8_t region_id, Colour colour_id)
+{
+    mock().actualCall("setColour").withParameter("region_id", region_id).withParameter("colour_id", colour_id);
+}
+
+static void sinkSetBrightness(uint8_t brightness)
+{
+    UNUSED(brightness);
+}
+
+static void sinkDisplayOn(void)
+{
+}
+
+static void sinkDisplayOff(void)
+{
+}
+
+static void sinkShow(uint8_t region_id)
+{
+    UNUSED(region_id);
+}
+
+static void sinkHide(uint8_t region_id)
+{
+    UNUSED(region_id);
+}
+
+/*
+    Test Groups
+*/
+
+TEST_GROUP(DisplayMuxModule)
+{
+    void setup()
+    {
+        fastSink.displayOff = sinkDisplayOff;
+        fastSink.displayOn = sinkDisplayOn;
+        fastSink.setBrightness = sinkSetBrightness;
+        fastSink.setBitmap = fastSetBitmap;
+        fastSink.setColour = sinkSetColour;
+        fastSink.show = sinkShow;
+        fastSink.hide = sinkHide;
+        fastSink.setState = NULL;
+        slowSink = fastSink;
+        slowSink.setBitmap = slowSetBitmap;
+        mux_tick = 0;
+        testMux.getTick = muxGetTick;
+        DisplayMux_Init(&testMux);
+    }
+
+    void teardown()
+    {
+        mock().clear();
+    }
+};
+
+/*
+    Unit Tests
+*/
+
+TEST(DisplayMuxModule, U61_UncappedSinkWrittenThrough)
+{
+    // Setup mock function calls
+    mock().expectOneCall("fastSetBitmap").withParameter("region_id", ROW_1).withParameter("first", 1);
+    mock().expectOneCall("fastSetBitmap").withParameter("region_id", ROW_1).withParameter("first", 2);
+
+    // Production code
+    uint8_t bitmap[LARGE_BITMAP_SIZE] = {1};
+    DisplaySinkStats stats;
+    DisplayMux_AddSink(&fastSink, 0, NULL);
+    testMux.display.setBitmap(ROW_1, bitmap);
+    testMux.display.setBitmap(ROW_1, bitmap);   // Unchanged
+    bitmap[0] = 2;
+    testMux.display.setBitmap(ROW_1, bitmap);
+    DisplayMux_GetStats(0, &stats);
+
+    // Checks
+    mock().checkExpectations();
+    CHECK_EQUAL(2, stats.delivered);
+    CHECK_EQUAL(1, stats.dropped);
+    CHECK_EQUAL(0, stats.coalesced);
+}
+
+TEST(DisplayMuxModule, U62_CappedSinkGetsLatestWhenDue)
+{
+    // Setup mock function calls
+    mock().expectNCalls(3, "fastSetBitmap").ignoreOtherParameters();
+    mock().expectOneCall("setColour").withParameter("region_id", ROW_2).withParameter("colour_id", CYAN);
+    mock().expectOneCall("slowSetBitmap").withParameter("region_id", ROW_2).withParameter("first", 3);
+    mock().expectOneCall("setColour").withParameter("region_id", ROW_2).withParameter("colour_id", CYAN);
+
+    // Production code
+    uint8_t bitmap[LARGE_BITMAP_SIZE] = {1};
+    uint8_t slow_id;
+    DisplaySinkStats stats;
+    DisplayMux_AddSink(&fastSink, 0, NULL);
+    DisplayMux_AddSink(&slowSink, 100, &slow_id);
+    testMux.display.setColour(ROW_2, CYAN);
+    for (uint8_t i = 1; i <= 3; i++)
+    {
+        bitmap[0] = i;
+        testMux.display.setBitmap(ROW_2, bitmap);
+        mux_tick += 30;
+        DisplayMux_Update();        // Slow sink not due until 100 ms
+    }
+    mux_tick = 100;
+    DisplayMux_Update();
+    DisplayMux_GetStats(slow_id, &stats);
+
+    // Checks
+    mock().checkExpectations();
+    CHECK_EQUAL(2, stats.delivered);
+    CHECK_EQUAL(2, stats.coalesced);
+}
+
+TEST(DisplayMuxModule, U63_StateOnlyWhenEverySinkTakesIt)
+{
+    // Setup mock function calls
+    mock().expectOneCall("slowSetState").withParameter("time_ms", 1000);
+
+    // Production code
+    DisplayStateMsg state = {};
+    slowSink.setState = slowSetState;
+    DisplayMux_AddSink(&slowSink, 0, NULL);
+    bool state_alone = testMux.display.setState != NULL;
+    state.time_ms = 1000;
+    testMux.display.setState(&state);
+    DisplayMux_AddSink(&fastSink, 0, NULL);     // Needs bitmaps
+    bool state_mixed = testMux.display.setState != NULL;
+
+    // Checks
+    mock().checkExpectations();
+    CHECK_TRUE(state_alone);
+    CHECK_FALSE(state_mixed);
+}
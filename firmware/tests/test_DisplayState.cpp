@@ -0,0 +1,228 @@
+extern "C"
+{
+#include <string.h>
+
+#include "display.h"
+#include "clock_types.h"
+#include "doz_clock.h"
+}
+#include "CppUTest/TestHarness.h"
+#include "CppUTestExt/MockSupport.h"
+
+static Display stateDisplay;
+static SnapshotPub stateSnapshot;
+static DisplayStateMsg clockState;
+
+/*
+    Mock Functions
+*/
+static void stateSetBrightness(uint8_t brightness)
+{
+    UNUSED(brightness);
+}
+
+static void stateSetColour(uint8_t region_id, Colour colour_id)
+{
+    UNUSED(region_id);
+    UNUSED(colour_id);
+}
+
+static void stateSetBitmap(uint8_t region_id, uint8_t *bitmap)
+{
+    mock().actualCall("setBitmap").withParameter("region_id", region_id).withParameter("bitmap", bitmap);
+}
+
+static void stateDisplayOn(void)
+{
+}
+
+static void stateDisplayOff(void)
+{
+}
+
+static void stateShow(uint8_t region_id)
+{
+    UNUSED(region_id);
+}
+
+static void stateHide(uint8_t region_id)
+{
+    UNUSED(region_id);
+}
+
+static void setState(DisplayStateMsg *state)
+{
+    mock().actualCall("setState").withParameter("time_ms", state->time_ms);
+}
+
+/*
+    Test Groups
+*/
+
+TEST_GROUP(DisplayStateModule)
+{
+    void setup()
+    {
+        stateDisplay.setBrightness = stateSetBrightness;
+        stateDisplay.setColour = stateSetColour;
+        stateDisplay.setBitmap = stateSetBitmap;
+        stateDisplay.displayOn = stateDisplayOn;
+        stateDisplay.displayOff = stateDisplayOff;
+        stateDisplay.show = stateShow;
+        stateDisplay.hide = stateHide;
+        stateDisplay.setState = setState;
+
+        memset(&clockState, 0, sizeof(clockState));
+        clockState.time_ms = 3600000;
+        clockState.user_timer_ms = 60000;
+        Snapshot_Init(&stateSnapshot);
+        Display_PublishState(&stateSnapshot, &clockState);
+    }
+
+    void teardown()
+    {
+        mock().clear();
+    }
+};
+
+/*
+    Unit Tests
+*/
+
+TEST(DisplayStateModule, U41_PackUnpackRoundTrip)
+{
+    // Production code
+    DisplayStateMsg state = { }, result = { };
+    uint8_t buf[DISPLAY_STATE_MSG_SIZE];
+    state.state_code = STATE_SETALARM;
+    state.time_format = DOZ_SEMI;
+    state.time_ms = 74120000;
+    state.user_alarm_ms = 25200000;
+    state.rtc_calib = -42;
+    state.digit_sel = 3;
+    state.digit_vals[3] = 11;
+    state.semi_diurn_radix_pos = RADIX_POS2;
+    state.alarm_set = true;
+    state.timer_alarm_displayed = true;
+    uint8_t size = Display_PackState(&state, buf);
+
+    // Checks
+    CHECK_EQUAL(DISPLAY_STATE_MSG_SIZE, size);
+    CHECK_EQUAL(CLOCK_OK, Display_UnpackState(&result, buf, size));
+    CHECK_EQUAL(STATE_SETALARM, result.state_code);
+    CHECK_EQUAL(DOZ_SEMI, result.time_format);
+    CHECK_EQUAL(74120000, result.time_ms);
+    CHECK_EQUAL(25200000, result.user_alarm_ms);
+    CHECK_EQUAL(-42, result.rtc_calib);
+    CHECK_EQUAL(3, result.digit_sel);
+    CHECK_EQUAL(11, result.digit_vals[3]);
+    CHECK_EQUAL(RADIX_POS2, result.semi_diurn_radix_pos);
+    CHECK(result.alarm_set);
+    CHECK(!result.timer_set);
+    CHECK(result.timer_alarm_displayed);
+    CHECK_EQUAL(CLOCK_FAIL, Display_UnpackState(&result, buf, size - 1));
+}
+
+TEST(DisplayStateModule, U42_StateSentOnlyOnChange)
+{
+    // Setup mock function calls
+    mock().expectNCalls(3, "setBitmap").ignoreOtherParameters();    // Display Init
+    mock().expectOneCall("setState").withParameter("time_ms", 3600000);
+    mock().expectOneCall("setState").withParameter("time_ms", 3600000 + DISPLAY_STATE_RESYNC_MS);
+    mock().expectOneCall("setState").withParameter("time_ms", 3600000 + DISPLAY_STATE_RESYNC_MS + 167);
+
+    // Production code
+    Display_Init(&stateDisplay, &stateSnapshot);
+    Display_On();
+    Display_Update();                                   // First state
+    Display_Update();                                   // Unchanged
+    clockState.time_ms += 1000;
+    Display_PublishState(&stateSnapshot, &clockState);
+    Display_Update();                                   // Receiver interpolates
+    clockState.time_ms += DISPLAY_STATE_RESYNC_MS - 1000;
+    Display_PublishState(&stateSnapshot, &clockState);
+    Display_Update();                                   // Periodic resync
+    clockState.time_ms += 167;
+    clockState.alarm_set = true;
+    Display_PublishState(&stateSnapshot, &clockState);
+    Display_Update();                                   // Flag changed
+
+    // Checks
+    mock().checkExpectations();
+}
+
+TEST(DisplayStateModule, U43_RunningTimerIsPredicted)
+{
+    // Setup mock function calls
+    mock().expectNCalls(3, "setBitmap").ignoreOtherParameters();    // Display Init
+    mock().expectOneCall("setState").withParameter("time_ms", 3600000);
+    mock().expectOneCall("setState").withParameter("time_ms", 3602000);
+
+    // Production code
+    clockState.timer_set = true;
+    Display_PublishState(&stateSnapshot, &clockState);
+    Display_Init(&stateDisplay, &stateSnapshot);
+    Display_On();
+    Display_Update();
+    clockState.time_ms += 1000;
+    clockState.user_timer_ms -= 1000;
+    Display_PublishState(&stateSnapshot, &clockState);
+    Display_Update();                                   // Counting down as predicted
+    clockState.time_ms += 1000;
+    clockState.user_timer_ms = 30000;
+    Display_PublishState(&stateSnapshot, &clockState);
+    Display_Update();                                   // Timer was changed
+
+    // Checks
+    mock().checkExpectations();
+}
+
+TEST(DisplayStateModule, U44_UnchangedFramesSkipped)
+{
+    // Setup mock function calls, three rows per frame drawn
+    mock().expectNCalls(3 + 3 * 4, "setBitmap").ignoreOtherParameters();
+
+    // Production code
+    stateDisplay.setState = NULL;
+    Display_Init(&stateDisplay, &stateSnapshot);        // Init clears the rows
+    Display_On();
+    Display_Update();                                   // First frame
+    Display_Update();                                   // Same snapshot, skipped
+    Display_PublishState(&stateSnapshot, &clockState);
+    Display_Update();                                   // Published again with nothing new, skipped
+    clockState.time_ms += 1000;
+    Display_PublishState(&stateSnapshot, &clockState);
+    Display_Update();                                   // Time moved on
+    Display_PeriodicCallback();
+    Display_Update();                                   // Blink
+    Display_SetFormat(TRAD_24H);
+    Display_Update();                                   // Format
+    Display_Update();
+
+    // Checks
+    mock().checkExpectations();
+}
+
+TEST(DisplayStateModule, U45_SnapshotSequenceTracksChanges)
+{
+    // Production code
+    ClockSnapshot Snap, Copy;
+    memset(&Snap, 0, sizeof(Snap));
+    Snapshot_Init(&stateSnapshot);
+    Snap.time_ms = 1234;
+    Snap.digit_vals[6] = 1;
+    uint32_t First = Snapshot_Publish(&stateSnapshot, &Snap);
+    uint32_t Same = Snapshot_Publish(&stateSnapshot, &Snap);
+    Snap.timer_set = true;
+    uint32_t Changed = Snapshot_Publish(&stateSnapshot, &Snap);
+    uint32_t Read = Snapshot_Read(&stateSnapshot, &Copy);
+
+    // Checks, always even once a write has finished
+    CHECK_EQUAL(2, First);
+    CHECK_EQUAL(First, Same);
+    CHECK_EQUAL(4, Changed);
+    CHECK_EQUAL(Changed, Read);
+    CHECK_EQUAL(1234, Copy.time_ms);
+    CHECK_EQUAL(1, Copy.digit_vals[6]);
+    CHECK_TRUE(Copy.timer_set);
+}
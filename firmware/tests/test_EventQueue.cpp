@@ -1,3 +1,6 @@
+#include <thread>
+#include <vector>
+
 extern "C"
 {
 #include <string.h>
@@ -11,6 +14,12 @@ extern "C"
 /*
     Mock Functions
 */
+static uint32_t fake_tick_ms;
+
+static uint32_t EventQueueTest_GetTick(void)
+{
+    return fake_tick_ms;
+}
 
 /*
     Test Groups
@@ -20,6 +29,8 @@ TEST_GROUP(EventQueueModule)
 {
     void setup()
     {
+        fake_tick_ms = 0;
+        EventQ_SetTickSource(NULL);
     }
 
     void teardown()
@@ -37,18 +48,18 @@ TEST_GROUP(EventQueueModule)
 TEST(EventQueueModule, U21_QueueEmptyRead)
 {
     // Production code
-    EventId Event;
+    ClockEvent Event;
     EventQ_Init();
     EventQ_GetEvent(&Event);
 
     // Checks
-    CHECK_EQUAL(E_NONE, Event);
+    CHECK_EQUAL(E_NONE, Event.id);
 }
 
 TEST(EventQueueModule, U22_AddEventWhileQueueEmpty)
 {
     // Production code
-    EventId Event1, Event2;
+    ClockEvent Event1, Event2;
     EventQ_Init();
     EventQ_TriggerAlarmEvent(ALARM_TRIG);
     EventQ_GetEvent(&Event1);
@@ -56,26 +67,26 @@ TEST(EventQueueModule, U22_AddEventWhileQueueEmpty)
 
 
     // Checks
-    CHECK_EQUAL(E_ALARM_TRIG, Event1);
-    CHECK_EQUAL(E_NONE, Event2);
+    CHECK_EQUAL(E_ALARM_TRIG, Event1.id);
+    CHECK_EQUAL(E_NONE, Event2.id);
 }
 
 TEST(EventQueueModule, U23_AddEventWhileQueueNotEmpty)
 {
     // Production code
-    EventId Event1, Event2, Event3;
+    ClockEvent Event1, Event2, Event3;
     EventQ_Init();
-    EventQ_TriggerLightEvent(LIGHT_ROOM);
-    EventQ_TriggerLightEvent(DARK_ROOM);
+    EventQ_TriggerButtonEvent(B_DISPLAY, SHORT);
+    EventQ_TriggerButtonEvent(B_TIMER, SHORT);
     EventQ_GetEvent(&Event1);
     EventQ_TriggerAlarmEvent(ALARM_TRIG);
     EventQ_GetEvent(&Event2);
     EventQ_GetEvent(&Event3);
 
-    // Checks
-    CHECK_EQUAL(E_ROOM_LIGHT, Event1);
-    CHECK_EQUAL(E_ROOM_DARK, Event2);
-    CHECK_EQUAL(E_ALARM_TRIG, Event3);
+    // Checks, the alarm overtakes the button event still waiting
+    CHECK_EQUAL(E_DISPLAY_SHORT, Event1.id);
+    CHECK_EQUAL(E_ALARM_TRIG, Event2.id);
+    CHECK_EQUAL(E_TIMER_SHORT, Event3.id);
 }
 
 TEST(EventQueueModule, U24_AddEventWhileQueueFull)
@@ -83,11 +94,9 @@ TEST(EventQueueModule, U24_AddEventWhileQueueFull)
     // Production code
     ClockStatus Status;
     EventQ_Init();
-    EventQ_TriggerAlarmEvent(ALARM_TRIG);
-    EventQ_TriggerAlarmEvent(ALARM_TRIG);
-    EventQ_TriggerAlarmEvent(ALARM_TRIG);
-    EventQ_TriggerAlarmEvent(ALARM_TRIG);
-    EventQ_TriggerAlarmEvent(ALARM_TRIG);
+    for (unsigned i = 0; i < EVENTQ_ALARM_DEPTH; ++i) {
+        EventQ_TriggerAlarmEvent(ALARM_TRIG);
+    }
     Status = EventQ_TriggerAlarmEvent(ALARM_TRIG);
 
     // Checks
@@ -99,7 +108,7 @@ TEST(EventQueueModule, U25_FillQueueWithoutReads)
     // Production code
     ClockStatus Status;
     EventQ_Init();
-    for (unsigned i = 0; i < 5; ++i) {
+    for (unsigned i = 0; i < EVENTQ_INPUT_DEPTH; ++i) {
         EventQ_TriggerButtonEvent(B_DISPLAY, SHORT);
     }
     Status = EventQ_TriggerButtonEvent(B_DISPLAY, LONG);
@@ -107,3 +116,271 @@ TEST(EventQueueModule, U25_FillQueueWithoutReads)
     // Checks
     CHECK_EQUAL(CLOCK_FAIL, Status);
 }
+
+TEST(EventQueueModule, U26_OverflowAndHighWaterPerClass)
+{
+    // Production code
+    EventQStats stats;
+    ClockEvent Event;
+    EventQ_Init();
+    EventQ_TriggerLightEvent(DARK_ROOM);
+    for (unsigned i = 0; i < EVENTQ_INPUT_DEPTH + 1; ++i) {
+        EventQ_TriggerButtonEvent(B_UP, SHORT);    // Last one does not fit
+    }
+    EventQ_GetEvent(&Event);
+    EventQ_TriggerAlarmEvent(ALARM_TRIG);
+    EventQ_GetStats(&stats);
+
+    // Checks
+    CHECK_EQUAL(0, stats.overflow[EVENT_CLASS_AMBIENT]);
+    CHECK_EQUAL(1, stats.overflow[EVENT_CLASS_INPUT]);
+    CHECK_EQUAL(0, stats.overflow[EVENT_CLASS_ALARM]);
+    CHECK_EQUAL(1, stats.high_water[EVENT_CLASS_AMBIENT]);
+    CHECK_EQUAL(EVENTQ_INPUT_DEPTH, stats.high_water[EVENT_CLASS_INPUT]);
+    CHECK_EQUAL(1, stats.high_water[EVENT_CLASS_ALARM]);
+}
+
+TEST(EventQueueModule, U27_ConcurrentProducersStress)
+{
+    // Each producer thread stands in for an ISR pushing its own button
+    const int producers = 4;
+    const int pushes = 20000;
+    const BtnId buttons[producers] = {B_UP, B_DOWN, B_LEFT, B_RIGHT};
+    const EventId events[producers] = {E_UP_SHORT, E_DOWN_SHORT, E_LEFT_SHORT, E_RIGHT_SHORT};
+    int accepted[producers] = {0};
+    int received[producers] = {0};
+    int unexpected = 0;
+    volatile int running = producers;
+    std::vector<std::thread> threads;
+
+    // Production code
+    EventQ_Init();
+    for (int p = 0; p < producers; p++) {
+        threads.emplace_back([&, p]() {
+            for (int i = 0; i < pushes; i++) {
+                if (EventQ_TriggerButtonEvent(buttons[p], SHORT) == CLOCK_OK) {
+                    accepted[p]++;
+                }
+            }
+            __atomic_sub_fetch(&running, 1, __ATOMIC_RELEASE);
+        });
+    }
+    ClockEvent Event;
+    bool draining = true;
+    while (draining) {
+        // Read running before draining so nothing pushed before the last producer finished is missed
+        draining = __atomic_load_n(&running, __ATOMIC_ACQUIRE) > 0;
+        while (EventQ_GetEvent(&Event) == CLOCK_OK) {
+            int p = 0;
+            while (p < producers && events[p] != Event.id) {
+                p++;
+            }
+            if (p == producers) {
+                unexpected++;
+            } else {
+                received[p]++;
+            }
+        }
+    }
+    for (auto &t : threads) {
+        t.join();
+    }
+    EventQStats stats;
+    EventQ_GetStats(&stats);
+
+    // Checks
+    int total_accepted = 0;
+    for (int p = 0; p < producers; p++) {
+        CHECK_EQUAL(accepted[p], received[p]);
+        total_accepted += accepted[p];
+    }
+    CHECK_EQUAL(0, unexpected);
+    CHECK_EQUAL(producers * pushes - total_accepted, stats.overflow[EVENT_CLASS_INPUT]);
+    CHECK(stats.high_water[EVENT_CLASS_INPUT] <= EVENTQ_INPUT_DEPTH);
+}
+
+TEST(EventQueueModule, U28_ButtonBurstCannotBlockAlarm)
+{
+    // Production code
+    ClockStatus Status;
+    ClockEvent Event;
+    EventQ_Init();
+    for (unsigned i = 0; i < EVENTQ_INPUT_DEPTH + 4; ++i) {
+        EventQ_TriggerButtonEvent(B_UP, SHORT);
+    }
+    for (unsigned i = 0; i < EVENTQ_AMBIENT_DEPTH + 4; ++i) {
+        EventQ_TriggerLightEvent(LIGHT_ROOM);
+    }
+    Status = EventQ_TriggerAlarmEvent(TIMER_TRIG);
+    EventQ_GetEvent(&Event);
+
+    // Checks
+    CHECK_EQUAL(CLOCK_OK, Status);
+    CHECK_EQUAL(E_TIMER_TRIG, Event.id);
+}
+
+TEST(EventQueueModule, U29_StarvingClassGetsBoundedTurn)
+{
+    // Production code
+    ClockEvent Events[EVENTQ_STARVE_LIMIT + 1];
+    EventQ_Init();
+    EventQ_TriggerLightEvent(DARK_ROOM);
+    for (unsigned i = 0; i < EVENTQ_STARVE_LIMIT + 1; ++i) {
+        EventQ_TriggerButtonEvent(B_LEFT, SHORT);
+    }
+    for (unsigned i = 0; i < EVENTQ_STARVE_LIMIT + 1; ++i) {
+        EventQ_GetEvent(&Events[i]);
+    }
+
+    // Checks
+    for (unsigned i = 0; i < EVENTQ_STARVE_LIMIT; ++i) {
+        CHECK_EQUAL(E_LEFT_SHORT, Events[i].id);
+    }
+    CHECK_EQUAL(E_ROOM_DARK, Events[EVENTQ_STARVE_LIMIT].id);
+}
+
+TEST(EventQueueModule, U30_AlarmLatencyUnderAdversarialInput)
+{
+    // Host simulation of the main loop handling one event per pass while every
+    // button and the light sensor fire as fast as they can. Alarms arrive at
+    // pseudo random passes, sometimes back to back.
+    const int passes = 100000;
+    const int max_waiting_alarms = EVENTQ_ALARM_DEPTH;
+    unsigned rng = 12345;
+    int alarms_sent = 0, alarms_received = 0, alarms_failed = 0;
+    int pending_since[max_waiting_alarms];  // Pass each waiting alarm was pushed, oldest first
+    int pending = 0;
+    int worst_alarm_wait = 0;
+    int passes_since_input = 0, worst_input_wait = 0;
+    int passes_since_ambient = 0, worst_ambient_wait = 0;
+
+    // Production code
+    EventQ_Init();
+    for (int pass = 0; pass < passes; pass++) {
+        for (int i = 0; i < 3; i++) {
+            EventQ_TriggerButtonEvent(B_UP, (i & 1) ? LONG : SHORT);
+            EventQ_TriggerLightEvent((i & 1) ? DARK_ROOM : LIGHT_ROOM);
+        }
+        rng = rng * 1103515245 + 12345;
+        if (((rng >> 16) % 7) == 0 && pending < max_waiting_alarms) {
+            if (EventQ_TriggerAlarmEvent(((rng >> 8) & 1) ? ALARM_TRIG : TIMER_TRIG) == CLOCK_OK) {
+                pending_since[pending++] = pass;
+                alarms_sent++;
+            } else {
+                alarms_failed++;
+            }
+        }
+
+        ClockEvent Event;
+        passes_since_input++;
+        passes_since_ambient++;
+        if (EventQ_GetEvent(&Event) != CLOCK_OK) {
+            continue;
+        }
+        if (Event.id == E_ALARM_TRIG || Event.id == E_TIMER_TRIG) {
+            int wait = pass - pending_since[0];
+            worst_alarm_wait = (wait > worst_alarm_wait) ? wait : worst_alarm_wait;
+            memmove(&pending_since[0], &pending_since[1], (pending - 1) * sizeof(int));
+            pending--;
+            alarms_received++;
+        } else if (Event.id == E_ROOM_LIGHT || Event.id == E_ROOM_DARK) {
+            worst_ambient_wait = (passes_since_ambient > worst_ambient_wait) ? passes_since_ambient : worst_ambient_wait;
+            passes_since_ambient = 0;
+        } else {
+            worst_input_wait = (passes_since_input > worst_input_wait) ? passes_since_input : worst_input_wait;
+            passes_since_input = 0;
+        }
+    }
+    EventQStats stats;
+    EventQ_GetStats(&stats);
+
+    // Checks
+    CHECK(alarms_sent > passes / 10);
+    CHECK_EQUAL(0, alarms_failed);
+    CHECK_EQUAL(0, stats.overflow[EVENT_CLASS_ALARM]);
+    CHECK(alarms_sent - alarms_received <= max_waiting_alarms);
+    // Every alarm ahead of it plus at most one turn for each lower class
+    CHECK(worst_alarm_wait <= max_waiting_alarms - 1 + NUM_EVENT_CLASSES - 1);
+    // The flooded classes still get through, input may also see up to two ambient turns while it waits
+    CHECK(worst_input_wait <= EVENTQ_STARVE_LIMIT + 3);
+    CHECK(worst_ambient_wait <= EVENTQ_STARVE_LIMIT + 1);
+    CHECK(stats.overflow[EVENT_CLASS_INPUT] > 0);
+}
+
+TEST(EventQueueModule, U201_EventsCarryCaptureTimestamp)
+{
+    // Production code
+    ClockEvent Event1, Event2;
+    EventQ_Init();
+    EventQ_SetTickSource(EventQueueTest_GetTick);
+    fake_tick_ms = 1200;
+    EventQ_TriggerButtonEvent(B_LEFT, SHORT);
+    fake_tick_ms = 1350;
+    EventQ_TriggerAlarmEvent(TIMER_TRIG);
+    fake_tick_ms = 5000;
+    EventQ_GetEvent(&Event1);
+    EventQ_GetEvent(&Event2);
+
+    // Checks
+    CHECK_EQUAL(E_TIMER_TRIG, Event1.id);
+    CHECK_EQUAL(1350, Event1.timestamp_ms);
+    CHECK_EQUAL(1, Event1.payload);
+    CHECK_EQUAL(E_LEFT_SHORT, Event2.id);
+    CHECK_EQUAL(1200, Event2.timestamp_ms);
+}
+
+TEST(EventQueueModule, U202_RepeatedStepsCoalesce)
+{
+    // Production code
+    ClockEvent Event1, Event2, Event3, Event4, Event5;
+    EventQStats stats;
+    EventQ_Init();
+    EventQ_SetTickSource(EventQueueTest_GetTick);
+    fake_tick_ms = 100;
+    EventQ_TriggerButtonEvent(B_UP, SHORT);
+    EventQ_TriggerButtonEvent(B_UP, SHORT);
+    fake_tick_ms = 200;
+    EventQ_TriggerButtonRepeat(B_UP, 2);
+    fake_tick_ms = 300;
+    EventQ_TriggerButtonRepeat(B_UP, 4);
+    EventQ_TriggerButtonEvent(B_RIGHT, SHORT);
+    EventQ_TriggerButtonRepeat(B_UP, 1);
+    EventQ_GetEvent(&Event1);
+    EventQ_GetEvent(&Event2);
+    EventQ_GetEvent(&Event3);
+    EventQ_GetEvent(&Event4);
+    EventQ_GetEvent(&Event5);
+    EventQ_GetStats(&stats);
+
+    // Checks, short presses each stay their own event, the repeats before RIGHT become
+    // one +6 step stamped when they started
+    CHECK_EQUAL(E_UP_SHORT, Event1.id);
+    CHECK_EQUAL(E_UP_SHORT, Event2.id);
+    CHECK_EQUAL(1, Event2.payload);
+    CHECK_EQUAL(E_UP_REPEAT, Event3.id);
+    CHECK_EQUAL(6, Event3.payload);
+    CHECK_EQUAL(200, Event3.timestamp_ms);
+    CHECK_EQUAL(E_RIGHT_SHORT, Event4.id);
+    CHECK_EQUAL(E_UP_REPEAT, Event5.id);
+    CHECK_EQUAL(1, Event5.payload);
+    CHECK_EQUAL(1, stats.coalesced);
+    CHECK_EQUAL(CLOCK_FAIL, EventQ_TriggerButtonRepeat(B_LEFT, 1));
+    CHECK_EQUAL(CLOCK_FAIL, EventQ_TriggerButtonRepeat(B_UP, 0));
+}
+
+TEST(EventQueueModule, U203_LightFlapsCollapseToLastState)
+{
+    // Production code
+    ClockEvent Event1, Event2;
+    EventQ_Init();
+    EventQ_TriggerLightEvent(DARK_ROOM);
+    EventQ_TriggerLightEvent(LIGHT_ROOM);
+    EventQ_TriggerLightEvent(DARK_ROOM);
+    EventQ_TriggerLightEvent(LIGHT_ROOM);
+    EventQ_GetEvent(&Event1);
+    EventQ_GetEvent(&Event2);
+
+    // Checks
+    CHECK_EQUAL(E_ROOM_LIGHT, Event1.id);
+    CHECK_EQUAL(E_NONE, Event2.id);
+}
@@ -0,0 +1,125 @@
+#include <string>
+
+extern "C"
+{
+#include <string.h>
+
+#include "flight_recorder.h"
+#include "clock_types.h"
+}
+#include "CppUTest/TestHarness.h"
+#include "CppUTestExt/MockSupport.h"
+
+/*
+    Mock Functions
+*/
+static uint32_t recorder_tick_ms;
+static std::string recorder_dump;
+
+static uint32_t FlightRecTest_GetTick(void)
+{
+    return recorder_tick_ms;
+}
+
+static void FlightRecTest_Write(uint8_t *buf, uint16_t len)
+{
+    recorder_dump.append((const char *)buf, len);
+}
+
+/*
+    Test Groups
+*/
+
+TEST_GROUP(FlightRecorderModule)
+{
+    void setup()
+    {
+        recorder_tick_ms = 100;
+        recorder_dump.clear();
+        FlightRec_Init(FlightRecTest_GetTick);
+    }
+
+    void teardown()
+    {
+        FlightRec_Init(NULL);
+        mock().clear();
+    }
+};
+
+/*
+    Unit Tests
+*/
+
+TEST(FlightRecorderModule, U71_RecordsKeptInOrderWithTicks)
+{
+    // Production code
+    FlightRecord Boot, Event, State;
+    recorder_tick_ms = 250;
+    FlightRec_Log(REC_EVENT, 22, 3, 240);
+    recorder_tick_ms = 260;
+    FlightRec_Log(REC_CLOCK_STATE, 2, 4, 0);
+    FlightRec_Get(0, &Boot);
+    FlightRec_Get(1, &Event);
+    FlightRec_Get(2, &State);
+
+    // Checks
+    CHECK_EQUAL(3, FlightRec_Count());
+    CHECK_EQUAL(REC_BOOT, Boot.type);
+    CHECK_EQUAL(100, Boot.tick_ms);
+    CHECK_EQUAL(REC_EVENT, Event.type);
+    CHECK_EQUAL(22, Event.code);
+    CHECK_EQUAL(3, Event.arg);
+    CHECK_EQUAL(240, Event.value);
+    CHECK_EQUAL(250, Event.tick_ms);
+    CHECK_EQUAL(REC_CLOCK_STATE, State.type);
+    CHECK_EQUAL(260, State.tick_ms);
+    CHECK_EQUAL(CLOCK_FAIL, FlightRec_Get(3, &State));
+}
+
+TEST(FlightRecorderModule, U72_OldestOverwrittenWhenFull)
+{
+    // Production code
+    FlightRecord Oldest, Newest;
+    for (uint32_t i = 0; i < FLIGHTREC_DEPTH + 10; i++) {
+        FlightRec_Log(REC_RTC_SYNC, 0, 0, i);
+    }
+    FlightRec_Get(0, &Oldest);
+    FlightRec_Get(FLIGHTREC_DEPTH - 1, &Newest);
+
+    // Checks, the boot record and the first 10 syncs are gone
+    CHECK_EQUAL(FLIGHTREC_DEPTH, FlightRec_Count());
+    CHECK_EQUAL(REC_RTC_SYNC, Oldest.type);
+    CHECK_EQUAL(10, Oldest.value);
+    CHECK_EQUAL(FLIGHTREC_DEPTH + 9, Newest.value);
+}
+
+TEST(FlightRecorderModule, U73_DumpParsesBack)
+{
+    // Production code
+    FlightRecord Original, Parsed;
+    recorder_tick_ms = 0x12345678;
+    FlightRec_Log(REC_GPS_SYNC, 0xAB, 0xBEEF, 43199000);
+    for (uint32_t i = 0; i < FLIGHTREC_DEPTH; i++) {
+        FlightRec_Log(REC_EVENT, 1, 1, i);
+    }
+    FlightRec_Log(REC_GPS_SYNC, 0xAB, 0xBEEF, 43199000);
+    FlightRec_Dump(FlightRecTest_Write);
+    FlightRec_Get(FLIGHTREC_DEPTH - 1, &Original);
+
+    size_t header_end = recorder_dump.find("\r\n");
+    size_t last_start = recorder_dump.size() - strlen("END\r\n") - FLIGHTREC_LINE_SIZE;
+    ClockStatus Status = FlightRec_ParseLine(recorder_dump.c_str() + last_start, &Parsed);
+
+    // Checks
+    STRCMP_EQUAL(("FLIGHTREC 1 " + std::to_string(FLIGHTREC_DEPTH) + " 3").c_str(),
+                 recorder_dump.substr(0, header_end).c_str());
+    CHECK_EQUAL(header_end + 2 + FLIGHTREC_DEPTH * FLIGHTREC_LINE_SIZE + 5, recorder_dump.size());
+    CHECK_EQUAL(CLOCK_OK, Status);
+    CHECK_EQUAL(Original.tick_ms, Parsed.tick_ms);
+    CHECK_EQUAL(Original.value, Parsed.value);
+    CHECK_EQUAL(Original.arg, Parsed.arg);
+    CHECK_EQUAL(Original.code, Parsed.code);
+    CHECK_EQUAL(Original.type, Parsed.type);
+    CHECK_EQUAL(CLOCK_FAIL, FlightRec_ParseLine("END\r\n", &Parsed));
+    CHECK_EQUAL(CLOCK_FAIL, FlightRec_ParseLine("FLIGHTREC 1 128 0", &Parsed));
+}
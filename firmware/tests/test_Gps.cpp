@@ -0,0 +1,138 @@
+extern "C"
+{
+#include <string.h>
+
+#include "gps.h"
+#include "clock_types.h"
+}
+#include "CppUTest/TestHarness.h"
+#include "CppUTestExt/MockSupport.h"
+
+/*
+    Mock Functions
+*/
+// The last sentence the UART finished, hhmmss.ss and the microseconds its '$' came in at
+static float sentence_utc;
+static uint32_t sentence_us;
+static Gps TestGps;
+
+static float GpsTest_GetUtcTime(void)
+{
+    return sentence_utc;
+}
+
+static uint32_t GpsTest_GetUtcTimeUs(void)
+{
+    return sentence_us;
+}
+
+// A pulse at at_us for the second utc, its sentence starts 120 ms later
+static void GpsTest_Second(uint32_t at_us, float utc, bool with_sentence)
+{
+    GpsPps Pulse;
+    Gps_PpsEdge(at_us);
+    Gps_GetPps(&Pulse);     // The main loop looks before the sentence is in
+    if (with_sentence)
+    {
+        sentence_utc = utc;
+        sentence_us = at_us + 120000;
+    }
+}
+
+/*
+    Test Groups
+*/
+
+TEST_GROUP(GpsModule)
+{
+    void setup()
+    {
+        memset(&TestGps, 0, sizeof(TestGps));
+        TestGps.getUtcTime = GpsTest_GetUtcTime;
+        TestGps.getUtcTimeUs = GpsTest_GetUtcTimeUs;
+        TestGps.latency_us = 100000;
+        sentence_utc = 0;
+        sentence_us = 0;
+        Gps_Init(&TestGps);
+    }
+
+    void teardown()
+    {
+        mock().clear();
+    }
+};
+
+/*
+    Unit Tests
+*/
+
+TEST(GpsModule, U131_PulseLabelledByItsSentence)
+{
+    // Production code, the microsecond count wraps between the two pulses
+    GpsPps Before, First, Second;
+    sentence_us = 0xFFFFFFFF - 400000 - 880000;
+    ClockStatus Unlabelled = Gps_GetPps(&Before);
+    GpsTest_Second(0xFFFFFFFF - 400000, 123456.0f, true);
+    Gps_GetPps(&First);
+    GpsTest_Second(599999, 123457.0f, true);
+    Gps_GetPps(&Second);
+
+    // Checks
+    CHECK_EQUAL(CLOCK_FAIL, Unlabelled);
+    CHECK(First.labelled);
+    CHECK_EQUAL((12 * 3600 + 34 * 60 + 56) * 1000, First.ms);
+    CHECK_EQUAL(0xFFFFFFFF - 400000, First.at_us);
+    CHECK_EQUAL((12 * 3600 + 34 * 60 + 57) * 1000, Second.ms);
+    CHECK_EQUAL(599999, Second.at_us);
+    CHECK_EQUAL(2, Second.labels);
+}
+
+TEST(GpsModule, U132_MissingSentenceAndGlitches)
+{
+    // Production code, the second pulse has no sentence, a glitch lands between the
+    // third and fourth, and a sentence that starts too late labels nothing
+    GpsPps Carried, Glitched, Late;
+    GpsTest_Second(1000000, 235959.0f, true);
+    GpsTest_Second(2000000, 0.0f, false);
+    Gps_GetPps(&Carried);
+    GpsTest_Second(3000050, 1.0f, true);
+    Gps_PpsEdge(3400000);
+    Gps_GetPps(&Glitched);
+    GpsTest_Second(3999900, 2.0f, false);
+    sentence_utc = 3.0f;
+    sentence_us = 3999900 + 950000;
+    Gps_GetPps(&Late);
+
+    // Checks, the label carries over midnight and the glitch is dropped
+    CHECK(Carried.labelled);
+    CHECK_EQUAL(0, Carried.ms);
+    CHECK_EQUAL(1, Carried.labels);
+    CHECK_EQUAL(3000050, Glitched.at_us);
+    CHECK_EQUAL(1000, Glitched.ms);
+    CHECK_EQUAL(1, Glitched.rejected);
+    CHECK_EQUAL(3999900, Late.at_us);
+    CHECK_EQUAL(2000, Late.ms);
+    CHECK_EQUAL(2, Late.labels);
+    CHECK_EQUAL(4, Late.edges);
+}
+
+TEST(GpsModule, U133_TimeFromPulseOrSentenceStamp)
+{
+    // Production code, first a sentence with no pulse, then the pulse train starts
+    sentence_utc = 101010.25f;
+    sentence_us = 5000000;
+    GpsTime Stamped = Gps_GetTime();
+    GpsTest_Second(7000000, 101012.0f, true);
+    GpsTime Pulsed = Gps_GetTime();
+
+    // Checks, the sentence's fraction and the module's latency, then the pulse itself
+    CHECK(Stamped.stamped);
+    CHECK_EQUAL(10, Stamped.hr);
+    CHECK_EQUAL(10, Stamped.min);
+    CHECK_EQUAL(10, Stamped.sec);
+    CHECK_EQUAL(250, Stamped.ms);
+    CHECK_EQUAL(4900000, Stamped.at_us);
+    CHECK_EQUAL(12, Pulsed.sec);
+    CHECK_EQUAL(0, Pulsed.ms);
+    CHECK_EQUAL(7000000, Pulsed.at_us);
+}
@@ -0,0 +1,222 @@
+extern "C"
+{
+#include <string.h>
+#include <math.h>
+
+#include "rtc_discipline.h"
+#include "rtc_module.h"
+#include "clock_types.h"
+}
+#include "CppUTest/TestHarness.h"
+#include "CppUTestExt/MockSupport.h"
+
+#define DAY_S   86400
+
+/*
+    Mock Functions
+*/
+// A free-running crystal: a fixed error, ageing and a daily swing, all in ppb. With a
+// curve it also slows on the tuning fork parabola as the room temperature moves.
+typedef struct disc_crystal_t
+{
+    double      base_ppb;
+    double      ageing_ppb_per_day;
+    double      swing_ppb;
+    double      curve_ppb_per_c2;
+    double      room_c, daily_c, weather_c;
+} DiscCrystal;
+
+static Rtc discRtc;
+static DiscCrystal crystal;
+static int32_t rtc_calib;
+static int64_t rtc_err_ns;      // RTC minus true time
+static uint32_t sim_s;
+static uint32_t seed;
+
+static bool DiscTest_SetCalibration(int32_t calib)
+{
+    if (calib > discRtc.max_calib || calib < -discRtc.max_calib)
+    {
+        return false;
+    }
+    rtc_calib = calib;
+    return true;
+}
+
+static int32_t DiscTest_GetCalibration(void)
+{
+    return rtc_calib;
+}
+
+// Mild days and nights with a week or so of weather on top
+static double DiscTest_Temperature(void)
+{
+    return crystal.room_c + crystal.daily_c * sin(2 * M_PI * sim_s / DAY_S)
+           + crystal.weather_c * sin(2 * M_PI * sim_s / (7.3 * DAY_S));
+}
+
+static bool DiscTest_GetTemperature(int16_t *centi_c)
+{
+    *centi_c = (int16_t)lround(DiscTest_Temperature() * 100);
+    return true;
+}
+
+// GPS whole seconds read up to a second after they went by
+static int32_t DiscTest_ReadLagUs(void)
+{
+    seed = seed * 1103515245 + 12345;
+    return (seed >> 4) % 1000000;
+}
+
+// One RTC second at a time, with an hourly GPS sync that steps the RTC like TimeTrack does
+static void DiscTest_Run(uint32_t days, bool gps)
+{
+    int32_t lag_us;
+    double drift_ppb, from_turnover;
+
+    for (uint32_t end_s = sim_s + days * DAY_S; sim_s < end_s; sim_s++)
+    {
+        drift_ppb = crystal.base_ppb + crystal.ageing_ppb_per_day * sim_s / DAY_S
+                    + crystal.swing_ppb * sin(2 * M_PI * sim_s / DAY_S);
+        if (crystal.curve_ppb_per_c2 != 0)
+        {
+            from_turnover = DiscTest_Temperature() - 25;
+            drift_ppb -= crystal.curve_ppb_per_c2 * from_turnover * from_turnover;
+        }
+        rtc_err_ns += (int64_t)drift_ppb - (int64_t)rtc_calib * discRtc.calib_ppb;
+        Discipline_Tick();
+        if (gps && sim_s % 3600 == 0)
+        {
+            lag_us = DiscTest_ReadLagUs();
+            Discipline_Measure(llround(rtc_err_ns / 1e6 + lag_us / 1e3));
+            rtc_err_ns = -(int64_t)lag_us * 1000;
+        }
+    }
+}
+
+/*
+    Test Groups
+*/
+
+TEST_GROUP(RtcDiscipline)
+{
+    void setup()
+    {
+        memset(&discRtc, 0, sizeof(discRtc));
+        discRtc.setCalibration = DiscTest_SetCalibration;
+        discRtc.getCalibration = DiscTest_GetCalibration;
+        discRtc.max_calib = 511;
+        discRtc.calib_ppb = 954;
+        Rtc_Init(&discRtc);
+        memset(&crystal, 0, sizeof(crystal));
+        rtc_calib = 0;
+        rtc_err_ns = 0;
+        sim_s = 1;
+        seed = 42;
+    }
+
+    void teardown()
+    {
+        mock().clear();
+    }
+};
+
+/*
+    Unit Tests
+*/
+
+TEST(RtcDiscipline, U111_HoldoverAfterInternalTrim)
+{
+    // Production code, a month of hourly syncs then a month without GPS
+    DiscStats Stats;
+    int64_t HoldStart_ns, Drift_ns;
+    crystal.base_ppb = 12000;               // About 1 s a day
+    crystal.ageing_ppb_per_day = 3;         // 0.1 ppm a month
+    crystal.swing_ppb = 500;
+    CHECK_EQUAL(CLOCK_OK, Discipline_Init());
+    DiscTest_Run(30, true);
+    Discipline_GetStats(&Stats);
+    HoldStart_ns = rtc_err_ns;
+    DiscTest_Run(30, false);
+    Drift_ns = rtc_err_ns - HoldStart_ns;
+
+    // Checks, untrimmed it would be 31 s out, it stays well inside a second
+    CHECK_TRUE(Stats.locked);
+    CHECK_EQUAL(720, Stats.syncs);
+    CHECK_EQUAL(0, Stats.restarts);
+    CHECK_TRUE(llabs(Stats.freq_ppb - 12090) < 300);
+    CHECK_TRUE(rtc_calib == 12 || rtc_calib == 13);
+    CHECK_TRUE(llabs(Drift_ns) < 400000000);
+}
+
+TEST(RtcDiscipline, U112_DS3231AgingTrim)
+{
+    // Production code, a slow DS3231 is trimmed in 0.1 ppm aging steps
+    DiscStats Stats;
+    int64_t HoldStart_ns;
+    discRtc.max_calib = 127;
+    discRtc.calib_ppb = 100;
+    rtc_calib = 5;                          // Left over from a hand trim
+    crystal.base_ppb = -2300;
+    crystal.swing_ppb = 100;
+    CHECK_EQUAL(CLOCK_OK, Discipline_Init());
+    DiscTest_Run(20, true);
+    Discipline_GetStats(&Stats);
+    HoldStart_ns = rtc_err_ns;
+    DiscTest_Run(30, false);
+
+    // Checks, the target is the whole correction not just what is left after the hand trim
+    CHECK_TRUE(Stats.target_q8 > -24 * 256 && Stats.target_q8 < -22 * 256);
+    CHECK_TRUE(abs(rtc_calib * 256 - Stats.target_q8) < 256);
+    CHECK_TRUE(llabs(rtc_err_ns - HoldStart_ns) < 400000000);
+}
+
+TEST(RtcDiscipline, U114_TemperatureCurveHoldover)
+{
+    // Production code, a clock by a window: up to 20 C from the turnover and back within days.
+    // The crystal's curve is steeper than the datasheet one the model starts from.
+    DiscStats Stats;
+    int64_t HoldStart_ns, Drift_ns;
+    discRtc.getTemperature = DiscTest_GetTemperature;
+    crystal.base_ppb = 6000;
+    crystal.curve_ppb_per_c2 = 40;
+    crystal.room_c = 17;
+    crystal.daily_c = 4;
+    crystal.weather_c = 6;
+    CHECK_EQUAL(CLOCK_OK, Discipline_Init());
+    DiscTest_Run(30, true);
+    Discipline_GetStats(&Stats);
+    HoldStart_ns = rtc_err_ns;
+    crystal.room_c = 23;                    // The heating comes on as GPS goes
+    DiscTest_Run(30, false);
+    Drift_ns = rtc_err_ns - HoldStart_ns;
+
+    // Checks, the curve moved towards the real one. A fixed trim ends this month 6 s out.
+    CHECK_TRUE(Stats.curve_ppt > DISC_CURVE_PPT && Stats.curve_ppt < 43000);
+    CHECK_TRUE(abs(Stats.base_ppb - 6000) < 600);
+    CHECK_TRUE(llabs(Drift_ns) < 600000000);
+}
+
+TEST(RtcDiscipline, U113_TimeChangeRestartsEstimate)
+{
+    // Production code, the clock is set 5 minutes out after a week of syncs
+    DiscStats Before, After;
+    crystal.base_ppb = 8000;
+    CHECK_EQUAL(CLOCK_OK, Discipline_Init());
+    DiscTest_Run(7, true);
+    Discipline_GetStats(&Before);
+    rtc_err_ns += 300000000000LL;
+    DiscTest_Run(1, true);
+    Discipline_GetStats(&After);
+
+    // Checks, the jump is not taken as drift and the trim carries on from the last estimate
+    CHECK_TRUE(Before.locked);
+    CHECK_EQUAL(1, After.restarts);
+    CHECK_EQUAL(Before.target_q8, After.target_q8);
+    CHECK_TRUE(rtc_calib == 8 || rtc_calib == 9);
+
+    // Checks, an RTC that cannot be calibrated is left alone
+    discRtc.calib_ppb = 0;
+    CHECK_EQUAL(CLOCK_FAIL, Discipline_Init());
+    CHECK_EQUAL(CLOCK_FAIL, Discipline_Measure(100));
+}
@@ -0,0 +1,276 @@
+extern "C"
+{
+#include <string.h>
+
+#include "scheduler.h"
+#include "clock_types.h"
+}
+#include "CppUTest/TestHarness.h"
+#include "CppUTestExt/MockSupport.h"
+
+/*
+    Mock Functions
+*/
+static uint32_t sched_tick_ms;
+static uint32_t sched_us;
+static uint32_t sched_work_us;
+static uint32_t fast_runs_at[64], slow_runs_at[8];
+static uint32_t fast_count, slow_count;
+static SchedTask FastTask, SlowTask, OnceTask;
+static bool work_queued;
+static uint32_t slept_ms, interrupt_in_ms;
+
+static uint32_t SchedTest_GetTick(void)
+{
+    return sched_tick_ms;
+}
+
+static uint32_t SchedTest_GetUs(void)
+{
+    return sched_us;
+}
+
+static void SchedTest_Fast(void)
+{
+    if (fast_count < 64)
+    {
+        fast_runs_at[fast_count] = sched_tick_ms;
+    }
+    fast_count++;
+    sched_us += sched_work_us;
+}
+
+static void SchedTest_Slow(void)
+{
+    if (slow_count < 8)
+    {
+        slow_runs_at[slow_count] = sched_tick_ms;
+    }
+    slow_count++;
+}
+
+static void SchedTest_Once(void)
+{
+    mock().actualCall("SchedTest_Once");
+    Sched_Cancel(&FastTask);
+}
+
+static bool SchedTest_Ready(void)
+{
+    return work_queued;
+}
+
+static void SchedTest_Work(void)
+{
+    mock().actualCall("SchedTest_Work");
+    work_queued = false;
+}
+
+// Sleeps the whole time unless an interrupt comes first and queues work
+static void SchedTest_Sleep(uint32_t max_ms)
+{
+    mock().actualCall("SchedTest_Sleep").withParameter("max_ms", max_ms);
+    uint32_t ms = max_ms;
+    if (interrupt_in_ms > 0 && interrupt_in_ms < max_ms)
+    {
+        ms = interrupt_in_ms;
+        interrupt_in_ms = 0;
+        work_queued = true;
+    }
+    sched_tick_ms += ms;
+    sched_us += ms * 1000;
+    slept_ms += ms;
+}
+
+// Step the tick one millisecond at a time like the main loop would see it
+static void SchedTest_RunFor(uint32_t ms)
+{
+    for (uint32_t i = 0; i < ms; i++)
+    {
+        sched_tick_ms++;
+        sched_us += 1000;
+        Sched_Run();
+    }
+}
+
+/*
+    Test Groups
+*/
+
+TEST_GROUP(SchedulerModule)
+{
+    void setup()
+    {
+        sched_tick_ms = 1000;
+        sched_us = 0;
+        sched_work_us = 0;
+        fast_count = 0;
+        slow_count = 0;
+        work_queued = false;
+        slept_ms = 0;
+        interrupt_in_ms = 0;
+        Sched_Init(SchedTest_GetTick, SchedTest_GetUs);
+        memset(&FastTask, 0, sizeof(FastTask));
+        memset(&SlowTask, 0, sizeof(SlowTask));
+        memset(&OnceTask, 0, sizeof(OnceTask));
+        FastTask.run = SchedTest_Fast;
+        FastTask.period_ms = 167;
+        SlowTask.run = SchedTest_Slow;
+        OnceTask.run = SchedTest_Once;
+    }
+
+    void teardown()
+    {
+        Sched_Init(SchedTest_GetTick, NULL);
+        mock().clear();
+    }
+};
+
+/*
+    Unit Tests
+*/
+
+TEST(SchedulerModule, U81_PeriodicTaskKeepsPhase)
+{
+    // Production code
+    Sched_Start(&FastTask, 0);
+    SchedTest_RunFor(1000);
+
+    // Checks, first run on the next tick then every 167 ms
+    CHECK_EQUAL(6, fast_count);
+    for (uint32_t i = 0; i < fast_count; i++) {
+        CHECK_EQUAL(1001 + i * 167, fast_runs_at[i]);
+    }
+    CHECK_EQUAL(0, FastTask.late);
+}
+
+TEST(SchedulerModule, U82_LongDelaysCascadeToExactTick)
+{
+    // Production code, one in each level and one past the end of the wheel
+    SlowTask.period_ms = 0;
+    Sched_Start(&SlowTask, 63);
+    SchedTest_RunFor(100);
+    Sched_Start(&SlowTask, 4095);
+    SchedTest_RunFor(4200);
+    Sched_Start(&SlowTask, 200000);
+    SchedTest_RunFor(200100);
+    Sched_Start(&SlowTask, SCHED_WHEEL_SPAN + 12345);
+    SchedTest_RunFor(SCHED_WHEEL_SPAN + 12400);
+
+    // Checks
+    CHECK_EQUAL(4, slow_count);
+    CHECK_EQUAL(1063, slow_runs_at[0]);
+    CHECK_EQUAL(1100 + 4095, slow_runs_at[1]);
+    CHECK_EQUAL(1100 + 4200 + 200000, slow_runs_at[2]);
+    CHECK_EQUAL(1100 + 4200 + 200100 + SCHED_WHEEL_SPAN + 12345, slow_runs_at[3]);
+}
+
+TEST(SchedulerModule, U83_CancelAndRestart)
+{
+    // Expectations, the one-shot cancels the fast task
+    mock().expectOneCall("SchedTest_Once");
+
+    // Production code
+    Sched_Start(&FastTask, 0);
+    Sched_Start(&OnceTask, 400);
+    Sched_Start(&SlowTask, 5000);
+    Sched_Start(&SlowTask, 10);     // Restarting moves it rather than adding a second copy
+    SchedTest_RunFor(1000);
+
+    // Checks
+    mock().checkExpectations();
+    CHECK_EQUAL(3, fast_count);     // 1001, 1168, 1335, cancelled at 1400
+    CHECK_FALSE(FastTask.armed);
+    CHECK_FALSE(OnceTask.armed);
+    CHECK_EQUAL(1, slow_count);
+    CHECK_EQUAL(1010, slow_runs_at[0]);
+    OnceTask.run = NULL;
+    CHECK_EQUAL(CLOCK_FAIL, Sched_Start(&OnceTask, 0));
+}
+
+TEST(SchedulerModule, U84_RuntimeAndLoadAccounting)
+{
+    // Production code, 25 ms of work every 167 ms
+    SchedStats Stats;
+    sched_work_us = 25000;
+    Sched_Start(&FastTask, 0);
+    SchedTest_RunFor(2004);
+    Sched_GetStats(&Stats);
+
+    // Checks, 6 runs of 25 ms in each 1 s window
+    CHECK_EQUAL(12, FastTask.runs);
+    CHECK_EQUAL(12 * 25000, FastTask.busy_us);
+    CHECK_EQUAL(25000, FastTask.max_us);
+    CHECK_EQUAL(12, Stats.runs);
+    CHECK_EQUAL(150, Stats.load_permille);
+    CHECK_EQUAL(150, Stats.peak_permille);
+}
+
+TEST(SchedulerModule, U85_CatchesUpAfterSlowPass)
+{
+    // Production code, the main loop stalls for 600 ms
+    SchedStats Stats;
+    Sched_Start(&FastTask, 0);
+    SchedTest_RunFor(1);
+    sched_tick_ms += 600;
+    Sched_Run();
+    Sched_GetStats(&Stats);
+
+    // Checks, the missed runs happen straight away so nothing is lost,
+    // the ones due at 1168 and 1335 were a full period late
+    CHECK_EQUAL(4, fast_count);
+    CHECK_EQUAL(2, Stats.late);
+    CHECK_EQUAL(1001, fast_runs_at[0]);
+    CHECK_EQUAL(1601, fast_runs_at[3]);
+}
+
+TEST(SchedulerModule, U86_IdleUntilNextDueTask)
+{
+    // Production code, the next task is 700 ms out in level 1 then 30 ms out in level 0
+    SlowTask.period_ms = 1000;
+    Sched_Start(&SlowTask, 700);
+    uint32_t Far = Sched_IdleMs(SCHED_MAX_SLEEP_MS);
+    uint32_t Capped = Sched_IdleMs(5000);
+    SchedTest_RunFor(670);
+    uint32_t Near = Sched_IdleMs(SCHED_MAX_SLEEP_MS);
+    sched_tick_ms += 40;    // Main loop behind the wheel
+    uint32_t Behind = Sched_IdleMs(SCHED_MAX_SLEEP_MS);
+
+    // Checks
+    CHECK_EQUAL(SCHED_MAX_SLEEP_MS, Far);
+    CHECK_EQUAL(700, Capped);
+    CHECK_EQUAL(30, Near);
+    CHECK_EQUAL(0, Behind);
+}
+
+TEST(SchedulerModule, U87_SleepsBetweenTasksAndWakesForWork)
+{
+    // Expectations, an interrupt 3 ms into the first sleep queues work that runs
+    // straight away, then it sleeps out the rest of the period
+    mock().expectOneCall("SchedTest_Sleep").withParameter("max_ms", 100);
+    mock().expectOneCall("SchedTest_Work");
+    mock().expectOneCall("SchedTest_Sleep").withParameter("max_ms", 97);
+    mock().expectOneCall("SchedTest_Work");
+
+    // Production code
+    SchedStats Stats;
+    OnceTask.run = SchedTest_Work;
+    OnceTask.ready = SchedTest_Ready;
+    OnceTask.period_ms = 100;
+    interrupt_in_ms = 3;
+    Sched_SetSleep(SchedTest_Sleep);
+    Sched_Start(&OnceTask, 100);
+    Sched_Run();
+    Sched_Idle();
+    Sched_Run();
+    Sched_Idle();
+    Sched_Run();
+    Sched_GetStats(&Stats);
+
+    // Checks
+    mock().checkExpectations();
+    CHECK_EQUAL(1100, sched_tick_ms);
+    CHECK_EQUAL(2, OnceTask.runs);
+    CHECK_EQUAL(2, Stats.sleeps);
+    CHECK_EQUAL(100000, Stats.sleep_us);
+}
@@ -11,6 +11,8 @@ extern "C"
 
 Rtc testRtc;
 
+#define TIMER_PERIOD_TEST_MS    167
+
 /*
     Mock Functions
 */
@@ -28,6 +30,7 @@ TEST_GROUP(TimeTrackAlgorithm)
     void setup()
     {
         testRtc.getTime = getTime;
+        testRtc.getTimeMs = NULL;
         Rtc_Init(&testRtc);
     }
 
@@ -309,3 +312,562 @@ TEST(TimeTrackAlgorithm, U17_UpdatesRollover)
     CHECK_EQUAL(999, Output_ms2);
     CHECK_EQUAL(1999, Output_ms3);
 }
+
+// RTC and microsecond counter on one simulated timeline, the RTC runs sim_rtc_lag_us behind
+// and loses a microsecond every sim_slow_every_us when that is set
+static uint32_t sim_us, sim_start_ms, sim_rtc_lag_us, sim_slow_every_us;
+
+static uint32_t SimTime_GetUs(void)
+{
+    return sim_us;
+}
+
+static uint32_t SimTime_TrueMs(void)
+{
+    uint64_t rtc_us = (uint64_t)sim_start_ms * 1000 + sim_us - sim_rtc_lag_us;
+    if (sim_slow_every_us != 0)
+    {
+        rtc_us -= sim_us / sim_slow_every_us;
+    }
+    return (uint32_t)((rtc_us / 1000) % TIME_24H_MS);
+}
+
+static void SimTime_GetTime(uint8_t *hour_24mode, uint8_t *minute, uint8_t *second)
+{
+    Epoch_MsToHms(SimTime_TrueMs(), hour_24mode, minute, second);
+}
+
+static void SimTime_GetTimeMs(uint8_t *hour_24mode, uint8_t *minute, uint8_t *second, uint16_t *millis)
+{
+    SimTime_GetTime(hour_24mode, minute, second);
+    *millis = SimTime_TrueMs() % 1000;
+}
+
+TEST(TimeTrackAlgorithm, U18_InterpolatesFromSubSeconds)
+{
+    // Production code, an RTC with a sub-second register at 08:00:00.500
+    uint32_t Output_ms1, Output_ms2, Output_ms3, Output_ms4, Edge_ms;
+    sim_us = 0;
+    sim_start_ms = 28800500;
+    sim_rtc_lag_us = 0;
+    sim_slow_every_us = 0;
+    testRtc.getTime = SimTime_GetTime;
+    testRtc.getTimeMs = SimTime_GetTimeMs;
+    TimeTrack_SetUsSource(SimTime_GetUs);
+    TimeTrack_Init();
+    TimeTrack_GetTimeMs(&Output_ms1);
+
+    sim_us = 123456;
+    TimeTrack_GetTimeMs(&Output_ms2);   // Between reads
+
+    sim_us = 167000;
+    TimeTrack_PeriodicCallback(TIMER_PERIOD_TEST_MS);
+    TimeTrack_Update();
+    TimeTrack_GetTimeMs(&Output_ms3);
+
+    sim_rtc_lag_us = 2000;              // The next read comes back behind what was shown
+    TimeTrack_PeriodicCallback(TIMER_PERIOD_TEST_MS);
+    TimeTrack_Update();
+    TimeTrack_GetTimeMs(&Output_ms4);
+    ClockStatus Probe = TimeTrack_NextEdgeMs(&Edge_ms);
+    TimeTrack_SetUsSource(NULL);
+
+    // Checks, no probing needed when the RTC has the phase itself
+    CHECK_EQUAL(28800500, Output_ms1);
+    CHECK_EQUAL(28800623, Output_ms2);
+    CHECK_EQUAL(28800667, Output_ms3);
+    CHECK_EQUAL(28800667, Output_ms4);
+    CHECK_EQUAL(CLOCK_FAIL, Probe);
+}
+
+TEST(TimeTrackAlgorithm, U19_LocksToSecondsOnlyRtc)
+{
+    // Production code, a seconds-only RTC 40 ppm slow with its edges 300.437 ms into the microsecond count,
+    // read at 6 Hz plus a probe where the next edge should be, like DozClock_TimerCallback does
+    uint32_t Output_ms, Prev_ms = 0, Error_ms, Max_error_ms = 0, Edge_ms, Probe_at;
+    bool Monotonic = true;
+    sim_us = 0;
+    sim_start_ms = 28800700;
+    sim_rtc_lag_us = 437;
+    sim_slow_every_us = 25000;
+    testRtc.getTime = SimTime_GetTime;
+    TimeTrack_SetUsSource(SimTime_GetUs);
+    TimeTrack_Init();
+
+    for (uint32_t tick = 1; tick <= 6 * 60; tick++)
+    {
+        TimeTrack_PeriodicCallback(TIMER_PERIOD_TEST_MS);
+        TimeTrack_Update();
+        Probe_at = (TimeTrack_NextEdgeMs(&Edge_ms) == CLOCK_OK && Edge_ms < TIMER_PERIOD_TEST_MS) ? Edge_ms : 0;
+
+        for (uint32_t ms = 1; ms <= TIMER_PERIOD_TEST_MS; ms++)
+        {
+            sim_us += 1000;
+            if (ms == Probe_at)
+            {
+                TimeTrack_Probe();
+            }
+            TimeTrack_GetTimeMs(&Output_ms);
+            if (tick > 6 * 20)
+            {
+                Error_ms = (Output_ms > SimTime_TrueMs()) ? Output_ms - SimTime_TrueMs() : SimTime_TrueMs() - Output_ms;
+                Max_error_ms = (Error_ms > Max_error_ms) ? Error_ms : Max_error_ms;
+                Monotonic = Monotonic && Output_ms >= Prev_ms;
+            }
+            Prev_ms = Output_ms;
+        }
+    }
+    TimeTrack_SetUsSource(NULL);
+
+    // Checks, within a millisecond once locked and never stepping back
+    CHECK(Max_error_ms <= 1);
+    CHECK(Monotonic);
+}
+
+// A day on a 64-bit timeline so the 32-bit microsecond count wraps under it, with the RTC's
+// phase moved by day_rtc_lag_us and GPS left unplugged
+static uint64_t day_us;
+static int64_t day_rtc_lag_us;
+
+static uint32_t DayTime_GetUs(void)
+{
+    return (uint32_t)day_us;
+}
+
+static uint32_t DayTime_TrueMs(void)
+{
+    return (uint32_t)((43200000000ULL + day_us - day_rtc_lag_us) / 1000 % TIME_24H_MS);
+}
+
+static void DayTime_GetTime(uint8_t *hour_24mode, uint8_t *minute, uint8_t *second)
+{
+    Epoch_MsToHms(DayTime_TrueMs(), hour_24mode, minute, second);
+}
+
+TEST(TimeTrackAlgorithm, U121_SlewsCorrectionsForADay)
+{
+    // Production code, a seconds-only RTC from noon to noon that is knocked up to 900 ms
+    // either way every 20 minutes, read at 6 Hz with the display polled every millisecond
+    uint32_t Output_ms, Prev_ms, Error_ms, Seed = 42;
+    bool Monotonic = true;
+    Gps Unplugged = {};
+    TimeSlew Slew;
+    day_us = 0;
+    day_rtc_lag_us = 0;
+    Gps_Init(&Unplugged);
+    testRtc.getTime = DayTime_GetTime;
+    TimeTrack_SetUsSource(DayTime_GetUs);
+    TimeTrack_Init();
+    TimeTrack_GetTimeMs(&Prev_ms);
+
+    for (uint32_t tick = 1; tick <= 6 * 86400; tick++)
+    {
+        if (tick % (6 * 1200) == 0 && tick < 6 * 86000)
+        {
+            Seed = Seed * 1103515245 + 12345;
+            day_rtc_lag_us += (int64_t)((Seed >> 8) % 1800001) - 900000;
+        }
+        TimeTrack_PeriodicCallback(TIMER_PERIOD_TEST_MS);
+        TimeTrack_Update();
+        for (uint32_t ms = 1; ms <= TIMER_PERIOD_TEST_MS; ms++)
+        {
+            day_us += 1000;
+            TimeTrack_GetTimeMs(&Output_ms);
+            Monotonic = Monotonic && (Output_ms + TIME_24H_MS - Prev_ms) % TIME_24H_MS < TIME_24H_MS / 2;
+            Prev_ms = Output_ms;
+        }
+    }
+    TimeTrack_GetSlew(&Slew);
+    TimeTrack_SetUsSource(NULL);
+    Error_ms = (Output_ms + TIME_24H_MS - DayTime_TrueMs()) % TIME_24H_MS;
+
+    // Checks, never back and never a step, caught up by the end
+    CHECK(Monotonic);
+    CHECK_EQUAL(0, Slew.steps);
+    CHECK(Slew.slews > 70);
+    CHECK(Error_ms <= 1 || Error_ms >= TIME_24H_MS - 1);
+    CHECK(Slew.residual_us < 1000 && Slew.residual_us > -1000);
+}
+
+static uint32_t day_reads;
+
+static void DayTime_CountedGetTime(uint8_t *hour_24mode, uint8_t *minute, uint8_t *second)
+{
+    day_reads++;
+    DayTime_GetTime(hour_24mode, minute, second);
+}
+
+TEST(TimeTrackAlgorithm, U122_ReadsOnceAtEachSecondEdge)
+{
+    // Production code, a seconds-only RTC with its 1 Hz interrupt for a minute, then the interrupt stops
+    uint32_t Output_ms, Prev_ms = 0, Error_ms, Max_error_ms = 0, Edge_reads = 0;
+    bool Monotonic = true;
+    Gps Unplugged = {};
+    day_us = 0;
+    day_rtc_lag_us = 123456;
+    day_reads = 0;
+    Gps_Init(&Unplugged);
+    testRtc.getTime = DayTime_CountedGetTime;
+    TimeTrack_SetUsSource(DayTime_GetUs);
+    TimeTrack_Init();
+
+    for (uint32_t tick = 1; tick <= 6 * 70; tick++)
+    {
+        TimeTrack_PeriodicCallback(TIMER_PERIOD_TEST_MS);
+        TimeTrack_Update();
+        for (uint32_t ms = 1; ms <= TIMER_PERIOD_TEST_MS; ms++)
+        {
+            day_us += 1000;
+            if (tick <= 6 * 60 && DayTime_TrueMs() % 1000 == 0)
+            {
+                TimeTrack_SecondEdge(DayTime_GetUs());
+            }
+            TimeTrack_GetTimeMs(&Output_ms);
+            if (tick > 6)
+            {
+                Error_ms = (Output_ms > DayTime_TrueMs()) ? Output_ms - DayTime_TrueMs() : DayTime_TrueMs() - Output_ms;
+                Max_error_ms = (Error_ms > Max_error_ms) ? Error_ms : Max_error_ms;
+                Monotonic = Monotonic && Output_ms >= Prev_ms;
+            }
+            Prev_ms = Output_ms;
+        }
+        if (tick == 6 * 60)
+        {
+            Edge_reads = day_reads;
+        }
+    }
+    TimeTrack_SetUsSource(NULL);
+
+    // Checks, one read a second (plus Init and the first tick before any edge) and locked
+    // from the first edge, polling at 6 Hz again once the interrupt has been gone for EDGE_LOST_MS
+    CHECK(Edge_reads <= 63);
+    CHECK(day_reads - Edge_reads > 6 * 7);
+    CHECK(Max_error_ms <= 1);
+    CHECK(Monotonic);
+}
+
+// GPS on the same timeline with no lag, each second's sentence has its '$' day_gps_delay_us after
+// the top of that second. The clock reads as it is read, so waiting on it in a loop moves it on.
+static uint32_t day_gps_delay_us;
+
+static uint32_t DayTime_ReadUs(void)
+{
+    return (uint32_t)++day_us;
+}
+
+static int64_t DayTime_GpsSecondUs(void)
+{
+    return (43200000000LL + (int64_t)day_us - day_gps_delay_us) / 1000000 * 1000000;
+}
+
+static float DayTime_GpsUtc(void)
+{
+    uint32_t Second = (DayTime_GpsSecondUs() / 1000000) % 86400;
+    return (float)(Second / 3600 * 10000 + Second / 60 % 60 * 100 + Second % 60);
+}
+
+static uint32_t DayTime_GpsUtcUs(void)
+{
+    return (uint32_t)(DayTime_GpsSecondUs() + day_gps_delay_us - 43200000000LL);
+}
+
+static unsigned DayTime_GpsConnected(void)
+{
+    return 1;
+}
+
+static void DayTime_SetTimeDate(uint8_t hour_24mode, uint8_t minute, uint8_t second, uint8_t, uint8_t)
+{
+    day_rtc_lag_us = 43200000000LL + (int64_t)day_us - ((int64_t)hour_24mode * 3600 + minute * 60 + second) * 1000000;
+}
+
+TEST(TimeTrackAlgorithm, U123_GpsSyncWritesRtcOnGpsSecond)
+{
+    // Production code, a seconds-only RTC 600 ms behind a GPS whose sentences start 350 ms after
+    // their second, read at 6 Hz with the probe where TimeTrack asks for it, past the hourly sync
+    uint32_t Output_ms, Error_ms, Max_error_ms = 0, Edge_ms, Probe_at, Synced_tick = 0;
+    Gps Stamped = {};
+    Stamped.getUtcTime = DayTime_GpsUtc;
+    Stamped.gpsConnected = DayTime_GpsConnected;
+    Stamped.getUtcTimeUs = DayTime_GpsUtcUs;
+    Stamped.latency_us = 350000;
+    TimeSlew Slew;
+    day_us = 0;
+    day_rtc_lag_us = 600000;
+    day_gps_delay_us = 350000;
+    Gps_Init(&Stamped);
+    testRtc.getTime = DayTime_GetTime;
+    testRtc.setTimeDate = DayTime_SetTimeDate;
+    TimeTrack_SetUsSource(DayTime_ReadUs);
+    TimeTrack_Init();
+
+    for (uint32_t tick = 1; tick <= 6 * 3700; tick++)
+    {
+        TimeTrack_PeriodicCallback(TIMER_PERIOD_TEST_MS);
+        TimeTrack_Update();
+        Probe_at = (TimeTrack_NextEdgeMs(&Edge_ms) == CLOCK_OK && Edge_ms < TIMER_PERIOD_TEST_MS) ? Edge_ms : 0;
+
+        for (uint32_t ms = 1; ms <= TIMER_PERIOD_TEST_MS; ms++)
+        {
+            day_us += 1000;
+            if (ms == Probe_at)
+            {
+                TimeTrack_Probe();
+            }
+            TimeTrack_GetTimeMs(&Output_ms);
+            if (Synced_tick != 0 && tick > Synced_tick + 6 * 30)
+            {
+                Error_ms = (Output_ms > DayTime_TrueMs()) ? Output_ms - DayTime_TrueMs() : DayTime_TrueMs() - Output_ms;
+                Max_error_ms = (Error_ms > Max_error_ms) ? Error_ms : Max_error_ms;
+            }
+        }
+        if (Synced_tick == 0 && day_rtc_lag_us != 600000)
+        {
+            Synced_tick = tick;
+        }
+    }
+    TimeTrack_GetSlew(&Slew);
+    TimeTrack_SetUsSource(NULL);
+    testRtc.setTimeDate = NULL;
+
+    // Checks, the RTC's second starts within a millisecond of the GPS's and the shown time slews onto it
+    CHECK(Synced_tick != 0);
+    CHECK(day_rtc_lag_us >= 0 && day_rtc_lag_us < 1000);
+    CHECK(Max_error_ms <= 1);
+    CHECK_EQUAL(0, Slew.steps);
+}
+
+static uint32_t DayTime_GpsMs(void)
+{
+    return (uint32_t)((43200000000ULL + day_us) / 1000 % TIME_24H_MS);
+}
+
+TEST(TimeTrackAlgorithm, U124_FollowsPpsThenFallsBackToRtc)
+{
+    // Production code, a seconds-only RTC 250 ms behind the GPS. Its PPS is captured on every
+    // second for a minute, each labelled by a sentence starting 350 ms later, then it stops.
+    uint32_t Output_ms, Pps_mismatches = 0, Error_ms, Max_rtc_error_ms = 0, Edge_ms, Probe_at;
+    static Gps Stamped, Unplugged;
+    memset(&Stamped, 0, sizeof(Stamped));
+    Stamped.getUtcTime = DayTime_GpsUtc;
+    Stamped.gpsConnected = DayTime_GpsConnected;
+    Stamped.getUtcTimeUs = DayTime_GpsUtcUs;
+    Stamped.latency_us = 350000;
+    day_us = 0;
+    day_rtc_lag_us = 250000;
+    day_gps_delay_us = 350000;
+    Gps_Init(&Stamped);
+    testRtc.getTime = DayTime_GetTime;
+    TimeTrack_SetUsSource(DayTime_GetUs);
+    TimeTrack_Init();
+
+    for (uint32_t tick = 1; tick <= 6 * 120; tick++)
+    {
+        TimeTrack_PeriodicCallback(TIMER_PERIOD_TEST_MS);
+        TimeTrack_Update();
+        Probe_at = (TimeTrack_NextEdgeMs(&Edge_ms) == CLOCK_OK && Edge_ms < TIMER_PERIOD_TEST_MS) ? Edge_ms : 0;
+
+        for (uint32_t ms = 1; ms <= TIMER_PERIOD_TEST_MS; ms++)
+        {
+            day_us += 1000;
+            if (tick <= 6 * 60 && DayTime_GpsMs() % 1000 == 0)
+            {
+                Gps_PpsEdge(DayTime_GetUs());
+            }
+            if (ms == Probe_at)
+            {
+                TimeTrack_Probe();
+            }
+            TimeTrack_GetTimeMs(&Output_ms);
+            if (tick > 6 * 30 && tick <= 6 * 60)
+            {
+                Pps_mismatches += (Output_ms != DayTime_GpsMs());
+            }
+            if (tick > 6 * 90)
+            {
+                Error_ms = (Output_ms > DayTime_TrueMs()) ? Output_ms - DayTime_TrueMs() : DayTime_TrueMs() - Output_ms;
+                Max_rtc_error_ms = (Error_ms > Max_rtc_error_ms) ? Error_ms : Max_rtc_error_ms;
+            }
+        }
+    }
+    TimeTrack_SetUsSource(NULL);
+    Gps_Init(&Unplugged);
+
+    // Checks, every millisecond matches the GPS while the pulses come, then back on the RTC
+    CHECK_EQUAL(0, Pps_mismatches);
+    CHECK(Max_rtc_error_ms <= 1);
+}
+
+// A GPS without stamps that can lose its fix and can be knocked off the true time by whole seconds
+static uint8_t day_gps_fix;
+static int32_t day_gps_shift_s;
+
+static float DayTime_ShiftedGpsUtc(void)
+{
+    uint32_t Second = (uint32_t)((DayTime_GpsSecondUs() / 1000000 + 86400 + day_gps_shift_s) % 86400);
+    return (float)(Second / 3600 * 10000 + Second / 60 % 60 * 100 + Second % 60);
+}
+
+static uint8_t DayTime_GpsFix(void)
+{
+    return day_gps_fix;
+}
+
+static void DayTime_RunTicks(uint32_t ticks)
+{
+    for (uint32_t tick = 0; tick < ticks; tick++)
+    {
+        TimeTrack_PeriodicCallback(TIMER_PERIOD_TEST_MS);
+        TimeTrack_Update();
+        day_us += 1000 * TIMER_PERIOD_TEST_MS;
+    }
+}
+
+TEST(TimeTrackAlgorithm, U125_ScoresGpsAndHoldsOver)
+{
+    // Production code, a seconds-only RTC 300 ms behind a GPS that has no fix at the first
+    // hourly sync, then gets one. An hour later the GPS is 30 s out.
+    TimeQuality No_fix, Synced, Outlier, Confirmed;
+    static Gps Unstamped, Unplugged;
+    memset(&Unstamped, 0, sizeof(Unstamped));
+    Unstamped.getUtcTime = DayTime_ShiftedGpsUtc;
+    Unstamped.gpsConnected = DayTime_GpsConnected;
+    Unstamped.getFix = DayTime_GpsFix;
+    day_us = 0;
+    day_rtc_lag_us = 300000;
+    day_gps_delay_us = 0;
+    day_gps_fix = 0;
+    day_gps_shift_s = 0;
+    Gps_Init(&Unstamped);
+    testRtc.getTime = DayTime_GetTime;
+    testRtc.setTimeDate = DayTime_SetTimeDate;
+    TimeTrack_SetUsSource(DayTime_GetUs);
+    TimeTrack_Init();
+
+    DayTime_RunTicks(6 * 3610);
+    TimeTrack_GetQuality(&No_fix);
+    day_gps_fix = 1;
+    DayTime_RunTicks(6 * 10);
+    TimeTrack_GetQuality(&Synced);
+    day_gps_shift_s = 30;
+    DayTime_RunTicks(6 * 3580);
+    do
+    {
+        DayTime_RunTicks(1);
+        TimeTrack_GetQuality(&Outlier);
+    } while (Outlier.outliers == 0 && day_us < 7300000000LL);
+    DayTime_RunTicks(6 * 10);
+    TimeTrack_GetQuality(&Confirmed);
+    TimeTrack_SetUsSource(NULL);
+    testRtc.setTimeDate = NULL;
+    Gps_Init(&Unplugged);
+
+    // Checks, nothing taken without a fix. The first outlier holds over with the bound grown by
+    // an hour of undisciplined drift, and the run that agrees with it is taken.
+    CHECK_EQUAL(TIME_SRC_RTC, No_fix.source);
+    CHECK(No_fix.no_fix > 0);
+    CHECK_EQUAL(TIME_UNCERT_UNKNOWN, No_fix.uncertainty_us);
+    CHECK_EQUAL(TIME_SRC_GPS, Synced.source);
+    CHECK_EQUAL(1, Synced.syncs);
+    CHECK(Synced.uncertainty_us >= 1000000 && Synced.uncertainty_us < 1000000 + 10 * 20);
+    CHECK_EQUAL(TIME_SRC_HOLDOVER, Outlier.source);
+    CHECK_EQUAL(1, Outlier.outliers);
+    CHECK(Outlier.uncertainty_us >= 1000000 + 3600 * 20);
+    CHECK_EQUAL(TIME_SRC_GPS, Confirmed.source);
+    CHECK_EQUAL(2, Confirmed.syncs);
+    CHECK_EQUAL(3, Confirmed.outliers);
+    CHECK(Confirmed.uncertainty_us < Outlier.uncertainty_us);
+}
+
+// A dated RTC, only its setters move the date, and a GPS whose RMC date turns over with its UTC
+static uint8_t day_rtc_day, day_rtc_month;
+static uint16_t day_rtc_year;
+
+static uint8_t DayTime_GetDay(void)
+{
+    return day_rtc_day;
+}
+
+static uint8_t DayTime_GetMonth(void)
+{
+    return day_rtc_month;
+}
+
+static uint16_t DayTime_GetYear(void)
+{
+    return day_rtc_year;
+}
+
+static void DayTime_SetYear(uint16_t year)
+{
+    day_rtc_year = year;
+}
+
+static void DayTime_SetDated(uint8_t hour_24mode, uint8_t minute, uint8_t second, uint8_t day, uint8_t month)
+{
+    DayTime_SetTimeDate(hour_24mode, minute, second, day, month);
+    day_rtc_day = day;
+    day_rtc_month = month;
+}
+
+static uint32_t DayTime_GpsDate(void)
+{
+    return (DayTime_GpsSecondUs() < 86400000000LL) ? 311225 : 10126;
+}
+
+TEST(TimeTrackAlgorithm, U126_DateRollsOverMidnight)
+{
+    // Production code, a seconds-only RTC set to noon on New Year's Eve run past midnight
+    // with a GPS synced every hour
+    ClockDate Eve, New_year;
+    EpochMs Epoch_ms;
+    static Gps Dated, Unplugged;
+    memset(&Dated, 0, sizeof(Dated));
+    Dated.getUtcTime = DayTime_ShiftedGpsUtc;
+    Dated.gpsConnected = DayTime_GpsConnected;
+    Dated.getFix = DayTime_GpsFix;
+    Dated.getDate = DayTime_GpsDate;
+    day_us = 0;
+    day_rtc_lag_us = 0;
+    day_gps_delay_us = 0;
+    day_gps_fix = 1;
+    day_gps_shift_s = 0;
+    day_rtc_day = 31;
+    day_rtc_month = 12;
+    day_rtc_year = 2025;
+    Gps_Init(&Dated);
+    testRtc.getTime = DayTime_GetTime;
+    testRtc.setTimeDate = DayTime_SetDated;
+    testRtc.getDay = DayTime_GetDay;
+    testRtc.getMonth = DayTime_GetMonth;
+    testRtc.getYear = DayTime_GetYear;
+    testRtc.setYear = DayTime_SetYear;
+    TimeTrack_SetUsSource(DayTime_GetUs);
+    TimeTrack_Init();
+
+    DayTime_RunTicks((12 * 3600 - 60) * 1000 / TIMER_PERIOD_TEST_MS);
+    TimeTrack_GetDate(&Eve);
+    DayTime_RunTicks(3600 * 1000 / TIMER_PERIOD_TEST_MS);
+    TimeTrack_GetDate(&New_year);
+    TimeTrack_GetEpochMs(&Epoch_ms);
+    TimeTrack_SetUsSource(NULL);
+    testRtc.setTimeDate = NULL;
+    testRtc.getDay = NULL;
+    testRtc.getMonth = NULL;
+    testRtc.getYear = NULL;
+    testRtc.setYear = NULL;
+    Gps_Init(&Unplugged);
+
+    // Checks, the day turns over with the time and the sync after midnight dates the RTC from the GPS
+    CHECK_EQUAL(2025, Eve.year);
+    CHECK_EQUAL(12, Eve.month);
+    CHECK_EQUAL(31, Eve.day);
+    CHECK_EQUAL(2026, New_year.year);
+    CHECK_EQUAL(1, New_year.month);
+    CHECK_EQUAL(1, New_year.day);
+    CHECK(Epoch_ms / EPOCH_DAY_MS == Epoch_FromDate(&New_year, 0) / EPOCH_DAY_MS);
+    CHECK_EQUAL(DayTime_TrueMs() / 1000, Epoch_TimeOfDay(Epoch_ms) / 1000);
+    CHECK_EQUAL(1, day_rtc_day);
+    CHECK_EQUAL(1, day_rtc_month);
+    CHECK_EQUAL(2026, day_rtc_year);
+}
@@ -9,7 +9,7 @@ extern "C"
 
 Display display;
 ClockStatus status;
-ExternVars vars;
+SnapshotPub vars;
 
 /*
     Mock Functions
@@ -0,0 +1,684 @@
+/*
+ * flight_replay.c
+ * Replays a flight recorder dump through the shared clock code on the host
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: Matt L.
+ *
+ * doz_clock.c, display.c and time_track.c run unchanged against virtual
+ * RTC, GPS, buzzer and display drivers. Recorded events are injected at
+ * their recorded tick and the scheduler is stepped in virtual time, so a
+ * day of dump replays in well under a minute and the same dump always
+ * gives the same frames. The state changes the replay makes are checked
+ * against the ones the clock recorded.
+ *
+ * Usage: flight_replay.out [-v] [-o replayed_dump] dump
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "doz_clock.h"
+#include "flight_recorder.h"
+
+#define MAX_RECORDS     32768
+#define NUM_REGIONS     3
+#define SETTLE_MS       2000    // Keep running after the last record so its effects are drawn
+#define FNV_OFFSET      2166136261UL
+#define FNV_PRIME       16777619UL
+
+typedef struct button_event_t
+{
+    EventId         id;
+    BtnId           button;
+    BtnPressType    type;
+} ButtonEvent;
+
+typedef struct replay_result_t
+{
+    uint32_t    events;
+    uint32_t    frames;
+    uint32_t    frame_hash;     // Every frame drawn, in order
+    uint32_t    buzzer_starts;
+} ReplayResult;
+
+/*
+    Private function definitions
+*/
+static int loadDump(const char *path, FlightRecord *output, int max);
+static void replay(FlightRecord *dump, int count, ReplayResult *result);
+static void stepTo(uint32_t tick_ms, ReplayResult *result);
+static void inject(FlightRecord *record);
+static int compareTransitions(FlightRecord *dump, int count, FlightRecType type, const char *name);
+static void captureFrame(ReplayResult *result);
+static uint32_t fnv(uint32_t hash, const uint8_t *buf, uint32_t len);
+static void writeDump(uint8_t *buf, uint16_t len);
+
+// Virtual drivers
+static uint32_t getTick(void);
+static uint32_t trueTimeMs(void);
+static void setTrueTime(uint32_t time_ms);
+static void rtcSetTime(uint8_t hr, uint8_t min, uint8_t sec);
+static void rtcGetTime(uint8_t *hr, uint8_t *min, uint8_t *sec);
+static void rtcSetDay(uint8_t day);
+static void rtcSetMonth(uint8_t month);
+static uint8_t rtcGetDay(void);
+static uint8_t rtcGetMonth(void);
+static void rtcSetAlarm(uint8_t id, uint8_t hr, uint8_t min, uint8_t sec);
+static void rtcGetAlarm(uint8_t id, uint8_t *hr, uint8_t *min, uint8_t *sec);
+static void rtcEnableAlarm(uint8_t id, bool enable);
+static bool rtcGetAlarmStatus(uint8_t id);
+static bool rtcSetCalibration(int32_t calib);
+static int32_t rtcGetCalibration(void);
+static float gpsGetUtcTime(void);
+static unsigned gpsConnected(void);
+static void buzzerStart(void);
+static void buzzerStop(void);
+static void buzzerSetOutputLevel(uint32_t dc);
+static void displayOff(void);
+static void displayOn(void);
+static void setBrightness(uint8_t brightness);
+static void setBitmap(uint8_t region_id, uint8_t *bitmap);
+static void setColour(uint8_t region_id, Colour colour_id);
+static void show(uint8_t region_id);
+static void hide(uint8_t region_id);
+static void errorHandler(void);
+
+/*
+    Private variables
+*/
+static const ButtonEvent button_events[] =
+{
+    {E_DISPLAY_SHORT, B_DISPLAY, SHORT},    {E_DISPLAY_LONG, B_DISPLAY, LONG},
+    {E_ALARM_SHORT, B_ALARM, SHORT},        {E_ALARM_LONG, B_ALARM, LONG},
+    {E_TIMER_SHORT, B_TIMER, SHORT},        {E_TIMER_LONG, B_TIMER, LONG},
+    {E_LEFT_SHORT, B_LEFT, SHORT},          {E_LEFT_LONG, B_LEFT, LONG},
+    {E_RIGHT_SHORT, B_RIGHT, SHORT},        {E_RIGHT_LONG, B_RIGHT, LONG},
+    {E_UP_SHORT, B_UP, SHORT},              {E_UP_LONG, B_UP, LONG},
+    {E_DOWN_SHORT, B_DOWN, SHORT},          {E_DOWN_LONG, B_DOWN, LONG},
+    {E_DOZ_SHORT, B_DOZ, SHORT},            {E_DOZ_LONG, B_DOZ, LONG},
+    {E_TRAD_SHORT, B_TRAD, SHORT},          {E_TRAD_LONG, B_TRAD, LONG},
+    {E_VOLUP_SHORT, B_VOLUP, SHORT},        {E_VOLUP_LONG, B_VOLUP, LONG},
+    {E_VOLDOWN_SHORT, B_VOLDOWN, SHORT},    {E_VOLDOWN_LONG, B_VOLDOWN, LONG},
+    {E_CANCEL_SHORT, B_CANCEL, SHORT},      {E_CANCEL_LONG, B_CANCEL, LONG},
+};
+
+static FlightRecord dump[MAX_RECORDS];
+static bool verbose = false;
+static FILE *out_file = NULL;
+
+// Virtual time, true_ms is the time of day at true_tick_ms
+static uint32_t tick_ms;
+static uint32_t true_ms, true_tick_ms;
+static bool has_gps;
+static int32_t calib;
+static RtcTime alarms[3];
+static bool alarm_enabled[3];
+
+// Display as last drawn
+static uint8_t regions[NUM_REGIONS][LARGE_BITMAP_SIZE];
+static uint8_t colours[NUM_REGIONS];
+static bool visible[NUM_REGIONS];
+static bool display_on;
+static uint8_t display_brightness;
+static uint32_t last_frame = 0;
+static bool buzzer_on;
+static uint32_t buzzer_starts;
+
+static Rtc rtc =
+{
+    .setRtcTime = rtcSetTime,
+    .getTime = rtcGetTime,
+    .setDay = rtcSetDay,
+    .setMonth = rtcSetMonth,
+    .getDay = rtcGetDay,
+    .getMonth = rtcGetMonth,
+    .setAlarm = rtcSetAlarm,
+    .getAlarm = rtcGetAlarm,
+    .enableAlarm = rtcEnableAlarm,
+    .getAlarmStatus = rtcGetAlarmStatus,
+    .setCalibration = rtcSetCalibration,
+    .getCalibration = rtcGetCalibration,
+    .max_calib = 511,
+};
+
+static Gps gps =
+{
+    .getUtcTime = gpsGetUtcTime,
+    .gpsConnected = gpsConnected,
+};
+
+static Buzzer buzzer =
+{
+    .start = buzzerStart,
+    .stop = buzzerStop,
+    .setOutputLevel = buzzerSetOutputLevel,
+};
+
+static Display display =
+{
+    .displayOff = displayOff,
+    .displayOn = displayOn,
+    .setBrightness = setBrightness,
+    .setBitmap = setBitmap,
+    .setColour = setColour,
+    .show = show,
+    .hide = hide,
+    .setState = NULL,
+};
+
+static DozClock doz_clock =
+{
+    .buzzer = &buzzer,
+    .display = &display,
+    .gps = &gps,
+    .rtc = &rtc,
+    .error_handler = errorHandler,
+};
+
+/*
+    Public functions
+*/
+int main(int argc, char *argv[])
+{
+    ReplayResult result = { 0 };
+    struct timespec start, end;
+    int opt, count, mismatches;
+
+    while ((opt = getopt(argc, argv, "vo:")) != -1)
+    {
+        switch (opt)
+        {
+            case 'v':
+                verbose = true;
+                break;
+            case 'o':
+                out_file = fopen(optarg, "w");
+                if (out_file == NULL)
+                {
+                    perror(optarg);
+                    return 1;
+                }
+                break;
+            default:
+                fprintf(stderr, "usage: %s [-v] [-o replayed_dump] dump\n", argv[0]);
+                return 1;
+        }
+    }
+    if (optind >= argc)
+    {
+        fprintf(stderr, "usage: %s [-v] [-o replayed_dump] dump\n", argv[0]);
+        return 1;
+    }
+
+    count = loadDump(argv[optind], dump, MAX_RECORDS);
+    if (count <= 0)
+    {
+        fprintf(stderr, "flight_replay: no records in %s\n", argv[optind]);
+        return 1;
+    }
+    if (dump[0].type != REC_BOOT)
+    {
+        printf("Dump does not start at boot, the replay starts from power-on state and may differ early on\n");
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    replay(dump, count, &result);
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    double wall_s = (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9;
+    double virtual_s = (tick_ms - dump[0].tick_ms) / 1000.0;
+
+    printf("Records         %d\n", count);
+    printf("Events          %u\n", result.events);
+    mismatches = compareTransitions(dump, count, REC_CLOCK_STATE, "Clock states");
+    mismatches += compareTransitions(dump, count, REC_DISPLAY_STATE, "Display states");
+    printf("Frames          %u (hash %08X)\n", result.frames, result.frame_hash);
+    printf("Buzzer starts   %u\n", result.buzzer_starts);
+    printf("Replayed        %.1f s in %.3f s (%.0fx real time)\n", virtual_s, wall_s,
+           (wall_s > 0) ? virtual_s / wall_s : 0);
+
+    if (out_file != NULL)
+    {
+        FlightRec_Dump(writeDump);
+        fclose(out_file);
+    }
+    return (mismatches == 0) ? 0 : 2;
+}
+
+/*
+    Private functions
+*/
+static int loadDump(const char *path, FlightRecord *output, int max)
+{
+    char line[128];
+    int count = 0;
+    FILE *file = fopen(path, "r");
+
+    if (file == NULL)
+    {
+        perror(path);
+        return -1;
+    }
+    while (fgets(line, sizeof(line), file) != NULL && count < max)
+    {
+        // Header, END and any terminal noise around the dump fail to parse
+        if (strlen(line) >= FLIGHTREC_LINE_SIZE - 2 && FlightRec_ParseLine(line, &output[count]) == CLOCK_OK)
+        {
+            count++;
+        }
+    }
+    fclose(file);
+    return count;
+}
+
+static void replay(FlightRecord *records, int count, ReplayResult *result)
+{
+    bool seeded = false;
+
+    tick_ms = records[0].tick_ms;
+
+    // The RTC must read what the clock read at boot, before its sync record comes up
+    for (int i = 0; i < count; i++)
+    {
+        if (records[i].type == REC_RTC_SYNC || records[i].type == REC_GPS_SYNC)
+        {
+            true_ms = records[i].value;
+            true_tick_ms = records[i].tick_ms;
+            seeded = true;
+            break;
+        }
+    }
+    if (!seeded)
+    {
+        true_tick_ms = tick_ms;
+    }
+    has_gps = false;
+    for (int i = 0; i < count; i++)
+    {
+        has_gps = has_gps || records[i].type == REC_GPS_SYNC;
+    }
+
+    FlightRec_Init(getTick);
+    EventQ_SetTickSource(getTick);
+    DozClock_Init(&doz_clock);
+    Sched_Init(getTick, NULL);
+    DozClock_StartTasks();
+    captureFrame(result);
+
+    for (int i = 1; i < count; i++)
+    {
+        stepTo(records[i].tick_ms, result);
+        switch (records[i].type)
+        {
+            case REC_EVENT:
+                inject(&records[i]);
+                DozClock_Update();
+                captureFrame(result);
+                result->events++;
+                break;
+            case REC_RTC_SYNC:
+            case REC_GPS_SYNC:
+                // The clock found the time had moved, move the virtual RTC and GPS with it
+                setTrueTime(records[i].value);
+                break;
+            case REC_BOOT:
+                printf("Clock restarted at %u ms, replay stops there\n", records[i].tick_ms);
+                result->buzzer_starts = buzzer_starts;
+                return;
+            default:
+                break;
+        }
+    }
+    stepTo(tick_ms + SETTLE_MS, result);
+    result->buzzer_starts = buzzer_starts;
+}
+
+// Run the scheduled clock tasks up to target_ms, skipping straight over idle time
+static void stepTo(uint32_t target_ms, ReplayResult *result)
+{
+    SchedStats stats;
+    uint32_t runs, idle_ms;
+
+    Sched_GetStats(&stats);
+    runs = stats.runs;
+    while ((int32_t)(target_ms - tick_ms) > 0)
+    {
+        idle_ms = Sched_IdleMs(target_ms - tick_ms);
+        tick_ms += (idle_ms > 0) ? idle_ms : 1;
+        Sched_Run();
+        Sched_GetStats(&stats);
+        if (stats.runs != runs)
+        {
+            runs = stats.runs;
+            captureFrame(result);
+        }
+    }
+}
+
+static void inject(FlightRecord *record)
+{
+    EventId id = record->code;
+
+    if (verbose)
+    {
+        printf("%10u  event %d x%u\n", tick_ms, id, record->arg);
+    }
+    switch (id)
+    {
+        case E_ALARM_TRIG:
+            EventQ_TriggerAlarmEvent(ALARM_TRIG);
+            return;
+        case E_TIMER_TRIG:
+            EventQ_TriggerAlarmEvent(TIMER_TRIG);
+            return;
+        case E_ROOM_LIGHT:
+            EventQ_TriggerLightEvent(LIGHT_ROOM);
+            return;
+        case E_ROOM_DARK:
+            EventQ_TriggerLightEvent(DARK_ROOM);
+            return;
+        case E_UP_REPEAT:
+        case E_DOWN_REPEAT:
+            EventQ_TriggerButtonRepeat((id == E_UP_REPEAT) ? B_UP : B_DOWN, record->arg);
+            return;
+        case E_UP_SHORT:
+        case E_DOWN_SHORT:
+            if (record->arg > 1)
+            {
+                // Older dumps logged a held key as a short press with its steps
+                EventQ_TriggerButtonRepeat((id == E_UP_SHORT) ? B_UP : B_DOWN, record->arg);
+                return;
+            }
+            break;
+        default:
+            break;
+    }
+    for (size_t i = 0; i < sizeof(button_events) / sizeof(button_events[0]); i++)
+    {
+        if (button_events[i].id == id)
+        {
+            EventQ_TriggerButtonEvent(button_events[i].button, button_events[i].type);
+            return;
+        }
+    }
+    printf("Unknown event %d at %u ms skipped\n", id, record->tick_ms);
+}
+
+// Compares the state changes the clock recorded against the ones the replay made, in order
+static int compareTransitions(FlightRecord *records, int count, FlightRecType type, const char *name)
+{
+    FlightRecord replayed;
+    int recorded_n = 0, replayed_n = 0, matched = 0;
+    int r = 0;
+    bool diverged = false;
+
+    for (uint16_t i = 0; i < FlightRec_Count(); i++)
+    {
+        FlightRec_Get(i, &replayed);
+        if (replayed.type != type)
+        {
+            continue;
+        }
+        replayed_n++;
+        while (r < count && records[r].type != type)
+        {
+            r++;
+        }
+        if (r >= count)
+        {
+            continue;
+        }
+        if (!diverged && records[r].code == replayed.code && records[r].arg == replayed.arg)
+        {
+            matched++;
+        }
+        else if (!diverged)
+        {
+            diverged = true;
+            printf("%s diverge at change %d: recorded %u -> %u at %u ms, replayed %u -> %u at %u ms\n", name,
+                   matched + 1, records[r].arg, records[r].code, records[r].tick_ms, replayed.arg, replayed.code,
+                   replayed.tick_ms);
+        }
+        r++;
+    }
+    for (int i = 0; i < count; i++)
+    {
+        recorded_n += (records[i].type == type);
+    }
+    printf("%-15s %d recorded, %d replayed, %d matched\n", name, recorded_n, replayed_n, matched);
+    return (matched == recorded_n && matched == replayed_n) ? 0 : 1;
+}
+
+// Folds the display into the frame hash whenever what it shows changes
+static void captureFrame(ReplayResult *result)
+{
+    uint32_t hash = FNV_OFFSET;
+
+    hash = fnv(hash, (uint8_t *)&display_on, sizeof(display_on));
+    if (display_on)
+    {
+        hash = fnv(hash, &display_brightness, 1);
+        for (int i = 0; i < NUM_REGIONS; i++)
+        {
+            hash = fnv(hash, (uint8_t *)&visible[i], sizeof(visible[i]));
+            if (visible[i])
+            {
+                hash = fnv(hash, &colours[i], 1);
+                hash = fnv(hash, regions[i], LARGE_BITMAP_SIZE);
+            }
+        }
+    }
+    if (hash == last_frame)
+    {
+        return;
+    }
+    last_frame = hash;
+    result->frames++;
+    result->frame_hash = fnv((result->frame_hash == 0) ? FNV_OFFSET : result->frame_hash, (uint8_t *)&hash,
+                             sizeof(hash));
+    if (verbose)
+    {
+        printf("%10u  frame %08X\n", tick_ms, hash);
+    }
+}
+
+static uint32_t fnv(uint32_t hash, const uint8_t *buf, uint32_t len)
+{
+    for (uint32_t i = 0; i < len; i++)
+    {
+        hash = (hash ^ buf[i]) * FNV_PRIME;
+    }
+    return hash;
+}
+
+static void writeDump(uint8_t *buf, uint16_t len)
+{
+    fwrite(buf, 1, len, out_file);
+}
+
+// Virtual drivers
+static uint32_t getTick(void)
+{
+    return tick_ms;
+}
+
+static uint32_t trueTimeMs(void)
+{
+    // The boot seed can come from a sync logged a few ms after the clock first reads the RTC
+    int32_t elapsed_ms = (int32_t)(tick_ms - true_tick_ms);
+    return (true_ms + TIME_24H_MS + elapsed_ms) % TIME_24H_MS;
+}
+
+static void setTrueTime(uint32_t time_ms)
+{
+    true_ms = time_ms;
+    true_tick_ms = tick_ms;
+}
+
+static void rtcSetTime(uint8_t hr, uint8_t min, uint8_t sec)
+{
+    setTrueTime(hr * 3600000UL + min * 60000UL + sec * 1000UL);
+}
+
+static void rtcGetTime(uint8_t *hr, uint8_t *min, uint8_t *sec)
+{
+    uint32_t now_s = trueTimeMs() / 1000;
+    *hr = now_s / 3600;
+    *min = (now_s / 60) % 60;
+    *sec = now_s % 60;
+}
+
+static void rtcSetDay(uint8_t day)
+{
+    UNUSED(day);
+}
+
+static void rtcSetMonth(uint8_t month)
+{
+    UNUSED(month);
+}
+
+static uint8_t rtcGetDay(void)
+{
+    return 1;
+}
+
+static uint8_t rtcGetMonth(void)
+{
+    return 1;
+}
+
+static void rtcSetAlarm(uint8_t id, uint8_t hr, uint8_t min, uint8_t sec)
+{
+    if (id < 3)
+    {
+        alarms[id].hr = hr;
+        alarms[id].min = min;
+        alarms[id].sec = sec;
+    }
+}
+
+static void rtcGetAlarm(uint8_t id, uint8_t *hr, uint8_t *min, uint8_t *sec)
+{
+    if (id < 3)
+    {
+        *hr = alarms[id].hr;
+        *min = alarms[id].min;
+        *sec = alarms[id].sec;
+    }
+}
+
+static void rtcEnableAlarm(uint8_t id, bool enable)
+{
+    if (id < 3)
+    {
+        alarm_enabled[id] = enable;
+    }
+}
+
+static bool rtcGetAlarmStatus(uint8_t id)
+{
+    return id < 3 && alarm_enabled[id];
+}
+
+static bool rtcSetCalibration(int32_t value)
+{
+    if (value > rtc.max_calib || value < -rtc.max_calib)
+    {
+        return false;
+    }
+    calib = value;
+    return true;
+}
+
+static int32_t rtcGetCalibration(void)
+{
+    return calib;
+}
+
+static float gpsGetUtcTime(void)
+{
+    uint32_t now_s = trueTimeMs() / 1000;
+    return (float)((now_s / 3600) * 10000 + ((now_s / 60) % 60) * 100 + now_s % 60);
+}
+
+// Only dumps that show a GPS sync had a GPS to sync from
+static unsigned gpsConnected(void)
+{
+    return has_gps;
+}
+
+static void buzzerStart(void)
+{
+    buzzer_starts += !buzzer_on;
+    buzzer_on = true;
+    if (verbose)
+    {
+        printf("%10u  buzzer on\n", tick_ms);
+    }
+}
+
+static void buzzerStop(void)
+{
+    buzzer_on = false;
+}
+
+static void buzzerSetOutputLevel(uint32_t dc)
+{
+    UNUSED(dc);
+}
+
+static void displayOff(void)
+{
+    display_on = false;
+}
+
+static void displayOn(void)
+{
+    display_on = true;
+}
+
+static void setBrightness(uint8_t brightness)
+{
+    display_brightness = brightness;
+}
+
+static void setBitmap(uint8_t region_id, uint8_t *bitmap)
+{
+    if (region_id < NUM_REGIONS)
+    {
+        memcpy(regions[region_id], bitmap, (region_id == ROW_2) ? LARGE_BITMAP_SIZE : SMALL_BITMAP_SIZE);
+    }
+}
+
+static void setColour(uint8_t region_id, Colour colour_id)
+{
+    if (region_id < NUM_REGIONS)
+    {
+        colours[region_id] = colour_id;
+    }
+}
+
+static void show(uint8_t region_id)
+{
+    if (region_id < NUM_REGIONS)
+    {
+        visible[region_id] = true;
+    }
+}
+
+static void hide(uint8_t region_id)
+{
+    if (region_id < NUM_REGIONS)
+    {
+        visible[region_id] = false;
+    }
+}
+
+static void errorHandler(void)
+{
+    printf("Clock error %d at %u ms\n", doz_clock.error_code, tick_ms);
+}
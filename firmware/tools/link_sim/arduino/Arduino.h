@@ -0,0 +1,43 @@
+/*
+ * Arduino.h
+ * Host stand-in for the parts of the ESP8266 Arduino core used by chrono_uart.cpp
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: Matt L.
+ */
+
+#ifndef FIRMWARE_TOOLS_LINK_SIM_ARDUINO_ARDUINO_H_
+#define FIRMWARE_TOOLS_LINK_SIM_ARDUINO_ARDUINO_H_
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#define SERIAL_RX_BUFFER_SIZE   256     // HardwareSerial default
+#define SERIAL_TX_BUFFER_SIZE   128     // UART FIFO, writes block once it is full
+
+class HardwareSerial
+{
+public:
+    void begin(uint32_t baud);
+    int available(void);
+    uint8_t read(void);
+    size_t write(uint8_t c);
+    size_t write(const uint8_t *buf, size_t len);
+    int printf(const char *format, ...);
+    uint32_t overruns(void);
+
+private:
+    void fill(void);
+
+    uint8_t     rx_ring[SERIAL_RX_BUFFER_SIZE];
+    uint16_t    rx_head = 0;
+    uint16_t    rx_tail = 0;
+    uint32_t    rx_overruns = 0;
+};
+
+extern HardwareSerial Serial;
+
+uint32_t millis(void);
+
+#endif  // FIRMWARE_TOOLS_LINK_SIM_ARDUINO_ARDUINO_H_
@@ -0,0 +1,98 @@
+/*
+ * arduino_shim.cpp
+ * Host stand-in for the parts of the ESP8266 Arduino core used by chrono_uart.cpp
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: Matt L.
+ */
+
+#include "Arduino.h"
+
+#include <stdarg.h>
+
+extern "C"
+{
+#include "sim_line.h"
+}
+
+HardwareSerial Serial;
+
+void HardwareSerial::begin(uint32_t baud)
+{
+    (void)baud;     // The line runs at the configured simulation baud
+    rx_head = 0;
+    rx_tail = 0;
+    rx_overruns = 0;
+}
+
+int HardwareSerial::available(void)
+{
+    fill();
+    return (rx_head + SERIAL_RX_BUFFER_SIZE - rx_tail) % SERIAL_RX_BUFFER_SIZE;
+}
+
+uint8_t HardwareSerial::read(void)
+{
+    fill();
+    if (rx_tail == rx_head)
+    {
+        return 0xFF;
+    }
+    uint8_t c = rx_ring[rx_tail];
+    rx_tail = (rx_tail + 1) % SERIAL_RX_BUFFER_SIZE;
+    return c;
+}
+
+size_t HardwareSerial::write(uint8_t c)
+{
+    return write(&c, 1);
+}
+
+size_t HardwareSerial::write(const uint8_t *buf, size_t len)
+{
+    for (size_t i = 0; i < len; i++)
+    {
+        while (SimLine_TxQueued() >= SERIAL_TX_BUFFER_SIZE)
+        {
+            SimLine_Service();
+        }
+        SimLine_Write(&buf[i], 1);
+    }
+    return len;
+}
+
+int HardwareSerial::printf(const char *format, ...)
+{
+    va_list args;
+    va_start(args, format);
+    int n = vfprintf(stderr, format, args);
+    va_end(args);
+    return n;
+}
+
+uint32_t HardwareSerial::overruns(void)
+{
+    return rx_overruns;
+}
+
+// Move bytes off the wire, anything that does not fit is lost as on the real UART
+void HardwareSerial::fill(void)
+{
+    uint8_t c;
+    while (SimLine_Read(&c, 1) == 1)
+    {
+        uint16_t next = (rx_head + 1) % SERIAL_RX_BUFFER_SIZE;
+        if (next == rx_tail)
+        {
+            rx_overruns++;
+            continue;
+        }
+        rx_ring[rx_head] = c;
+        rx_head = next;
+    }
+}
+
+uint32_t millis(void)
+{
+    return SimLine_TickMs();
+}
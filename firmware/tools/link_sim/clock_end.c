@@ -0,0 +1,213 @@
+/*
+ * clock_end.c
+ * Clock side of the link simulator, display.c driving the STM32F0 driver
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: Matt L.
+ */
+
+#include <unistd.h>
+
+#include "link_sim.h"
+#include "uart-display.h"
+
+/*
+    Private function definitions
+*/
+static void displayOff(void);
+static void displayOn(void);
+static void setBrightness(uint8_t brightness);
+static void setBitmap(uint8_t region_id, uint8_t *bitmap);
+static void setColour(uint8_t region_id, Colour colour_id);
+static void show(uint8_t region_id);
+static void hide(uint8_t region_id);
+static void setState(DisplayStateMsg *state);
+static void record(uint8_t code, uint8_t *payload, uint8_t len);
+static uint8_t colourId(Colour colour);
+
+/*
+    Private variables
+*/
+static SimShared *g_shared;
+static uint32_t last_key[STATE_CODE - BITMAP_CODE + 1][4];   // Per message code and region
+
+static ClockSnapshot clock_vals;
+static SnapshotPub clock_snapshot;
+
+static Display display =
+{
+    .displayOff = displayOff,
+    .displayOn = displayOn,
+    .setBrightness = setBrightness,
+    .setBitmap = setBitmap,
+    .setColour = setColour,
+    .show = show,
+    .hide = hide,
+    .setState = NULL,
+};
+
+/*
+    Public functions
+*/
+int ClockEnd_Run(SimShared *shared, int fd, SimOptions *options)
+{
+    UART_HandleTypeDef huart;
+    TimeFormats format = TRAD_24H;
+    uint32_t last_update = 0, last_blink = 0, last_mode = 0, last_format = 0;
+
+    g_shared = shared;
+    SimLine_Init(fd, &shared->config);
+
+    if (!Esp8266Driver_Init(&huart, SIM_HANDSHAKE_MS))
+    {
+        return 1;
+    }
+
+    clock_vals.time_ms = SIM_START_TIME_MS;
+    clock_vals.alarm_set = true;
+    clock_vals.user_alarm_ms = 25200000;   // 07:00
+    clock_vals.diurn_radix_pos = RADIX_POS3;
+    clock_vals.semi_diurn_radix_pos = RADIX_POS2;
+    Snapshot_Init(&clock_snapshot);
+    if (options->state_mode)
+    {
+        display.setState = setState;
+    }
+    Display_Init(&display, &clock_snapshot);
+    Display_On();
+    shared->ready = true;
+
+    uint32_t start = HAL_GetTick();
+    while (HAL_GetTick() - start < options->duration_ms)
+    {
+        uint32_t now = HAL_GetTick();
+        clock_vals.time_ms = SIM_START_TIME_MS + (now - start);
+
+        if (now - last_blink >= SIM_BLINK_PERIOD_MS)
+        {
+            last_blink = now;
+            Display_PeriodicCallback();
+        }
+        if (now - last_mode >= SIM_MODE_PERIOD_MS)
+        {
+            last_mode = now;
+            Display_ToggleMode();
+        }
+        if (now - last_format >= SIM_FORMAT_PERIOD_MS)
+        {
+            last_format = now;
+            format = (format + 1) % (DOZ_SEMI + 1);
+            Display_SetFormat(format);
+        }
+        if (now - last_update >= options->update_ms)
+        {
+            last_update = now;
+            Snapshot_Publish(&clock_snapshot, &clock_vals);
+            Display_Update();
+        }
+        Esp8266Driver_Poll();
+        usleep(100);
+    }
+
+    Esp8266Driver_GetLinkStats(&shared->clock_stats);
+    shared->clock_tx_bytes = SimLine_TxBytes();
+    return 0;
+}
+
+/*
+    Private functions
+*/
+static void displayOff(void)
+{
+    record(OFF_CODE, NULL, 0);
+    Esp8266Driver_DisplayOff();
+}
+
+static void displayOn(void)
+{
+    record(ON_CODE, NULL, 0);
+    Esp8266Driver_DisplayOn();
+}
+
+static void setBrightness(uint8_t brightness)
+{
+    record(BRIGHTNESS_CODE, &brightness, 1);
+    Esp8266Driver_SetDisplayBrightness(brightness);
+}
+
+// Display rows are numbered from 0, the driver numbers regions from 1
+static void setBitmap(uint8_t region_id, uint8_t *bitmap)
+{
+    uint8_t payload[CHRONO_MAX_PAYLOAD];
+    uint8_t size = (region_id == ROW_2) ? LARGE_BITMAP_SIZE : SMALL_BITMAP_SIZE;
+
+    payload[0] = TOP_REGION_ID + region_id;
+    memcpy(payload + 1, bitmap, size);
+    record(BITMAP_CODE, payload, size + 1);
+    Esp8266Driver_SetBitmap(region_id + 1, bitmap);
+}
+
+static void setColour(uint8_t region_id, Colour colour_id)
+{
+    uint8_t payload[2] = {TOP_REGION_ID + region_id, colourId(colour_id)};
+    record(COLOUR_CODE, payload, sizeof(payload));
+    Esp8266Driver_SetColour(region_id + 1, payload[1]);
+}
+
+static void show(uint8_t region_id)
+{
+    uint8_t payload[2] = {TOP_REGION_ID + region_id, DISPLAY_ON_ID};
+    record(STATUS_CODE, payload, sizeof(payload));
+    Esp8266Driver_Show(region_id + 1);
+}
+
+static void hide(uint8_t region_id)
+{
+    uint8_t payload[2] = {TOP_REGION_ID + region_id, DISPLAY_OFF_ID};
+    record(STATUS_CODE, payload, sizeof(payload));
+    Esp8266Driver_Hide(region_id + 1);
+}
+
+static void setState(DisplayStateMsg *state)
+{
+    uint8_t packed[DISPLAY_STATE_MSG_SIZE];
+    uint8_t size = Display_PackState(state, packed);
+    record(STATE_CODE, packed, size);
+    Esp8266Driver_SetState(state);
+}
+
+// Only changes count as display updates, repeats of what is already shown do not
+static void record(uint8_t code, uint8_t *payload, uint8_t len)
+{
+    uint8_t region = (code == BITMAP_CODE || code == COLOUR_CODE || code == STATUS_CODE) ? payload[0] - TOP_REGION_ID : 0;
+    uint32_t key = SimLine_Key(code, payload, len);
+    uint32_t *last = &last_key[code - BITMAP_CODE][region & 3];
+
+    g_shared->updates_offered++;
+    if (*last != key)
+    {
+        *last = key;
+        SimLine_RecordSubmit(g_shared, key);
+    }
+}
+
+static uint8_t colourId(Colour colour)
+{
+    switch (colour)
+    {
+    case RED:
+        return RED_ID;
+    case GREEN:
+        return GREEN_ID;
+    case BLUE:
+        return BLUE_ID;
+    case YELLOW:
+        return YELLOW_ID;
+    case MAGENTA:
+        return MAGENTA_ID;
+    case CYAN:
+        return CYAN_ID;
+    default:
+        return WHITE_ID;
+    }
+}
@@ -0,0 +1,113 @@
+/*
+ * display_end.cpp
+ * Display side of the link simulator, the ESP8266 chrono_uart parser
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: Matt L.
+ */
+
+#include <unistd.h>
+
+#include "Arduino.h"
+#include "chrono_uart.h"
+
+extern "C"
+{
+#include "link_sim.h"
+}
+
+#define DISPLAY_BAUD    9600    // Passed to Chrono_Init, the line itself runs at the simulated baud
+
+static void delivered(uint8_t code, uint8_t *payload, uint8_t len);
+static void displayOff(void);
+static void displayOn(void);
+static void setColour(uint8_t id, uint8_t val);
+static void setMatrixBrightness(uint8_t val);
+static void setBitmap(uint8_t id, uint8_t *vals);
+static void setRegionStatus(uint8_t id, uint8_t val);
+static void setState(uint8_t *vals, uint8_t len);
+
+static SimShared *g_shared;
+static Chrono chrono_ctx;
+
+void DisplayEnd_Run(SimShared *shared, int fd)
+{
+    g_shared = shared;
+    SimLine_Init(fd, &shared->config);
+
+    chrono_ctx.display_off = displayOff;
+    chrono_ctx.display_on = displayOn;
+    chrono_ctx.setColour = setColour;
+    chrono_ctx.setMatrixBrightness = setMatrixBrightness;
+    chrono_ctx.setBitmap = setBitmap;
+    chrono_ctx.setRegionStatus = setRegionStatus;
+    chrono_ctx.setState = setState;
+    Chrono_Init(&chrono_ctx, DISPLAY_BAUD);
+
+    while (!shared->done)
+    {
+        Chrono_Update();
+        SimLine_Service();
+        usleep(100);
+    }
+
+    Chrono_GetStats(&shared->display_stats);
+    shared->display_tx_bytes = SimLine_TxBytes();
+    shared->rx_overruns = Serial.overruns();
+}
+
+// Rebuild the link payload so it can be matched against what the clock sent
+void delivered(uint8_t code, uint8_t *payload, uint8_t len)
+{
+    uint64_t now_us = SimLine_NowUs();
+    uint64_t outage_end_us = g_shared->config.start_us +
+            1000ULL * (g_shared->config.outage_start_ms + g_shared->config.outage_ms);
+
+    g_shared->frames_delivered++;
+    uint64_t submit_us = SimLine_RecordDelivery(g_shared, SimLine_Key(code, payload, len));
+    if (g_shared->config.outage_ms > 0 && submit_us > 0 && submit_us < outage_end_us && now_us >= outage_end_us)
+    {
+        g_shared->caught_up_us = now_us;
+    }
+}
+
+void displayOff(void)
+{
+    delivered(OFF_CODE, NULL, 0);
+}
+
+void displayOn(void)
+{
+    delivered(ON_CODE, NULL, 0);
+}
+
+void setColour(uint8_t id, uint8_t val)
+{
+    uint8_t payload[2] = {id, val};
+    delivered(COLOUR_CODE, payload, sizeof(payload));
+}
+
+void setMatrixBrightness(uint8_t val)
+{
+    delivered(BRIGHTNESS_CODE, &val, 1);
+}
+
+void setBitmap(uint8_t id, uint8_t *vals)
+{
+    uint8_t payload[CHRONO_MAX_PAYLOAD];
+    uint8_t size = (id == MID_REGION_ID) ? LARGE_BITMAP_SIZE : SMALL_BITMAP_SIZE;
+    payload[0] = id;
+    memcpy(payload + 1, vals, size);
+    delivered(BITMAP_CODE, payload, size + 1);
+}
+
+void setRegionStatus(uint8_t id, uint8_t val)
+{
+    uint8_t payload[2] = {id, val};
+    delivered(STATUS_CODE, payload, sizeof(payload));
+}
+
+void setState(uint8_t *vals, uint8_t len)
+{
+    delivered(STATE_CODE, vals, len);
+}
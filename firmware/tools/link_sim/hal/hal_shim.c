@@ -0,0 +1,96 @@
+/*
+ * hal_shim.c
+ * Host stand-in for the parts of the STM32F0 HAL used by uart-display.c
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: Matt L.
+ *
+ * There is one UART. Receive interrupts are modelled by HalShim_Service,
+ * which runs whenever the driver calls into the HAL, the same points a
+ * real interrupt could preempt it.
+ */
+
+#include "stm32f0xx_hal.h"
+
+#include "sim_line.h"
+
+GPIO_TypeDef sim_gpioa, sim_gpiob, sim_gpioc;
+
+static UART_HandleTypeDef *g_rx_uart = NULL;
+static bool in_isr = false;
+
+uint32_t HAL_GetTick(void)
+{
+    HalShim_Service();
+    return SimLine_TickMs();
+}
+
+void HAL_Delay(uint32_t delay_ms)
+{
+    uint32_t start = HAL_GetTick();
+    while (HAL_GetTick() - start < delay_ms)
+    {
+    }
+}
+
+void HAL_GPIO_WritePin(GPIO_TypeDef *port, uint16_t pin, GPIO_PinState state)
+{
+    if (state == GPIO_PIN_SET)
+    {
+        port->odr |= pin;
+    }
+    else
+    {
+        port->odr &= ~pin;
+    }
+}
+
+// Blocks until the last byte has left the wire, like the polled HAL driver
+HAL_StatusTypeDef HAL_UART_Transmit(UART_HandleTypeDef *huart, uint8_t *data, uint16_t size, uint32_t timeout)
+{
+    (void)huart;
+    (void)timeout;
+    SimLine_Write(data, size);
+    while (!SimLine_TxIdle())
+    {
+        // Receive interrupts still run, unless this is called from one
+        SimLine_Service();
+        HalShim_Service();
+    }
+    return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_UART_Receive_IT(UART_HandleTypeDef *huart, uint8_t *data, uint16_t size)
+{
+    huart->rx_buff = data;
+    huart->rx_size = size;
+    huart->rx_count = 0;
+    g_rx_uart = huart;
+    return HAL_OK;
+}
+
+void HalShim_Service(void)
+{
+    if (in_isr)
+    {
+        return;
+    }
+    in_isr = true;
+    SimLine_Service();
+    while (g_rx_uart != NULL && g_rx_uart->rx_count < g_rx_uart->rx_size)
+    {
+        UART_HandleTypeDef *huart = g_rx_uart;
+        if (SimLine_Read(&huart->rx_buff[huart->rx_count], 1) == 0)
+        {
+            break;
+        }
+        huart->rx_count++;
+        if (huart->rx_count == huart->rx_size)
+        {
+            // Disarm before the callback, it normally re-arms
+            g_rx_uart = NULL;
+            HAL_UART_RxCpltCallback(huart);
+        }
+    }
+    in_isr = false;
+}
@@ -0,0 +1,77 @@
+/*
+ * stm32f0xx_hal.h
+ * Host stand-in for the parts of the STM32F0 HAL used by uart-display.c
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: Matt L.
+ */
+
+#ifndef FIRMWARE_TOOLS_LINK_SIM_HAL_STM32F0XX_HAL_H_
+#define FIRMWARE_TOOLS_LINK_SIM_HAL_STM32F0XX_HAL_H_
+
+#include <stdint.h>
+
+typedef enum
+{
+    HAL_OK,
+    HAL_ERROR,
+    HAL_BUSY,
+    HAL_TIMEOUT
+} HAL_StatusTypeDef;
+
+typedef enum
+{
+    GPIO_PIN_RESET,
+    GPIO_PIN_SET
+} GPIO_PinState;
+
+typedef struct
+{
+    uint32_t odr;
+} GPIO_TypeDef;
+
+typedef struct
+{
+    uint8_t     *rx_buff;
+    uint16_t    rx_size;
+    uint16_t    rx_count;
+} UART_HandleTypeDef;
+
+extern GPIO_TypeDef sim_gpioa, sim_gpiob, sim_gpioc;
+
+#define GPIOA   (&sim_gpioa)
+#define GPIOB   (&sim_gpiob)
+#define GPIOC   (&sim_gpioc)
+
+#define GPIO_PIN_0      0x0001U
+#define GPIO_PIN_1      0x0002U
+#define GPIO_PIN_2      0x0004U
+#define GPIO_PIN_3      0x0008U
+#define GPIO_PIN_4      0x0010U
+#define GPIO_PIN_5      0x0020U
+#define GPIO_PIN_6      0x0040U
+#define GPIO_PIN_7      0x0080U
+#define GPIO_PIN_8      0x0100U
+#define GPIO_PIN_9      0x0200U
+#define GPIO_PIN_10     0x0400U
+#define GPIO_PIN_11     0x0800U
+#define GPIO_PIN_12     0x1000U
+#define GPIO_PIN_13     0x2000U
+#define GPIO_PIN_14     0x4000U
+#define GPIO_PIN_15     0x8000U
+
+#define EXTI0_1_IRQn    5
+#define EXTI2_3_IRQn    6
+#define EXTI4_15_IRQn   7
+
+uint32_t HAL_GetTick(void);
+void HAL_Delay(uint32_t delay_ms);
+void HAL_GPIO_WritePin(GPIO_TypeDef *port, uint16_t pin, GPIO_PinState state);
+HAL_StatusTypeDef HAL_UART_Transmit(UART_HandleTypeDef *huart, uint8_t *data, uint16_t size, uint32_t timeout);
+HAL_StatusTypeDef HAL_UART_Receive_IT(UART_HandleTypeDef *huart, uint8_t *data, uint16_t size);
+void HAL_UART_RxCpltCallback(UART_HandleTypeDef *huart);
+
+// Runs pending receive interrupts, called from every HAL entry point
+void HalShim_Service(void);
+
+#endif  // FIRMWARE_TOOLS_LINK_SIM_HAL_STM32F0XX_HAL_H_
@@ -0,0 +1,219 @@
+/*
+ * link_sim.c
+ * Loopback simulator and throughput benchmark for the clock to display link
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: Matt L.
+ *
+ * Forks into the two ends of the link, the STM32F0 uart-display.c driver
+ * fed by display.c and the ESP8266 chrono_uart.cpp parser, joined by a
+ * pseudo-terminal pair. Each end paces, delays and corrupts what it sends.
+ *
+ * Usage: link_sim.out [-b baud] [-e bit_error_rate] [-l latency_us]
+ *                     [-d duration_s] [-u update_ms] [-o outage_ms] [-s seed] [-S]
+ */
+
+#include <pty.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include <termios.h>
+#include <unistd.h>
+
+#include "link_sim.h"
+
+#define DEFAULT_BAUD        9600
+#define DEFAULT_DURATION_S  10
+#define DEFAULT_UPDATE_MS   50
+#define SETTLE_MS           200     // Let the last frames and ACKs drain before reading stats
+
+/*
+    Private function definitions
+*/
+static void parseArgs(int argc, char *argv[], SimLineConfig *config, SimOptions *options);
+static int openLine(int fd);
+static void report(SimShared *shared, SimOptions *options);
+static uint32_t percentile(uint32_t *sorted, uint32_t n, uint32_t pct);
+static int compareU32(const void *a, const void *b);
+
+/*
+    Public functions
+*/
+int main(int argc, char *argv[])
+{
+    SimOptions options;
+    int clock_fd, display_fd;
+    pid_t display_pid;
+    int status;
+
+    SimShared *shared = mmap(NULL, sizeof(SimShared), PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+    if (shared == MAP_FAILED)
+    {
+        perror("mmap");
+        return 1;
+    }
+    memset(shared, 0, sizeof(SimShared));
+    parseArgs(argc, argv, &shared->config, &options);
+
+    if (openpty(&clock_fd, &display_fd, NULL, NULL, NULL) < 0 || openLine(clock_fd) < 0 || openLine(display_fd) < 0)
+    {
+        perror("openpty");
+        return 1;
+    }
+    shared->config.start_us = SimLine_NowUs();
+
+    display_pid = fork();
+    if (display_pid == 0)
+    {
+        close(clock_fd);
+        srand(shared->config.seed + 1);
+        DisplayEnd_Run(shared, display_fd);
+        _exit(0);
+    }
+    close(display_fd);
+    srand(shared->config.seed);
+
+    status = ClockEnd_Run(shared, clock_fd, &options);
+    usleep(1000 * SETTLE_MS);
+    shared->done = true;
+    while (waitpid(display_pid, NULL, WNOHANG) == 0)
+    {
+        // Keep draining so the display end is never stuck on a full pty
+        uint8_t discard[64];
+        SimLine_Read(discard, sizeof(discard));
+    }
+
+    if (status != 0)
+    {
+        fprintf(stderr, "link_sim: display did not complete the handshake\n");
+        return status;
+    }
+    report(shared, &options);
+    return 0;
+}
+
+/*
+    Private functions
+*/
+static void parseArgs(int argc, char *argv[], SimLineConfig *config, SimOptions *options)
+{
+    int opt;
+
+    config->baud = DEFAULT_BAUD;
+    config->seed = 1;
+    options->duration_ms = 1000 * DEFAULT_DURATION_S;
+    options->update_ms = DEFAULT_UPDATE_MS;
+    options->state_mode = false;
+
+    while ((opt = getopt(argc, argv, "b:e:l:d:u:o:s:S")) != -1)
+    {
+        switch (opt)
+        {
+        case 'b':
+            config->baud = strtoul(optarg, NULL, 10);
+            break;
+        case 'e':
+            config->bit_error_rate = strtod(optarg, NULL);
+            break;
+        case 'l':
+            config->latency_us = strtoul(optarg, NULL, 10);
+            break;
+        case 'd':
+            options->duration_ms = 1000 * strtoul(optarg, NULL, 10);
+            break;
+        case 'u':
+            options->update_ms = strtoul(optarg, NULL, 10);
+            break;
+        case 'o':
+            config->outage_ms = strtoul(optarg, NULL, 10);
+            break;
+        case 's':
+            config->seed = strtoul(optarg, NULL, 10);
+            break;
+        case 'S':
+            options->state_mode = true;
+            break;
+        default:
+            fprintf(stderr, "usage: %s [-b baud] [-e ber] [-l latency_us] [-d duration_s] "
+                    "[-u update_ms] [-o outage_ms] [-s seed] [-S]\n", argv[0]);
+            exit(1);
+        }
+    }
+    // Cut the line half way through, after the handshake
+    config->outage_start_ms = options->duration_ms / 2;
+}
+
+static int openLine(int fd)
+{
+    struct termios tio;
+
+    if (tcgetattr(fd, &tio) < 0)
+    {
+        return -1;
+    }
+    cfmakeraw(&tio);
+    if (tcsetattr(fd, TCSANOW, &tio) < 0)
+    {
+        return -1;
+    }
+    return fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+}
+
+static void report(SimShared *shared, SimOptions *options)
+{
+    SimLineConfig *config = &shared->config;
+    double seconds = options->duration_ms / 1000.0;
+    uint32_t frames = shared->frames_delivered;
+    uint32_t n = shared->num_latency;
+
+    printf("link_sim: %u baud, BER %g, latency %u us, %.0f s, %s mode, update every %u ms\n",
+           config->baud, config->bit_error_rate, config->latency_us, seconds,
+           options->state_mode ? "state" : "bitmap", options->update_ms);
+    printf("  frames delivered       %u (%.1f fps)\n", frames, frames / seconds);
+    printf("  bytes per frame        %.1f clock to display, %.1f display to clock\n",
+           frames ? (double)shared->clock_tx_bytes / frames : 0.0,
+           frames ? (double)shared->display_tx_bytes / frames : 0.0);
+    printf("  display updates        %u offered, %u changes, %u shown\n",
+           shared->updates_offered, shared->num_records, n);
+
+    if (n > 0)
+    {
+        qsort(shared->latency_us, n, sizeof(uint32_t), compareU32);
+        printf("  latency ms             p50 %.1f  p90 %.1f  p99 %.1f  max %.1f\n",
+               percentile(shared->latency_us, n, 50) / 1000.0, percentile(shared->latency_us, n, 90) / 1000.0,
+               percentile(shared->latency_us, n, 99) / 1000.0, shared->latency_us[n - 1] / 1000.0);
+    }
+    if (config->outage_ms > 0)
+    {
+        uint64_t outage_end_us = config->start_us + 1000ULL * (config->outage_start_ms + config->outage_ms);
+        if (shared->caught_up_us > 0)
+        {
+            printf("  resync after %u ms cut  %.1f ms\n", config->outage_ms,
+                   (shared->caught_up_us - outage_end_us) / 1000.0);
+        }
+        else
+        {
+            printf("  resync after %u ms cut  nothing held back\n", config->outage_ms);
+        }
+    }
+    printf("  clock link             sent %u, acked %u, retransmitted %u, superseded %u, bad acks %u\n",
+           shared->clock_stats.sent, shared->clock_stats.acked, shared->clock_stats.retransmitted,
+           shared->clock_stats.dropped, shared->clock_stats.rejected);
+    printf("  display link           received %u, duplicates %u, rejected %u, rx overruns %u\n",
+           shared->display_stats.received, shared->display_stats.duplicates,
+           shared->display_stats.rejected, shared->rx_overruns);
+}
+
+static uint32_t percentile(uint32_t *sorted, uint32_t n, uint32_t pct)
+{
+    return sorted[(n - 1) * pct / 100];
+}
+
+static int compareU32(const void *a, const void *b)
+{
+    uint32_t x = *(const uint32_t *)a, y = *(const uint32_t *)b;
+    return (x > y) - (x < y);
+}
@@ -0,0 +1,30 @@
+/*
+ * link_sim.h
+ * Loopback simulator for the clock to display link
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: Matt L.
+ */
+
+#ifndef FIRMWARE_TOOLS_LINK_SIM_LINK_SIM_H_
+#define FIRMWARE_TOOLS_LINK_SIM_LINK_SIM_H_
+
+#include "sim_line.h"
+
+#define SIM_HANDSHAKE_MS        5000
+#define SIM_BLINK_PERIOD_MS     500     // Display_PeriodicCallback rate on the clock
+#define SIM_MODE_PERIOD_MS      3000    // Cycle the ShowTime rows
+#define SIM_FORMAT_PERIOD_MS    7000    // Cycle the time format, redraws every row
+#define SIM_START_TIME_MS       50390000    // 13:59:50, rolls over the hour early in a run
+
+typedef struct sim_options_t
+{
+    uint32_t    duration_ms;
+    uint32_t    update_ms;      // How often the clock calls Display_Update
+    bool        state_mode;     // Send DisplayStateMsg instead of bitmaps
+} SimOptions;
+
+int ClockEnd_Run(SimShared *shared, int fd, SimOptions *options);
+void DisplayEnd_Run(SimShared *shared, int fd);
+
+#endif  // FIRMWARE_TOOLS_LINK_SIM_LINK_SIM_H_
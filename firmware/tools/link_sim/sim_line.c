@@ -0,0 +1,209 @@
+/*
+ * sim_line.c
+ * Simulated UART line over a pseudo-terminal, one direction per process
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: Matt L.
+ *
+ * Bytes written are held until the wire would have finished shifting them
+ * out at the configured baud rate, plus any extra latency, then go to the
+ * pty with bit errors and outages applied. Reads come straight from the pty
+ * since the other end already paced them.
+ */
+
+#include "sim_line.h"
+
+#include <stdlib.h>
+#include <time.h>
+#include <unistd.h>
+
+/*
+    Private types
+*/
+typedef struct tx_byte_t
+{
+    uint8_t     c;
+    uint64_t    release_us;
+} TxByte;
+
+/*
+    Private function definitions
+*/
+static uint8_t corrupt(uint8_t c);
+
+/*
+    Private variables
+*/
+static int g_fd = -1;
+static SimLineConfig *g_config;
+static TxByte tx_queue[SIM_TX_QUEUE_SIZE];
+static uint16_t tx_head, tx_tail;
+static uint64_t line_free_us;   // When the last queued byte finishes shifting out
+static uint64_t tx_bytes;
+
+/*
+    Public functions
+*/
+void SimLine_Init(int fd, SimLineConfig *config)
+{
+    g_fd = fd;
+    g_config = config;
+    tx_head = 0;
+    tx_tail = 0;
+    line_free_us = 0;
+    tx_bytes = 0;
+}
+
+void SimLine_Write(const uint8_t *buf, uint16_t len)
+{
+    uint64_t byte_us = (1000000ULL * SIM_BITS_PER_BYTE) / g_config->baud;
+
+    for (int i = 0; i < len; i++)
+    {
+        // Queue full, block like a UART with a full transmit FIFO
+        while ((tx_head + 1) % SIM_TX_QUEUE_SIZE == tx_tail)
+        {
+            SimLine_Service();
+        }
+        uint64_t now_us = SimLine_NowUs();
+        line_free_us = ((line_free_us > now_us) ? line_free_us : now_us) + byte_us;
+        tx_queue[tx_head].c = buf[i];
+        tx_queue[tx_head].release_us = line_free_us + g_config->latency_us;
+        tx_head = (tx_head + 1) % SIM_TX_QUEUE_SIZE;
+        tx_bytes++;
+    }
+    SimLine_Service();
+}
+
+uint16_t SimLine_Read(uint8_t *buf, uint16_t max)
+{
+    SimLine_Service();
+    ssize_t n = read(g_fd, buf, max);
+    return (n > 0) ? (uint16_t)n : 0;
+}
+
+void SimLine_Service(void)
+{
+    uint64_t now_us = SimLine_NowUs();
+
+    while (tx_tail != tx_head && tx_queue[tx_tail].release_us <= now_us)
+    {
+        if (!SimLine_InOutage(tx_queue[tx_tail].release_us))
+        {
+            uint8_t c = corrupt(tx_queue[tx_tail].c);
+            if (write(g_fd, &c, 1) != 1)
+            {
+                break;  // pty full, try again next time
+            }
+        }
+        tx_tail = (tx_tail + 1) % SIM_TX_QUEUE_SIZE;
+    }
+}
+
+bool SimLine_TxIdle(void)
+{
+    return tx_tail == tx_head && SimLine_NowUs() >= line_free_us;
+}
+
+uint16_t SimLine_TxQueued(void)
+{
+    return (tx_head + SIM_TX_QUEUE_SIZE - tx_tail) % SIM_TX_QUEUE_SIZE;
+}
+
+uint64_t SimLine_TxBytes(void)
+{
+    return tx_bytes;
+}
+
+uint64_t SimLine_NowUs(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000ULL + ts.tv_nsec / 1000;
+}
+
+// Milliseconds since the start of the run, stands in for HAL_GetTick and millis
+uint32_t SimLine_TickMs(void)
+{
+    return (uint32_t)((SimLine_NowUs() - g_config->start_us) / 1000);
+}
+
+bool SimLine_InOutage(uint64_t now_us)
+{
+    uint64_t start_us = g_config->start_us + 1000ULL * g_config->outage_start_ms;
+    return g_config->outage_ms > 0 && now_us >= start_us && now_us < start_us + 1000ULL * g_config->outage_ms;
+}
+
+// FNV-1a
+uint32_t SimLine_Key(uint8_t code, const uint8_t *payload, uint8_t len)
+{
+    uint32_t key = 2166136261UL;
+    key = (key ^ code) * 16777619UL;
+    for (int i = 0; i < len; i++)
+    {
+        key = (key ^ payload[i]) * 16777619UL;
+    }
+    return key;
+}
+
+void SimLine_RecordSubmit(SimShared *shared, uint32_t key)
+{
+    uint32_t n = __atomic_load_n(&shared->num_records, __ATOMIC_RELAXED);
+    if (n >= SIM_RECORDS)
+    {
+        return;
+    }
+    shared->records[n].submit_us = SimLine_NowUs();
+    shared->records[n].key = key;
+    shared->records[n].matched = false;
+    __atomic_store_n(&shared->num_records, n + 1, __ATOMIC_RELEASE);
+}
+
+// Latency runs from the first time the clock asked for this content to it reaching the display,
+// returns when that was or 0 if the content was already shown
+uint64_t SimLine_RecordDelivery(SimShared *shared, uint32_t key)
+{
+    uint32_t n = __atomic_load_n(&shared->num_records, __ATOMIC_ACQUIRE);
+    uint64_t now_us = SimLine_NowUs();
+    int oldest = -1;
+
+    for (uint32_t i = 0; i < n; i++)
+    {
+        if (!shared->records[i].matched && shared->records[i].key == key)
+        {
+            if (oldest < 0)
+            {
+                oldest = i;
+            }
+            shared->records[i].matched = true;
+        }
+    }
+    if (oldest < 0)
+    {
+        return 0;
+    }
+    if (shared->num_latency < SIM_RECORDS)
+    {
+        shared->latency_us[shared->num_latency++] = (uint32_t)(now_us - shared->records[oldest].submit_us);
+    }
+    return shared->records[oldest].submit_us;
+}
+
+/*
+    Private functions
+*/
+static uint8_t corrupt(uint8_t c)
+{
+    if (g_config->bit_error_rate <= 0)
+    {
+        return c;
+    }
+    for (int bit = 0; bit < 8; bit++)
+    {
+        if ((double)rand() / RAND_MAX < g_config->bit_error_rate)
+        {
+            c ^= 1 << bit;
+        }
+    }
+    return c;
+}
@@ -0,0 +1,80 @@
+/*
+ * sim_line.h
+ * Simulated UART line over a pseudo-terminal, one direction per process
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: Matt L.
+ */
+
+#ifndef FIRMWARE_TOOLS_LINK_SIM_SIM_LINE_H_
+#define FIRMWARE_TOOLS_LINK_SIM_SIM_LINE_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "chrono_link.h"
+
+#define SIM_TX_QUEUE_SIZE   4096    // Bytes waiting to go out on the wire
+#define SIM_RECORDS         8192    // Display updates tracked for latency
+#define SIM_BITS_PER_BYTE   10      // 8N1, start and stop bit
+
+typedef struct sim_line_config_t
+{
+    uint32_t    baud;
+    double      bit_error_rate;     // Chance of each bit flipping on the wire
+    uint32_t    latency_us;         // Extra one way delay, e.g. a level shifter or radio bridge
+    uint64_t    start_us;           // Shared start of the run, see SimLine_NowUs
+    uint32_t    outage_start_ms;    // Line cut for outage_ms, both directions lose every byte
+    uint32_t    outage_ms;
+    uint32_t    seed;
+} SimLineConfig;
+
+typedef struct sim_record_t
+{
+    uint64_t    submit_us;
+    uint32_t    key;
+    bool        matched;
+} SimRecord;
+
+// Shared by both ends, lives in memory mapped before the fork
+typedef struct sim_shared_t
+{
+    SimLineConfig   config;
+
+    // Clock end
+    SimRecord       records[SIM_RECORDS];
+    uint32_t        num_records;
+    uint64_t        clock_tx_bytes;
+    uint32_t        updates_offered;
+    ChronoLinkStats clock_stats;
+
+    // Display end
+    uint32_t        latency_us[SIM_RECORDS];
+    uint32_t        num_latency;
+    uint32_t        frames_delivered;
+    uint64_t        display_tx_bytes;
+    uint32_t        rx_overruns;
+    uint64_t        caught_up_us;       // Last update held back by the outage reached the display
+    ChronoLinkStats display_stats;
+
+    volatile bool   ready;
+    volatile bool   done;
+} SimShared;
+
+void SimLine_Init(int fd, SimLineConfig *config);
+void SimLine_Write(const uint8_t *buf, uint16_t len);
+uint16_t SimLine_Read(uint8_t *buf, uint16_t max);
+void SimLine_Service(void);
+bool SimLine_TxIdle(void);
+uint16_t SimLine_TxQueued(void);
+uint64_t SimLine_TxBytes(void);
+uint64_t SimLine_NowUs(void);
+uint32_t SimLine_TickMs(void);
+bool SimLine_InOutage(uint64_t now_us);
+
+// Display update matching, key covers the message code and payload
+uint32_t SimLine_Key(uint8_t code, const uint8_t *payload, uint8_t len);
+void SimLine_RecordSubmit(SimShared *shared, uint32_t key);
+uint64_t SimLine_RecordDelivery(SimShared *shared, uint32_t key);
+
+#endif  // FIRMWARE_TOOLS_LINK_SIM_SIM_LINE_H_